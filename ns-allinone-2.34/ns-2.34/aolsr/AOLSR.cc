@@ -35,6 +35,7 @@
 #include <ip.h>
 #include <cmu-trace.h>
 #include <map>
+#include <algorithm>
 
 /// Length (in bytes) of UDP header.
 #define UDP_HDR_LEN	8
@@ -75,6 +76,24 @@ public:
 	}
 } class_rtProtoAOLSR;
 
+
+///
+/// \brief Appends the usage of the pool of type T to the result of a Tcl command.
+///
+/// The element is the list {name objects_in_use high_water_mark objects_allocated}.
+///
+/// \param tcl the Tcl interpreter.
+/// \param name the name of the pooled type.
+///
+template <class T>
+static void
+append_pool_stats(Tcl& tcl, const char* name) {
+	char buf[128];
+	sprintf(buf, "%s %u %u %u", name,
+		AOLSR_pool<T>::in_use(), AOLSR_pool<T>::high_water(), AOLSR_pool<T>::capacity());
+	Tcl_AppendElement(tcl.interp(), buf);
+}
+
 ///
 /// \brief Interface with TCL interpreter.
 ///
@@ -217,6 +236,28 @@ AOLSR::command(int argc, const char*const* argv) {
 			}
 			return TCL_OK;
 		}
+		// Gives the usage of the pools of tuples and timers, which are
+		// shared by all the agents
+		else if (strcasecmp(argv[1], "pool_stats") == 0) {
+			Tcl& tcl = Tcl::instance();
+			Tcl_ResetResult(tcl.interp());
+			append_pool_stats<AOLSR_rt_entry>(tcl, "rt_entry");
+			append_pool_stats<AOLSR_link_tuple>(tcl, "link_tuple");
+			append_pool_stats<AOLSR_nb_tuple>(tcl, "nb_tuple");
+			append_pool_stats<AOLSR_nb2hop_tuple>(tcl, "nb2hop_tuple");
+			append_pool_stats<AOLSR_mprsel_tuple>(tcl, "mprsel_tuple");
+			append_pool_stats<AOLSR_dup_tuple>(tcl, "dup_tuple");
+			append_pool_stats<AOLSR_topology_tuple>(tcl, "topology_tuple");
+			append_pool_stats<AOLSR_iface_assoc_tuple>(tcl, "iface_assoc_tuple");
+			append_pool_stats<AOLSR_DupTupleTimer>(tcl, "dup_timer");
+			append_pool_stats<AOLSR_LinkTupleTimer>(tcl, "link_timer");
+			append_pool_stats<AOLSR_Nb2hopTupleTimer>(tcl, "nb2hop_timer");
+			append_pool_stats<AOLSR_MprSelTupleTimer>(tcl, "mprsel_timer");
+			append_pool_stats<AOLSR_TopologyTupleTimer>(tcl, "topology_timer");
+			append_pool_stats<AOLSR_IfaceAssocTupleTimer>(tcl, "iface_assoc_timer");
+			append_pool_stats<AOLSR_MsgTimer>(tcl, "msg_timer");
+			return TCL_OK;
+		}
 	}
 	else if (argc == 3) {
 		// Obtains the corresponding dmux to carry packets to upper layers
@@ -533,6 +574,122 @@ AOLSR_IfaceAssocTupleTimer::expire(Event* e) {
 		resched(DELAY(tuple_->time()));
 }
 
+/********** Tuple expiry wheel **********/
+
+///
+/// \brief Hands the timer to the expiry wheel of its agent.
+/// \param delay time from now at which the timer expires.
+///
+void
+AOLSR_TupleTimer::resched(double delay) {
+	agent_->expiry_wheel_.schedule(this, delay);
+}
+
+AOLSR_ExpiryWheel::AOLSR_ExpiryWheel() : TimerHandler() {
+	cursor_		= 0;
+	size_		= 0;
+	seq_		= 0;
+	next_		= -1.0;
+	sweeping_	= false;
+}
+
+///
+/// \brief Adds a tuple timer to the wheel.
+///
+/// The handler is only rescheduled if the timer is due before all the
+/// other ones.
+///
+/// \param timer the tuple timer.
+/// \param delay time from now at which the timer expires.
+///
+void
+AOLSR_ExpiryWheel::schedule(AOLSR_TupleTimer* timer, double delay) {
+	entry e;
+	e.time_		= CURRENT_TIME + delay;
+	e.tick_		= (long)floor(e.time_ / AOLSR_WHEEL_TICK);
+	e.seq_		= seq_++;
+	e.timer_	= timer;
+	slots_[e.tick_ & (AOLSR_WHEEL_SLOTS - 1)].push_back(e);
+	size_++;
+	if (e.tick_ < cursor_)
+		cursor_ = e.tick_;
+
+	// While sweeping, the handler is rescheduled once all due timers are expired
+	if (!sweeping_ && (next_ < 0 || e.time_ < next_)) {
+		next_ = e.time_;
+		resched(delay);
+	}
+}
+
+///
+/// \brief Expires all the due tuple timers, sorted by time and then by order
+/// of scheduling, and reschedules the handler at the next one.
+/// \param e The event which has expired.
+///
+void
+AOLSR_ExpiryWheel::expire(Event* e) {
+	// The handler may run slightly before next_ due to rounding errors
+	double now	= MAX(CURRENT_TIME, next_);
+	long last	= (long)floor(now / AOLSR_WHEEL_TICK);
+
+	// Every slot is visited once at most
+	if (last - cursor_ >= AOLSR_WHEEL_SLOTS)
+		cursor_ = last - AOLSR_WHEEL_SLOTS + 1;
+	for (long k = cursor_; k <= last; k++) {
+		std::vector<entry>& slot = slots_[k & (AOLSR_WHEEL_SLOTS - 1)];
+		for (u_int32_t i = 0; i < slot.size();) {
+			if (slot[i].time_ <= now) {
+				due_.push_back(slot[i]);
+				slot[i] = slot.back();
+				slot.pop_back();
+			}
+			else
+				i++;
+		}
+	}
+	cursor_	= last;
+	size_	-= due_.size();
+	std::sort(due_.begin(), due_.end());
+
+	sweeping_ = true;
+	for (u_int32_t i = 0; i < due_.size(); i++)
+		due_[i].timer_->expire(e);
+	due_.clear();
+	sweeping_ = false;
+
+	reschedule();
+}
+
+///
+/// \brief Schedules the handler at the time of the earliest tuple timer.
+///
+void
+AOLSR_ExpiryWheel::reschedule() {
+	next_ = -1.0;
+	if (size_ == 0)
+		return;
+
+	// The earliest timer lies in the first slot with a timer of the current round...
+	const entry* first = NULL;
+	for (long k = cursor_; first == NULL && k < cursor_ + AOLSR_WHEEL_SLOTS; k++) {
+		std::vector<entry>& slot = slots_[k & (AOLSR_WHEEL_SLOTS - 1)];
+		for (u_int32_t i = 0; i < slot.size(); i++)
+			if (slot[i].tick_ == k && (first == NULL || slot[i] < *first))
+				first = &slot[i];
+	}
+	// ...unless all of them lie beyond the wheel
+	if (first == NULL) {
+		for (int s = 0; s < AOLSR_WHEEL_SLOTS; s++)
+			for (u_int32_t i = 0; i < slots_[s].size(); i++)
+				if (first == NULL || slots_[s][i] < *first)
+					first = &slots_[s][i];
+	}
+
+	cursor_	= first->tick_;
+	next_	= first->time_;
+	resched(next_ - CURRENT_TIME);
+}
+
 ///
 /// \brief Sends a control packet which must bear every message in the AOLSR agent's buffer.
 ///
@@ -570,6 +727,7 @@ mid_timer_(this) {
 	bind("hello_ival_", &hello_ival_);
 	bind("tc_ival_", &tc_ival_); // \D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC\D6\DC
 	bind("mid_ival_", &mid_ival_);
+	bind("max_pkt_size_", &max_pkt_size_);
 	bind_bool("use_mac_", &use_mac_);
 
 	// Do some initializations
@@ -577,6 +735,7 @@ mid_timer_(this) {
 	pkt_seq_ = AOLSR_MAX_SEQ_NUM;
 	msg_seq_ = AOLSR_MAX_SEQ_NUM;
 	ansn_ = AOLSR_MAX_SEQ_NUM;
+	mpr_version_ = 0;
        Hmax_ = 0; /// added by ÖÜŒÒŒÒ
 	Hmin_ = 10; /// added by ÖÜŒÒŒÒ
 	 Pmax_ = -0.001; /// added by ÖÜŒÒŒÒ
@@ -683,9 +842,10 @@ AOLSR::recv_aolsr(Packet* p) {
 		return;
 	}
 
-	assert(op->count >= 0 && op->count <= AOLSR_MAX_MSGS);
+	assert(op->count >= 0);
 	for (int i = 0; i < op->count; i++) {
-		AOLSR_msg& msg = op->msg(i);
+		AOLSR_msg msg;
+		AOLSR_pkt::get_msg(p, i, msg);
 
 		// If ttl is less than or equal to zero, or
 		// the receiver is the same as the originator,
@@ -743,205 +903,196 @@ AOLSR::recv_aolsr(Packet* p) {
 	Packet::free(p);    ///\CAͷ\C5\D7\CAԴ
 }
 
+///
+/// \brief Moves a member of N to a bucket of the MPR computation.
+///
+/// \param buckets the buckets, by willingness and reachability.
+/// \param pos position of every member of N in its bucket.
+/// \param b the bucket.
+/// \param y the member of N.
+///
+static void
+bucket_insert(std::vector<std::vector<int> >& buckets, std::vector<int>& pos, int b, int y) {
+	pos[y] = buckets[b].size();
+	buckets[b].push_back(y);
+}
+
+///
+/// \brief Removes a member of N from a bucket of the MPR computation.
+///
+/// \param buckets the buckets, by willingness and reachability.
+/// \param pos position of every member of N in its bucket.
+/// \param b the bucket.
+/// \param y the member of N.
+///
+static void
+bucket_erase(std::vector<std::vector<int> >& buckets, std::vector<int>& pos, int b, int y) {
+	std::vector<int>& bucket = buckets[b];
+	bucket[pos[y]]		= bucket.back();
+	pos[bucket[pos[y]]]	= pos[y];
+	bucket.pop_back();
+}
+
 ///
 /// \brief Computates MPR set of a node following RFC 3626 hints.
 /// \BC\C6\CB\E3MPR\BC\AF\BA\CF
+///
+/// The set only depends on the Neighbor Set and the 2-hop Neighbor Set, so it
+/// is only computed again once they have changed. The members of N are kept
+/// in buckets by willingness and reachability, which are updated as the
+/// members of N2 get covered, so that every step of the heuristic only looks
+/// at the members with the highest willingness and reachability.
+///
 void
 AOLSR::mpr_computation() {
+	if (mpr_version_ == state_.nbhood_version())
+		return;
+	mpr_version_ = state_.nbhood_version();
+
 	// MPR computation should be done for each interface. See section 8.3.1
 	// (RFC 3626) for details.
-
+	
 	state_.clear_mprset();
-
-	nbset_t N; nb2hopset_t N2;
+	
 	// N is the subset of neighbors of the node, which are
-	// neighbor "of the interface I"
-	for (nbset_t::iterator it = nbset().begin(); it != nbset().end(); it++)
-		if ((*it)->status() == AOLSR_STATUS_SYM) // I think that we need this check
-			N.push_back(*it);///һ\CC\F8\C1ھӼ\AF\BA\CF
-
+	// neighbor "of the interface I". Its members are numbered in the
+	// order of the Neighbor Set.
+	std::vector<AOLSR_nb_tuple*> N;
+	AOLSR_hash<nsaddr_t, int> N_index;
+	int max_willingness = 0;
+	for (nbset_t::iterator it = nbset().begin(); it != nbset().end(); it++) {
+		AOLSR_nb_tuple* nb_tuple = *it;
+		if (nb_tuple->status() == AOLSR_STATUS_SYM // I think that we need this check
+			&& N_index.find(nb_tuple->nb_main_addr()) == NULL) {
+			N_index[nb_tuple->nb_main_addr()] = N.size();
+			N.push_back(nb_tuple);
+			max_willingness = MAX(max_willingness, nb_tuple->willingness());
+		}
+	}
+	
 	// N2 is the set of 2-hop neighbors reachable from "the interface
-	// I", excluding: N2\CAǴӡ\B0\BDӿ\DAI\A1\B1\BFɵ\BD\B4\EF\B5\C42\CC\F8\C1ھӼ\AF\BAϣ\AC\B2\BB\B0\FC\C0\A8\A3\BA
+	// I", excluding:
 	// (i)   the nodes only reachable by members of N with willingness WILL_NEVER
-	/// ֻ\D3\D0N\B5ĳ\C9Ա\D2\E2ԸΪWILL_NEVER\B2\C5\C4ܵ\BD\B4\EF\B5Ľڵ\E3
 	// (ii)  the node performing the computation
-	/// \B5\B1ǰ\D4ڼ\C6\CB\E3\B5Ľڵ\E3
 	// (iii) all the symmetric neighbors: the nodes for which there exists a symmetric
 	//       link to this node on some interface.
-	/// \CB\F9\D3жԳ\C6\C1ھӣ\BA\D4\DAĳ\B8\F6\BDӿ\DA\C9\CF\D3\EB\C6\E4\B4\E6\D4ڶԳ\C6\C1\B4\BDӵĽڵ㡣
+	// Its members are numbered too, providers holds the members of N which
+	// every one is reachable through, and covers the members of N2 which are
+	// reachable through every member of N.
+	//
+	// 2. Calculate D(y), where y is a member of N, for all nodes in N:
+	// the number of symmetric neighbors of y, excluding all the members
+	// of N and the node performing the computation.
+	AOLSR_hash<nsaddr_t, int> N2_index;
+	std::vector<std::vector<int> > providers;
+	std::vector<std::vector<int> > covers(N.size());
+	std::vector<int> degree(N.size(), 0);
 	for (nb2hopset_t::iterator it = nb2hopset().begin(); it != nb2hopset().end(); it++) {
 		AOLSR_nb2hop_tuple* nb2hop_tuple = *it;
-		bool ok = true;
-		AOLSR_nb_tuple* nb_tuple = state_.find_sym_nb_tuple(nb2hop_tuple->nb_main_addr());
-		if (nb_tuple == NULL)
-			ok = false;
-		else {
-			nb_tuple = state_.find_nb_tuple(nb2hop_tuple->nb_main_addr(), AOLSR_WILL_NEVER);
-			if (nb_tuple != NULL)
-				ok = false;
-			else {
-				nb_tuple = state_.find_sym_nb_tuple(nb2hop_tuple->nb2hop_addr());
-				if (nb_tuple != NULL)
-					ok = false;
-			}
+		nsaddr_t addr	= nb2hop_tuple->nb2hop_addr();
+		int* y		= N_index.find(nb2hop_tuple->nb_main_addr());
+		if (y == NULL || addr == ra_addr() || N_index.find(addr) != NULL)
+			continue;
+		degree[*y]++;
+		if (N[*y]->willingness() == AOLSR_WILL_NEVER)
+			continue;
+		int* x = N2_index.find(addr);
+		if (x == NULL) {
+			N2_index[addr] = providers.size();
+			providers.push_back(std::vector<int>());
+			x = N2_index.find(addr);
 		}
-
-		if (ok)
-			N2.push_back(nb2hop_tuple);///2\CC\F8\C1ھӼ\AF\BA\CF
+		providers[*x].push_back(*y);
+		covers[*y].push_back(*x);
 	}
-
+	
+	// The reachability of a member of N is the number of members of N2
+	// which are not yet covered by a node in the MPR set, and which are
+	// reachable through it. Members of N which are not in the MPR set
+	// and have a non-zero reachability are kept in buckets, which sort
+	// them by willingness and then by reachability.
+	int stride	= providers.size() + 1;
+	int n_buckets	= (max_willingness + 1) * stride;
+	std::vector<std::vector<int> > buckets(n_buckets);
+	std::vector<int> reachability(N.size());
+	std::vector<int> pos(N.size());
+	for (u_int32_t y = 0; y < N.size(); y++) {
+		reachability[y] = covers[y].size();
+		if (reachability[y] > 0)
+			bucket_insert(buckets, pos,
+				N[y]->willingness() * stride + reachability[y], y);
+	}
+	
 	// 1. Start with an MPR set made of all members of N with
 	// N_willingness equal to WILL_ALWAYS
-	for (nbset_t::iterator it = N.begin(); it != N.end(); it++) {
-		AOLSR_nb_tuple* nb_tuple = *it;
-		if (nb_tuple->willingness() == AOLSR_WILL_ALWAYS)
-			state_.insert_mpr_addr(nb_tuple->nb_main_addr());
-	}
-
-	// 2. Calculate D(y), where y is a member of N, for all nodes in N.
-	// We will do this later.
-
+	std::vector<int> selected;
+	for (u_int32_t y = 0; y < N.size(); y++)
+		if (N[y]->willingness() == AOLSR_WILL_ALWAYS)
+			selected.push_back(y);
+	
 	// 3. Add to the MPR set those nodes in N, which are the *only*
 	// nodes to provide reachability to a node in N2. Remove the
 	// nodes from N2 which are now covered by a node in the MPR set.
-	mprset_t foundset;
-	std::set<nsaddr_t> deleted_addrs;
-	for (nb2hopset_t::iterator it = N2.begin(); it != N2.end(); it++) {
-		AOLSR_nb2hop_tuple* nb2hop_tuple1 = *it;
-
-		mprset_t::iterator pos = foundset.find(nb2hop_tuple1->nb2hop_addr());
-		if (pos != foundset.end())
-			continue;
-
-		bool found = false;
-		for (nbset_t::iterator it2 = N.begin(); it2 != N.end(); it2++) {
-			if ((*it2)->nb_main_addr() == nb2hop_tuple1->nb_main_addr()) {
-				found = true;
-				break;
-			}
-		}
-		if (!found)
-			continue;
-
-		found = false;
-		for (nb2hopset_t::iterator it2 = it + 1; it2 != N2.end(); it2++) {
-			AOLSR_nb2hop_tuple* nb2hop_tuple2 = *it2;
-			if (nb2hop_tuple1->nb2hop_addr() == nb2hop_tuple2->nb2hop_addr()) {
-				foundset.insert(nb2hop_tuple1->nb2hop_addr());// \C1\BD\CC\F8\BDڵ\E3\BF\C9\D3ɶ\E0\CC\F5·\BE\B6\B5\BD\B4\D4\DAfound\BC\AF\BA\CF\D6м\D3\C8\EB\B8ýڵ\E3\B5\D8ַ\A1\A3
-				found = true;// \CC\F8\B3\F6ѭ\BB\B7\A1\A3
-				break;
-			}
-		}
-		if (!found) {
-			state_.insert_mpr_addr(nb2hop_tuple1->nb_main_addr());
-
-			for (nb2hopset_t::iterator it2 = it + 1; it2 != N2.end(); it2++) {
-				AOLSR_nb2hop_tuple* nb2hop_tuple2 = *it2;
-				if (nb2hop_tuple1->nb_main_addr() == nb2hop_tuple2->nb_main_addr()) {
-					deleted_addrs.insert(nb2hop_tuple2->nb2hop_addr());
-					it2 = N2.erase(it2);
-					it2--;
-				}
-			}
-			it = N2.erase(it);
-			it--;
-		}
-
-		for (std::set<nsaddr_t>::iterator it2 = deleted_addrs.begin();
-			it2 != deleted_addrs.end();
-			it2++) {
-			for (nb2hopset_t::iterator it3 = N2.begin();
-				it3 != N2.end();
-				it3++) {
-				if ((*it3)->nb2hop_addr() == *it2) {
-					it3 = N2.erase(it3);
-					it3--;
-					// I have to reset the external iterator because it
-					// may have been invalidated by the latter deletion
-					it = N2.begin();
-					it--;
-				}
-			}
-		}
-		deleted_addrs.clear();
-	}
-
+	for (u_int32_t x = 0; x < providers.size(); x++)
+		if (providers[x].size() == 1)
+			selected.push_back(providers[x][0]);
+	
 	// 4. While there exist nodes in N2 which are not covered by at
 	// least one node in the MPR set:
-	while (N2.begin() != N2.end()) {
-		// 4.1. For each node in N, calculate the reachability, i.e., the
-		// number of nodes in N2 which are not yet covered by at
-		// least one node in the MPR set, and which are reachable
-		// through this 1-hop neighbor
-		map<int, std::vector<AOLSR_nb_tuple*> > reachability;
-		set<int> rs;
-		for (nbset_t::iterator it = N.begin(); it != N.end(); it++) {
-			AOLSR_nb_tuple* nb_tuple = *it;
-			int r = 0;
-			for (nb2hopset_t::iterator it2 = N2.begin(); it2 != N2.end(); it2++) {
-				AOLSR_nb2hop_tuple* nb2hop_tuple = *it2;
-				if (nb_tuple->nb_main_addr() == nb2hop_tuple->nb_main_addr())
-					r++;
-			}
-			rs.insert(r);
-			reachability[r].push_back(nb_tuple);
+	std::vector<bool> mpr(N.size(), false);
+	std::vector<bool> covered(providers.size(), false);
+	u_int32_t uncovered = providers.size();
+	u_int32_t next = 0;
+	int top = n_buckets - 1;
+	while (next < selected.size() || uncovered > 0) {
+		int max;
+		if (next < selected.size()) {
+			max = selected[next++];
+			if (mpr[max])
+				continue;
 		}
-
-		// 4.2. Select as a MPR the node with highest N_willingness among
-		// the nodes in N with non-zero reachability. In case of
-		// multiple choice select the node which provides
-		// reachability to the maximum number of nodes in N2. In
-		// case of multiple nodes providing the same amount of
-		// reachability, select the node as MPR whose D(y) is
-		// greater. Remove the nodes from N2 which are now covered
-		// by a node in the MPR set.
-		AOLSR_nb_tuple* max = NULL;
-		int max_r = 0;
-		for (set<int>::iterator it = rs.begin(); it != rs.end(); it++) {
-			int r = *it;
-			if (r > 0) {
-				for (std::vector<AOLSR_nb_tuple*>::iterator it2 = reachability[r].begin();
-					it2 != reachability[r].end();
-					it2++) {
-					AOLSR_nb_tuple* nb_tuple = *it2;
-					if (max == NULL || nb_tuple->willingness() > max->willingness()) {
-						max = nb_tuple;
-						max_r = r;
-					}
-					else if (nb_tuple->willingness() == max->willingness()) {
-						if (r > max_r) {
-							max = nb_tuple;
-							max_r = r;
-						}
-						else if (r == max_r) {
-							if (degree(nb_tuple) > degree(max)) {
-								max = nb_tuple;
-								max_r = r;
-							}
-						}
-					}
-				}
+		else {
+			// 4.2. Select as a MPR the node with highest N_willingness among
+			// the nodes in N with non-zero reachability. In case of
+			// multiple choice select the node which provides
+			// reachability to the maximum number of nodes in N2. In
+			// case of multiple nodes providing the same amount of
+			// reachability, select the node as MPR whose D(y) is
+			// greater.
+			while (buckets[top].empty())
+				top--;
+			max = buckets[top][0];
+			for (u_int32_t i = 1; i < buckets[top].size(); i++) {
+				int y = buckets[top][i];
+				if (degree[y] > degree[max] || (degree[y] == degree[max] && y < max))
+					max = y;
 			}
 		}
-		if (max != NULL) {
-			state_.insert_mpr_addr(max->nb_main_addr());
-			std::set<nsaddr_t> nb2hop_addrs;
-			for (nb2hopset_t::iterator it = N2.begin(); it != N2.end(); it++) {
-				AOLSR_nb2hop_tuple* nb2hop_tuple = *it;
-				if (nb2hop_tuple->nb_main_addr() == max->nb_main_addr()) {
-					nb2hop_addrs.insert(nb2hop_tuple->nb2hop_addr());
-					it = N2.erase(it);
-					it--;
-				}
-			}
-			for (nb2hopset_t::iterator it = N2.begin(); it != N2.end(); it++) {
-				AOLSR_nb2hop_tuple* nb2hop_tuple = *it;
-				std::set<nsaddr_t>::iterator it2 =
-					nb2hop_addrs.find(nb2hop_tuple->nb2hop_addr());
-				if (it2 != nb2hop_addrs.end()) {
-					it = N2.erase(it);
-					it--;
-				}
+		
+		mpr[max] = true;
+		state_.insert_mpr_addr(N[max]->nb_main_addr());
+		if (reachability[max] > 0)
+			bucket_erase(buckets, pos,
+				N[max]->willingness() * stride + reachability[max], max);
+		
+		// Remove the nodes from N2 which are now covered by a node in the
+		// MPR set, and update the reachability of the nodes they are
+		// reachable through.
+		for (u_int32_t i = 0; i < covers[max].size(); i++) {
+			int x = covers[max][i];
+			if (covered[x])
+				continue;
+			covered[x] = true;
+			uncovered--;
+			for (u_int32_t j = 0; j < providers[x].size(); j++) {
+				int y = providers[x][j];
+				int b = N[y]->willingness() * stride + reachability[y];
+				reachability[y]--;
+				if (mpr[y])
+					continue;
+				bucket_erase(buckets, pos, b, y);
+				if (reachability[y] > 0)
+					bucket_insert(buckets, pos, b - 1, y);
 			}
 		}
 	}
@@ -1373,40 +1524,33 @@ AOLSR::enque_msg(AOLSR_msg& msg, double delay) {
 /// \brief Creates as many %AOLSR packets as needed in order to send all buffered
 /// %AOLSR messages.
 ///
-/// Maximum number of messages which can be contained in an %AOLSR packet is
-/// dictated by AOLSR_MAX_MSGS constant.
+/// Messages are bundled in order, as long as the length of the packet does
+/// not exceed max_pkt_size_ bytes. A longer message is sent on its own.
 ///
 void
 AOLSR::send_pkt() {
-	int num_msgs = msgs_.size();
-	if (num_msgs == 0)
-		return;
-
-	// Calculates the number of needed packets
-	int num_pkts = (num_msgs%AOLSR_MAX_MSGS == 0) ? num_msgs / AOLSR_MAX_MSGS :
-		(num_msgs / AOLSR_MAX_MSGS + 1);
-
-	for (int i = 0; i < num_pkts; i++) {
-		Packet* p = allocpkt();
+	u_int32_t i = 0;
+	while (i < msgs_.size()) {
+		// msgs_[first..i) are bundled in the packet
+		u_int32_t first = i;
+		u_int16_t pkt_len = AOLSR_PKT_HDR_SIZE;
+		do {
+			pkt_len += msgs_[i].size();
+			i++;
+		} while (i < msgs_.size() &&
+			pkt_len + msgs_[i].size() <= (u_int32_t)max_pkt_size_);
+
+		Packet* p = allocpkt(pkt_len - AOLSR_PKT_HDR_SIZE);
 		struct hdr_cmn* ch = HDR_CMN(p);
 		struct hdr_ip* ih = HDR_IP(p);
 		AOLSR_pkt* op = PKT_AOLSR(p);
 
-		op->pkt_len() = AOLSR_PKT_HDR_SIZE;
+		op->pkt_len() = pkt_len;
 		op->pkt_seq_num() = pkt_seq();
-
-		int j = 0;
-		for (std::vector<AOLSR_msg>::iterator it = msgs_.begin(); it != msgs_.end(); it++) {
-			if (j == AOLSR_MAX_MSGS)
-				break;
-
-			op->pkt_body_[j++] = *it;
-			op->count = j;
-			op->pkt_len() += (*it).size();
-
-			it = msgs_.erase(it);
-			it--;
-		}
+		op->count = i - first;
+		unsigned char* buf = p->accessdata();
+		for (u_int32_t j = first; j < i; j++)
+			buf += AOLSR_pkt::put_msg(buf, msgs_[j]);
 
 		ch->ptype() = PT_AOLSR;
 		ch->direction() = hdr_cmn::DOWN;
@@ -1427,6 +1571,7 @@ AOLSR::send_pkt() {
 
 		Scheduler::instance().schedule(target_, p, 0.0);
 	}
+	msgs_.clear();
 }
 
 ///
@@ -1687,8 +1832,10 @@ AOLSR::populate_nbset(AOLSR_msg& msg) {
 	AOLSR_hello& hello = msg.hello();
 
 	AOLSR_nb_tuple* nb_tuple = state_.find_nb_tuple(msg.orig_addr());
-	if (nb_tuple != NULL)
+	if (nb_tuple != NULL && nb_tuple->willingness() != hello.willingness()) {
 		nb_tuple->willingness() = hello.willingness();
+		state_.nbhood_changed();
+	}
 }
 
 ///
@@ -2016,6 +2163,7 @@ AOLSR::updated_link_tuple(AOLSR_link_tuple* tuple) {
 		if (nb_state != nb_tuple->status())
 		{
 			//added \D6ܼҼ\D2
+			state_.nbhood_changed();
 			AOLSR::MS() = AOLSR::MS() + 1;//added \D6ܼҼ\D2
 			printf("state changed from %d to %d \n",nb_state,nb_tuple->status());
 		}
@@ -2223,27 +2371,6 @@ AOLSR::seq_num_bigger_than(u_int16_t s1, u_int16_t s2) {
 		|| (s2 > s1 && s2 - s1 > AOLSR_MAX_SEQ_NUM / 2);
 }
 
-///
-/// \brief This auxiliary function (defined in RFC 3626) is used for calculating the MPR Set.
-///
-/// \param tuple the neighbor tuple which has the main address of the node we are going to calculate its degree to.
-/// \return the degree of the node.
-///
-int
-AOLSR::degree(AOLSR_nb_tuple* tuple) {
-	int degree = 0;
-	for (nb2hopset_t::iterator it = nb2hopset().begin(); it != nb2hopset().end(); it++) {
-		AOLSR_nb2hop_tuple* nb2hop_tuple = *it;
-		if (nb2hop_tuple->nb_main_addr() == tuple->nb_main_addr()) {
-			AOLSR_nb_tuple* nb_tuple =
-				state_.find_nb_tuple(nb2hop_tuple->nb_main_addr());
-			if (nb_tuple == NULL)
-				degree++;
-		}
-	}
-	return degree;
-}
-
 ///
 /// \brief Converts a decimal number of seconds to the mantissa/exponent format.
 ///
@@ -165,6 +165,12 @@
 #define JITTER			(Random::uniform()*AOLSR_MAXJITTER)
 
 
+/// Number of slots of the tuple expiry wheel (must be a power of 2).
+#define AOLSR_WHEEL_SLOTS	64
+/// Time spanned by every slot of the tuple expiry wheel, in seconds.
+#define AOLSR_WHEEL_TICK		0.5
+
+
 class AOLSR;			// forward declaration
 
 
@@ -172,7 +178,7 @@ class AOLSR;			// forward declaration
 
 
 /// Timer for sending an enqued message. ڷϢļʱ
-class AOLSR_MsgTimer : public TimerHandler {
+class AOLSR_MsgTimer : public TimerHandler, public AOLSR_pooled<AOLSR_MsgTimer> {
 public:
 	AOLSR_MsgTimer(AOLSR* agent) : TimerHandler() {
 		agent_ = agent;
@@ -212,15 +218,71 @@ protected:
 };
 
 
+///
+/// \brief Base class of the timers removing the tuples of the repositories.
+///
+/// They are not scheduled on their own: resched() hands them to the expiry
+/// wheel of their agent, which calls expire() once they are due.
+///
+class AOLSR_TupleTimer {
+	friend class AOLSR_ExpiryWheel;
+public:
+	AOLSR_TupleTimer(AOLSR* agent) { agent_ = agent; }
+	virtual ~AOLSR_TupleTimer() {}
+	void		resched(double);
+protected:
+	AOLSR*	agent_;			///< AOLSR agent which created the timer.
+	virtual void expire(Event* e) = 0;
+};
+
+
+///
+/// \brief Timer which expires all the tuple timers of an agent.
+///
+/// Tuple timers are kept in a hashed wheel of AOLSR_WHEEL_SLOTS slots, each
+/// one spanning AOLSR_WHEEL_TICK seconds, so only this handler is known by
+/// the scheduler. It is scheduled at the time of the earliest tuple timer,
+/// and then expires every due one, in the order the scheduler would have
+/// dispatched them.
+///
+class AOLSR_ExpiryWheel : public TimerHandler {
+	/// A tuple timer and the time at which it is due.
+	struct entry {
+		double			time_;
+		long			tick_;	///< Number of the slot, counting from time 0.
+		u_int32_t		seq_;	///< Order of scheduling.
+		AOLSR_TupleTimer*	timer_;
+
+		inline bool operator<(const entry& e) const {
+			return time_ < e.time_ || (time_ == e.time_ && seq_ < e.seq_);
+		}
+	};
+
+	std::vector<entry>	slots_[AOLSR_WHEEL_SLOTS];
+	std::vector<entry>	due_;		///< Timers being expired.
+	long			cursor_;	///< No timer lies in a slot before this one.
+	u_int32_t		size_;		///< Number of timers in the wheel.
+	u_int32_t		seq_;		///< Order of the next timer to be scheduled.
+	double			next_;		///< Time of the earliest timer, or -1.
+	bool			sweeping_;	///< Whether due timers are being expired.
+
+	void		reschedule();
+public:
+	AOLSR_ExpiryWheel();
+	void		schedule(AOLSR_TupleTimer*, double);
+	inline u_int32_t	size() { return size_; }
+protected:
+	virtual void expire(Event* e);
+};
+
+
 /// Timer for removing duplicate tuples: AOLSR_dup_tuple.
-class AOLSR_DupTupleTimer : public TimerHandler {
+class AOLSR_DupTupleTimer : public AOLSR_TupleTimer, public AOLSR_pooled<AOLSR_DupTupleTimer> {
 public:
-	AOLSR_DupTupleTimer(AOLSR* agent, AOLSR_dup_tuple* tuple) : TimerHandler() {
-		agent_ = agent;
+	AOLSR_DupTupleTimer(AOLSR* agent, AOLSR_dup_tuple* tuple) : AOLSR_TupleTimer(agent) {
 		tuple_ = tuple;
 	}
 protected:
-	AOLSR*		agent_;	///< AOLSR agent which created the timer.
 	AOLSR_dup_tuple*	tuple_;	///< AOLSR_dup_tuple which must be removed.
 
 	virtual void expire(Event* e);
@@ -228,7 +290,7 @@ protected:
 
 
 /// Timer for removing link tuples: AOLSR_link_tuple.
-class AOLSR_LinkTupleTimer : public TimerHandler {
+class AOLSR_LinkTupleTimer : public AOLSR_TupleTimer, public AOLSR_pooled<AOLSR_LinkTupleTimer> {
 	///
 	/// \brief A flag which tells if the timer has expired (at least) once or not.
 	///
@@ -238,13 +300,11 @@ class AOLSR_LinkTupleTimer : public TimerHandler {
 	///
 	bool			first_time_;
 public:
-	AOLSR_LinkTupleTimer(AOLSR* agent, AOLSR_link_tuple* tuple) : TimerHandler() {
-		agent_ = agent;
+	AOLSR_LinkTupleTimer(AOLSR* agent, AOLSR_link_tuple* tuple) : AOLSR_TupleTimer(agent) {
 		tuple_ = tuple;
 		first_time_ = true;
 	}
 protected:
-	AOLSR*			agent_;	///< AOLSR agent which created the timer.
 	AOLSR_link_tuple*	tuple_;	///< AOLSR_link_tuple which must be removed.
 
 	virtual void expire(Event* e);
@@ -252,14 +312,12 @@ protected:
 
 
 /// Timer for removing nb2hop tuples: AOLSR_nb2hop_tuple.
-class AOLSR_Nb2hopTupleTimer : public TimerHandler {
+class AOLSR_Nb2hopTupleTimer : public AOLSR_TupleTimer, public AOLSR_pooled<AOLSR_Nb2hopTupleTimer> {
 public:
-	AOLSR_Nb2hopTupleTimer(AOLSR* agent, AOLSR_nb2hop_tuple* tuple) : TimerHandler() {
-		agent_ = agent;
+	AOLSR_Nb2hopTupleTimer(AOLSR* agent, AOLSR_nb2hop_tuple* tuple) : AOLSR_TupleTimer(agent) {
 		tuple_ = tuple;
 	}
 protected:
-	AOLSR*			agent_;	///< AOLSR agent which created the timer.
 	AOLSR_nb2hop_tuple*	tuple_;	///< AOLSR_nb2hop_tuple which must be removed.
 
 	virtual void expire(Event* e);
@@ -267,14 +325,12 @@ protected:
 
 
 /// Timer for removing MPR selector tuples: AOLSR_mprsel_tuple.
-class AOLSR_MprSelTupleTimer : public TimerHandler {
+class AOLSR_MprSelTupleTimer : public AOLSR_TupleTimer, public AOLSR_pooled<AOLSR_MprSelTupleTimer> {
 public:
-	AOLSR_MprSelTupleTimer(AOLSR* agent, AOLSR_mprsel_tuple* tuple) : TimerHandler() {
-		agent_ = agent;
+	AOLSR_MprSelTupleTimer(AOLSR* agent, AOLSR_mprsel_tuple* tuple) : AOLSR_TupleTimer(agent) {
 		tuple_ = tuple;
 	}
 protected:
-	AOLSR*			agent_;	///< AOLSR agent which created the timer.
 	AOLSR_mprsel_tuple*	tuple_;	///< AOLSR_mprsel_tuple which must be removed.
 
 	virtual void expire(Event* e);
@@ -282,14 +338,12 @@ protected:
 
 
 /// Timer for removing topology tuples: AOLSR_topology_tuple.
-class AOLSR_TopologyTupleTimer : public TimerHandler {
+class AOLSR_TopologyTupleTimer : public AOLSR_TupleTimer, public AOLSR_pooled<AOLSR_TopologyTupleTimer> {
 public:
-	AOLSR_TopologyTupleTimer(AOLSR* agent, AOLSR_topology_tuple* tuple) : TimerHandler() {
-		agent_ = agent;
+	AOLSR_TopologyTupleTimer(AOLSR* agent, AOLSR_topology_tuple* tuple) : AOLSR_TupleTimer(agent) {
 		tuple_ = tuple;
 	}
 protected:
-	AOLSR*			agent_;	///< AOLSR agent which created the timer.
 	AOLSR_topology_tuple*	tuple_;	///< AOLSR_topology_tuple which must be removed.
 
 	virtual void expire(Event* e);
@@ -297,14 +351,12 @@ protected:
 
 
 /// Timer for removing interface association tuples: AOLSR_iface_assoc_tuple.
-class AOLSR_IfaceAssocTupleTimer : public TimerHandler {
+class AOLSR_IfaceAssocTupleTimer : public AOLSR_TupleTimer, public AOLSR_pooled<AOLSR_IfaceAssocTupleTimer> {
 public:
-	AOLSR_IfaceAssocTupleTimer(AOLSR* agent, AOLSR_iface_assoc_tuple* tuple) : TimerHandler() {
-		agent_ = agent;
+	AOLSR_IfaceAssocTupleTimer(AOLSR* agent, AOLSR_iface_assoc_tuple* tuple) : AOLSR_TupleTimer(agent) {
 		tuple_ = tuple;
 	}
 protected:
-	AOLSR*			agent_;	///< AOLSR agent which created the timer.
 	AOLSR_iface_assoc_tuple*	tuple_;	///< AOLSR_iface_assoc_tuple which must be removed.
 
 	virtual void expire(Event* e);
@@ -332,6 +384,7 @@ class AOLSR : public Agent {
 	friend class AOLSR_MprSelTupleTimer;
 	friend class AOLSR_TopologyTupleTimer;
 	friend class AOLSR_IfaceAssocTupleTimer;
+	friend class AOLSR_TupleTimer;
 	friend class AOLSR_MsgTimer;
 
 	/// Address of the routing agent.
@@ -394,6 +447,10 @@ CMUPriQueue *ifq;
 	AOLSR_state		state_;
 	/// A list of pending messages which are buffered awaiting for being sent.
 	std::vector<AOLSR_msg>	msgs_;
+	/// Maximum length (in bytes) of the %AOLSR packets bundling buffered messages.
+	int			max_pkt_size_;
+	/// Version of the neighborhood the MPR Set was computed for.
+	u_int32_t		mpr_version_;
 
 protected:
 	PortClassifier*	dmux_;		///< For passing packets up to agents.
@@ -402,6 +459,7 @@ protected:
 	AOLSR_HelloTimer	hello_timer_;	///< Timer for sending HELLO messages.
 	AOLSR_TcTimer	tc_timer_;	///< Timer for sending TC messages.
 	AOLSR_MidTimer	mid_timer_;	///< Timer for sending MID messages.
+	AOLSR_ExpiryWheel	expiry_wheel_;	///< Timer removing the expired tuples.
 
 	/// Increments packet sequence number and returns the new value.
 	inline u_int16_t	pkt_seq() {
@@ -504,7 +562,6 @@ protected:
 	void		rm_ifaceassoc_tuple(AOLSR_iface_assoc_tuple*);
 
 	nsaddr_t	get_main_addr(nsaddr_t);
-	int		degree(AOLSR_nb_tuple*);
 
 	static bool	seq_num_bigger_than(u_int16_t, u_int16_t);
 
@@ -91,10 +91,12 @@ AOLSR_printer::print_ip_hdr(FILE* out, struct hdr_ip* ih) {
 /// \brief Prints a given AOLSR packet into a given file.
 /// \warning This function is actually not used.
 /// \param out	File where the %AOLSR packet is going to be written.
-/// \param pkt	%AOLSR packet to be written.
+/// \param p	packet whose %AOLSR header and messages are going to be written.
 ///
 void
-AOLSR_printer::print_aolsr_pkt(FILE* out, AOLSR_pkt* pkt) {
+AOLSR_printer::print_aolsr_pkt(FILE* out, Packet* p) {
+	AOLSR_pkt* pkt = PKT_AOLSR(p);
+	AOLSR_msg msg;
 
 	fprintf(out,
 		"  AOLSR PACKET\n\tlength = %d\n\tseq_num = %d\n\t------------\n",
@@ -102,7 +104,8 @@ AOLSR_printer::print_aolsr_pkt(FILE* out, AOLSR_pkt* pkt) {
 		pkt->pkt_seq_num());
 
 	for (int i = 0; i < pkt->count; i++) {
-		print_aolsr_msg(out, pkt->msg(i));
+		AOLSR_pkt::get_msg(p, i, msg);
+		print_aolsr_msg(out, msg);
 		fprintf(out, "\t------------\n");
 	}
 	fprintf(out, "\n");
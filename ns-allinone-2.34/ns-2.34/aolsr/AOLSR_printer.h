@@ -45,7 +45,7 @@ protected:
 	static void	print_mprselset(Trace*, mprselset_t&);
 	static void	print_topologyset(Trace*, topologyset_t&);
 
-	static void	print_aolsr_pkt(FILE*, AOLSR_pkt*);
+	static void	print_aolsr_pkt(FILE*, Packet*);
 	static void	print_aolsr_msg(FILE*, AOLSR_msg&);
 	static void	print_aolsr_hello(FILE*, AOLSR_hello&);
 	static void	print_aolsr_tc(FILE*, AOLSR_tc&);
@@ -29,9 +29,10 @@
 #include <set>
 #include <vector>
 #include <config.h>
+#include <aolsr/AOLSR_pool.h>
 
 /// An %AOLSR's routing table entry. // ·ɱĿ
-typedef struct AOLSR_rt_entry {
+typedef struct AOLSR_rt_entry : public AOLSR_pooled<AOLSR_rt_entry> {
 	nsaddr_t	dest_addr_;	///< Address of the destination node.
 	nsaddr_t	next_addr_;	///< Address of the next hop.
 	nsaddr_t	iface_addr_;	///< Address of the local interface.
@@ -49,7 +50,7 @@ typedef struct AOLSR_rt_entry {
 } AOLSR_rt_entry;
 
 /// An Interface Association Tuple. //ӿڹԪ
-typedef struct AOLSR_iface_assoc_tuple {
+typedef struct AOLSR_iface_assoc_tuple : public AOLSR_pooled<AOLSR_iface_assoc_tuple> {
 	/// Interface address of a node. //ڵӿڵַ
 	nsaddr_t	iface_addr_;
 	/// Main address of the node. 
@@ -63,7 +64,7 @@ typedef struct AOLSR_iface_assoc_tuple {
 } AOLSR_iface_assoc_tuple;
 
 /// A Link Tuple.
-typedef struct AOLSR_link_tuple {
+typedef struct AOLSR_link_tuple : public AOLSR_pooled<AOLSR_link_tuple> {
 	/// Interface address of the local node.
 	nsaddr_t	local_iface_addr_;
 	/// Interface address of the neighbor node.
@@ -91,7 +92,7 @@ typedef struct AOLSR_link_tuple {
 } AOLSR_link_tuple;
 
 /// A Neighbor Tuple.
-typedef struct AOLSR_nb_tuple {
+typedef struct AOLSR_nb_tuple : public AOLSR_pooled<AOLSR_nb_tuple> {
 	/// Main address of a neighbor node.
 	nsaddr_t nb_main_addr_;
 	/// Neighbor Type and Link Type at the four less significative digits.ھͺ͵ĸλЧ֡
@@ -105,7 +106,7 @@ typedef struct AOLSR_nb_tuple {
 } AOLSR_nb_tuple;
 
 /// A 2-hop Tuple.
-typedef struct AOLSR_nb2hop_tuple {
+typedef struct AOLSR_nb2hop_tuple : public AOLSR_pooled<AOLSR_nb2hop_tuple> {
 	/// Main address of a neighbor.
 	nsaddr_t	nb_main_addr_;
 	/// Main address of a 2-hop neighbor with a symmetric link to nb_main_addr.
@@ -122,7 +123,7 @@ typedef struct AOLSR_nb2hop_tuple {
 } AOLSR_nb2hop_tuple;
 
 /// An MPR-Selector Tuple. 
-typedef struct AOLSR_mprsel_tuple {
+typedef struct AOLSR_mprsel_tuple : public AOLSR_pooled<AOLSR_mprsel_tuple> {
 	/// Main address of a node which have selected this node as a MPR.
 	nsaddr_t	main_addr_;
 	/// Time at which this tuple expires and must be removed.
@@ -132,11 +133,66 @@ typedef struct AOLSR_mprsel_tuple {
 	inline double&		time() { return time_; }
 } AOLSR_mprsel_tuple;
 
+/// Number of addresses an interface list holds without allocating memory.
+#define AOLSR_ADDR_LIST_INLINE	2
+
+///
+/// \brief List of interface addresses.
+///
+/// Nodes have a single interface, so the addresses are stored in the list
+/// itself, and memory is only allocated for longer lists.
+///
+class AOLSR_addr_list {
+	nsaddr_t	inline_[AOLSR_ADDR_LIST_INLINE];
+	nsaddr_t*	addrs_;		///< inline_, unless the list is longer.
+	u_int32_t	size_;
+	u_int32_t	capacity_;
+
+public:
+	typedef nsaddr_t*	iterator;
+
+	AOLSR_addr_list() : addrs_(inline_), size_(0), capacity_(AOLSR_ADDR_LIST_INLINE) {}
+	AOLSR_addr_list(const AOLSR_addr_list& l) :
+		addrs_(inline_), size_(0), capacity_(AOLSR_ADDR_LIST_INLINE) {
+		*this = l;
+	}
+	~AOLSR_addr_list() {
+		if (addrs_ != inline_)
+			delete[] addrs_;
+	}
+
+	AOLSR_addr_list& operator=(const AOLSR_addr_list& l) {
+		if (this != &l) {
+			size_ = 0;
+			for (u_int32_t i = 0; i < l.size_; i++)
+				push_back(l.addrs_[i]);
+		}
+		return *this;
+	}
+
+	inline iterator		begin()		{ return addrs_; }
+	inline iterator		end()		{ return addrs_ + size_; }
+	inline u_int32_t	size() const	{ return size_; }
+
+	void push_back(nsaddr_t addr) {
+		if (size_ == capacity_) {
+			nsaddr_t* addrs = new nsaddr_t[2 * capacity_];
+			for (u_int32_t i = 0; i < size_; i++)
+				addrs[i] = addrs_[i];
+			if (addrs_ != inline_)
+				delete[] addrs_;
+			addrs_		= addrs;
+			capacity_	*= 2;
+		}
+		addrs_[size_++] = addr;
+	}
+};
+
 /// The type "list of interface addresses"
-typedef std::vector<nsaddr_t> addr_list_t;
+typedef AOLSR_addr_list addr_list_t;
 
 /// A Duplicate TupleһظԪ
-typedef struct AOLSR_dup_tuple {
+typedef struct AOLSR_dup_tuple : public AOLSR_pooled<AOLSR_dup_tuple> {
 	/// Originator address of the message.
 	nsaddr_t	addr_;
 	/// Message sequence number.
@@ -156,7 +212,7 @@ typedef struct AOLSR_dup_tuple {
 } AOLSR_dup_tuple;
 
 /// A Topology Tuple Ԫ
-typedef struct AOLSR_topology_tuple {
+typedef struct AOLSR_topology_tuple : public AOLSR_pooled<AOLSR_topology_tuple> {
 	/// Main address of the destination.ĿĵصҪַ
 	nsaddr_t	dest_addr_;
 	/// Main address of a node which is a neighbor of the destination.Ŀĵصھӽڵַ
@@ -27,6 +27,7 @@
 #define __AOLSR_state_h__
 
 #include <aolsr/AOLSR_repositories.h>
+#include <aolsr/AOLSR_hash.h>
 
 /// This class encapsulates all data structures needed for maintaining internal state of an AOLSR node.
 class AOLSR_state {
@@ -41,7 +42,35 @@ class AOLSR_state {
 	dupset_t	dupset_;	///< Duplicate Set (RFC 3626, section 3.4).
 	ifaceassocset_t	ifaceassocset_;	///< Interface Association Set (RFC 3626, section 4.1).
 
+	/// Tuples of the repositories by key, see AOLSR_hash.h.
+	AOLSR_index<nsaddr_t, AOLSR_mprsel_tuple>	mprsel_index_;	///< By main address.
+	AOLSR_index<nsaddr_t, AOLSR_nb_tuple>		nb_index_;	///< By main address.
+	/// By neighbor and 2-hop neighbor main addresses.
+	AOLSR_index<std::pair<nsaddr_t, nsaddr_t>, AOLSR_nb2hop_tuple>	nb2hop_index_;
+	/// By originator address and sequence number.
+	AOLSR_index<std::pair<nsaddr_t, u_int16_t>, AOLSR_dup_tuple>	dup_index_;
+	AOLSR_index<nsaddr_t, AOLSR_link_tuple>		link_index_;	///< By neighbor interface address.
+	/// By destination and last hop addresses.
+	AOLSR_index<std::pair<nsaddr_t, nsaddr_t>, AOLSR_topology_tuple>	topology_index_;
+	/// Topology tuples of every last hop address, in repository order.
+	AOLSR_hash<nsaddr_t, topologyset_t>	topology_last_index_;
+	AOLSR_index<nsaddr_t, AOLSR_iface_assoc_tuple>	ifaceassoc_index_;	///< By interface address.
+
+	/// Number of changes of the Neighbor Set and the 2-hop Neighbor Set.
+	u_int32_t	nbhood_version_;
+
+	void			unindex_topology_tuple(AOLSR_topology_tuple*);
+
+public:
+	AOLSR_state();
+
 protected:
+	/// Gives the number of changes of the neighborhood, which tells whether
+	/// it has changed since a given time.
+	inline	u_int32_t		nbhood_version()	{ return nbhood_version_; }
+	/// Must be called when a neighbor tuple is modified.
+	inline	void			nbhood_changed()	{ nbhood_version_++; }
+
 	inline	linkset_t&		linkset() { return linkset_; }
 	inline	mprset_t&		mprset() { return mprset_; }
 	inline	mprselset_t&		mprselset() { return mprselset_; }
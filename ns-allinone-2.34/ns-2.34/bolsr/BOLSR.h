@@ -161,6 +161,12 @@
 #define JITTER			(Random::uniform()*BOLSR_MAXJITTER)
 
 
+/// Number of slots of the tuple expiry wheel (must be a power of 2).
+#define BOLSR_WHEEL_SLOTS	64
+/// Time spanned by every slot of the tuple expiry wheel, in seconds.
+#define BOLSR_WHEEL_TICK		0.5
+
+
 class BOLSR;			// forward declaration
 
 
@@ -168,7 +174,7 @@ class BOLSR;			// forward declaration
 
 
 /// Timer for sending an enqued message.
-class BOLSR_MsgTimer : public TimerHandler {
+class BOLSR_MsgTimer : public TimerHandler, public BOLSR_pooled<BOLSR_MsgTimer> {
 public:
 	BOLSR_MsgTimer(BOLSR* agent) : TimerHandler() {
 		agent_	= agent;
@@ -208,15 +214,71 @@ protected:
 };
 
 
+///
+/// \brief Base class of the timers removing the tuples of the repositories.
+///
+/// They are not scheduled on their own: resched() hands them to the expiry
+/// wheel of their agent, which calls expire() once they are due.
+///
+class BOLSR_TupleTimer {
+	friend class BOLSR_ExpiryWheel;
+public:
+	BOLSR_TupleTimer(BOLSR* agent) { agent_ = agent; }
+	virtual ~BOLSR_TupleTimer() {}
+	void		resched(double);
+protected:
+	BOLSR*	agent_;			///< BOLSR agent which created the timer.
+	virtual void expire(Event* e) = 0;
+};
+
+
+///
+/// \brief Timer which expires all the tuple timers of an agent.
+///
+/// Tuple timers are kept in a hashed wheel of BOLSR_WHEEL_SLOTS slots, each
+/// one spanning BOLSR_WHEEL_TICK seconds, so only this handler is known by
+/// the scheduler. It is scheduled at the time of the earliest tuple timer,
+/// and then expires every due one, in the order the scheduler would have
+/// dispatched them.
+///
+class BOLSR_ExpiryWheel : public TimerHandler {
+	/// A tuple timer and the time at which it is due.
+	struct entry {
+		double			time_;
+		long			tick_;	///< Number of the slot, counting from time 0.
+		u_int32_t		seq_;	///< Order of scheduling.
+		BOLSR_TupleTimer*	timer_;
+
+		inline bool operator<(const entry& e) const {
+			return time_ < e.time_ || (time_ == e.time_ && seq_ < e.seq_);
+		}
+	};
+
+	std::vector<entry>	slots_[BOLSR_WHEEL_SLOTS];
+	std::vector<entry>	due_;		///< Timers being expired.
+	long			cursor_;	///< No timer lies in a slot before this one.
+	u_int32_t		size_;		///< Number of timers in the wheel.
+	u_int32_t		seq_;		///< Order of the next timer to be scheduled.
+	double			next_;		///< Time of the earliest timer, or -1.
+	bool			sweeping_;	///< Whether due timers are being expired.
+
+	void		reschedule();
+public:
+	BOLSR_ExpiryWheel();
+	void		schedule(BOLSR_TupleTimer*, double);
+	inline u_int32_t	size() { return size_; }
+protected:
+	virtual void expire(Event* e);
+};
+
+
 /// Timer for removing duplicate tuples: BOLSR_dup_tuple.
-class BOLSR_DupTupleTimer : public TimerHandler {
+class BOLSR_DupTupleTimer : public BOLSR_TupleTimer, public BOLSR_pooled<BOLSR_DupTupleTimer> {
 public:
-	BOLSR_DupTupleTimer(BOLSR* agent, BOLSR_dup_tuple* tuple) : TimerHandler() {
-		agent_ = agent;
+	BOLSR_DupTupleTimer(BOLSR* agent, BOLSR_dup_tuple* tuple) : BOLSR_TupleTimer(agent) {
 		tuple_ = tuple;
 	}
 protected:
-	BOLSR*		agent_;	///< BOLSR agent which created the timer.
 	BOLSR_dup_tuple*	tuple_;	///< BOLSR_dup_tuple which must be removed.
 	
 	virtual void expire(Event* e);
@@ -224,7 +286,7 @@ protected:
 
 
 /// Timer for removing link tuples: BOLSR_link_tuple.
-class BOLSR_LinkTupleTimer : public TimerHandler {
+class BOLSR_LinkTupleTimer : public BOLSR_TupleTimer, public BOLSR_pooled<BOLSR_LinkTupleTimer> {
 	///
 	/// \brief A flag which tells if the timer has expired (at least) once or not.
 	///
@@ -234,13 +296,11 @@ class BOLSR_LinkTupleTimer : public TimerHandler {
 	///
 	bool			first_time_;
 public:
-	BOLSR_LinkTupleTimer(BOLSR* agent, BOLSR_link_tuple* tuple) : TimerHandler() {
-		agent_		= agent;
+	BOLSR_LinkTupleTimer(BOLSR* agent, BOLSR_link_tuple* tuple) : BOLSR_TupleTimer(agent) {
 		tuple_		= tuple;
 		first_time_	= true;
 	}
 protected:
-	BOLSR*			agent_;	///< BOLSR agent which created the timer.
 	BOLSR_link_tuple*	tuple_;	///< BOLSR_link_tuple which must be removed.
 	
 	virtual void expire(Event* e);
@@ -248,14 +308,12 @@ protected:
 
 
 /// Timer for removing nb2hop tuples: BOLSR_nb2hop_tuple.
-class BOLSR_Nb2hopTupleTimer : public TimerHandler {
+class BOLSR_Nb2hopTupleTimer : public BOLSR_TupleTimer, public BOLSR_pooled<BOLSR_Nb2hopTupleTimer> {
 public:
-	BOLSR_Nb2hopTupleTimer(BOLSR* agent, BOLSR_nb2hop_tuple* tuple) : TimerHandler() {
-		agent_ = agent;
+	BOLSR_Nb2hopTupleTimer(BOLSR* agent, BOLSR_nb2hop_tuple* tuple) : BOLSR_TupleTimer(agent) {
 		tuple_ = tuple;
 	}
 protected:
-	BOLSR*			agent_;	///< BOLSR agent which created the timer.
 	BOLSR_nb2hop_tuple*	tuple_;	///< BOLSR_nb2hop_tuple which must be removed.
 	
 	virtual void expire(Event* e);
@@ -263,14 +321,12 @@ protected:
 
 
 /// Timer for removing MPR selector tuples: BOLSR_mprsel_tuple.
-class BOLSR_MprSelTupleTimer : public TimerHandler {
+class BOLSR_MprSelTupleTimer : public BOLSR_TupleTimer, public BOLSR_pooled<BOLSR_MprSelTupleTimer> {
 public:
-	BOLSR_MprSelTupleTimer(BOLSR* agent, BOLSR_mprsel_tuple* tuple) : TimerHandler() {
-		agent_ = agent;
+	BOLSR_MprSelTupleTimer(BOLSR* agent, BOLSR_mprsel_tuple* tuple) : BOLSR_TupleTimer(agent) {
 		tuple_ = tuple;
 	}
 protected:
-	BOLSR*			agent_;	///< BOLSR agent which created the timer.
 	BOLSR_mprsel_tuple*	tuple_;	///< BOLSR_mprsel_tuple which must be removed.
 	
 	virtual void expire(Event* e);
@@ -278,14 +334,12 @@ protected:
 
 
 /// Timer for removing topology tuples: BOLSR_topology_tuple.
-class BOLSR_TopologyTupleTimer : public TimerHandler {
+class BOLSR_TopologyTupleTimer : public BOLSR_TupleTimer, public BOLSR_pooled<BOLSR_TopologyTupleTimer> {
 public:
-	BOLSR_TopologyTupleTimer(BOLSR* agent, BOLSR_topology_tuple* tuple) : TimerHandler() {
-		agent_ = agent;
+	BOLSR_TopologyTupleTimer(BOLSR* agent, BOLSR_topology_tuple* tuple) : BOLSR_TupleTimer(agent) {
 		tuple_ = tuple;
 	}
 protected:
-	BOLSR*			agent_;	///< BOLSR agent which created the timer.
 	BOLSR_topology_tuple*	tuple_;	///< BOLSR_topology_tuple which must be removed.
 	
 	virtual void expire(Event* e);
@@ -293,14 +347,12 @@ protected:
 
 
 /// Timer for removing interface association tuples: BOLSR_iface_assoc_tuple.
-class BOLSR_IfaceAssocTupleTimer : public TimerHandler {
+class BOLSR_IfaceAssocTupleTimer : public BOLSR_TupleTimer, public BOLSR_pooled<BOLSR_IfaceAssocTupleTimer> {
 public:
-	BOLSR_IfaceAssocTupleTimer(BOLSR* agent, BOLSR_iface_assoc_tuple* tuple) : TimerHandler() {
-		agent_ = agent;
+	BOLSR_IfaceAssocTupleTimer(BOLSR* agent, BOLSR_iface_assoc_tuple* tuple) : BOLSR_TupleTimer(agent) {
 		tuple_ = tuple;
 	}
 protected:
-	BOLSR*			agent_;	///< BOLSR agent which created the timer.
 	BOLSR_iface_assoc_tuple*	tuple_;	///< BOLSR_iface_assoc_tuple which must be removed.
 	
 	virtual void expire(Event* e);
@@ -328,6 +380,7 @@ class BOLSR : public Agent {
 	friend class BOLSR_MprSelTupleTimer;
 	friend class BOLSR_TopologyTupleTimer;
 	friend class BOLSR_IfaceAssocTupleTimer;
+	friend class BOLSR_TupleTimer;
 	friend class BOLSR_MsgTimer;
 	
 	/// Address of the routing agent.
@@ -381,6 +434,8 @@ class BOLSR : public Agent {
 	BOLSR_state		state_;
 	/// A list of pending messages which are buffered awaiting for being sent.
 	std::vector<BOLSR_msg>	msgs_;
+	/// Maximum length (in bytes) of the %BOLSR packets bundling buffered messages.
+	int			max_pkt_size_;
 	
 protected:
 	PortClassifier*	dmux_;		///< For passing packets up to agents.
@@ -389,6 +444,7 @@ protected:
 	BOLSR_HelloTimer	hello_timer_;	///< Timer for sending HELLO messages.
 	BOLSR_TcTimer	tc_timer_;	///< Timer for sending TC messages.
 	BOLSR_MidTimer	mid_timer_;	///< Timer for sending MID messages.
+	BOLSR_ExpiryWheel	expiry_wheel_;	///< Timer removing the expired tuples.
 	
 	/// Increments packet sequence number and returns the new value.
 	inline u_int16_t	pkt_seq() {
@@ -0,0 +1,110 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+///
+/// \file	BOLSR_pool.h
+/// \brief	Slab allocator for the tuples and timers of the BOLSR agents.
+///
+/// Every pooled type has a single pool, shared by all the agents of the
+/// simulation. Objects are carved out of slabs of BOLSR_POOL_SLAB objects,
+/// which are kept until the simulation ends. A freed object is pushed on a
+/// free list linked through its own storage, and is the next one handed out.
+///
+
+#ifndef __BOLSR_pool_h__
+#define __BOLSR_pool_h__
+
+#include <assert.h>
+#include <stddef.h>
+#include <new>
+#include "config.h"
+
+/// Number of objects of a slab.
+#define BOLSR_POOL_SLAB	256
+
+///
+/// \brief Pool of objects of type T.
+///
+template <class T>
+class BOLSR_pool {
+	/// Storage of an object, which links the free list while it is free.
+	union chunk {
+		chunk*		next_;
+		char		object_[sizeof(T)];
+		double		align_;
+	};
+
+	static chunk*		free_;		///< Free list.
+	static u_int32_t	in_use_;	///< Number of objects in use.
+	static u_int32_t	high_water_;	///< Highest number of objects in use.
+	static u_int32_t	capacity_;	///< Number of objects of all the slabs.
+
+	static void grow() {
+		chunk* slab = (chunk*)::operator new(BOLSR_POOL_SLAB * sizeof(chunk));
+		for (int i = BOLSR_POOL_SLAB - 1; i >= 0; i--) {
+			slab[i].next_	= free_;
+			free_		= &slab[i];
+		}
+		capacity_ += BOLSR_POOL_SLAB;
+	}
+
+public:
+	static void* alloc() {
+		if (free_ == NULL)
+			grow();
+		chunk* c	= free_;
+		free_		= c->next_;
+		if (++in_use_ > high_water_)
+			high_water_ = in_use_;
+		return c;
+	}
+
+	static void release(void* p) {
+		if (p == NULL)
+			return;
+		chunk* c	= (chunk*)p;
+		c->next_	= free_;
+		free_		= c;
+		in_use_--;
+	}
+
+	static inline u_int32_t	in_use()	{ return in_use_; }
+	static inline u_int32_t	high_water()	{ return high_water_; }
+	static inline u_int32_t	capacity()	{ return capacity_; }
+};
+
+template <class T> typename BOLSR_pool<T>::chunk*	BOLSR_pool<T>::free_		= NULL;
+template <class T> u_int32_t				BOLSR_pool<T>::in_use_		= 0;
+template <class T> u_int32_t				BOLSR_pool<T>::high_water_	= 0;
+template <class T> u_int32_t				BOLSR_pool<T>::capacity_		= 0;
+
+///
+/// \brief Base class of the pooled types: new and delete take and give back
+/// objects of type T to its pool.
+///
+template <class T>
+struct BOLSR_pooled {
+	static inline void* operator new(size_t size) {
+		assert(size == sizeof(T));
+		return BOLSR_pool<T>::alloc();
+	}
+	static inline void operator delete(void* p) {
+		BOLSR_pool<T>::release(p);
+	}
+};
+
+#endif
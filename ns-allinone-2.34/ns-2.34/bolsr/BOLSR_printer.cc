@@ -91,10 +91,12 @@ BOLSR_printer::print_ip_hdr(FILE* out, struct hdr_ip* ih) {
 /// \brief Prints a given BOLSR packet into a given file.
 /// \warning This function is actually not used.
 /// \param out	File where the %BOLSR packet is going to be written.
-/// \param pkt	%BOLSR packet to be written.
+/// \param p	packet whose %BOLSR header and messages are going to be written.
 ///
 void
-BOLSR_printer::print_bolsr_pkt(FILE* out, BOLSR_pkt* pkt) {
+BOLSR_printer::print_bolsr_pkt(FILE* out, Packet* p) {
+	BOLSR_pkt* pkt = PKT_BOLSR(p);
+	BOLSR_msg msg;
 		
 	fprintf(out,
 		"  BOLSR PACKET\n\tlength = %d\n\tseq_num = %d\n\t------------\n",
@@ -102,7 +104,8 @@ BOLSR_printer::print_bolsr_pkt(FILE* out, BOLSR_pkt* pkt) {
 		pkt->pkt_seq_num());
 	
 	for (int i = 0; i < pkt->count; i++) {
-		print_bolsr_msg(out, pkt->msg(i));
+		BOLSR_pkt::get_msg(p, i, msg);
+		print_bolsr_msg(out, msg);
 		fprintf(out, "\t------------\n");
 	}
 	fprintf(out, "\n");
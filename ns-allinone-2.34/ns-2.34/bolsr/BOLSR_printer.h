@@ -45,7 +45,7 @@ protected:
 	static void	print_mprselset(Trace*, mprselset_t&);
 	static void	print_topologyset(Trace*, topologyset_t&);
 	
-	static void	print_bolsr_pkt(FILE*, BOLSR_pkt*);
+	static void	print_bolsr_pkt(FILE*, Packet*);
 	static void	print_bolsr_msg(FILE*, BOLSR_msg&);
 	static void	print_bolsr_hello(FILE*, BOLSR_hello&);
 	static void	print_bolsr_tc(FILE*, BOLSR_tc&);
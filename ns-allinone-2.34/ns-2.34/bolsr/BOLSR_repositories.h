@@ -29,9 +29,10 @@
 #include <set>
 #include <vector>
 #include <config.h>
+#include <bolsr/BOLSR_pool.h>
 
 /// An %BOLSR's routing table entry.
-typedef struct BOLSR_rt_entry {
+typedef struct BOLSR_rt_entry : public BOLSR_pooled<BOLSR_rt_entry> {
 	nsaddr_t	dest_addr_;	///< Address of the destination node.
 	nsaddr_t	next_addr_;	///< Address of the next hop.
 	nsaddr_t	iface_addr_;	///< Address of the local interface.
@@ -46,7 +47,7 @@ typedef struct BOLSR_rt_entry {
 } BOLSR_rt_entry;
 
 /// An Interface Association Tuple.
-typedef struct BOLSR_iface_assoc_tuple {
+typedef struct BOLSR_iface_assoc_tuple : public BOLSR_pooled<BOLSR_iface_assoc_tuple> {
 	/// Interface address of a node.
 	nsaddr_t	iface_addr_;
 	/// Main address of the node.
@@ -60,7 +61,7 @@ typedef struct BOLSR_iface_assoc_tuple {
 } BOLSR_iface_assoc_tuple;
 
 /// A Link Tuple.
-typedef struct BOLSR_link_tuple {
+typedef struct BOLSR_link_tuple : public BOLSR_pooled<BOLSR_link_tuple> {
 	/// Interface address of the local node.
 	nsaddr_t	local_iface_addr_;
 	/// Interface address of the neighbor node.
@@ -104,7 +105,7 @@ typedef struct BOLSR_link_tuple {
 } BOLSR_link_tuple;
 
 /// A Neighbor Tuple.
-typedef struct BOLSR_nb_tuple {
+typedef struct BOLSR_nb_tuple : public BOLSR_pooled<BOLSR_nb_tuple> {
 	/// Main address of a neighbor node.
 	nsaddr_t nb_main_addr_;
 	/// Neighbor Type and Link Type at the four less significative digits.
@@ -126,7 +127,7 @@ typedef struct BOLSR_nb_tuple {
 } BOLSR_nb_tuple;
 
 /// A 2-hop Tuple.
-typedef struct BOLSR_nb2hop_tuple {
+typedef struct BOLSR_nb2hop_tuple : public BOLSR_pooled<BOLSR_nb2hop_tuple> {
 	/// Main address of a neighbor.
 	nsaddr_t	nb_main_addr_;
 	/// Main address of a 2-hop neighbor with a symmetric link to nb_main_addr.
@@ -143,7 +144,7 @@ typedef struct BOLSR_nb2hop_tuple {
 } BOLSR_nb2hop_tuple;
 
 /// An MPR-Selector Tuple.
-typedef struct BOLSR_mprsel_tuple {
+typedef struct BOLSR_mprsel_tuple : public BOLSR_pooled<BOLSR_mprsel_tuple> {
 	/// Main address of a node which have selected this node as a MPR.
 	nsaddr_t	main_addr_;
 	/// Time at which this tuple expires and must be removed.
@@ -153,11 +154,66 @@ typedef struct BOLSR_mprsel_tuple {
 	inline double&		time()		{ return time_; }
 } BOLSR_mprsel_tuple;
 
+/// Number of addresses an interface list holds without allocating memory.
+#define BOLSR_ADDR_LIST_INLINE	2
+
+///
+/// \brief List of interface addresses.
+///
+/// Nodes have a single interface, so the addresses are stored in the list
+/// itself, and memory is only allocated for longer lists.
+///
+class BOLSR_addr_list {
+	nsaddr_t	inline_[BOLSR_ADDR_LIST_INLINE];
+	nsaddr_t*	addrs_;		///< inline_, unless the list is longer.
+	u_int32_t	size_;
+	u_int32_t	capacity_;
+
+public:
+	typedef nsaddr_t*	iterator;
+
+	BOLSR_addr_list() : addrs_(inline_), size_(0), capacity_(BOLSR_ADDR_LIST_INLINE) {}
+	BOLSR_addr_list(const BOLSR_addr_list& l) :
+		addrs_(inline_), size_(0), capacity_(BOLSR_ADDR_LIST_INLINE) {
+		*this = l;
+	}
+	~BOLSR_addr_list() {
+		if (addrs_ != inline_)
+			delete[] addrs_;
+	}
+
+	BOLSR_addr_list& operator=(const BOLSR_addr_list& l) {
+		if (this != &l) {
+			size_ = 0;
+			for (u_int32_t i = 0; i < l.size_; i++)
+				push_back(l.addrs_[i]);
+		}
+		return *this;
+	}
+
+	inline iterator		begin()		{ return addrs_; }
+	inline iterator		end()		{ return addrs_ + size_; }
+	inline u_int32_t	size() const	{ return size_; }
+
+	void push_back(nsaddr_t addr) {
+		if (size_ == capacity_) {
+			nsaddr_t* addrs = new nsaddr_t[2 * capacity_];
+			for (u_int32_t i = 0; i < size_; i++)
+				addrs[i] = addrs_[i];
+			if (addrs_ != inline_)
+				delete[] addrs_;
+			addrs_		= addrs;
+			capacity_	*= 2;
+		}
+		addrs_[size_++] = addr;
+	}
+};
+
 /// The type "list of interface addresses"
-typedef std::vector<nsaddr_t> addr_list_t;
+typedef BOLSR_addr_list addr_list_t;
 
 /// A Duplicate Tuple
-typedef struct BOLSR_dup_tuple {
+typedef struct BOLSR_dup_tuple : public BOLSR_pooled<BOLSR_dup_tuple> {
 	/// Originator address of the message.
 	nsaddr_t	addr_;
 	/// Message sequence number.
@@ -177,7 +233,7 @@ typedef struct BOLSR_dup_tuple {
 } BOLSR_dup_tuple;
 
 /// A Topology Tuple
-typedef struct BOLSR_topology_tuple {
+typedef struct BOLSR_topology_tuple : public BOLSR_pooled<BOLSR_topology_tuple> {
 	/// Main address of the destination.
 	nsaddr_t	dest_addr_;
 	/// Main address of a node which is a neighbor of the destination.
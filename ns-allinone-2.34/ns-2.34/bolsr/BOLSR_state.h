@@ -27,6 +27,7 @@
 #define __BOLSR_state_h__
 
 #include <bolsr/BOLSR_repositories.h>
+#include <bolsr/BOLSR_hash.h>
 
 /// This class encapsulates all data structures needed for maintaining internal state of an BOLSR node.
 class BOLSR_state {
@@ -40,6 +41,25 @@ class BOLSR_state {
 	mprselset_t	mprselset_;	///< MPR Selector Set (RFC 3626, section 4.3.4).
 	dupset_t	dupset_;	///< Duplicate Set (RFC 3626, section 3.4).
 	ifaceassocset_t	ifaceassocset_;	///< Interface Association Set (RFC 3626, section 4.1).
+
+	/// Tuples of the repositories by key, see BOLSR_hash.h.
+	BOLSR_index<nsaddr_t, BOLSR_mprsel_tuple>	mprsel_index_;	///< By main address.
+	BOLSR_index<nsaddr_t, BOLSR_nb_tuple>		nb_index_;	///< By main address.
+	/// By neighbor and 2-hop neighbor main addresses.
+	BOLSR_index<std::pair<nsaddr_t, nsaddr_t>, BOLSR_nb2hop_tuple>	nb2hop_index_;
+	/// By originator address and sequence number.
+	BOLSR_index<std::pair<nsaddr_t, u_int16_t>, BOLSR_dup_tuple>	dup_index_;
+	BOLSR_index<nsaddr_t, BOLSR_link_tuple>		link_index_;	///< By neighbor interface address.
+	/// By destination and last hop addresses.
+	BOLSR_index<std::pair<nsaddr_t, nsaddr_t>, BOLSR_topology_tuple>	topology_index_;
+	/// Topology tuples of every last hop address, in repository order.
+	BOLSR_hash<nsaddr_t, topologyset_t>	topology_last_index_;
+	BOLSR_index<nsaddr_t, BOLSR_iface_assoc_tuple>	ifaceassoc_index_;	///< By interface address.
+
+	void			unindex_topology_tuple(BOLSR_topology_tuple*);
+
+public:
+	BOLSR_state();
 	
 protected:
 	inline	linkset_t&		linkset()	{ return linkset_; }
@@ -0,0 +1,356 @@
+/* -*-  Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+
+/*
+ * ladder-scheduler.cc
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/**
+ *
+ * Scheduler based on a ladder queue.
+ *
+ * W. T. Tang, R. S. M. Goh and I. L.-J. Thng. Ladder queue: An O(1)
+ * priority queue structure for large-scale discrete event
+ * simulation. ACM Transactions on Modeling and Computer Simulation,
+ * 15(3):175--204, 2005.
+ *
+ * Basic idea of this scheduler: events far in the future are appended,
+ * unsorted, to the top list.  When the events before them have all been
+ * dispatched, the top list is spread over the buckets of a rung, whose
+ * width is chosen from the number of events and the times they span.
+ * The buckets are then handed down in time order: a bucket of at most
+ * LADDER_THRES events is sorted into the bottom list, from which events
+ * are dequeued, and a larger one is spread over a finer rung in turn.
+ * A rung spans the whole bucket it was spread from, so that the events
+ * scheduled into that bucket later are spread over it too.  As every
+ * rung is sized from the events it receives, the queue adapts
+ * to skewed time distributions without ever resizing all of it, and
+ * insert() and deque() take O(1) amortized time.
+ *
+ * Implementation notes: all the lists are linked through Event::next_
+ * and Event::prev_.  Where an event goes only depends on its time and
+ * on how far the rungs have been handed down (see locate()), so events
+ * with the same time always end up in the same list, and as events are
+ * only ever appended to or merged stably into lists, they are dispatched
+ * in the order they were scheduled.  cancel() finds the list of an event
+ * the same way.  A bucket is sorted into the bottom list by a merge
+ * sort, and an insert into the bottom list scans it from its tail; the
+ * bottom list is spread over a new rung when it grows beyond
+ * LADDER_THRES events.  lookup() scans all the lists.
+ **/
+#include <scheduler.h>
+#include <assert.h>
+
+
+static class LadderSchedulerClass : public TclClass
+{
+public:
+        LadderSchedulerClass() : TclClass("Scheduler/Ladder") {}
+        TclObject* create(int /* argc */, const char*const* /* argv */) {
+                return (new LadderScheduler);
+        }
+} class_ladder_sched;
+
+LadderScheduler::LadderScheduler() : topmax_(0), toplimit_(0),
+	nrungs_(0)
+{
+	top_.head_ = top_.tail_ = 0;
+	top_.count_ = 0;
+	bottom_.head_ = bottom_.tail_ = 0;
+	bottom_.count_ = 0;
+	for (int i = 0; i < LADDER_MAX_RUNGS; i++) {
+		rungs_[i].nbuckets_ = rungs_[i].cur_ = rungs_[i].size_ = 0;
+		rungs_[i].buckets_ = 0;
+	}
+}
+
+LadderScheduler::~LadderScheduler()
+{
+	for (int i = 0; i < LADDER_MAX_RUNGS; i++)
+		delete [] rungs_[i].buckets_;
+}
+
+void
+LadderScheduler::append(Bucket* b, Event* e)
+{
+	e->next_ = 0;
+	e->prev_ = b->tail_;
+	if (b->tail_)
+		b->tail_->next_ = e;
+	else
+		b->head_ = e;
+	b->tail_ = e;
+	b->count_++;
+}
+
+void
+LadderScheduler::unlink(Bucket* b, Event* e)
+{
+	if (e->prev_)
+		e->prev_->next_ = e->next_;
+	else
+		b->head_ = e->next_;
+	if (e->next_)
+		e->next_->prev_ = e->prev_;
+	else
+		b->tail_ = e->prev_;
+	b->count_--;
+}
+
+/*
+ * The list which holds, or is to hold, the events of time t: the top
+ * list beyond toplimit_, else the bucket of the first rung which has not
+ * been handed down that far yet, else the bottom list.  The top list
+ * holds all the events while the rest of the ladder is empty.
+ */
+LadderScheduler::Bucket*
+LadderScheduler::locate(double t)
+{
+	if (t > toplimit_ || (nrungs_ == 0 && bottom_.count_ == 0))
+		return (&top_);
+	for (int x = 0; x < nrungs_; x++) {
+		Rung& r = rungs_[x];
+		int i = r.index(t);
+		if (i >= r.cur_)
+			return (&r.buckets_[i]);
+	}
+	return (&bottom_);
+}
+
+/*
+ * Spreads the events of b over a new rung below the others, keeping
+ * their order in every bucket.  The rung spans from the first event of
+ * b to end, or to its last event if that is later, so that the events
+ * scheduled later up to end are spread over it too.  Fails if the
+ * ladder is full, or if all the events have the same time.
+ */
+int
+LadderScheduler::spawn(Bucket* b, double end)
+{
+	if (nrungs_ == LADDER_MAX_RUNGS)
+		return (0);
+	double min = b->head_->time_, max = min;
+	Event* e;
+	for (e = b->head_->next_; e != 0; e = e->next_) {
+		if (e->time_ < min)
+			min = e->time_;
+		if (e->time_ > max)
+			max = e->time_;
+	}
+	if (max <= min)
+		return (0);
+	if (end < max)
+		end = max;
+
+	Rung& r = rungs_[nrungs_++];
+	int n = b->count_;
+	if (n > r.size_) {
+		delete [] r.buckets_;
+		r.buckets_ = new Bucket[n];
+		r.size_ = n;
+	}
+	r.start_ = min;
+	r.width_ = (end - min) / n;
+	r.nbuckets_ = n;
+	r.cur_ = 0;
+	for (int i = 0; i < n; i++) {
+		r.buckets_[i].head_ = r.buckets_[i].tail_ = 0;
+		r.buckets_[i].count_ = 0;
+	}
+	Event* next;
+	for (e = b->head_; e != 0; e = next) {
+		next = e->next_;
+		append(&r.buckets_[r.index(e->time_)], e);
+	}
+	b->head_ = b->tail_ = 0;
+	b->count_ = 0;
+	return (1);
+}
+
+/*
+ * Stable merge sort of a list linked through next_.
+ */
+static Event*
+ladder_sort(Event* l, int n)
+{
+	if (n < 2)
+		return (l);
+	Event* m = l;
+	for (int i = 1; i < n / 2; i++)
+		m = m->next_;
+	Event* r = m->next_;
+	m->next_ = 0;
+	l = ladder_sort(l, n / 2);
+	r = ladder_sort(r, n - n / 2);
+
+	Event* head;
+	Event** p = &head;
+	while (l && r) {
+		if (r->time_ < l->time_) {
+			*p = r;
+			r = r->next_;
+		} else {
+			*p = l;
+			l = l->next_;
+		}
+		p = &(*p)->next_;
+	}
+	*p = l ? l : r;
+	return (head);
+}
+
+/*
+ * Sorts the events of b into the bottom list, which is empty.  Buckets
+ * often hold events in time order already, timers of the same period
+ * firing together, and are then moved as they are.
+ */
+void
+LadderScheduler::to_bottom(Bucket* b)
+{
+	assert(bottom_.count_ == 0);
+	Event* e;
+	for (e = b->head_; e->next_ != 0; e = e->next_)
+		if (e->next_->time_ < e->time_)
+			break;
+	if (e->next_ == 0) {
+		bottom_ = *b;
+		b->head_ = b->tail_ = 0;
+		b->count_ = 0;
+		return;
+	}
+	e = ladder_sort(b->head_, b->count_);
+	Event* prev = 0;
+	bottom_.head_ = e;
+	for (; e != 0; e = e->next_) {
+		e->prev_ = prev;
+		prev = e;
+	}
+	bottom_.tail_ = prev;
+	bottom_.count_ = b->count_;
+	b->head_ = b->tail_ = 0;
+	b->count_ = 0;
+}
+
+/*
+ * Hands buckets down the ladder until the bottom list holds the next
+ * events, and returns the first of them.
+ */
+Event*
+LadderScheduler::prepare()
+{
+	while (bottom_.count_ == 0) {
+		if (nrungs_ == 0) {
+			if (top_.count_ == 0)
+				return (0);
+			toplimit_ = topmax_;
+			if (!spawn(&top_, topmax_))
+				to_bottom(&top_);
+			continue;
+		}
+		Rung& r = rungs_[nrungs_ - 1];
+		while (r.cur_ < r.nbuckets_ && r.buckets_[r.cur_].count_ == 0)
+			r.cur_++;
+		if (r.cur_ == r.nbuckets_) {
+			nrungs_--;
+			continue;
+		}
+		Bucket* b = &r.buckets_[r.cur_++];
+		if (b->count_ <= LADDER_THRES ||
+		    !spawn(b, r.start_ + r.cur_ * r.width_))
+			to_bottom(b);
+	}
+	return (bottom_.head_);
+}
+
+void
+LadderScheduler::insert(Event* e)
+{
+	double t = e->time_;
+	Bucket* b = locate(t);
+
+	if (b == &top_) {
+		if (top_.count_ == 0 || t > topmax_)
+			topmax_ = t;
+		append(&top_, e);
+	} else if (b != &bottom_) {
+		append(b, e);
+	} else {
+		/* after the events of the same time */
+		Event* p;
+		for (p = bottom_.tail_; p != 0 && t < p->time_; p = p->prev_)
+			;
+		if (p == 0) {
+			e->prev_ = 0;
+			e->next_ = bottom_.head_;
+			bottom_.head_ = e;
+		} else {
+			e->prev_ = p;
+			e->next_ = p->next_;
+			p->next_ = e;
+		}
+		if (e->next_)
+			e->next_->prev_ = e;
+		else
+			bottom_.tail_ = e;
+		if (++bottom_.count_ > LADDER_THRES) {
+			/* up to the buckets not handed down yet */
+			double end = toplimit_;
+			if (nrungs_ > 0) {
+				Rung& r = rungs_[nrungs_ - 1];
+				end = r.start_ + r.cur_ * r.width_;
+			}
+			spawn(&bottom_, end);
+		}
+	}
+}
+
+void
+LadderScheduler::cancel(Event* e)
+{
+	if (e->uid_ <= 0)	// event not in queue
+		return;
+	e->uid_ = - e->uid_;
+	unlink(locate(e->time_), e);
+}
+
+Event*
+LadderScheduler::lookup(scheduler_uid_t uid)
+{
+	Event* e;
+	for (e = top_.head_; e != 0; e = e->next_)
+		if (e->uid_ == uid)
+			return (e);
+	for (int x = 0; x < nrungs_; x++) {
+		Rung& r = rungs_[x];
+		for (int i = r.cur_; i < r.nbuckets_; i++)
+			for (e = r.buckets_[i].head_; e != 0; e = e->next_)
+				if (e->uid_ == uid)
+					return (e);
+	}
+	for (e = bottom_.head_; e != 0; e = e->next_)
+		if (e->uid_ == uid)
+			return (e);
+	return (0);
+}
+
+Event*
+LadderScheduler::deque()
+{
+	Event* e = prepare();
+	if (e)
+		unlink(&bottom_, e);
+	return (e);
+}
@@ -59,10 +59,118 @@ int p_info::addPacket(char *name)
 
 int Packet::hdrlen_ = 0;		// size of a packet's header
 Packet* Packet::free_;			// free list
+long Packet::copies_ = 0;		// packets copied
+double Packet::copied_bytes_ = 0;	// bytes of headers and data copied
+long Packet::shares_ = 0;		// packets shared
+long Packet::unshared_ = 0;		// shared packets later copied
+int Packet::nhdrs_ = 0;			// number of headers
+int Packet::hdroff_[PACKET_MAX_HDRS];	// offset of each header
+int Packet::hdrsize_[PACKET_MAX_HDRS];	// aligned size of each header
+const char* Packet::hdrname_[PACKET_MAX_HDRS];	// class of each header
+unsigned char* Packet::hdrslot_ = 0;	// header of each aligned offset
+int Packet::hdrslots_ = 0;		// bytes hdrslot_ covers
+long Packet::allocs_ = 0;		// packets allocated
+double Packet::zeroed_bytes_ = 0;	// bytes of headers zeroed
+int Packet::audit_ = 0;			// check fresh headers are zero
 int hdr_cmn::offset_;			// static offset of common header
 int hdr_flags::offset_;			// static offset of flags header
 
 
+/*
+ * Record where a header is, so that packets can zero it only when it
+ * has been accessed, see Packet::touch()
+ */
+void Packet::register_hdr(const char* name, int off, int len)
+{
+	int i, end;
+
+	len = (len + PACKET_HDR_ALIGN - 1) & ~(PACKET_HDR_ALIGN - 1);
+	end = off + len;
+	if ((off & (PACKET_HDR_ALIGN - 1)) != 0) {
+		fprintf(stderr, "Packet: %s at offset %d is not aligned\n",
+			name, off);
+		abort();
+	}
+	for (i = 0; i < nhdrs_; i++)
+		if (strcmp(hdrname_[i], name) == 0)
+			break;
+	if (i == PACKET_HDR_ALL) {
+		fprintf(stderr, "Packet: more than %d packet headers, "
+			"increase PACKET_MAX_HDRS\n", PACKET_HDR_ALL);
+		abort();
+	}
+	if (i < nhdrs_) {
+		/*
+		 * The header moves, see Simulator prune-packet-headers: free
+		 * the slots it had, unless another header took them already
+		 */
+		for (int o = hdroff_[i]; o < hdroff_[i] + hdrsize_[i];
+		     o += PACKET_HDR_ALIGN)
+			if (hdrslot_[o >> PACKET_HDR_SHIFT] == i)
+				hdrslot_[o >> PACKET_HDR_SHIFT] = PACKET_HDR_ALL;
+	}
+	hdroff_[i] = off;
+	hdrname_[i] = name;
+	if (i == nhdrs_)
+		nhdrs_++;
+	if (off < 0) {
+		/* pruned from the layout, so never accessed nor zeroed */
+		hdrsize_[i] = 0;
+		return;
+	}
+	if (end > hdrslots_) {
+		int n = end >> PACKET_HDR_SHIFT;
+		unsigned char* slot = new unsigned char[n];
+		memset(slot, PACKET_HDR_ALL, n);
+		if (hdrslot_ != 0) {
+			memcpy(slot, hdrslot_, hdrslots_ >> PACKET_HDR_SHIFT);
+			delete [] hdrslot_;
+		}
+		hdrslot_ = slot;
+		hdrslots_ = end;
+	}
+	for (int o = off; o < end; o += PACKET_HDR_ALIGN)
+		hdrslot_[o >> PACKET_HDR_SHIFT] = i;
+	hdrsize_[i] = len;
+}
+
+/*
+ * Abort on an access to a header pruned from the layout. Pruned headers
+ * are far below offset 0, so that the offsets of their fields are
+ * negative too: the header is the nearest pruned one below off.
+ */
+void Packet::stray(int off)
+{
+	int j = -1;
+
+	for (int i = 0; i < nhdrs_; i++)
+		if (hdrsize_[i] == 0 && hdroff_[i] <= off &&
+		    (j < 0 || hdroff_[i] > hdroff_[j]))
+			j = i;
+	fprintf(stderr, "Packet: access to the %s header, which was pruned "
+		"from the packet layout, see PacketHeaderManager uses_\n",
+		(j >= 0) ? hdrname_[j] : "unknown");
+	abort();
+}
+
+/*
+ * Check that the headers of a packet just allocated are zero: a header
+ * which is not would have been written without going through access()
+ */
+void Packet::audit(Packet* p)
+{
+	for (int off = 0; off < hdrlen_; off++) {
+		if (p->bits_[off] == 0)
+			continue;
+		int i = (off < hdrslots_) ? hdrslot_[off >> PACKET_HDR_SHIFT] :
+			PACKET_HDR_ALL;
+		fprintf(stderr, "Packet: byte %d of the headers of a new "
+			"packet is not zero (%s)\n", off,
+			(i < nhdrs_) ? hdrname_[i] : "no header");
+		abort();
+	}
+}
+
 PacketHeaderClass::PacketHeaderClass(const char* classname, int hdrlen) : 
 	TclClass(classname), hdrlen_(hdrlen), offset_(0)
 {
@@ -100,6 +208,8 @@ int PacketHeaderClass::method(int ac, const char*const* av)
 	const char*const* argv = av + 2;
 	if (argc == 3) {
 		if (strcmp(argv[1], "offset") == 0) {
+			Packet::register_hdr(classname_, atoi(argv[2]),
+					     hdrlen_);
 			if (offset_) {
 				*offset_ = atoi(argv[2]);
 				return TCL_OK;
@@ -149,6 +259,20 @@ class PacketHeaderManager : public TclObject {
 public:
 	PacketHeaderManager() {
 		bind("hdrlen_", &Packet::hdrlen_);
+		bind_bool("audit_", &Packet::audit_);
+	}
+	int command(int argc, const char*const* argv) {
+		if (argc == 2) {
+			// Gives the number of packets allocated and the
+			// bytes of headers zeroed
+			if (strcmp(argv[1], "zero-stats") == 0) {
+				Tcl& tcl = Tcl::instance();
+				tcl.resultf("%ld %.0f", Packet::allocs_,
+					    Packet::zeroed_bytes_);
+				return TCL_OK;
+			}
+		}
+		return TclObject::command(argc, argv);
 	}
 };
 
@@ -38,6 +38,7 @@
 #define ns_packet_h
 
 #include <string.h>
+#include <strings.h>
 #include <assert.h>
 
 #include "config.h"
@@ -465,14 +466,38 @@ private:
 //Monarch ext
 typedef void (*FailureCallback)(Packet *,void *);
 
+/*
+ * Packets only zero the headers which were accessed since they were
+ * last zeroed, see Packet::touch().  Headers are aligned on
+ * PACKET_HDR_ALIGN bytes by PacketHeaderManager (ns-packet.tcl), and
+ * the last bit of the bitmap stands for all of them.
+ */
+#define PACKET_MAX_HDRS		128
+#define PACKET_HDR_WORDS	(PACKET_MAX_HDRS / 32)
+#define PACKET_HDR_ALL		(PACKET_MAX_HDRS - 1)
+#define PACKET_HDR_ALIGN	8
+#define PACKET_HDR_SHIFT	3
+
 class Packet : public Event {
 private:
 	unsigned char* bits_;	// header bits
+	// headers accessed since the header bits were zeroed
+	u_int32_t touched_[PACKET_HDR_WORDS];
+	inline void touch(int off) const;
+	inline void touch_all() const;
+	inline bool touched(int i) const {
+		return (touched_[i >> 5] & (1U << (i & 31))) != 0;
+	}
+	static void audit(Packet*);	// check the header bits are zero
 //	unsigned char* data_;	// variable size buffer for 'data'
 //  	unsigned int datalen_;	// length of variable size buffer
 	AppData* data_;		// variable size buffer for 'data'
 	static void init(Packet*);     // initialize pkt hdr 
 	bool fflag_;
+	// packet whose header bits and data are shared, see share()
+	Packet* share_;
+	static inline Packet* take();	// take a packet off the free list
+	inline void unshare();		// get private header bits and data
 protected:
 	static Packet* free_;	// packet free list
 	int	ref_count_;	// free the pkt until count to 0
@@ -480,25 +505,57 @@ public:
 	Packet* next_;		// for queues and the free list
 	static int hdrlen_;
 
-	Packet() : bits_(0), data_(0), ref_count_(0), next_(0) { }
-	inline unsigned char* const bits() { return (bits_); }
+	// copy statistics, see WirelessChannel "copy-stats"
+	static long copies_;		// packets copied
+	static double copied_bytes_;	// bytes of headers and data copied
+	static long shares_;		// packets shared
+	static long unshared_;		// shared packets later copied
+
+	// header layout, see register_hdr()
+	static int nhdrs_;			// number of headers
+	static int hdroff_[PACKET_MAX_HDRS];	// offset of each header
+	static int hdrsize_[PACKET_MAX_HDRS];	// aligned size of each header
+	static const char* hdrname_[PACKET_MAX_HDRS];
+	static unsigned char* hdrslot_;	// header of each aligned offset
+	static int hdrslots_;		// bytes hdrslot_ covers
+	static void register_hdr(const char* name, int off, int len);
+	static void stray(int off);	// abort on access to a pruned header
+
+	// zeroing statistics, see PacketHeaderManager "zero-stats"
+	static long allocs_;		// packets allocated
+	static double zeroed_bytes_;	// bytes of headers zeroed
+	static int audit_;		// check fresh headers are zero
+
+
+	Packet() : bits_(0), data_(0), share_(0), ref_count_(0), next_(0) {
+		bzero(touched_, sizeof(touched_));
+	}
+	inline unsigned char* const bits() {
+		if (share_ != 0)
+			unshare();
+		touch_all();
+		return (bits_);
+	}
 	inline Packet* copy() const;
+	inline Packet* share();
 	inline Packet* refcopy() { ++ref_count_; return this; }
 	inline int& ref_count() { return (ref_count_); }
 	static inline Packet* alloc();
 	static inline Packet* alloc(int);
 	inline void allocdata(int);
 	// dirty hack for diffusion data
-	inline void initdata() { data_  = 0;}
-	static inline void free(Packet*);
-	inline unsigned char* access(int off) const {
-		if (off < 0)
-			abort();
-		return (&bits_[off]);
+	inline void initdata() {
+		if (share_ != 0)
+			unshare();
+		data_  = 0;
 	}
+	static inline void free(Packet*);
+	inline unsigned char* access(int off) const;
 	// This is used for backward compatibility, i.e., assuming user data
 	// is PacketData and return its pointer.
 	inline unsigned char* accessdata() const { 
+		if (share_ != 0)
+			((Packet*)this)->unshare();
 		if (data_ == 0)
 			return 0;
 		assert(data_->type() == PACKET_DATA);
@@ -507,14 +564,22 @@ public:
 	// This is used to access application-specific data, not limited 
 	// to PacketData.
 	inline AppData* userdata() const {
+		if (share_ != 0)
+			((Packet*)this)->unshare();
 		return data_;
 	}
 	inline void setdata(AppData* d) { 
+		if (share_ != 0)
+			unshare();
 		if (data_ != NULL)
 			delete data_;
 		data_ = d; 
 	}
-	inline int datalen() const { return data_ ? data_->size() : 0; }
+	inline int datalen() const {
+		if (share_ != 0)
+			return share_->datalen();
+		return data_ ? data_->size() : 0;
+	}
 
 	// Monarch extn
 
@@ -624,6 +689,10 @@ struct hdr_cmn {
 	double txtime_;
 	inline double& txtime() { return(txtime_); }
 
+	// called if pkt is ack'd by the next hop, with xmit_failure_data_
+	// as argument. the pkt still belongs to the MAC and must not be freed
+	FailureCallback xmit_success_;
+
 	static int offset_;	// offset for this header
 	inline static int& offset() { return offset_; }
 	inline static hdr_cmn* access(const Packet* p) {
@@ -668,12 +737,48 @@ public:
 };
 
 
+/*
+ * Zero the headers accessed since they were last zeroed
+ */
 inline void Packet::init(Packet* p)
 {
-	bzero(p->bits_, hdrlen_);
+	if (p->touched(PACKET_HDR_ALL)) {
+		bzero(p->bits_, hdrlen_);
+		zeroed_bytes_ += hdrlen_;
+	} else {
+		for (int w = 0; w < PACKET_HDR_WORDS; w++) {
+			for (u_int32_t b = p->touched_[w]; b != 0; b &= b - 1) {
+				int i = (w << 5) + ffs(b) - 1;
+				bzero(p->bits_ + hdroff_[i], hdrsize_[i]);
+				zeroed_bytes_ += hdrsize_[i];
+			}
+		}
+	}
+	bzero(p->touched_, sizeof(p->touched_));
 }
 
-inline Packet* Packet::alloc()
+/*
+ * Mark the header at offset off as accessed, or all of them if the
+ * offset is not in a registered header
+ */
+inline void Packet::touch(int off) const
+{
+	int i = (off < hdrslots_) ? hdrslot_[off >> PACKET_HDR_SHIFT] :
+		PACKET_HDR_ALL;
+	((Packet*)this)->touched_[i >> 5] |= 1U << (i & 31);
+}
+
+inline void Packet::touch_all() const
+{
+	((Packet*)this)->touched_[PACKET_HDR_ALL >> 5] |=
+		1U << (PACKET_HDR_ALL & 31);
+}
+
+/*
+ * Take a packet off the free list, or allocate a new one, leaving
+ * its header bits as they are
+ */
+inline Packet* Packet::take()
 {
 	Packet* p = free_;
 	if (p != 0) {
@@ -687,8 +792,18 @@ inline Packet* Packet::alloc()
 		p->bits_ = new unsigned char[hdrlen_];
 		if (p == 0 || p->bits_ == 0)
 			abort();
+		p->touch_all();
 	}
+	return (p);
+}
+
+inline Packet* Packet::alloc()
+{
+	Packet* p = take();
 	init(p); // Initialize bits_[]
+	if (audit_)
+		audit(p);
+	allocs_++;
 	(HDR_CMN(p))->next_hop_ = -2; // -1 reserved for IP_BROADCAST
 	(HDR_CMN(p))->last_hop_ = -2; // -1 reserved for IP_BROADCAST
 	p->fflag_ = TRUE;
@@ -706,6 +821,8 @@ inline Packet* Packet::alloc()
  */
 inline void Packet::allocdata(int n)
 {
+	if (share_ != 0)
+		unshare();
 	assert(data_ == 0);
 	data_ = new PacketData(n);
 	if (data_ == 0)
@@ -736,7 +853,11 @@ inline void Packet::free(Packet* p)
 				delete p->data_;
 				p->data_ = 0;
 			}
-			init(p);
+			// the header bits are zeroed when the packet is reused
+			if (p->share_ != 0) {
+				free(p->share_);
+				p->share_ = 0;
+			}
 			p->next_ = free_;
 			free_ = p;
 			p->fflag_ = FALSE;
@@ -748,21 +869,121 @@ inline void Packet::free(Packet* p)
 
 inline Packet* Packet::copy() const
 {
+	if (share_ != 0)
+		((Packet*)this)->unshare();
 	
+	// the headers which were not accessed are zero in both packets
 	Packet* p = alloc();
-	memcpy(p->bits(), bits_, hdrlen_);
-	if (data_) 
+	if (touched(PACKET_HDR_ALL)) {
+		memcpy(p->bits_, bits_, hdrlen_);
+		copied_bytes_ += hdrlen_;
+	} else {
+		for (int w = 0; w < PACKET_HDR_WORDS; w++) {
+			for (u_int32_t b = touched_[w]; b != 0; b &= b - 1) {
+				int i = (w << 5) + ffs(b) - 1;
+				memcpy(p->bits_ + hdroff_[i], bits_ + hdroff_[i],
+				       hdrsize_[i]);
+				copied_bytes_ += hdrsize_[i];
+			}
+		}
+	}
+	for (int w = 0; w < PACKET_HDR_WORDS; w++)
+		p->touched_[w] |= touched_[w];
+	copies_++;
+	if (data_) {
 		p->data_ = data_->copy();
+		copied_bytes_ += data_->size();
+	}
 	p->txinfo_.init(&txinfo_);
  
 	return (p);
 }
 
+/*
+ * Copy-on-write copy of a packet: the new packet has its own common
+ * header and txinfo_, but shares the other headers and the data with
+ * this one, which is kept until they are freed or unshared.  They are
+ * only copied when something other than the common header is accessed,
+ * since headers are written through the pointers access() returns.
+ */
+inline Packet* Packet::share()
+{
+	Packet* root = (share_ != 0) ? share_ : this;
+	Packet* p = take();
+	memcpy(p->access(hdr_cmn::offset_), access(hdr_cmn::offset_),
+	       sizeof(hdr_cmn));
+	// the other headers of p are whatever they were, see unshare()
+	p->share_ = root->refcopy();
+	p->fflag_ = TRUE;
+	p->next_ = 0;
+	p->txinfo_.init(&txinfo_);
+	shares_++;
+	copied_bytes_ += sizeof(hdr_cmn);
+
+	return (p);
+}
+
+/*
+ * Copy the headers of the shared packet but the common one, and zero
+ * those this packet accessed before it was shared
+ */
+inline void Packet::unshare()
+{
+	Packet* root = share_;
+	int off = hdr_cmn::offset_;
+	int end = off + sizeof(hdr_cmn);
+
+	if (touched(PACKET_HDR_ALL) || root->touched(PACKET_HDR_ALL)) {
+		memcpy(bits_, root->bits_, off);
+		memcpy(bits_ + end, root->bits_ + end, hdrlen_ - end);
+		copied_bytes_ += hdrlen_ - sizeof(hdr_cmn);
+		touch_all();
+	} else {
+		int cmn = hdrslot_[off >> PACKET_HDR_SHIFT];
+		for (int w = 0; w < PACKET_HDR_WORDS; w++) {
+			u_int32_t b = touched_[w] | root->touched_[w];
+			touched_[w] = b;
+			for (; b != 0; b &= b - 1) {
+				int i = (w << 5) + ffs(b) - 1;
+				if (i == cmn)
+					continue;
+				if (root->touched(i)) {
+					memcpy(bits_ + hdroff_[i],
+					       root->bits_ + hdroff_[i],
+					       hdrsize_[i]);
+					copied_bytes_ += hdrsize_[i];
+				} else
+					bzero(bits_ + hdroff_[i], hdrsize_[i]);
+			}
+		}
+	}
+	if (root->data_) {
+		data_ = root->data_->copy();
+		copied_bytes_ += data_->size();
+	}
+	unshared_++;
+	share_ = 0;
+	free(root);
+}
+
+inline unsigned char* Packet::access(int off) const
+{
+	if (off < 0)
+		stray(off);
+	if (share_ != 0 && off != hdr_cmn::offset_)
+		((Packet*)this)->unshare();
+	touch(off);
+	return (&bits_[off]);
+}
+
 inline void
 Packet::dump_header(Packet *p, int offset, int length)
 {
         assert(offset + length <= p->hdrlen_);
         struct hdr_cmn *ch = HDR_CMN(p);
+        if (p->share_ != 0)
+                p->unshare();
+        p->touch_all();
 
         fprintf(stderr, "\nPacket ID: %d\n", ch->uid());
 
@@ -115,6 +115,18 @@ Scheduler::schedule(Handler* h, Event* e, double delay)
 	insert(e);
 }
 
+/*
+ * Move a pending event to delay time units into the future.  This is
+ * the same as cancel() then schedule(), which schedulers that can move
+ * an event in place do faster.
+ */
+void
+Scheduler::reschedule(Handler* h, Event* e, double delay)
+{
+	cancel(e);
+	schedule(h, e, delay);
+}
+
 void
 Scheduler::run()
 {
@@ -216,6 +228,11 @@ Scheduler::command(int argc, const char*const* argv)
 				globalMemTrace->diff("Sim.");
 #endif
 			return (TCL_OK);
+		} else if (strcmp(argv[1], "event-count") == 0) {
+			/* number of events scheduled so far */
+			sprintf(tcl.buffer(), UID_PRINTF_FORMAT, uid_ - 1);
+			tcl.result(tcl.buffer());
+			return (TCL_OK);
 		} else if (strcmp(argv[1], "is-running") == 0) {
 			sprintf(tcl.buffer(), "%d", !halted_);
 			return (TCL_OK);
@@ -539,22 +556,142 @@ public:
 	}
 } class_heap_sched;
 
+/*
+ * Move the event in slot i up or down to where it belongs.
+ */
+void
+HeapScheduler::sift(int i)
+{
+	Slot s = heap_[i];
+	int p, c;
+
+	while (i > 0 && before(s, heap_[p = (i - 1) / 2])) {
+		place(i, heap_[p]);
+		i = p;
+	}
+	while ((c = 2 * i + 1) < size_) {
+		if (c + 1 < size_ && before(heap_[c + 1], heap_[c]))
+			c++;
+		if (!before(heap_[c], s))
+			break;
+		place(i, heap_[c]);
+		i = c;
+	}
+	place(i, s);
+}
+
+/*
+ * Free slot i, without touching the event in it, which may be gone
+ * already if it is the event deque() returned.
+ */
+void
+HeapScheduler::remove(int i)
+{
+	if (i < --size_) {
+		place(i, heap_[size_]);
+		sift(i);
+	}
+}
+
+/*
+ * deque() leaves the event it returns at the root of the heap until
+ * the next operation: a timer which schedules its event again from its
+ * handler then only moves it down from the root, instead of removing it
+ * and inserting it again.
+ */
+void
+HeapScheduler::settle()
+{
+	if (popped_) {
+		popped_ = 0;
+		remove(0);
+	}
+}
+
+void
+HeapScheduler::insert(Event* e)
+{
+	int i;
+
+	if (popped_ && heap_[0].event_ == e) {
+		/* dequeued last, see settle() */
+		popped_ = 0;
+		i = 0;
+		e->slot_ = 0;
+	} else {
+		settle();
+		if (queued(e)) {
+			/* left in the heap by reschedule() */
+			i = e->slot_;
+		} else {
+			if (size_ == maxsize_) {
+				int n = (maxsize_ > 0) ? 2 * maxsize_ :
+					HEAP_DEFAULT_SIZE;
+				Slot* heap = new Slot[n];
+				if (size_ > 0)
+					memcpy(heap, heap_, size_ * sizeof(Slot));
+				delete [] heap_;
+				heap_ = heap;
+				maxsize_ = n;
+			}
+			i = size_++;
+			heap_[i].event_ = e;
+			e->slot_ = i;
+		}
+	}
+	heap_[i].time_ = e->time_;
+	heap_[i].seq_ = seq_++;
+	sift(i);
+}
+
+void
+HeapScheduler::cancel(Event* e)
+{
+	if (e->uid_ <= 0)	// event not in queue
+		return;
+	e->uid_ = - e->uid_;
+	settle();
+	if (queued(e)) {
+		remove(e->slot_);
+		e->slot_ = -1;
+	}
+}
+
+void
+HeapScheduler::reschedule(Handler* h, Event* e, double delay)
+{
+	if (e->uid_ > 0)
+		e->uid_ = - e->uid_;	// cancelled, but left in the heap
+	schedule(h, e, delay);		// insert() moves it
+}
+
+const Event*
+HeapScheduler::head()
+{
+	settle();
+	return (size_ > 0 ? heap_[0].event_ : 0);
+}
+
 Event* 
 HeapScheduler::lookup(scheduler_uid_t uid)
 {
-	Event* e;
-	
-	for (e = (Event*) hp_->heap_iter_init(); e;
-	     e = (Event*) hp_->heap_iter())
-		if (e->uid_ == uid)
-			break;
-	return e;
+	settle();
+	for (int i = 0; i < size_; i++)
+		if (heap_[i].event_->uid_ == uid)
+			return (heap_[i].event_);
+	return (0);
 }
 
 Event*
 HeapScheduler::deque()
 {
-	return ((Event*) hp_->heap_extract_min());
+	settle();
+	if (size_ == 0)
+		return (0);
+	Event* e = heap_[0].event_;
+	e->slot_ = -1;
+	popped_ = 1;
+	return (e);
 }
 
 /*
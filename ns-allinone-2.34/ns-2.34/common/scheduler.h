@@ -60,7 +60,8 @@ public:
 	Handler* handler_;	/* handler to call when event ready */
 	double time_;		/* time at which event is ready */
 	scheduler_uid_t uid_;	/* unique ID */
-	Event() : time_(0), uid_(0) {}
+	int slot_;		/* index in HeapScheduler's heap, -1 if none */
+	Event() : time_(0), uid_(0), slot_(-1) {}
 };
 
 /*
@@ -82,6 +83,7 @@ public:
 		return (*instance_);		// general access to scheduler
 	}
 	void schedule(Handler*, Event*, double delay);	// sched later event
+	virtual void reschedule(Handler*, Event*, double delay); // move pending
 	virtual void run();			// execute the simulator
 	virtual void cancel(Event*) = 0;	// cancel event
 	virtual void insert(Event*) = 0;	// schedule event
@@ -124,23 +126,48 @@ protected:
 
 #include "heap.h"
 
+/*
+ * Binary heap of events ordered by time, then by order of insertion.
+ * Every event keeps its index in the heap in Event::slot_, so that
+ * cancel() and reschedule() are O(log n) rather than a search of the heap.
+ */
 class HeapScheduler : public Scheduler {
 public:
-	HeapScheduler() { hp_ = new Heap; } 
-	void cancel(Event* e) {
-		if (e->uid_ <= 0)
-			return;
-		e->uid_ = - e->uid_;
-		hp_->heap_delete((void*) e);
-	}
-	void insert(Event* e) {
-		hp_->heap_insert(e->time_, (void*) e);
-	}
+	HeapScheduler() : heap_(0), size_(0), maxsize_(0), seq_(0),
+			  popped_(0) {}
+	~HeapScheduler() { delete [] heap_; }
+	void cancel(Event*);
+	void insert(Event*);
+	void reschedule(Handler*, Event*, double delay);
 	Event* lookup(scheduler_uid_t uid);
 	Event* deque();
-	const Event* head() { return (const Event *)hp_->heap_min(); }
+	const Event* head();
 protected:
-	Heap* hp_;
+	struct Slot {
+		double time_;		/* copy of event_->time_ */
+		unsigned long seq_;	/* order of insertion, breaks ties */
+		Event* event_;
+	} *heap_;
+	int size_;
+	int maxsize_;
+	unsigned long seq_;
+	int popped_;		/* heap_[0] was dequeued, see settle() */
+
+	int before(const Slot& a, const Slot& b) const {
+		return (a.time_ < b.time_ ||
+			(a.time_ == b.time_ && a.seq_ < b.seq_));
+	}
+	int queued(Event* e) const {
+		return (e->slot_ >= 0 && e->slot_ < size_ &&
+			heap_[e->slot_].event_ == e);
+	}
+	void place(int i, const Slot& s) {
+		heap_[i] = s;
+		s.event_->slot_ = i;
+	}
+	void sift(int i);
+	void remove(int i);
+	void settle();
 };
 
 class CalendarScheduler : public Scheduler {
@@ -217,5 +244,57 @@ private:
 	int validate(Event *);
 };
 
+#define LADDER_THRES		50	/* events a bucket sorts directly */
+#define LADDER_MAX_RUNGS	8
+
+/*
+ * Ladder queue, see ladder-scheduler.cc
+ */
+class LadderScheduler : public Scheduler {
+public:
+	LadderScheduler();
+	~LadderScheduler();
+	void cancel(Event*);
+	void insert(Event*);
+	Event* lookup(scheduler_uid_t uid);
+	Event* deque();
+	const Event* head() { return (prepare()); }
+
+protected:
+	struct Bucket {		/* unsorted list, but for bottom_ */
+		Event* head_;
+		Event* tail_;
+		int count_;
+	};
+	struct Rung {
+		double start_;	/* time of bucket 0 */
+		double width_;	/* of a bucket */
+		int nbuckets_;
+		int cur_;	/* first bucket not yet handed down */
+		int size_;	/* of buckets_ */
+		Bucket* buckets_;
+		int index(double t) const {
+			double d = (t - start_) / width_;
+			if (d < 0)
+				return (-1);
+			return (d < nbuckets_ ? (int)d : nbuckets_ - 1);
+		}
+	};
+
+	Bucket top_;		/* events after toplimit_ */
+	double topmax_;		/* latest event of top_ */
+	double toplimit_;
+	Rung rungs_[LADDER_MAX_RUNGS];
+	int nrungs_;
+	Bucket bottom_;		/* sorted events before all the rungs */
+
+	Bucket* locate(double t);
+	Event* prepare();
+	int spawn(Bucket* b, double end);
+	void to_bottom(Bucket* b);
+	void append(Bucket* b, Event* e);
+	void unlink(Bucket* b, Event* e);
+};
+
 
 #endif
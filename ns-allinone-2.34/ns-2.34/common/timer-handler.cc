@@ -85,8 +85,9 @@ void
 TimerHandler::resched(double delay)
 {
 	if (status_ == TIMER_PENDING)
-		_cancel();
-	_sched(delay);
+		Scheduler::instance().reschedule(this, &event_, delay);
+	else
+		_sched(delay);
 	status_ = TIMER_PENDING;
 }
 
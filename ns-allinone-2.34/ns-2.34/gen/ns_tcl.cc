@@ -3346,6 +3346,7 @@ eval $self next $var $arg\n\
 \n\
 \n\
 PacketHeaderManager set hdrlen_ 0\n\
+PacketHeaderManager set audit_ false\n\
 \n\
 PacketHeaderManager set tab_(Common) 1\n\
 \n\
@@ -3437,6 +3438,7 @@ TORA 	# routing protocol for ad-hoc networks\n\
 AOMDV\n\
 OLSR  # routing protocol for ad-hoc networks\n\
 MPOLSR  # routing protocol for ad-hoc networks\n\
+Mojette # MPOLSR erasure coding, mpolsr/mojette.cc\n\
 AOLSR  # routing protocol for ad-hoc networks\n\
 BOLSR  # routing protocol for ad-hoc networks\n\
 Encap 	# common/encap.cc\n\
@@ -3478,6 +3480,106 @@ incr hdrlen_ $incr\n\
 return $base\n\
 }\n\
 \n\
+foreach pair {\n\
+{ Simulator {} }\n\
+{ Scheduler/Calendar {} }\n\
+{ Scheduler/List {} }\n\
+{ Scheduler/Heap {} }\n\
+{ Scheduler/Splay {} }\n\
+{ Scheduler/Map {} }\n\
+{ Scheduler/Ladder {} }\n\
+{ PacketHeaderManager {} }\n\
+{ RNG {} }\n\
+{ Address {} }\n\
+{ AllocAddr {} }\n\
+{ RouteLogic {} }\n\
+{ RtModule/Base {} }\n\
+{ God { IP } }\n\
+{ Topography {} }\n\
+{ Node/MobileNode {} }\n\
+{ EnergyModel {} }\n\
+{ Classifier/Hash/Dest { IP } }\n\
+{ Classifier/Port { IP } }\n\
+{ Channel/WirelessChannel {} }\n\
+{ Propagation/TwoRayGround {} }\n\
+{ Propagation/FreeSpace {} }\n\
+{ Antenna/OmniAntenna {} }\n\
+{ Phy/WirelessPhy {} }\n\
+{ Mac/802_11 { Mac } }\n\
+{ Queue/DropTail {} }\n\
+{ Queue/DropTail/PriQueue {} }\n\
+{ LL { IP LL Mac } }\n\
+{ ARPTable { IP LL Mac ARP } }\n\
+{ Agent/Null { IP Flags NV } }\n\
+{ Agent/UDP { IP Flags NV RTP } }\n\
+{ Agent/AODV { IP Flags NV AODV } }\n\
+{ Agent/OLSR { IP Flags NV OLSR } }\n\
+{ Agent/MPOLSR { IP Flags NV MPOLSR SR Mojette } }\n\
+{ Agent/AOLSR { IP Flags NV AOLSR } }\n\
+{ Agent/BOLSR { IP Flags NV BOLSR } }\n\
+{ Application/Traffic/CBR {} }\n\
+{ Application/Traffic/Exponential {} }\n\
+{ CMUTrace/Send { IP Mac ARP } }\n\
+{ CMUTrace/Recv { IP Mac ARP } }\n\
+{ CMUTrace/Drop { IP Mac ARP } }\n\
+{ CMUTrace/EOT { IP Mac ARP } }\n\
+{ Trace/Generic { IP Flags TCP RTP RAP TFRC TFRC_ACK SCTP SRM } }\n\
+{ Trace/Enque { IP Flags TCP RTP RAP TFRC TFRC_ACK SCTP SRM } }\n\
+{ Trace/Deque { IP Flags TCP RTP RAP TFRC TFRC_ACK SCTP SRM } }\n\
+{ Trace/Drop { IP Flags TCP RTP RAP TFRC TFRC_ACK SCTP SRM } }\n\
+{ Trace/Recv { IP Flags TCP RTP RAP TFRC TFRC_ACK SCTP SRM } }\n\
+} {\n\
+PacketHeaderManager set uses_([lindex $pair 0]) [lindex $pair 1]\n\
+}\n\
+\n\
+proc all-instances cl {\n\
+set l [$cl info instances]\n\
+foreach sub [$cl info subclass] {\n\
+eval lappend l [all-instances $sub]\n\
+}\n\
+return $l\n\
+}\n\
+\n\
+Simulator instproc prune-packet-headers {} {\n\
+PacketHeaderManager instvar tab_ uses_\n\
+$self instvar packetManager_\n\
+\n\
+if {[lindex [$packetManager_ zero-stats] 0] > 0} {\n\
+puts \"packet headers: not pruned, packets were allocated\\\n\
+before the simulation started\"\n\
+return\n\
+}\n\
+set keep(PacketHeader/Common) 1\n\
+foreach o [all-instances TclObject] {\n\
+set cl [$o info class]\n\
+if ![info exists uses_($cl)] {\n\
+puts \"packet headers: not pruned, the headers $cl\\\n\
+accesses are unknown\"\n\
+return\n\
+}\n\
+foreach hdr $uses_($cl) {\n\
+set keep(PacketHeader/$hdr) 1\n\
+}\n\
+}\n\
+set old [$packetManager_ set hdrlen_]\n\
+$packetManager_ set hdrlen_ 0\n\
+set kept 0\n\
+set pruned 0\n\
+foreach cl [PacketHeader info subclass] {\n\
+if ![info exists tab_($cl)] {\n\
+continue\n\
+}\n\
+if [info exists keep($cl)] {\n\
+$cl offset [$packetManager_ allochdr $cl]\n\
+incr kept\n\
+} else {\n\
+$cl offset [expr -65536 * [incr pruned]]\n\
+}\n\
+}\n\
+puts \"packet headers: $kept of [expr $kept + $pruned] kept,\\\n\
+$old -> [$packetManager_ set hdrlen_] bytes per packet\"\n\
+}\n\
+\n\
 \n\
 \n\
 \n\
@@ -19296,6 +19398,7 @@ AllocAddrBits set MAXADDRSIZE_ 32                ;# leaving the signed bit\n\
 Simulator set node_factory_ Node\n\
 Simulator set nsv1flag 0\n\
 Simulator set mobile_ip_ 0			 ;# flag for mobileIP\n\
+Simulator set prunePacketHeaders_ 0	 ;# see prune-packet-headers\n\
 \n\
 \n\
 Simulator set routingAgent_ \"\"\n\
@@ -19934,6 +20037,11 @@ Agent/OLSR set willingness_ 3\n\
 Agent/OLSR set hello_ival_  2\n\
 Agent/OLSR set tc_ival_     5\n\
 Agent/OLSR set mid_ival_    5\n\
+Agent/OLSR set max_pkt_size_ 1472\n\
+Agent/OLSR set tc_delta_    false\n\
+Agent/OLSR set tc_full_ival_ 30\n\
+Agent/OLSR set fisheye_     false\n\
+Agent/OLSR set timing_      false\n\
 \n\
 Agent/AOLSR set debug_       false\n\
 Agent/AOLSR set use_mac_     false\n\
@@ -19941,6 +20049,7 @@ Agent/AOLSR set willingness_ 3\n\
 Agent/AOLSR set hello_ival_  2\n\
 Agent/AOLSR set tc_ival_     5\n\
 Agent/AOLSR set mid_ival_    5\n\
+Agent/AOLSR set max_pkt_size_ 1472\n\
 \n\
 \n\
 Agent/BOLSR set debug_       false\n\
@@ -19949,6 +20058,7 @@ Agent/BOLSR set willingness_ 3\n\
 Agent/BOLSR set hello_ival_  2\n\
 Agent/BOLSR set tc_ival_     5\n\
 Agent/BOLSR set mid_ival_    5\n\
+Agent/BOLSR set max_pkt_size_ 1472\n\
 \n\
 Agent/MPOLSR set debug_       false\n\
 Agent/MPOLSR set use_mac_     false\n\
@@ -19956,6 +20066,13 @@ Agent/MPOLSR set willingness_ 3\n\
 Agent/MPOLSR set hello_ival_  2\n\
 Agent/MPOLSR set tc_ival_     5\n\
 Agent/MPOLSR set mid_ival_    5\n\
+Agent/MPOLSR set max_pkt_size_ 1472\n\
+Agent/MPOLSR set tc_delta_    false\n\
+Agent/MPOLSR set tc_full_ival_ 30\n\
+Agent/MPOLSR set timing_      false\n\
+Agent/MPOLSR set max_route_   3\n\
+Agent/MPOLSR set mojette_n_   0\n\
+Agent/MPOLSR set mojette_m_   2\n\
 \n\
 Agent/Diff_Sink set packetSize_ 512\n\
 Agent/Diff_Sink set interval_   0.5\n\
@@ -21376,6 +21493,9 @@ $self check-smac                      ;# print warning if in sleep/wakeup cycle\
 $self check-node-num\n\
 $self rtmodel-configure			;# in case there are any\n\
 [$self get-routelogic] configure\n\
+if [Simulator set prunePacketHeaders_] {\n\
+$self prune-packet-headers	;# before any packet is allocated\n\
+}\n\
 $self instvar scheduler_ Node_ link_ started_ \n\
 \n\
 set started_ 1\n\
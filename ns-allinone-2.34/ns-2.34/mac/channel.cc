@@ -293,7 +293,19 @@ WirelessChannel::WirelessChannel(void) : Channel(), numNodes_(0),
 int WirelessChannel::command(int argc, const char*const* argv)
 {
 	
-	if (argc == 3) {
+	if (argc == 2) {
+		// Gives the number of packets copied, shared with the
+		// receivers and copied after all because a layer accessed
+		// them, and the bytes of headers and data copied
+		if (strcmp(argv[1], "copy-stats") == 0) {
+			Tcl& tcl = Tcl::instance();
+			tcl.resultf("%ld %ld %ld %.0f", Packet::copies_,
+				    Packet::shares_, Packet::unshared_,
+				    Packet::copied_bytes_);
+			return TCL_OK;
+		}
+	}
+	else if (argc == 3) {
 		TclObject *obj;
 
 		if( (obj = TclObject::lookup(argv[2])) == 0) {
@@ -345,7 +357,7 @@ WirelessChannel::sendUp(Packet* p, Phy *tifp)
 						         outlist);
 	    for (i=0; i < out_index; i ++) {
 		
-		  newp = p->copy();
+		  newp = p->share();
 		  rnode = outlist[i];
 		  propdelay = get_pdelay(tnode, rnode);
 
@@ -376,7 +388,7 @@ WirelessChannel::sendUp(Packet* p, Phy *tifp)
 			 if(rnode == tnode)
 				 continue;
 			 
-			 newp = p->copy();
+			 newp = p->share();
 			 
 			 propdelay = get_pdelay(tnode, rnode);
 			 
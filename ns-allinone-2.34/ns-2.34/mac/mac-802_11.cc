@@ -469,7 +469,7 @@ Mac802_11::is_idle()
 void
 Mac802_11::discard(Packet *p, const char* why)
 {
-	hdr_mac802_11* mh = HDR_MAC802_11(p);
+	hdr_mac802_11* mh;
 	hdr_cmn *ch = HDR_CMN(p);
 
 	/* if the rcvd pkt contains errors, a real MAC layer couldn't
@@ -478,6 +478,8 @@ Mac802_11::discard(Packet *p, const char* why)
 		Packet::free(p);
 		return;
 	}
+	/* not before, so that errored broadcasts are never unshared */
+	mh = HDR_MAC802_11(p);
 
 	switch(mh->dh_fc.fc_type) {
 	case MAC_Type_Management:
@@ -1639,11 +1641,9 @@ Mac802_11::recv_timer()
 {
 	u_int32_t src; 
 	hdr_cmn *ch = HDR_CMN(pktRx_);
-	hdr_mac802_11 *mh = HDR_MAC802_11(pktRx_);
-	u_int32_t dst = ETHER_ADDR(mh->dh_ra);
-	u_int32_t ap_dst = ETHER_ADDR(mh->dh_3a);
-	u_int8_t  type = mh->dh_fc.fc_type;
-	u_int8_t  subtype = mh->dh_fc.fc_subtype;
+	hdr_mac802_11 *mh;
+	u_int32_t dst, ap_dst;
+	u_int8_t  type, subtype;
 
 	assert(pktRx_);
 	assert(rx_state_ == MAC_RECV || rx_state_ == MAC_COLL);
@@ -1680,6 +1680,16 @@ Mac802_11::recv_timer()
 		goto done;
 	}
 
+	/*
+	 * Only read the MAC header of the packets which are received,
+	 * so that the others are never unshared, see Packet::share().
+	 */
+	mh = HDR_MAC802_11(pktRx_);
+	dst = ETHER_ADDR(mh->dh_ra);
+	ap_dst = ETHER_ADDR(mh->dh_3a);
+	type = mh->dh_fc.fc_type;
+	subtype = mh->dh_fc.fc_subtype;
+
 	/*
 	 * IEEE 802.11 specs, section 9.2.5.6
 	 *	- update the NAV (Network Allocation Vector)
@@ -2098,6 +2108,13 @@ Mac802_11::recvACK(Packet *p)
 	else
 		slrc_ = 0;
 	rst_cw();
+
+	/*
+	 * Let the routing agent know that the next hop got the packet.
+	 */
+	if (HDR_CMN(pktTx_)->xmit_success_)
+		HDR_CMN(pktTx_)->xmit_success_(pktTx_,
+					       HDR_CMN(pktTx_)->xmit_failure_data_);
 	Packet::free(pktTx_); 
 	pktTx_ = 0;
 	
@@ -43,6 +43,9 @@
 #include "map"
 #include "set"
 #include <iostream>
+#include <algorithm>
+#include <iterator>
+#include <sys/time.h>
 
 using namespace std;
 
@@ -60,6 +63,33 @@ mpolsr_mac_failed_callback(Packet *p, void *arg) {
   ((MPOLSR*)arg)->mac_failed(p);
 }
 
+///
+/// \brief Function called by MAC layer when a packet has been acknowledged.
+///
+/// \param p Packet which has been delivered to the next hop.
+/// \param arg MPOLSR agent passed for a callback.
+///
+static void
+mpolsr_mac_succeeded_callback(Packet *p, void *arg) {
+  ((MPOLSR*)arg)->mac_succeeded(p);
+}
+
+///
+/// \brief Forgets the MAC layer callbacks a packet carries.
+///
+/// They were set by the node which sent the packet last, possibly for a copy
+/// of it, and must not reach the agent of that node again.
+///
+/// \param p the packet.
+///
+static inline void
+mpolsr_clear_mac_callbacks(Packet *p) {
+  struct hdr_cmn* ch = HDR_CMN(p);
+  ch->xmit_failure_ = 0;
+  ch->xmit_failure_data_ = 0;
+  ch->xmit_success_ = 0;
+}
+
 
 /********** TCL Hooks **********/
 
@@ -85,13 +115,33 @@ public:
 	}
 } class_rtProtoMPOLSR;
 
+
+///
+/// \brief Appends the usage of the pool of type T to the result of a Tcl command.
+///
+/// The element is the list {name objects_in_use high_water_mark objects_allocated}.
+///
+/// \param tcl the Tcl interpreter.
+/// \param name the name of the pooled type.
+///
+template <class T>
+static void
+append_pool_stats(Tcl& tcl, const char* name) {
+	char buf[128];
+	sprintf(buf, "%s %u %u %u", name,
+		MPOLSR_pool<T>::in_use(), MPOLSR_pool<T>::high_water(), MPOLSR_pool<T>::capacity());
+	Tcl_AppendElement(tcl.interp(), buf);
+}
+
 ///
 /// \brief Interface with TCL interpreter.
 ///
 /// From your TCL scripts or shell you can invoke commands on this MPOLSR
 /// routing agent thanks to this function. Currently you can call "start",
 /// "print_rtable", "print_linkset", "print_nbset", "print_nb2hopset",
-/// "print_mprset", "print_mprselset" and "print_topologyset" commands.
+/// "print_mprset", "print_mprselset", "print_topologyset", "print_m_rtable",
+/// "check_m_rtable", "m_rtable_stats", "m_rtable_mode" and "path_diversity"
+/// commands.
 ///
 /// \param argc Number of arguments.
 /// \param argv Arguments.
@@ -227,6 +277,109 @@ MPOLSR::command(int argc, const char*const* argv) {
 			}
 			return TCL_OK;
 		}
+		else if (strcasecmp(argv[1], "print_m_rtable") == 0) {
+			if (logtarget_ != NULL) {
+				sprintf(logtarget_->pt_->buffer(), "P %f _%d_ Multipath Routing Table",
+					CURRENT_TIME,
+					MPOLSR::node_id(ra_addr()));
+				logtarget_->pt_->dump();
+				MPOLSR_printer::print_m_rtable(logtarget_, m_rtable_);
+			}
+			else {
+				fprintf(stdout, "%f _%d_ If you want to print this multipath routing table "
+					"you must create a trace file in your tcl script",
+					CURRENT_TIME,
+					MPOLSR::node_id(ra_addr()));
+			}
+			return TCL_OK;
+		}
+		// Checks the multipath engine against the reference algorithm
+		else if (strcasecmp(argv[1], "check_m_rtable") == 0) {
+			Tcl& tcl = Tcl::instance();
+			tcl.resultf("%d", check_m_rtable());
+			return TCL_OK;
+		}
+		// Returns the number of multipath routing table computations which
+		// were run and avoided, and the current topology epoch
+		else if (strcasecmp(argv[1], "m_rtable_stats") == 0) {
+			Tcl& tcl = Tcl::instance();
+			tcl.resultf("%u %u %u", m_rt_computed_, m_rt_avoided_, topology_epoch_);
+			return TCL_OK;
+		}
+		// Returns the name of the path scheduler in use
+		else if (strcasecmp(argv[1], "path_scheduler") == 0) {
+			Tcl& tcl = Tcl::instance();
+			tcl.result(path_scheduler_->name());
+			return TCL_OK;
+		}
+		// Returns the Mojette coding statistics: packets encoded, decoded,
+		// expired and failed, redundant projections received, mean decode
+		// latency and ratio of bytes sent to original bytes
+		else if (strcasecmp(argv[1], "mojette_stats") == 0) {
+			Tcl& tcl = Tcl::instance();
+			tcl.resultf("%u %u %u %u %u %f %f",
+				mojette_.encoded_,
+				mojette_.decoded_,
+				mojette_.expired_,
+				mojette_.failed_,
+				mojette_.redundant_,
+				mojette_.decoded_ > 0 ? mojette_.latency_ / mojette_.decoded_ : 0.0,
+				mojette_.bytes_in_ > 0 ? mojette_.bytes_out_ / mojette_.bytes_in_ : 0.0);
+			return TCL_OK;
+		}
+		// Returns the name of the Mojette transform kernel in use
+		else if (strcasecmp(argv[1], "mojette_kernel") == 0) {
+			Tcl& tcl = Tcl::instance();
+			tcl.result(mojette_kernel());
+			return TCL_OK;
+		}
+		// Gives the number of full and delta TC messages and of TC
+		// requests generated, of delta TC messages which could not be
+		// applied, the bytes of TC messages and requests sent, and the
+		// number of TC messages processed and the wall clock time spent
+		// processing them (zero unless timing_ is set)
+		else if (strcasecmp(argv[1], "tc_stats") == 0) {
+			Tcl& tcl = Tcl::instance();
+			tcl.resultf("%u %u %u %u %u %u %f", tc_full_, tc_deltas_, tc_reqs_,
+				tc_gaps_, tc_bytes_, tc_rcvd_, tc_time_);
+			return TCL_OK;
+		}
+		// Gives the number of MPOLSR packets and messages sent, the
+		// bytes of headers saved by bundling the messages and the
+		// most messages sent in one packet
+		else if (strcasecmp(argv[1], "bundle_stats") == 0) {
+			Tcl& tcl = Tcl::instance();
+			tcl.resultf("%u %u %u %u", bundle_pkts_, bundle_msgs_,
+				bundle_saved_, bundle_max_);
+			return TCL_OK;
+		}
+		// Gives the number of MAC layer acknowledgements received for
+		// packets originated by this node, and for packets originated
+		// by other nodes, which should never be received
+		else if (strcasecmp(argv[1], "feedback_stats") == 0) {
+			Tcl& tcl = Tcl::instance();
+			tcl.resultf("%u %u", mac_acks_, mac_foreign_acks_);
+			return TCL_OK;
+		}
+		// Gives the usage of the pools of tuples and timers, which are
+		// shared by all the agents
+		else if (strcasecmp(argv[1], "pool_stats") == 0) {
+			Tcl& tcl = Tcl::instance();
+			Tcl_ResetResult(tcl.interp());
+			append_pool_stats<MPOLSR_rt_entry>(tcl, "rt_entry");
+			append_pool_stats<MPOLSR_link_tuple>(tcl, "link_tuple");
+			append_pool_stats<MPOLSR_nb_tuple>(tcl, "nb_tuple");
+			append_pool_stats<MPOLSR_nb2hop_tuple>(tcl, "nb2hop_tuple");
+			append_pool_stats<MPOLSR_mprsel_tuple>(tcl, "mprsel_tuple");
+			append_pool_stats<MPOLSR_topology_tuple>(tcl, "topology_tuple");
+			append_pool_stats<MPOLSR_iface_assoc_tuple>(tcl, "iface_assoc_tuple");
+			append_pool_stats<MPOLSR_LinkTupleTimer>(tcl, "link_timer");
+			append_pool_stats<MPOLSR_Nb2hopTupleTimer>(tcl, "nb2hop_timer");
+			append_pool_stats<MPOLSR_MprSelTupleTimer>(tcl, "mprsel_timer");
+			append_pool_stats<MPOLSR_TopologyTupleTimer>(tcl, "topology_timer");
+			append_pool_stats<MPOLSR_IfaceAssocTupleTimer>(tcl, "iface_assoc_timer");
+			return TCL_OK;
+		}
 	}
 	else if (argc == 3) {
 		// Obtains the corresponding dmux to carry packets to upper layers
@@ -245,6 +398,60 @@ MPOLSR::command(int argc, const char*const* argv) {
 				return TCL_ERROR;
 			return TCL_OK;
 		}
+		// Selects whether the multipath routing table is computed for the
+		// destination of each packet ("single") or for every destination
+		// at once ("all")
+		else if (strcasecmp(argv[1], "m_rtable_mode") == 0) {
+			if (strcasecmp(argv[2], "single") == 0)
+				m_rt_all_dest_ = false;
+			else if (strcasecmp(argv[2], "all") == 0)
+				m_rt_all_dest_ = true;
+			else {
+				fprintf(stderr, "%s: unknown %s %s\n", __FILE__, argv[1], argv[2]);
+				return TCL_ERROR;
+			}
+			m_rtable_.invalidate();
+			return TCL_OK;
+		}
+		// Selects how the paths towards a destination are diversified:
+		// "penalty" (links of the previous paths are penalized),
+		// "node_disjoint" or "link_disjoint"
+		else if (strcasecmp(argv[1], "path_diversity") == 0) {
+			if (strcasecmp(argv[2], "penalty") == 0)
+				path_diversity_ = MPOLSR_DIVERSITY_PENALTY;
+			else if (strcasecmp(argv[2], "node_disjoint") == 0)
+				path_diversity_ = MPOLSR_DIVERSITY_NODE_DISJOINT;
+			else if (strcasecmp(argv[2], "link_disjoint") == 0)
+				path_diversity_ = MPOLSR_DIVERSITY_LINK_DISJOINT;
+			else {
+				fprintf(stderr, "%s: unknown %s %s\n", __FILE__, argv[1], argv[2]);
+				return TCL_ERROR;
+			}
+			m_rtable_.invalidate();
+			return TCL_OK;
+		}
+		// Selects how originated packets are spread over the paths towards
+		// their destination: "round_robin", "wrr" (by inverse cost),
+		// "least_outstanding" or "delay" (by inverse first hop delay)
+		else if (strcasecmp(argv[1], "path_scheduler") == 0) {
+			MPOLSR_path_scheduler* scheduler = MPOLSR_path_scheduler::create(argv[2]);
+			if (scheduler == NULL) {
+				fprintf(stderr, "%s: unknown %s %s\n", __FILE__, argv[1], argv[2]);
+				return TCL_ERROR;
+			}
+			delete path_scheduler_;
+			path_scheduler_ = scheduler;
+			return TCL_OK;
+		}
+		// Selects the Mojette transform kernel: "scalar", "sse2" or "avx2".
+		// It is shared by every agent
+		else if (strcasecmp(argv[1], "mojette_kernel") == 0) {
+			if (!mojette_set_kernel(argv[2])) {
+				fprintf(stderr, "%s: unsupported %s %s\n", __FILE__, argv[1], argv[2]);
+				return TCL_ERROR;
+			}
+			return TCL_OK;
+		}
 	}
       	else if (strcasecmp(argv[1], "add-ll") == 0) {
 		TclObject* obj;
@@ -305,24 +512,6 @@ MPOLSR_MidTimer::expire(Event* e) {
 #endif
 }
 
-///
-/// \brief Removes tuple_ if expired. Else timer is rescheduled to expire at tuple_->time().
-///
-/// The task of actually removing the tuple is left to the MPOLSR agent.
-///
-/// \param e The event which has expired.
-///
-void
-MPOLSR_DupTupleTimer::expire(Event* e) {
-	if (tuple_->time() < CURRENT_TIME) {
-		agent_->rm_dup_tuple(tuple_);
-		delete tuple_;
-		delete this;
-	}
-	else
-		resched(DELAY(tuple_->time()));
-}
-
 ///
 /// \brief Removes tuple_ if expired. Else if symmetric time
 /// has expired then it is assumed a neighbor loss and agent_->nb_loss()
@@ -424,17 +613,132 @@ MPOLSR_IfaceAssocTupleTimer::expire(Event* e) {
 		resched(DELAY(tuple_->time()));
 }
 
+/********** Tuple expiry wheel **********/
+
+///
+/// \brief Hands the timer to the expiry wheel of its agent.
+/// \param delay time from now at which the timer expires.
+///
+void
+MPOLSR_TupleTimer::resched(double delay) {
+	agent_->expiry_wheel_.schedule(this, delay);
+}
+
+MPOLSR_ExpiryWheel::MPOLSR_ExpiryWheel() : TimerHandler() {
+	cursor_		= 0;
+	size_		= 0;
+	seq_		= 0;
+	next_		= -1.0;
+	sweeping_	= false;
+}
+
+///
+/// \brief Adds a tuple timer to the wheel.
+///
+/// The handler is only rescheduled if the timer is due before all the
+/// other ones.
+///
+/// \param timer the tuple timer.
+/// \param delay time from now at which the timer expires.
+///
+void
+MPOLSR_ExpiryWheel::schedule(MPOLSR_TupleTimer* timer, double delay) {
+	entry e;
+	e.time_		= CURRENT_TIME + delay;
+	e.tick_		= (long)floor(e.time_ / MPOLSR_WHEEL_TICK);
+	e.seq_		= seq_++;
+	e.timer_	= timer;
+	slots_[e.tick_ & (MPOLSR_WHEEL_SLOTS - 1)].push_back(e);
+	size_++;
+	if (e.tick_ < cursor_)
+		cursor_ = e.tick_;
+
+	// While sweeping, the handler is rescheduled once all due timers are expired
+	if (!sweeping_ && (next_ < 0 || e.time_ < next_)) {
+		next_ = e.time_;
+		resched(delay);
+	}
+}
+
+///
+/// \brief Expires all the due tuple timers, sorted by time and then by order
+/// of scheduling, and reschedules the handler at the next one.
+/// \param e The event which has expired.
+///
+void
+MPOLSR_ExpiryWheel::expire(Event* e) {
+	// The handler may run slightly before next_ due to rounding errors
+	double now	= MAX(CURRENT_TIME, next_);
+	long last	= (long)floor(now / MPOLSR_WHEEL_TICK);
+
+	// Every slot is visited once at most
+	if (last - cursor_ >= MPOLSR_WHEEL_SLOTS)
+		cursor_ = last - MPOLSR_WHEEL_SLOTS + 1;
+	for (long k = cursor_; k <= last; k++) {
+		std::vector<entry>& slot = slots_[k & (MPOLSR_WHEEL_SLOTS - 1)];
+		for (u_int32_t i = 0; i < slot.size();) {
+			if (slot[i].time_ <= now) {
+				due_.push_back(slot[i]);
+				slot[i] = slot.back();
+				slot.pop_back();
+			}
+			else
+				i++;
+		}
+	}
+	cursor_	= last;
+	size_	-= due_.size();
+	std::sort(due_.begin(), due_.end());
+
+	sweeping_ = true;
+	for (u_int32_t i = 0; i < due_.size(); i++)
+		due_[i].timer_->expire(e);
+	due_.clear();
+	sweeping_ = false;
+
+	reschedule();
+}
+
+///
+/// \brief Schedules the handler at the time of the earliest tuple timer.
+///
+void
+MPOLSR_ExpiryWheel::reschedule() {
+	next_ = -1.0;
+	if (size_ == 0)
+		return;
+
+	// The earliest timer lies in the first slot with a timer of the current round...
+	const entry* first = NULL;
+	for (long k = cursor_; first == NULL && k < cursor_ + MPOLSR_WHEEL_SLOTS; k++) {
+		std::vector<entry>& slot = slots_[k & (MPOLSR_WHEEL_SLOTS - 1)];
+		for (u_int32_t i = 0; i < slot.size(); i++)
+			if (slot[i].tick_ == k && (first == NULL || slot[i] < *first))
+				first = &slot[i];
+	}
+	// ...unless all of them lie beyond the wheel
+	if (first == NULL) {
+		for (int s = 0; s < MPOLSR_WHEEL_SLOTS; s++)
+			for (u_int32_t i = 0; i < slots_[s].size(); i++)
+				if (first == NULL || slots_[s][i] < *first)
+					first = &slots_[s][i];
+	}
+
+	cursor_	= first->tick_;
+	next_	= first->time_;
+	resched(next_ - CURRENT_TIME);
+}
+
 ///
-/// \brief Sends a control packet which must bear every message in the MPOLSR agent's buffer.
+/// \brief Sends the control packets which must bear every message in the MPOLSR agent's buffer.
 ///
-/// The task of actually sending the packet is left to the MPOLSR agent.
+/// The task of actually sending the packets is left to the MPOLSR agent.
 ///
 /// \param e The event which has expired.
 ///
 void
 MPOLSR_MsgTimer::expire(Event* e) {
 	agent_->send_pkt();
-	delete this;
 }
 
 
@@ -451,7 +755,8 @@ MPOLSR::MPOLSR(nsaddr_t id) :
 Agent::Agent(PT_MPOLSR),
 hello_timer_(this),
 tc_timer_(this),
-mid_timer_(this) {
+mid_timer_(this),
+msg_timer_(this) {
 
 	// Enable usage of some of the configuration variables from Tcl.
 	//
@@ -463,14 +768,54 @@ mid_timer_(this) {
 	bind("tc_ival_", &tc_ival_);
 	bind("mid_ival_", &mid_ival_);
 	bind_bool("use_mac_", &use_mac_);
+	bind("max_pkt_size_", &max_pkt_size_);
+	bind_bool("tc_delta_", &tc_delta_);
+	bind("tc_full_ival_", &tc_full_ival_);
+	bind_bool("timing_", &timing_);
+	bind("max_route_", &max_route_);
+	bind("mojette_n_", &mojette_n_);
+	bind("mojette_m_", &mojette_m_);
 	
 	// Do some initializations
 	ra_addr_	= id;
 	pkt_seq_	= MPOLSR_MAX_SEQ_NUM;
 	msg_seq_	= MPOLSR_MAX_SEQ_NUM;
 	ansn_		= MPOLSR_MAX_SEQ_NUM;
+	mpr_version_		= 0;
+	msgs_deadline_	= 0.0;
+	bundle_pkts_	= 0;
+	bundle_msgs_	= 0;
+	bundle_saved_	= 0;
+	bundle_max_	= 0;
+	mac_acks_	= 0;
+	mac_foreign_acks_	= 0;
+	tc_ansn_	= MPOLSR_MAX_SEQ_NUM;
+	tc_full_time_	= 0.0;
+	tc_full_req_	= true;
+	tc_full_	= 0;
+	tc_deltas_	= 0;
+	tc_reqs_	= 0;
+	tc_gaps_	= 0;
+	tc_bytes_	= 0;
+	tc_rcvd_	= 0;
+	tc_time_	= 0.0;
 
 	packet_count_ 	= 0;
+
+	topology_epoch_	= 1;
+	m_rt_computed_	= 0;
+	m_rt_avoided_	= 0;
+	m_rt_all_dest_	= false;
+	path_diversity_	= MPOLSR_DIVERSITY_PENALTY;
+	m_rt_max_route_	= 0;
+	path_scheduler_	= new MPOLSR_rr_scheduler();
+}
+
+///
+/// \brief Destroys the agent and its path scheduler.
+///
+MPOLSR::~MPOLSR() {
+	delete path_scheduler_;
 }
 
 /// 
@@ -494,8 +839,8 @@ MPOLSR::recv(Packet* p, Handler* h) {
 //	if(ifq->prq_length()>10)
 //	printf("%d \t ", ifq->prq_length());
 
-	nsaddr_t dest = ih->daddr();
-	
+	mpolsr_clear_mac_callbacks(p);
+
 	if (ih->saddr() == ra_addr()) {
 		// If there exists a loop, must drop the packet
 		if (ch->num_forwards() > 0) {
@@ -509,19 +854,23 @@ MPOLSR::recv(Packet* p, Handler* h) {
 		//	ch->error() = 0;
 			
 			
-			//check the flag of routing table. If it is out of date, recompute the routing table
-			if(m_rtable_.get_flag(dest) == true){
-				m_rtable_computation(p);
-			}
+			//if the routing table is out of date, recompute it
+			m_rtable_update(p);
 
 			//this must be an outgoing packet, it doesn't have a SR header on it
 			srh->init();
 
+			//with erasure coding, the projections are routed on their own
+			if (mojette_n_ > 0 && ch->ptype() != PT_MPOLSR) {
+				send_projections(p);
+				return;
+			}
+
 			//here we must chose one route from the routing table
-			m_rtable_t::iterator temp_it = m_rtable_.lookup(ih->daddr());
+			MPOLSR_m_rt_entry* m_entry = select_path(p);
 
 			//if there is no route, we must drop the packet and return
-			if(temp_it == (*m_rtable_.m_rt()).end()){
+			if(m_entry == NULL){
 				debug("%f: Node %d can not forward a packet destined to %d\n",
 					CURRENT_TIME,
 					MPOLSR::node_id(ra_addr()),
@@ -529,22 +878,10 @@ MPOLSR::recv(Packet* p, Handler* h) {
 				drop(p, DROP_RTR_NO_ROUTE);
 				return;
 			}
-			
-			//now find a route
-			for (int j = 0;j<packet_count_%MAX_ROUTE;j++)
-				temp_it++;
 
 			packet_count_++;
 			//now we must fill the source route
-			sr_addr* temp_addrs;
-			temp_addrs = srh->addrs();
-			
-			MPOLSR_m_rt_entry* m_entry = (*temp_it).second;
-			for(int i = 0;i<MAX_SR_LEN;i++){
-				*temp_addrs = m_entry->addr_[i];
-				temp_addrs++;
-			}
-			
+			set_source_route(srh, m_entry);
 		}
 	}
 	
@@ -587,9 +924,10 @@ MPOLSR::recv_mpolsr(Packet* p) {
 		return;
 	}
 	
-	assert(op->count >= 0 && op->count <= MPOLSR_MAX_MSGS);
+	assert(op->count >= 0);
 	for (int i = 0; i < op->count; i++) {
-		MPOLSR_msg& msg = op->msg(i);
+		MPOLSR_msg msg;
+		MPOLSR_pkt::get_msg(p, i, msg);
 		
 		// If ttl is less than or equal to zero, or
 		// the receiver is the same as the originator,
@@ -600,15 +938,26 @@ MPOLSR::recv_mpolsr(Packet* p) {
 		// If the message has been processed it must not be
 		// processed again
 		bool do_forwarding = true;
-		MPOLSR_dup_tuple* duplicated = state_.find_dup_tuple(msg.orig_addr(), msg.msg_seq_num());
-		if (duplicated == NULL) {
+		if (!state_.find_dup(msg.orig_addr(), msg.msg_seq_num(), CURRENT_TIME)) {
 			// Process the message according to its type
 			if (msg.msg_type() == MPOLSR_HELLO_MSG)
 				process_hello(msg, ra_addr(), ih->saddr());
-			else if (msg.msg_type() == MPOLSR_TC_MSG)
-				process_tc(msg, ih->saddr());
+			else if (msg.msg_type() == MPOLSR_TC_MSG) {
+				tc_rcvd_++;
+				if (timing_) {
+					struct timeval start, end;
+					gettimeofday(&start, NULL);
+					process_tc(msg, ih->saddr());
+					gettimeofday(&end, NULL);
+					tc_time_ += (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+				}
+				else
+					process_tc(msg, ih->saddr());
+			}
 			else if (msg.msg_type() == MPOLSR_MID_MSG)
 				process_mid(msg, ih->saddr());
+			else if (msg.msg_type() == MPOLSR_TC_REQ_MSG)
+				process_tc_req(msg);
 			else {
 				debug("%f: Node %d can not process MPOLSR packet because does not "
 					"implement MPOLSR type (%x)\n",
@@ -620,14 +969,7 @@ MPOLSR::recv_mpolsr(Packet* p) {
 		else {
 			// If the message has been considered for forwarding, it should
 			// not be retransmitted again
-			for (addr_list_t::iterator it = duplicated->iface_list().begin();
-				it != duplicated->iface_list().end();
-				it++) {
-				if (*it == ra_addr()) {
-					do_forwarding = false;
-					break;
-				}
-			}
+			do_forwarding = false;
 		}
 			
 		if (do_forwarding) {
@@ -635,7 +977,7 @@ MPOLSR::recv_mpolsr(Packet* p) {
 			// TC and MID messages are forwarded using the default algorithm.
 			// Remaining messages are also forwarded using the default algorithm.
 			if (msg.msg_type() != MPOLSR_HELLO_MSG)
-				forward_default(p, msg, duplicated, ra_addr());
+				forward_default(p, msg, ra_addr());
 		}
 
 	}
@@ -643,30 +985,78 @@ MPOLSR::recv_mpolsr(Packet* p) {
 	// After processing all MPOLSR messages, we must recompute routing table,for unipath routing
 //	rtable_computation();
 	
-	//for multipath rouitng, instead of recompute the routing table, just set the flag
-	m_rtable_.set_flag(true);
+	//for multipath routing, the routing table is recomputed lazily when the
+	//topology epoch has changed (see m_rtable_update())
 	
 	// Release resources
 	Packet::free(p);
 }
 
+///
+/// \brief Moves a member of N to a bucket of the MPR computation.
+///
+/// \param buckets the buckets, by willingness and reachability.
+/// \param pos position of every member of N in its bucket.
+/// \param b the bucket.
+/// \param y the member of N.
+///
+static void
+bucket_insert(std::vector<std::vector<int> >& buckets, std::vector<int>& pos, int b, int y) {
+	pos[y] = buckets[b].size();
+	buckets[b].push_back(y);
+}
+
+///
+/// \brief Removes a member of N from a bucket of the MPR computation.
+///
+/// \param buckets the buckets, by willingness and reachability.
+/// \param pos position of every member of N in its bucket.
+/// \param b the bucket.
+/// \param y the member of N.
+///
+static void
+bucket_erase(std::vector<std::vector<int> >& buckets, std::vector<int>& pos, int b, int y) {
+	std::vector<int>& bucket = buckets[b];
+	bucket[pos[y]]		= bucket.back();
+	pos[bucket[pos[y]]]	= pos[y];
+	bucket.pop_back();
+}
+
 ///
 /// \brief Computates MPR set of a node following RFC 3626 hints.
 ///
+/// The set only depends on the Neighbor Set and the 2-hop Neighbor Set, so it
+/// is only computed again once they have changed. The members of N are kept
+/// in buckets by willingness and reachability, which are updated as the
+/// members of N2 get covered, so that every step of the heuristic only looks
+/// at the members with the highest willingness and reachability.
+///
 void
 MPOLSR::mpr_computation() {
+	if (mpr_version_ == state_.nbhood_version())
+		return;
+	mpr_version_ = state_.nbhood_version();
+
 	// MPR computation should be done for each interface. See section 8.3.1
 	// (RFC 3626) for details.
 	
 	state_.clear_mprset();
-//	printf("computing mpr\n");
 	
-	nbset_t N; nb2hopset_t N2;
 	// N is the subset of neighbors of the node, which are
-	// neighbor "of the interface I"
-	for (nbset_t::iterator it = nbset().begin(); it != nbset().end(); it++)
-		if ((*it)->status() == MPOLSR_STATUS_SYM) // I think that we need this check
-			N.push_back(*it);
+	// neighbor "of the interface I". Its members are numbered in the
+	// order of the Neighbor Set.
+	std::vector<MPOLSR_nb_tuple*> N;
+	MPOLSR_hash<nsaddr_t, int> N_index;
+	int max_willingness = 0;
+	for (nbset_t::iterator it = nbset().begin(); it != nbset().end(); it++) {
+		MPOLSR_nb_tuple* nb_tuple = *it;
+		if (nb_tuple->status() == MPOLSR_STATUS_SYM // I think that we need this check
+			&& N_index.find(nb_tuple->nb_main_addr()) == NULL) {
+			N_index[nb_tuple->nb_main_addr()] = N.size();
+			N.push_back(nb_tuple);
+			max_willingness = MAX(max_willingness, nb_tuple->willingness());
+		}
+	}
 	
 	// N2 is the set of 2-hop neighbors reachable from "the interface
 	// I", excluding:
@@ -674,179 +1064,123 @@ MPOLSR::mpr_computation() {
 	// (ii)  the node performing the computation
 	// (iii) all the symmetric neighbors: the nodes for which there exists a symmetric
 	//       link to this node on some interface.
+	// Its members are numbered too, providers holds the members of N which
+	// every one is reachable through, and covers the members of N2 which are
+	// reachable through every member of N.
+	//
+	// 2. Calculate D(y), where y is a member of N, for all nodes in N:
+	// the number of symmetric neighbors of y, excluding all the members
+	// of N and the node performing the computation.
+	MPOLSR_hash<nsaddr_t, int> N2_index;
+	std::vector<std::vector<int> > providers;
+	std::vector<std::vector<int> > covers(N.size());
+	std::vector<int> degree(N.size(), 0);
 	for (nb2hopset_t::iterator it = nb2hopset().begin(); it != nb2hopset().end(); it++) {
 		MPOLSR_nb2hop_tuple* nb2hop_tuple = *it;
-		bool ok = true;
-		MPOLSR_nb_tuple* nb_tuple = state_.find_sym_nb_tuple(nb2hop_tuple->nb_main_addr());
-		if (nb_tuple == NULL)
-			ok = false;
-		else {
-			nb_tuple = state_.find_nb_tuple(nb2hop_tuple->nb_main_addr(), MPOLSR_WILL_NEVER);
-			if (nb_tuple != NULL)
-				ok = false;
-			else {
-				nb_tuple = state_.find_sym_nb_tuple(nb2hop_tuple->nb2hop_addr());
-				if (nb_tuple != NULL)
-					ok = false;
-			}
+		nsaddr_t addr	= nb2hop_tuple->nb2hop_addr();
+		int* y		= N_index.find(nb2hop_tuple->nb_main_addr());
+		if (y == NULL || addr == ra_addr() || N_index.find(addr) != NULL)
+			continue;
+		degree[*y]++;
+		if (N[*y]->willingness() == MPOLSR_WILL_NEVER)
+			continue;
+		int* x = N2_index.find(addr);
+		if (x == NULL) {
+			N2_index[addr] = providers.size();
+			providers.push_back(std::vector<int>());
+			x = N2_index.find(addr);
 		}
-
-		if (ok)
-			N2.push_back(nb2hop_tuple);
+		providers[*x].push_back(*y);
+		covers[*y].push_back(*x);
 	}
 	
-	// 1. Start with an MPR set made of all members of N with
-	// N_willingness equal to WILL_ALWAYS
-	for (nbset_t::iterator it = N.begin(); it != N.end(); it++) {
-		MPOLSR_nb_tuple* nb_tuple = *it;
-		if (nb_tuple->willingness() == MPOLSR_WILL_ALWAYS)
-			state_.insert_mpr_addr(nb_tuple->nb_main_addr());
+	// The reachability of a member of N is the number of members of N2
+	// which are not yet covered by a node in the MPR set, and which are
+	// reachable through it. Members of N which are not in the MPR set
+	// and have a non-zero reachability are kept in buckets, which sort
+	// them by willingness and then by reachability.
+	int stride	= providers.size() + 1;
+	int n_buckets	= (max_willingness + 1) * stride;
+	std::vector<std::vector<int> > buckets(n_buckets);
+	std::vector<int> reachability(N.size());
+	std::vector<int> pos(N.size());
+	for (u_int32_t y = 0; y < N.size(); y++) {
+		reachability[y] = covers[y].size();
+		if (reachability[y] > 0)
+			bucket_insert(buckets, pos,
+				N[y]->willingness() * stride + reachability[y], y);
 	}
 	
-	// 2. Calculate D(y), where y is a member of N, for all nodes in N.
-	// We will do this later.
+	// 1. Start with an MPR set made of all members of N with
+	// N_willingness equal to WILL_ALWAYS
+	std::vector<int> selected;
+	for (u_int32_t y = 0; y < N.size(); y++)
+		if (N[y]->willingness() == MPOLSR_WILL_ALWAYS)
+			selected.push_back(y);
 	
 	// 3. Add to the MPR set those nodes in N, which are the *only*
 	// nodes to provide reachability to a node in N2. Remove the
 	// nodes from N2 which are now covered by a node in the MPR set.
-	mprset_t foundset;
-	std::set<nsaddr_t> deleted_addrs;
-	for (nb2hopset_t::iterator it = N2.begin(); it != N2.end(); it++) {
-		MPOLSR_nb2hop_tuple* nb2hop_tuple1 = *it;
-		
-		mprset_t::iterator pos = foundset.find(nb2hop_tuple1->nb2hop_addr());
-		if (pos != foundset.end())
-			continue;
-		
-		bool found = false;
-		for (nbset_t::iterator it2 = N.begin(); it2 != N.end(); it2++) {
-			if ((*it2)->nb_main_addr() == nb2hop_tuple1->nb_main_addr()) {
-				found = true;
-				break;
-			}
-		}
-		if (!found)
-			continue;
-		
-		found = false;
-		for (nb2hopset_t::iterator it2 = it + 1; it2 != N2.end(); it2++) {
-			MPOLSR_nb2hop_tuple* nb2hop_tuple2 = *it2;
-			if (nb2hop_tuple1->nb2hop_addr() == nb2hop_tuple2->nb2hop_addr()) {
-				foundset.insert(nb2hop_tuple1->nb2hop_addr());
-				found = true;
-				break;
-			}
-		}
-		if (!found) {
-			state_.insert_mpr_addr(nb2hop_tuple1->nb_main_addr());
-			
-			for (nb2hopset_t::iterator it2 = it + 1; it2 != N2.end(); it2++) {
-				MPOLSR_nb2hop_tuple* nb2hop_tuple2 = *it2;
-				if (nb2hop_tuple1->nb_main_addr() == nb2hop_tuple2->nb_main_addr()) {
-					deleted_addrs.insert(nb2hop_tuple2->nb2hop_addr());
-					it2 = N2.erase(it2);
-					it2--;
-				}
-			}
-			it = N2.erase(it);
-			it--;
-		}
-		
-		for (std::set<nsaddr_t>::iterator it2 = deleted_addrs.begin();
-			it2 != deleted_addrs.end();
-			it2++) {
-			for (nb2hopset_t::iterator it3 = N2.begin();
-				it3 != N2.end();
-				it3++) {
-				if ((*it3)->nb2hop_addr() == *it2) {
-					it3 = N2.erase(it3);
-					it3--;
-					// I have to reset the external iterator because it
-					// may have been invalidated by the latter deletion
-					it = N2.begin();
-					it--;
-				}
-			}
-		}
-		deleted_addrs.clear();
-	}
+	for (u_int32_t x = 0; x < providers.size(); x++)
+		if (providers[x].size() == 1)
+			selected.push_back(providers[x][0]);
 	
 	// 4. While there exist nodes in N2 which are not covered by at
 	// least one node in the MPR set:
-	while (N2.begin() != N2.end()) {
-		// 4.1. For each node in N, calculate the reachability, i.e., the
-		// number of nodes in N2 which are not yet covered by at
-		// least one node in the MPR set, and which are reachable
-		// through this 1-hop neighbor
-		map<int, std::vector<MPOLSR_nb_tuple*> > reachability;
-		set<int> rs;
-		for (nbset_t::iterator it = N.begin(); it != N.end(); it++) {
-			MPOLSR_nb_tuple* nb_tuple = *it;
-			int r = 0;
-			for (nb2hopset_t::iterator it2 = N2.begin(); it2 != N2.end(); it2++) {
-				MPOLSR_nb2hop_tuple* nb2hop_tuple = *it2;
-				if (nb_tuple->nb_main_addr() == nb2hop_tuple->nb_main_addr())
-					r++;
-			}
-			rs.insert(r);
-			reachability[r].push_back(nb_tuple);
+	std::vector<bool> mpr(N.size(), false);
+	std::vector<bool> covered(providers.size(), false);
+	u_int32_t uncovered = providers.size();
+	u_int32_t next = 0;
+	int top = n_buckets - 1;
+	while (next < selected.size() || uncovered > 0) {
+		int max;
+		if (next < selected.size()) {
+			max = selected[next++];
+			if (mpr[max])
+				continue;
 		}
-		
-		// 4.2. Select as a MPR the node with highest N_willingness among
-		// the nodes in N with non-zero reachability. In case of
-		// multiple choice select the node which provides
-		// reachability to the maximum number of nodes in N2. In
-		// case of multiple nodes providing the same amount of
-		// reachability, select the node as MPR whose D(y) is
-		// greater. Remove the nodes from N2 which are now covered
-		// by a node in the MPR set.
-		MPOLSR_nb_tuple* max = NULL;
-		int max_r = 0;
-		for (set<int>::iterator it = rs.begin(); it != rs.end(); it++) {
-			int r = *it;
-			if (r > 0) {
-				for (std::vector<MPOLSR_nb_tuple*>::iterator it2 = reachability[r].begin();
-					it2 != reachability[r].end();
-					it2++) {
-					MPOLSR_nb_tuple* nb_tuple = *it2;
-					if (max == NULL || nb_tuple->willingness() > max->willingness()) {
-						max = nb_tuple;
-						max_r = r;
-					}
-					else if (nb_tuple->willingness() == max->willingness()) {
-						if (r > max_r) {
-							max = nb_tuple;
-							max_r = r;
-						}
-						else if (r == max_r) {
-							if (degree(nb_tuple) > degree(max)) {
-								max = nb_tuple;
-								max_r = r;
-							}
-						}
-					}
-				}
+		else {
+			// 4.2. Select as a MPR the node with highest N_willingness among
+			// the nodes in N with non-zero reachability. In case of
+			// multiple choice select the node which provides
+			// reachability to the maximum number of nodes in N2. In
+			// case of multiple nodes providing the same amount of
+			// reachability, select the node as MPR whose D(y) is
+			// greater.
+			while (buckets[top].empty())
+				top--;
+			max = buckets[top][0];
+			for (u_int32_t i = 1; i < buckets[top].size(); i++) {
+				int y = buckets[top][i];
+				if (degree[y] > degree[max] || (degree[y] == degree[max] && y < max))
+					max = y;
 			}
 		}
-		if (max != NULL) {
-			state_.insert_mpr_addr(max->nb_main_addr());
-			std::set<nsaddr_t> nb2hop_addrs;
-			for (nb2hopset_t::iterator it = N2.begin(); it != N2.end(); it++) {
-				MPOLSR_nb2hop_tuple* nb2hop_tuple = *it;
-				if (nb2hop_tuple->nb_main_addr() == max->nb_main_addr()) {
-					nb2hop_addrs.insert(nb2hop_tuple->nb2hop_addr());
-					it = N2.erase(it);
-					it--;
-				}
-			}
-			for (nb2hopset_t::iterator it = N2.begin(); it != N2.end(); it++) {
-				MPOLSR_nb2hop_tuple* nb2hop_tuple = *it;
-				std::set<nsaddr_t>::iterator it2 =
-					nb2hop_addrs.find(nb2hop_tuple->nb2hop_addr());
-				if (it2 != nb2hop_addrs.end()) {
-					it = N2.erase(it);
-					it--;
-				}
+		
+		mpr[max] = true;
+		state_.insert_mpr_addr(N[max]->nb_main_addr());
+		if (reachability[max] > 0)
+			bucket_erase(buckets, pos,
+				N[max]->willingness() * stride + reachability[max], max);
+		
+		// Remove the nodes from N2 which are now covered by a node in the
+		// MPR set, and update the reachability of the nodes they are
+		// reachable through.
+		for (u_int32_t i = 0; i < covers[max].size(); i++) {
+			int x = covers[max][i];
+			if (covered[x])
+				continue;
+			covered[x] = true;
+			uncovered--;
+			for (u_int32_t j = 0; j < providers[x].size(); j++) {
+				int y = providers[x][j];
+				int b = N[y]->willingness() * stride + reachability[y];
+				reachability[y]--;
+				if (mpr[y])
+					continue;
+				bucket_erase(buckets, pos, b, y);
+				if (reachability[y] > 0)
+					bucket_insert(buckets, pos, b - 1, y);
 			}
 		}
 	}
@@ -967,299 +1301,277 @@ MPOLSR::rtable_computation() {
 			}
 		}
 
-		if (!added)
-			break;
+		if (!added)
+			break;
+	}
+}
+
+///
+/// \brief Computes the multipath routing table entries towards the destination
+///	   of a given packet.
+///
+/// The graph is built once from the topology, neighbor and 2-hop neighbor sets,
+/// and then max_route_ rounds of a heap based Dijkstra are run over it. After
+/// each round the links of the found path are penalized by tuple_weight().
+///
+/// When the all-destination mode is enabled (see the "m_rtable_mode" command),
+/// the same graph is used for computing the paths towards every reachable node,
+/// so that packets to other destinations do not trigger a new computation
+/// until the topology changes.
+///
+/// \param p the packet which triggered the computation.
+///
+void 
+MPOLSR::m_rtable_computation(Packet* p){
+	struct hdr_cmn* ch	= HDR_CMN(p);
+	struct hdr_ip* ih	= HDR_IP(p);
+
+	debug("%f: Node %d computes the paths for packet %d\n",
+	      CURRENT_TIME, ra_addr(), ch->uid_);
+	m_rt_computed_++;
+
+	//destination
+	nsaddr_t dest = ih->daddr();
+	//source
+	nsaddr_t source = ra_addr();
+
+	//gather the topology info: topology set, nb set, 2nbset
+	dijkstra_.build(source, topologyset(), nbset(), nb2hopset());
+
+	if (m_rt_all_dest_) {
+		for (int i = 0; i < dijkstra_.num_nodes(); i++) {
+			if (dijkstra_.node_addr(i) != source)
+				m_rtable_fill(dijkstra_.node_addr(i));
+		}
+		//the destination may not be part of the graph
+		if (!m_rtable_.up_to_date(dest, topology_epoch_))
+			m_rtable_fill(dest);
+	}
+	else
+		m_rtable_fill(dest);
+}
+
+///
+/// \brief Replaces the multipath routing table entries towards a destination
+///	   by the paths computed over the current graph of dijkstra_.
+///
+/// \param dest the address of the destination node.
+///
+void
+MPOLSR::m_rtable_fill(nsaddr_t dest) {
+	nsaddr_t source = ra_addr();
+
+	//clear the old entries
+	m_rtable_.rm_entry(dest);
+
+	MPOLSR_path_list paths;
+	int result;
+	if (path_diversity_ == MPOLSR_DIVERSITY_PENALTY)
+		result = dijkstra_.k_paths(dest, max_route(), &MPOLSR::tuple_weight, paths);
+	else
+		result = dijkstra_.disjoint_paths(dest, max_route(),
+			path_diversity_ == MPOLSR_DIVERSITY_NODE_DISJOINT, paths);
+
+	for (MPOLSR_path_list::iterator it = paths.begin(); it != paths.end(); it++) {
+		if ((*it).size() > MAX_SR_LEN) {
+			debug("%f: Node %d drops a path towards %d of %d hops\n",
+			      CURRENT_TIME, source, dest, (int)(*it).size());
+			continue;
+		}
+
+		//add the entry to routing table
+		MPOLSR_m_rt_entry* m_rt_entry = m_rtable_.add_entry(dest);
+		if (m_rt_entry == NULL)
+			break;
+		for (u_int32_t j = 0; j < (*it).size(); j++)
+			m_rt_entry->addr_[j] = (*it)[j];
+		if (isdebug()) {
+			debug("%f: Node %d path towards %d:", CURRENT_TIME, source, dest);
+			for (u_int32_t j = 0; j < (*it).size(); j++)
+				debug(" %d", (*it)[j]);
+			debug("\n");
+		}
+		m_rt_entry->len_	= (*it).size();
+		m_rt_entry->cost_	= m_rt_entry->hops();
+		m_rt_entry->diversity_	= path_diversity_;
+		m_rtable_.inherit(m_rt_entry);
+	}
+
+	if (result != MPOLSR_PATH_FOUND)
+		debug("%f: Node %d finds no path towards %d\n",
+		      CURRENT_TIME, source, dest);
+
+	//finish the computation, the entries stay valid until the topology changes
+	m_rtable_.set_epoch(dest, topology_epoch_);
+}
+
+///
+/// \brief Copies a path of the multipath routing table into the source route
+///	of a packet.
+///
+/// Only the hops of the path are copied. The length of the source route is
+/// the one of the path, and its current hop is the first one, i.e. this node.
+///
+/// \param srh the source routing header of the packet.
+/// \param m_entry the selected path.
+///
+void
+MPOLSR::set_source_route(struct hdr_sr* srh, MPOLSR_m_rt_entry* m_entry) {
+	sr_addr* temp_addrs = srh->addrs();
+	for (int i = 0; i < m_entry->len_; i++) {
+		temp_addrs[i].addr_type	= 0;
+		temp_addrs[i].addr	= m_entry->addr_[i];
+		temp_addrs[i].Pt_	= 0;
+	}
+	srh->num_addrs()	= m_entry->len_;
+	srh->cur_addr()		= 0;
+	m_entry->last_used_	= CURRENT_TIME;
+}
+
+///
+/// \brief Looks for this node in the source route of a packet whose current
+///	hop is not up to date.
+///
+/// \param srh the source routing header of the packet.
+/// \return the position of this node in the source route, or -1 if it is not there.
+///
+int
+MPOLSR::find_in_source_route(struct hdr_sr* srh) {
+	for (int i = 0; i < srh->num_addrs(); i++)
+		if (srh->addrs()[i].addr == ra_addr())
+			return i;
+	return -1;
+}
+
+///
+/// \brief Chooses, by means of the path scheduler, the path of an originated packet.
+///
+/// The path scheduler is told about the packet, and the packet asks the MAC layer
+/// for a feedback if the scheduler needs it.
+///
+/// \param p the packet which is going to be routed.
+/// \return the selected path, or NULL if there is no path towards the destination.
+///
+MPOLSR_m_rt_entry*
+MPOLSR::select_path(Packet* p) {
+	struct hdr_cmn* ch	= HDR_CMN(p);
+	MPOLSR_m_rt_dest* d	= m_rtable_.lookup(HDR_IP(p)->daddr());
+	if (d == NULL)
+		return NULL;
+
+	MPOLSR_m_rt_entry* m_entry = &d->paths_[path_scheduler_->select(*d)];
+	path_scheduler_->sent(*m_entry, ch->uid());
+	if (path_scheduler_->feedback()) {
+		ch->xmit_success_	= mpolsr_mac_succeeded_callback;
+		ch->xmit_failure_data_	= (void*)this;
 	}
+	else
+		ch->xmit_success_	= 0;
+	return m_entry;
 }
 
-void 
-MPOLSR::m_rtable_computation(Packet* p){
-		struct hdr_cmn* ch	= HDR_CMN(p);
-		struct hdr_ip* ih	= HDR_IP(p);
-		struct hdr_sr* srh	= HDR_SR(p);   //the head for source routing
-		
-		struct sr_addr addrs_[MAX_SR_LEN];
-		double start_time, end_time;
-		int sr_count_ = 0;
-		bool type_flag = false;
-	
-		printf("\n packet ID:%d",ch->uid_);
-			
-		map<nsaddr_t,Dijkstra_node*>::iterator n_it,n_it_d;
-		
-		//destination
-		nsaddr_t dest = ih->daddr();
-		//source
-		nsaddr_t source = ra_addr();
-		
-		//clear the old entries
-		m_rtable_.rm_entry(dest);
-	
-		//gather the topology info: topology set, nb set, 2nbset
-		/*			MPOLSR_topology_tuple* topology_tuple = new MPOLSR_topology_tuple;
-				topology_tuple->dest_addr() = addr; 
-				topology_tuple->last_addr() = msg.orig_addr();
-				topology_tuple->seq()		= tc.ansn();
-				topology_tuple->time()		= now + MPOLSR::emf_to_seconds(msg.vtime());
-				topology_tuple->weight()	= 1;//initialize the weight
-				add_topology_tuple(topology_tuple);
-		*/
-	
-		start_time = CURRENT_TIME;
-		topologyset_t	n_topologyset_; 
-		MPOLSR_topology_tuple* tt;
-		for (topologyset_t::iterator it = topologyset().begin(); it != topologyset().end(); it++){
-			tt = new MPOLSR_topology_tuple;
-			tt->dest_addr() = (*it)->dest_addr_;
-			tt->last_addr() = (*it)->last_addr_;
-			tt->weight() = 1;	
-			if(tt->dest_addr()==ra_addr()||tt->last_addr()==ra_addr()){
-				delete tt;
-				continue;
-			}
-			n_topologyset_.push_back(tt);
-		}
-		for (nbset_t::iterator it = nbset().begin();it!=nbset().end();it++){
-			tt = new MPOLSR_topology_tuple;
-			tt->dest_addr() = (*it)->nb_main_addr_;
-			tt->last_addr() = ra_addr();
-			tt->weight() = 1;
-			n_topologyset_.push_back(tt);
-			//printf("%d, %d|\t", tt->last_addr(),tt->dest_addr());
-		}
-		for(nb2hopset_t::iterator it = nb2hopset().begin();it!=nb2hopset().end();it++){
-			tt = new MPOLSR_topology_tuple;
-			tt->dest_addr() = (*it)->nb2hop_addr_;
-			tt->last_addr() = (*it)->nb_main_addr_;
-			tt->weight() = 1;
-			if(tt->dest_addr()==ra_addr()||tt->last_addr()==ra_addr()){
-				delete tt;
-				continue;
-			}
-			n_topologyset_.push_back(tt);
-		}
-		
-		//get the node map
-		map<nsaddr_t, Dijkstra_node*> node_map_;
-	
-		//add the node itself
-		pair<map<nsaddr_t,Dijkstra_node*>::iterator,bool> ret;
-		Dijkstra_node* node = new Dijkstra_node;
-		(*node).addr_ = ra_addr();
-		(*node).weight_ = MAX_WEIGHT;
-		(*node).node_type = 0;
-		ret = node_map_.insert(pair<nsaddr_t,Dijkstra_node*>((*node).addr_,node));
-		
-		for (topologyset_t::iterator it = n_topologyset_.begin(); it != n_topologyset_.end(); it++){
-			//unvisited_.insert(pair<nsaddr_t,float>((*it)->dest_addr_,MAX_WEIGHT));
-			//	unvisited_.insert(pair<nsaddr_t,float>((*it)->last_addr_,MAX_WEIGHT));
-			pair<map<nsaddr_t,Dijkstra_node*>::iterator,bool> ret;
-			
-			Dijkstra_node* node = new Dijkstra_node;
-			(*node).addr_ = (*it)->last_addr_;
-			(*node).weight_ = MAX_WEIGHT;
-			(*node).node_type = 0;
-					ret = node_map_.insert(pair<nsaddr_t,Dijkstra_node*>((*node).addr_,node));
-			if (ret.second == false)	
-				delete node;
-			
-			
-			node = new Dijkstra_node;
-			(*node).addr_ = (*it)->dest_addr_;
-			(*node).weight_ = MAX_WEIGHT;
-			(*node).node_type = 0;
-					ret = node_map_.insert(pair<nsaddr_t,Dijkstra_node*>((*node).addr_,node));
-			if(ret.second == false)
-				delete node;
-	
-			(**it).weight_ = 1;
-			//node_set_.insert(node);
-		}
-	/*
-		//for test print the node set
-		int test0 = 0;
-		for(n_it = node_map_.begin();n_it != node_map_.end();n_it++){
-			printf("%d\t",(*n_it).first);
-			//test0++;
-		}*/
-		printf("\n");
-		/*
-		//	0 for T (temporary) type, 1 for P type
-		//initialize set the source to P type
-		n_it = node_map_.find(source);
-		(*(*n_it).second).node_type = P_TYPE;
-		(*(*n_it).second).weight_ = 0;
-		*/
-		Dijkstra_node *node_n, *node_t;
-		
-		for (int i = 0;i<MAX_ROUTE;i++){
-			n_it = node_map_.find(source);
-			(*(*n_it).second).node_type = P_TYPE;
-			(*(*n_it).second).weight_ = 0;
-			for(;;){
-				//1. renew all the weight_ of T type nodes
-				
-				for(topologyset_t::iterator it = n_topologyset_.begin(); it != n_topologyset_.end(); it++){
-					for(n_it = node_map_.begin();n_it != node_map_.end();n_it++){
-				/*		Dijkstra_node node_s, node_d;
-						node_s = *(*n_it).second;
-						//this part still need to be modified for uni-path protocol
-						if((node_s.node_type == P_TYPE) && ((node_s.addr_ == (*it)->last_addr_)||(node_s.addr_ == (*it)->dest_addr_))){
-							if (node_s.addr_ == (*it)->last_addr_)
-								n_it_d = node_map_.find((*it)->dest_addr_);
-							else
-								n_it_d = node_map_.find((*it)->last_addr_);
-							
-							node_d = *(*n_it_d).second;
-							if (node_s.weight_ + (*it)->weight_ < node_d.weight_){
-								node_d.weight_ = node_s.weight_ + (*it)->weight_;
-								node_d.pre_addr_ = node_s.addr_;
-							}
-							
-						}*/
-						Dijkstra_node *node_s, *node_d;
-						node_s = (*n_it).second;
-						//this part still need to be modified for uni-direction protocol
-						if(((*node_s).node_type == P_TYPE) && (((*node_s).addr_ == (*it)->last_addr_)||((*node_s).addr_ == (*it)->dest_addr_))){
-							if ((*node_s).addr_ == (*it)->last_addr_)
-								n_it_d = node_map_.find((*it)->dest_addr_);
-							else
-								n_it_d = node_map_.find((*it)->last_addr_);
-							
-							node_d = (*n_it_d).second;
-							if ((*node_s).weight_ + (*it)->weight_ < (*node_d).weight_){
-								(*node_d).weight_ = (*node_s).weight_ + (*it)->weight_;
-								(*node_d).pre_addr_ = (*node_s).addr_;
-							}
-						}
-						
-					}
-				}
-				
-				//2. find the T type node with the min weight_, and set it to P type
-				//Dijkstra_node node_n, *node_t;
-				//n_it = node_map_.begin();
-				//node_t = (*n_it).second;
-				int counter = 0;
-				node_t = (*node_map_.begin()).second; //intitilize
-				for(n_it = node_map_.begin();n_it != node_map_.end(); n_it++){
-					node_n = (*n_it).second;
-					if((*node_n).node_type == T_TYPE){
-						if (counter == 0) //the first rotation
-							node_t = node_n;
-						if ((*node_t).weight_ > (*node_n).weight_){
-							node_t = node_n;
-						}
-						counter++;
-					}
-				}
-	
-				//the weight is MAX, no route
-				if((*node_t).weight_ >= MAX_WEIGHT){
-					printf("\nthere is no route found from %d to %d!!", source,dest);
-					//m_rtable_.set_flag(dest, false);
-					type_flag = false;
-					return;
-					break;
-				}
-				
-				//set to P_TYPE
-				(*node_t).node_type = P_TYPE;
-	/*
-				//now renew the weight of the topology tuple for multipath algorithm
-				for(topologyset_t::iterator it = topologyset().begin(); it != topologyset().end(); it++){
-					if((*it)->last_addr_ == (*node_t).addr_){
-						(*it)->weight_ = tuple_weight((*it)->weight_);
-						printf("%f %d-> %d\n",(*it)->weight_, (*node_t).addr_, (*it)->dest_addr());
-					}
-				}*/
-				
-		
-				
-				//3. found the route to the destination
-				if((*node_t).addr_ == dest){
-					printf("\nI got one!");
-					type_flag = true;
-					break;
-				}
-				
-				type_flag = false;
-				for(n_it = node_map_.begin();n_it != node_map_.end(); n_it++){
-					node_n = (*n_it).second;
-					if((*node_n).node_type == T_TYPE)
-						type_flag = true;
-					//(*node_n).node_type = T_TYPE;
-					//(*node_n).weight_ = 0;
-				}
-				if(type_flag == false){
-					printf("\nthere is no route found from %d to %d!!", source,dest);
-					
-					break;
-				}
-				
-			}
-	
-			if (type_flag == false)
+///
+/// \brief Finds the path of the multipath routing table a packet was sent through.
+///
+/// \param p a packet originated by this node.
+/// \return the path whose addresses are the ones of the source route of the packet,
+///	or NULL if it is no longer in the routing table.
+///
+MPOLSR_m_rt_entry*
+MPOLSR::sent_path(Packet* p) {
+	nsaddr_t dest		= HDR_IP(p)->daddr();
+	struct hdr_sr* srh	= HDR_SR(p);
+	sr_addr* addrs		= srh->addrs();
+	int count		= m_rtable_.count(dest);
+
+	for (int i = 0; i < count; i++) {
+		MPOLSR_m_rt_entry* m_entry = m_rtable_.path(dest, i);
+		if (m_entry->len_ != srh->num_addrs())
+			continue;
+		int j;
+		for (j = 0; j < m_entry->len_; j++)
+			if (addrs[j].addr != m_entry->addr_[j])
 				break;
-			//construct the routing entry
-			MPOLSR_m_rt_entry* m_rt_entry = new MPOLSR_m_rt_entry;
-			std::vector<sr_addr> addr_stack;
-			//while((*node_t).addr_ != source)
-			do	{
-				sr_addr* sr_ = new sr_addr;
-				(*sr_).addr = (*node_t).addr_;
-				addr_stack.push_back(*sr_);
-	
-				//now renew the weight of the topology tuple for multipath algorithm
-				for(topologyset_t::iterator it = n_topologyset_.begin(); it != n_topologyset_.end(); it++){
-					if((*it)->last_addr_ == (*node_t).addr_){
-					//	printf("%f %d-> %d\t",(*it)->weight_, (*node_t).addr_, (*it)->dest_addr());
-						(*it)->weight_ = tuple_weight((*it)->weight_);
-						//(*it)->weight_ = (*it)->weight_*2;
-			
-					}
-				}
-				
-				node_t = node_map_.find((*node_t).pre_addr_)->second;
-			} while((*node_t).addr_ != source);
-	
-				/*		for(topologyset_t::iterator tit = topologyset().begin(); tit != topologyset().end(); tit++){
-					printf("%d--->%d, weight:%f\n", (*tit)->last_addr_, (*tit)->dest_addr_, (*tit)->weight_);
-				}*/
-			//add itself
-			sr_addr* sr_ = new sr_addr;
-			(*sr_).addr = ra_addr();
-			addr_stack.push_back(*sr_);
-			
-			int j = 0;
-			printf("from %d to %d:\t",ra_addr(),dest);
-			while(addr_stack.empty() == false){
-				(*m_rt_entry).addr_[j].addr = addr_stack.back().addr;
-				printf("%d->\t",addr_stack.back().addr);
-				addr_stack.pop_back();
-				j++;
-			}
-			
-			//add the entry to routing table
-			m_rtable_.add_entry(m_rt_entry,dest);
-	
-			
-	
-			//reset all the nodes for next rotation
-			for(n_it = node_map_.begin();n_it != node_map_.end(); n_it++){
-					node_n = (*n_it).second;
-				(*node_n).node_type = T_TYPE;
-				(*node_n).weight_ = MAX_WEIGHT;
-			}
+		if (j == m_entry->len_)
+			return m_entry;
+	}
+	return NULL;
+}
+
+///
+/// \brief Recomputes the multipath routing table entries towards the destination
+///	of a packet, if they were computed at an older topology epoch.
+///
+/// \param p the packet which is going to be routed.
+///
+void
+MPOLSR::m_rtable_update(Packet* p) {
+	nsaddr_t dest = HDR_IP(p)->daddr();
+
+	// max_route_ may have been changed from Tcl
+	if (m_rt_max_route_ != max_route()) {
+		m_rtable_.invalidate();
+		m_rt_max_route_ = max_route();
+	}
+
+	if (m_rtable_.up_to_date(dest, topology_epoch_))
+		m_rt_avoided_++;
+	else
+		m_rtable_computation(p);
+}
+
+///
+/// \brief Checks the multipath engine against the reference k-path algorithm.
+///
+/// Paths towards every node of the current graph are computed with both
+/// algorithms, and any difference is reported on stderr. Node-disjoint and
+/// link-disjoint paths are also checked to be valid and disjoint.
+///
+/// \return the number of destinations whose paths differ.
+///
+int
+MPOLSR::check_m_rtable() {
+	int errors = 0;
+
+	dijkstra_.build(ra_addr(), topologyset(), nbset(), nb2hopset());
+	for (int i = 0; i < dijkstra_.num_nodes(); i++) {
+		nsaddr_t dest = dijkstra_.node_addr(i);
+		if (dest == ra_addr())
+			continue;
+
+		MPOLSR_path_list paths, ref_paths;
+		int result = dijkstra_.k_paths(dest, max_route(), &MPOLSR::tuple_weight, paths);
+		int ref_result = MPOLSR_dijkstra::reference_k_paths(ra_addr(), dest, max_route(),
+			topologyset(), nbset(), nb2hopset(), &MPOLSR::tuple_weight, ref_paths);
+		if (result != ref_result || paths != ref_paths) {
+			fprintf(stderr, "%f _%d_ multipath mismatch towards %d "
+				"(%d paths, expected %d)\n",
+				CURRENT_TIME,
+				MPOLSR::node_id(ra_addr()),
+				dest,
+				(int)paths.size(),
+				(int)ref_paths.size());
+			errors++;
 		}
-		//finish the computation, set the flag
-		m_rtable_.set_flag(dest, false);
-		end_time = CURRENT_TIME; 
-	
-	//	delete *n_topologyset_;
 
-	
+		for (int node_disjoint = 0; node_disjoint < 2; node_disjoint++) {
+			MPOLSR_path_list d_paths;
+			dijkstra_.disjoint_paths(dest, max_route(), node_disjoint, d_paths);
+			if (!dijkstra_.disjoint(dest, d_paths, node_disjoint) ||
+				(int)d_paths.size() > max_route() ||
+				(d_paths.empty() != ref_paths.empty())) {
+				fprintf(stderr, "%f _%d_ invalid %s paths towards %d\n",
+					CURRENT_TIME,
+					MPOLSR::node_id(ra_addr()),
+					node_disjoint ? "node-disjoint" : "link-disjoint",
+					dest);
+				errors++;
+			}
+		}
+	}
+	return errors;
 }
+
 ///
 /// \brief Processes a HELLO message following RFC 3626 specification.
 ///
@@ -1314,16 +1626,29 @@ MPOLSR::process_tc(MPOLSR_msg& msg, nsaddr_t sender_iface) {
 		state_.find_newer_topology_tuple(msg.orig_addr(), tc.ansn());
 	if (topology_tuple != NULL)
 		return;
-	
-	// 3. All tuples in the topology set where:
-	//	T_last_addr == originator address AND
-	//	T_seq       <  ANSN
-	// MUST be removed from the topology set.
-	state_.erase_older_topology_tuples(msg.orig_addr(), tc.ansn());
+
+	// A delta TC message only updates the tuples of the originator, and
+	// the addresses to be recorded are the added ones
+	int added = tc.count;
+	if (tc.reserved() & MPOLSR_TC_DELTA) {
+		if (!process_delta_tc(msg))
+			return;
+		added = tc.reserved() & ~MPOLSR_TC_DELTA;
+	}
+	else {
+		// 3. All tuples in the topology set where:
+		//	T_last_addr == originator address AND
+		//	T_seq       <  ANSN
+		// MUST be removed from the topology set.
+		u_int32_t n_topology = topologyset().size();
+		state_.erase_older_topology_tuples(msg.orig_addr(), tc.ansn());
+		if (topologyset().size() != n_topology)
+			topology_changed();
+	}
 
 	// 4. For each of the advertised neighbor main address received in
 	// the TC message:
-	for (int i = 0; i < tc.count; i++) {
+	for (int i = 0; i < added; i++) {
 		assert(i >= 0 && i < MPOLSR_MAX_ADDRS);
 		nsaddr_t addr = tc.nb_main_addr(i);
 		// 4.1. If there exist some tuple in the topology set where:
@@ -1357,6 +1682,72 @@ MPOLSR::process_tc(MPOLSR_msg& msg, nsaddr_t sender_iface) {
 	}
 }
 
+///
+/// \brief Applies a delta TC message to the tuples of its originator.
+///
+/// The message lists the addresses added to the set advertised with the
+/// previous ANSN, followed by the removed ones (see send_tc()). It can only
+/// be applied if the tuples of the originator were recorded with the
+/// previous ANSN, or with its own ANSN if the set did not change. Otherwise
+/// some message was lost, and a full TC message is requested to the
+/// originator.
+///
+/// The removed tuples are erased and the remaining ones take the ANSN of
+/// the message and are refreshed. The added ones are left to process_tc().
+///
+/// \param msg the %MPOLSR message which contains the delta TC message.
+/// \return true if the message could be applied.
+///
+bool
+MPOLSR::process_delta_tc(MPOLSR_msg& msg) {
+	double now	= CURRENT_TIME;
+	MPOLSR_tc& tc	= msg.tc();
+	int added	= tc.reserved() & ~MPOLSR_TC_DELTA;
+	u_int16_t prev	= (tc.ansn() + MPOLSR_MAX_SEQ_NUM)%(MPOLSR_MAX_SEQ_NUM + 1);
+
+	// A delta TC message with no address does not change the set, and its
+	// ANSN is the one of the set
+	topologyset_t* tuples = state_.find_topology_tuples(msg.orig_addr());
+	if (tuples == NULL || tuples->empty() || (tuples->front()->seq() != tc.ansn() &&
+		(tc.count == 0 || tuples->front()->seq() != prev))) {
+		tc_gaps_++;
+		send_tc_req(msg.orig_addr(), msg.hop_count() + 1);
+		return false;
+	}
+
+	for (int i = added; i < tc.count; i++) {
+		MPOLSR_topology_tuple* topology_tuple =
+			state_.find_topology_tuple(tc.nb_main_addr(i), msg.orig_addr());
+		if (topology_tuple != NULL)
+			rm_topology_tuple(topology_tuple);
+	}
+	tuples = state_.find_topology_tuples(msg.orig_addr());
+	if (tuples != NULL) {
+		for (topologyset_t::iterator it = tuples->begin(); it != tuples->end(); it++) {
+			(*it)->seq()	= tc.ansn();
+			(*it)->time()	= now + MPOLSR::emf_to_seconds(msg.vtime());
+		}
+	}
+	return true;
+}
+
+///
+/// \brief Processes a TC request.
+///
+/// If this node is one of the originators listed in the request, its next
+/// TC message is a full one.
+///
+/// \param msg the %MPOLSR message which contains the TC request.
+///
+void
+MPOLSR::process_tc_req(MPOLSR_msg& msg) {
+	assert(msg.msg_type() == MPOLSR_TC_REQ_MSG);
+	MPOLSR_mid& tc_req = msg.tc_req();
+	for (int i = 0; i < tc_req.count; i++)
+		if (tc_req.iface_addr(i) == ra_addr())
+			tc_full_req_ = true;
+}
+
 ///
 /// \brief Processes a MID message following RFC 3626 specification.
 ///
@@ -1412,12 +1803,10 @@ MPOLSR::process_mid(MPOLSR_msg& msg, nsaddr_t sender_iface) {
 ///
 /// \param p the %MPOLSR packet which has been received.
 /// \param msg the %MPOLSR message which must be forwarded.
-/// \param dup_tuple NULL if the message has never been considered for forwarding,
-/// or a duplicate tuple in other case.
 /// \param local_iface the address of the interface where the message was received from.
 ///
 void
-MPOLSR::forward_default(Packet* p, MPOLSR_msg& msg, MPOLSR_dup_tuple* dup_tuple, nsaddr_t local_iface) {
+MPOLSR::forward_default(Packet* p, MPOLSR_msg& msg, nsaddr_t local_iface) {
 	double now		= CURRENT_TIME;
 	struct hdr_ip* ih	= HDR_IP(p);
 	
@@ -1427,21 +1816,9 @@ MPOLSR::forward_default(Packet* p, MPOLSR_msg& msg, MPOLSR_dup_tuple* dup_tuple,
 	if (link_tuple == NULL)
 		return;
 
-	// If the message has already been considered for forwarding,
-	// it must not be retransmitted again
-	if (dup_tuple != NULL && dup_tuple->retransmitted()) {
-		debug("%f: Node %d does not forward a message received"
-			" from %d because it is duplicated\n",
-			CURRENT_TIME,
-			MPOLSR::node_id(ra_addr()),
-			MPOLSR::node_id(dup_tuple->addr()));
-		return;
-	}
-	
 	// If the sender interface address is an interface address
 	// of a MPR selector of this node and ttl is greater than 1,
 	// the message must be retransmitted
-	bool retransmitted = false;
 	if (msg.ttl() > 1) {
 		MPOLSR_mprsel_tuple* mprsel_tuple =
 			state_.find_mprsel_tuple(get_main_addr(ih->saddr()));
@@ -1452,30 +1829,14 @@ MPOLSR::forward_default(Packet* p, MPOLSR_msg& msg, MPOLSR_dup_tuple* dup_tuple,
 			// We have to introduce a random delay to avoid
 			// synchronization with neighbors.
 			enque_msg(new_msg, JITTER);
-			retransmitted = true;
+			if (new_msg.msg_type() == MPOLSR_TC_MSG || new_msg.msg_type() == MPOLSR_TC_REQ_MSG)
+				tc_bytes_ += new_msg.size();
 		}
 	}
 	
-	// Update duplicate tuple...
-	if (dup_tuple != NULL) {
-		dup_tuple->time()		= now + MPOLSR_DUP_HOLD_TIME;
-		dup_tuple->retransmitted()	= retransmitted;
-		dup_tuple->iface_list().push_back(local_iface);
-	}
-	// ...or create a new one
-	else {
-		MPOLSR_dup_tuple* new_dup = new MPOLSR_dup_tuple;
-		new_dup->addr()			= msg.orig_addr();
-		new_dup->seq_num()		= msg.msg_seq_num();
-		new_dup->time()			= now + MPOLSR_DUP_HOLD_TIME;
-		new_dup->retransmitted()	= retransmitted;
-		new_dup->iface_list().push_back(local_iface);
-		add_dup_tuple(new_dup);
-		// Schedules dup tuple deletion
-		MPOLSR_DupTupleTimer* dup_timer =
-			new MPOLSR_DupTupleTimer(this, new_dup);
-		dup_timer->resched(DELAY(new_dup->time()));
-	}
+	// Records the message in the Duplicate Set, which is only looked up
+	// for messages already considered for forwarding
+	state_.insert_dup(msg.orig_addr(), msg.msg_seq_num(), now, now + MPOLSR_DUP_HOLD_TIME);
 }
 
 ///
@@ -1534,13 +1895,17 @@ MPOLSR::m_forward_data(Packet* p){
 	struct hdr_ip* ih	= HDR_IP(p);
 	struct hdr_sr* srh = HDR_SR(p);
 
-	struct sr_addr* local_sr;
-	int i;
-	bool flag = false;
 //	ch->uid_ = 0;
 
 	if (ch->direction() == hdr_cmn::UP &&
 		((u_int32_t)ih->daddr() == IP_BROADCAST || ih->daddr() == ra_addr())) {
+		//projections are passed up once the packet is reconstructed
+		if (HDR_MOJETTE(p)->n() > 0 && ih->daddr() == ra_addr()) {
+			p = mojette_.recv(p);
+			if (p == NULL)
+				return;
+			mpolsr_clear_mac_callbacks(p);
+		}
 		dmux_->recv(p, 0);
 		return;
 	}
@@ -1551,23 +1916,16 @@ MPOLSR::m_forward_data(Packet* p){
 			ch->next_hop()	= IP_BROADCAST;
 		else{
   		//	printf("\nQueue_length:\t%f\t%d\t%d\t%d", CURRENT_TIME, ch->uid(),ra_addr(), ifq->prq_length());			
-			local_sr = srh->addrs();
-			for(i = 0;i<MAX_SR_LEN;i++,local_sr++){
-				if((*local_sr).addr== ra_addr()){
-					local_sr++;
-					break;
-				}
-			}	
-			ch->next_hop() = (*local_sr).addr;
+			//the source route tells where this node is in the path
+			int cur = srh->cur_addr();
+			if (cur >= srh->num_addrs() || srh->addrs()[cur].addr != ra_addr())
+				cur = find_in_source_route(srh);
+
+			ch->next_hop() = (cur >= 0 && cur + 1 < srh->num_addrs()) ?
+				srh->addrs()[cur + 1].addr : ra_addr();
 
 			//check the neighbor
-			for(nbset_t::iterator it = nbset().begin();it!=nbset().end();it++){
-				if((*it)->nb_main_addr_==(*local_sr).addr){
-					flag = true;
-					break;
-				}
-			}
-			if (flag == false){
+			if (!state_.is_nb(ch->next_hop())) {
 				printf("\n%d has no neighbor %d from %d to %d.",ra_addr(),ch->next_hop(),  ih->saddr(),ih->daddr()); 
 		//		ch->xmit_reason_ = 1;
 
@@ -1575,6 +1933,7 @@ MPOLSR::m_forward_data(Packet* p){
 				resend_data(p);
 				return;
 			}
+			srh->cur_addr() = cur + 1;
 
 			
 	//		printf("\nforward from %d to %d",ra_addr(),ch->next_hop());
@@ -1582,6 +1941,8 @@ MPOLSR::m_forward_data(Packet* p){
 				ch->xmit_failure_	= mpolsr_mac_failed_callback;
 				ch->xmit_failure_data_	= (void*)this;
 			}
+			//only the source of the packet asked for its delivery, recv()
+			//cleared the callback of the previous hop
 			//srh.addrs_;
 			
 		}
@@ -1599,19 +1960,17 @@ void MPOLSR::resend_data(Packet* p){
 
 	nsaddr_t source = ra_addr();
 	
-	nsaddr_t dest = ih->daddr();
-	//change the source address
+	//change the source address, the packet is ours from now on
 	ih->saddr() = source;
+	mpolsr_clear_mac_callbacks(p);
 	printf("\nrecomputing...");
-	if(m_rtable_.get_flag(dest) == true){
-		m_rtable_computation(p);
-	}
+	m_rtable_update(p);
 
 	//here we must chose one route from the routing table
-	m_rtable_t::iterator temp_it = m_rtable_.lookup(ih->daddr());
+	MPOLSR_m_rt_entry* m_entry = select_path(p);
 
 	//if there is no route, we must drop the packet and return
-	if(temp_it == (*m_rtable_.m_rt()).end()){
+	if(m_entry == NULL){
 		debug("%f: Node %d can not forward a packet destined to %d\n",
 			CURRENT_TIME,
 			MPOLSR::node_id(ra_addr()),
@@ -1619,21 +1978,10 @@ void MPOLSR::resend_data(Packet* p){
 		drop(p, DROP_RTR_NO_ROUTE);
 		return;
 	}
-			
-	//now find a route
-	for (int j = 0;j<packet_count_%MAX_ROUTE;j++)
-		temp_it++;
 
-		packet_count_++;
-		//now we must fill the source route
-		sr_addr* temp_addrs;
-		temp_addrs = srh->addrs();
-			
-		MPOLSR_m_rt_entry* m_entry = (*temp_it).second;
-		for(int i = 0;i<MAX_SR_LEN;i++){
-			*temp_addrs = m_entry->addr_[i];
-			temp_addrs++;
-		}	
+	packet_count_++;
+	//now we must fill the source route
+	set_source_route(srh, m_entry);
 
 	ih->ttl_--;
 	if (ih->ttl_ == 0) {
@@ -1645,11 +1993,53 @@ void MPOLSR::resend_data(Packet* p){
 	m_forward_data(p);
 }
 
+///
+/// \brief Splits an originated packet into Mojette projections and sends each of
+///	them through the path chosen by the path scheduler.
+///
+/// Every projection gets its own unique id. The destination reconstructs the
+/// packet from any mojette_m_ of the mojette_n_ projections.
+///
+/// \param p the packet, with an initialized source routing header.
+///
+void
+MPOLSR::send_projections(Packet* p) {
+	int n = (mojette_n_ > MOJETTE_MAX_PROJECTIONS) ? MOJETTE_MAX_PROJECTIONS : mojette_n_;
+	int m = (mojette_m_ < 1) ? 1 : (mojette_m_ > n ? n : mojette_m_);
+
+	mojette_.encode(p, ra_addr(), n, m, mojette_proj_);
+	for (u_int32_t i = 0; i < mojette_proj_.size(); i++) {
+		Packet* q		= mojette_proj_[i];
+		struct hdr_ip* ih	= HDR_IP(q);
+
+		HDR_CMN(q)->uid() = uidcnt_++;
+		mpolsr_clear_mac_callbacks(q);
+		MPOLSR_m_rt_entry* m_entry = select_path(q);
+		if (m_entry == NULL) {
+			debug("%f: Node %d can not forward a packet destined to %d\n",
+				CURRENT_TIME,
+				MPOLSR::node_id(ra_addr()),
+				MPOLSR::node_id(ih->daddr()));
+			drop(q, DROP_RTR_NO_ROUTE);
+			continue;
+		}
+		packet_count_++;
+		set_source_route(HDR_SR(q), m_entry);
+
+		ih->ttl_--;
+		if (ih->ttl_ == 0) {
+			drop(q, DROP_RTR_TTL);
+			continue;
+		}
+		m_forward_data(q);
+	}
+}
+
 ///
 /// \brief Enques an %MPOLSR message which will be sent with a delay of (0, delay].
 ///
 /// This buffering system is used in order to piggyback several %MPOLSR messages in
-/// a same %MPOLSR packet.
+/// a same %MPOLSR packet. All of them are sent once the first one is due.
 ///
 /// \param msg the %MPOLSR message which must be sent.
 /// \param delay maximum delay the %MPOLSR message is going to be buffered.
@@ -1658,49 +2048,52 @@ void
 MPOLSR::enque_msg(MPOLSR_msg& msg, double delay) {
 	assert(delay >= 0);
 	
+	// The timer is armed to the earliest deadline of the buffered messages
+	double deadline = CURRENT_TIME + delay;
+	if (msgs_.empty() || deadline < msgs_deadline_) {
+		msgs_deadline_ = deadline;
+		msg_timer_.resched(delay);
+	}
 	msgs_.push_back(msg);
-	MPOLSR_MsgTimer* timer = new MPOLSR_MsgTimer(this);
-	timer->resched(delay);
 }
 
 ///
 /// \brief Creates as many %MPOLSR packets as needed in order to send all buffered
 /// %MPOLSR messages.
 ///
-/// Maximum number of messages which can be contained in an %MPOLSR packet is
-/// dictated by MPOLSR_MAX_MSGS constant.
+/// Messages are bundled in order, as long as the length of the packet does
+/// not exceed max_pkt_size_ bytes. A longer message is sent on its own.
 ///
 void
 MPOLSR::send_pkt() {
-	int num_msgs = msgs_.size();
-	if (num_msgs == 0)
-		return;
-//	printf("sending pkt...\n");
-	// Calculates the number of needed packets
-	int num_pkts = (num_msgs%MPOLSR_MAX_MSGS == 0) ? num_msgs/MPOLSR_MAX_MSGS :
-		(num_msgs/MPOLSR_MAX_MSGS + 1);
-	
-	for (int i = 0; i < num_pkts; i++) {
-		Packet* p		= allocpkt();
+	u_int32_t i = 0;
+	while (i < msgs_.size()) {
+		// msgs_[first..i) are bundled in the packet
+		u_int32_t first		= i;
+		u_int16_t pkt_len	= MPOLSR_PKT_HDR_SIZE;
+		do {
+			pkt_len += msgs_[i].size();
+			i++;
+		} while (i < msgs_.size() &&
+			pkt_len + msgs_[i].size() <= (u_int32_t)max_pkt_size_);
+		
+		Packet* p		= allocpkt(pkt_len - MPOLSR_PKT_HDR_SIZE);
 		struct hdr_cmn* ch	= HDR_CMN(p);
 		struct hdr_ip* ih	= HDR_IP(p);
 		MPOLSR_pkt* op		= PKT_MPOLSR(p);
 		
-		op->pkt_len()		= MPOLSR_PKT_HDR_SIZE;
+		op->pkt_len()		= pkt_len;
 		op->pkt_seq_num()	= pkt_seq();
-	
-		int j = 0;
-		for (std::vector<MPOLSR_msg>::iterator it = msgs_.begin(); it != msgs_.end(); it++) {
-			if (j == MPOLSR_MAX_MSGS)
-				break;
-			
-			op->pkt_body_[j++]	= *it;
-			op->count		= j;
-			op->pkt_len()		+= (*it).size();
-			
-			it = msgs_.erase(it);
-			it--;
-		}
+		op->count		= i - first;
+		unsigned char* buf	= p->accessdata();
+		for (u_int32_t j = first; j < i; j++)
+			buf += MPOLSR_pkt::put_msg(buf, msgs_[j]);
+		
+		bundle_pkts_++;
+		bundle_msgs_	+= op->count;
+		bundle_saved_	+= (op->count - 1) * (IP_HDR_LEN + UDP_HDR_LEN + MPOLSR_PKT_HDR_SIZE);
+		if ((u_int32_t)op->count > bundle_max_)
+			bundle_max_ = op->count;
 	
 		ch->ptype()		= PT_MPOLSR;
 		ch->direction()		= hdr_cmn::DOWN;
@@ -1721,6 +2114,7 @@ MPOLSR::send_pkt() {
 		
 		Scheduler::instance().schedule(target_, p, 0.0);
 	}
+	msgs_.clear();
 }
 
 ///
@@ -1838,15 +2232,20 @@ MPOLSR::send_tc() {
 	msg.tc().reserved()	= 0; 
 	msg.tc().count		= 0;
 	
-	//the original for OLSR 
-	//add the link to mprselecter to tc message
-	for (mprselset_t::iterator it = mprselset().begin(); it != mprselset().end(); it++) {
-		MPOLSR_mprsel_tuple* mprsel_tuple = *it;
-		int count = msg.tc().count;
-
-		assert(count >= 0 && count < MPOLSR_MAX_ADDRS);
-		msg.tc().nb_main_addr(count) = mprsel_tuple->main_addr();
-		msg.tc().count++;
+	if (tc_delta_)
+		fill_delta_tc(msg.tc());
+	else {
+		//the original for OLSR 
+		//add the link to mprselecter to tc message
+		for (mprselset_t::iterator it = mprselset().begin(); it != mprselset().end(); it++) {
+			MPOLSR_mprsel_tuple* mprsel_tuple = *it;
+			int count = msg.tc().count;
+
+			assert(count >= 0 && count < MPOLSR_MAX_ADDRS);
+			msg.tc().nb_main_addr(count) = mprsel_tuple->main_addr();
+			msg.tc().count++;
+		}
+		tc_full_++;
 	}
 	
 /*
@@ -1861,10 +2260,98 @@ MPOLSR::send_tc() {
 	}
 */
 	msg.msg_size()		= msg.size();
+	tc_bytes_		+= msg.size();
 	
 	enque_msg(msg, JITTER);
 }
 
+///
+/// \brief Fills a TC message advertising the MPR Selector Set in delta mode.
+///
+/// The ANSN is only increased when the advertised set changes, so that
+/// receivers can tell whether they missed a change. A full TC message is
+/// sent every tc_full_ival_ seconds, or earlier if some node requested it
+/// (see process_tc_req()). Otherwise the message only lists the MPR
+/// selectors added since the last TC message, followed by the removed ones,
+/// and its reserved field is MPOLSR_TC_DELTA plus the number of added ones.
+///
+/// \param tc the TC message, with no address.
+///
+void
+MPOLSR::fill_delta_tc(MPOLSR_tc& tc) {
+	double now = CURRENT_TIME;
+
+	std::vector<nsaddr_t> adv;
+	for (mprselset_t::iterator it = mprselset().begin(); it != mprselset().end(); it++)
+		adv.push_back((*it)->main_addr());
+	std::sort(adv.begin(), adv.end());
+
+	std::vector<nsaddr_t> added, removed;
+	std::set_difference(adv.begin(), adv.end(), tc_adv_.begin(), tc_adv_.end(),
+		std::back_inserter(added));
+	std::set_difference(tc_adv_.begin(), tc_adv_.end(), adv.begin(), adv.end(),
+		std::back_inserter(removed));
+	if (!added.empty() || !removed.empty())
+		tc_ansn_ = (tc_ansn_ + 1)%(MPOLSR_MAX_SEQ_NUM + 1);
+	tc.ansn() = tc_ansn_;
+
+	if (tc_full_req_ || now - tc_full_time_ >= tc_full_ival_ ||
+		added.size() + removed.size() > MPOLSR_MAX_ADDRS) {
+		for (u_int32_t i = 0; i < adv.size(); i++) {
+			assert(tc.count < MPOLSR_MAX_ADDRS);
+			tc.nb_main_addr(tc.count++) = adv[i];
+		}
+		tc_full_time_	= now;
+		tc_full_req_	= false;
+		tc_full_++;
+	}
+	else {
+		for (u_int32_t i = 0; i < added.size(); i++)
+			tc.nb_main_addr(tc.count++) = added[i];
+		for (u_int32_t i = 0; i < removed.size(); i++)
+			tc.nb_main_addr(tc.count++) = removed[i];
+		tc.reserved() = MPOLSR_TC_DELTA | added.size();
+		tc_deltas_++;
+	}
+	tc_adv_.swap(adv);
+}
+
+///
+/// \brief Creates a new %MPOLSR TC request which is buffered to be sent later on.
+///
+/// It asks the originator of a delta TC message which could not be applied
+/// for a full TC message. Requests are sent to the same originator once per
+/// TC interval at most.
+///
+/// \param orig_addr main address of the originator.
+/// \param ttl number of hops from the originator.
+///
+void
+MPOLSR::send_tc_req(nsaddr_t orig_addr, u_int8_t ttl) {
+	double now = CURRENT_TIME;
+	std::map<nsaddr_t, double>::iterator it = tc_req_time_.find(orig_addr);
+	if (it != tc_req_time_.end() && now - it->second < tc_ival())
+		return;
+	tc_req_time_[orig_addr] = now;
+
+	MPOLSR_msg msg;
+	msg.msg_type()		= MPOLSR_TC_REQ_MSG;
+	msg.vtime()		= MPOLSR::seconds_to_emf(MPOLSR_TOP_HOLD_TIME);
+	msg.orig_addr()		= ra_addr();
+	msg.ttl()		= ttl;
+	msg.hop_count()		= 0;
+	msg.msg_seq_num()	= msg_seq();
+
+	msg.tc_req().count		= 1;
+	msg.tc_req().iface_addr(0)	= orig_addr;
+
+	msg.msg_size()		= msg.size();
+	tc_reqs_++;
+	tc_bytes_		+= msg.size();
+
+	enque_msg(msg, JITTER);
+}
+
 ///
 /// \brief Creates a new %MPOLSR MID message which is buffered to be sent later on.
 /// \warning This message is never invoked because there is no support for multiple interfaces.
@@ -1977,8 +2464,12 @@ MPOLSR::populate_nbset(MPOLSR_msg& msg) {
 	MPOLSR_hello& hello = msg.hello();
 	
 	MPOLSR_nb_tuple* nb_tuple = state_.find_nb_tuple(msg.orig_addr());
-	if (nb_tuple != NULL)
-		nb_tuple->willingness() = hello.willingness();
+	if (nb_tuple != NULL) {
+		if (nb_tuple->willingness() != hello.willingness()) {
+			nb_tuple->willingness() = hello.willingness();
+			state_.nbhood_changed();
+		}
+	}
 	else
 		{
 			MPOLSR_nb_tuple* nb_tuple		= new MPOLSR_nb_tuple;
@@ -2058,8 +2549,11 @@ MPOLSR::populate_nb2hopset(MPOLSR_msg& msg) {
 							// N_neighbor_main_addr == Originator
 							// Address AND N_2hop_addr  == main address
 							// of the 2-hop neighbor are deleted.
+							u_int32_t n_nb2hop = nb2hopset().size();
 							state_.erase_nb2hop_tuples(msg.orig_addr(),
 								nb2hop_addr);
+							if (nb2hopset().size() != n_nb2hop)
+								topology_changed();
 						}
 					}
 				}
@@ -2141,10 +2635,40 @@ MPOLSR::mac_failed(Packet* p) {
 //		getchar();
 	}
 
+	if (ih->saddr() == ra_addr() && path_scheduler_->feedback()) {
+		MPOLSR_m_rt_entry* m_entry = sent_path(p);
+		if (m_entry != NULL)
+			path_scheduler_->failed(*m_entry, ch->uid());
+	}
+
 //	resend_data(p);
 	drop(p, DROP_RTR_MAC_CALLBACK);
 }
 
+///
+/// \brief	Tells the path scheduler that a packet originated by this node has been
+///		acknowledged by the next hop.
+///
+/// The time elapsed since the packet was scheduled is used as a delay sample
+/// of the path the packet was sent through.
+///
+/// \param p the packet which has been delivered by the MAC layer. It still
+///	belongs to the MAC layer.
+///
+void
+MPOLSR::mac_succeeded(Packet* p) {
+	struct hdr_cmn* ch	= HDR_CMN(p);
+
+	if (HDR_IP(p)->saddr() != ra_addr()) {
+		mac_foreign_acks_++;
+		return;
+	}
+	mac_acks_++;
+	MPOLSR_m_rt_entry* m_entry = sent_path(p);
+	if (m_entry != NULL)
+		path_scheduler_->acked(*m_entry, ch->uid());
+}
+
 ///
 /// \brief Schedule the timer used for sending HELLO messages.
 ///
@@ -2194,40 +2718,8 @@ MPOLSR::nb_loss(MPOLSR_link_tuple* tuple) {
 	
  //	rtable_computation();//this is for unipath routing
  	
- 	//for multipath routing, just set the out_of_date flag
- 	m_rtable_.set_flag(true);
-}
-
-///
-/// \brief Adds a duplicate tuple to the Duplicate Set.
-///
-/// \param tuple the duplicate tuple to be added.
-///
-void
-MPOLSR::add_dup_tuple(MPOLSR_dup_tuple* tuple) {
-	/*debug("%f: Node %d adds dup tuple: addr = %d seq_num = %d\n",
-		CURRENT_TIME,
-		MPOLSR::node_id(ra_addr()),
-		MPOLSR::node_id(tuple->addr()),
-		tuple->seq_num());*/
-	
-	state_.insert_dup_tuple(tuple);
-}
-
-///
-/// \brief Removes a duplicate tuple from the Duplicate Set.
-///
-/// \param tuple the duplicate tuple to be removed.
-///
-void
-MPOLSR::rm_dup_tuple(MPOLSR_dup_tuple* tuple) {
-	/*debug("%f: Node %d removes dup tuple: addr = %d seq_num = %d\n",
-		CURRENT_TIME,
-		MPOLSR::node_id(ra_addr()),
-		MPOLSR::node_id(tuple->addr()),
-		tuple->seq_num());*/
-	
-	state_.erase_dup_tuple(tuple);
+ 	//for multipath routing, the removal of the link tuple has already
+ 	//changed the topology epoch
 }
 
 ///
@@ -2282,6 +2774,7 @@ MPOLSR::rm_link_tuple(MPOLSR_link_tuple* tuple) {
 	MPOLSR_nb_tuple* nb_tuple = state_.find_nb_tuple(nb_addr);
 	state_.erase_nb_tuple(nb_tuple);
 	delete nb_tuple;
+	topology_changed();
 //	delete tuple;
 }
 
@@ -2299,12 +2792,17 @@ MPOLSR::updated_link_tuple(MPOLSR_link_tuple* tuple) {
 	MPOLSR_nb_tuple* nb_tuple =
 		state_.find_nb_tuple(get_main_addr(tuple->nb_iface_addr()));
 	if (nb_tuple != NULL) {
+		u_int8_t status = nb_tuple->status();
 		if (USE_MAC&& tuple->lost_time() >= now)
 			nb_tuple->status() = MPOLSR_STATUS_NOT_SYM;
 		else if (tuple->sym_time() >= now)
 			nb_tuple->status() = MPOLSR_STATUS_SYM;
 		else
 			nb_tuple->status() = MPOLSR_STATUS_NOT_SYM;
+		if (nb_tuple->status() != status) {
+			topology_changed();
+			state_.nbhood_changed();
+		}
 	
 	
 	debug("%f: Node %d has updated link tuple: nb_addr = %d status = %s\n",
@@ -2329,6 +2827,7 @@ MPOLSR::add_nb_tuple(MPOLSR_nb_tuple* tuple) {
 		((tuple->status() == MPOLSR_STATUS_SYM) ? "sym" : "not_sym"));
 	
 	state_.insert_nb_tuple(tuple);
+	topology_changed();
 }
 
 ///
@@ -2345,6 +2844,7 @@ MPOLSR::rm_nb_tuple(MPOLSR_nb_tuple* tuple) {
 		((tuple->status() == MPOLSR_STATUS_SYM) ? "sym" : "not_sym"));
 	
 	state_.erase_nb_tuple(tuple);
+	topology_changed();
 }
 
 ///
@@ -2361,6 +2861,7 @@ MPOLSR::add_nb2hop_tuple(MPOLSR_nb2hop_tuple* tuple) {
 		MPOLSR::node_id(tuple->nb2hop_addr()));
 
 	state_.insert_nb2hop_tuple(tuple);
+	topology_changed();
 }
 
 ///
@@ -2377,6 +2878,7 @@ MPOLSR::rm_nb2hop_tuple(MPOLSR_nb2hop_tuple* tuple) {
 		MPOLSR::node_id(tuple->nb2hop_addr()));
 
 	state_.erase_nb2hop_tuple(tuple);
+	topology_changed();
 }
 
 ///
@@ -2430,6 +2932,7 @@ MPOLSR::add_topology_tuple(MPOLSR_topology_tuple* tuple) {
 		tuple->seq());
 
 	state_.insert_topology_tuple(tuple);
+	topology_changed();
 }
 
 ///
@@ -2447,6 +2950,7 @@ MPOLSR::rm_topology_tuple(MPOLSR_topology_tuple* tuple) {
 		tuple->seq());
 
 	state_.erase_topology_tuple(tuple);
+	topology_changed();
 }
 
 ///
@@ -2510,27 +3014,6 @@ MPOLSR::seq_num_bigger_than(u_int16_t s1, u_int16_t s2) {
 		|| (s2 > s1 && s2-s1 > MPOLSR_MAX_SEQ_NUM/2);
 }
 
-///
-/// \brief This auxiliary function (defined in RFC 3626) is used for calculating the MPR Set.
-///
-/// \param tuple the neighbor tuple which has the main address of the node we are going to calculate its degree to.
-/// \return the degree of the node.
-///
-int
-MPOLSR::degree(MPOLSR_nb_tuple* tuple) {
-	int degree = 0;
-	for (nb2hopset_t::iterator it = nb2hopset().begin(); it != nb2hopset().end(); it++) {
-		MPOLSR_nb2hop_tuple* nb2hop_tuple = *it;
-		if (nb2hop_tuple->nb_main_addr() == tuple->nb_main_addr()) {
-			MPOLSR_nb_tuple* nb_tuple =
-				state_.find_nb_tuple(nb2hop_tuple->nb_main_addr());
-			if (nb_tuple == NULL)
-				degree++;
-		}
-	}
-	return degree;
-}
-
 ///
 /// \brief Converts a decimal number of seconds to the mantissa/exponent format.
 ///
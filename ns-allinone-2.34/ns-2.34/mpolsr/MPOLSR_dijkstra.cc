@@ -0,0 +1,578 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+///
+/// \file	MPOLSR_dijkstra.cc
+/// \brief	Implementation of the multipath Dijkstra engine.
+///
+
+#include "mpolsr/MPOLSR.h"
+#include "mpolsr/MPOLSR_dijkstra.h"
+#include "map"
+#include "algorithm"
+
+using namespace std;
+
+/// Orders heap entries so that the lightest (and then lowest addressed) vertex is on top.
+struct MPOLSR_heap_greater {
+	bool operator()(const pair<float, int>& a, const pair<float, int>& b) const {
+		if (a.first != b.first)
+			return a.first > b.first;
+		return a.second > b.second;
+	}
+};
+
+/// Orders paths by ascending hop count.
+static bool
+shorter_path(const MPOLSR_path& a, const MPOLSR_path& b) {
+	return a.size() < b.size();
+}
+
+///
+/// \brief Creates an empty engine.
+///
+MPOLSR_dijkstra::MPOLSR_dijkstra() {
+	source_ = -1;
+}
+
+///
+/// \brief Gets the vertex index of a given address.
+/// \param addr the address of the node.
+/// \return the index of the vertex, or -1 if the node is not in the graph.
+///
+int
+MPOLSR_dijkstra::index(nsaddr_t addr) {
+	std::vector<nsaddr_t>::iterator it = lower_bound(addr_.begin(), addr_.end(), addr);
+	if (it == addr_.end() || *it != addr)
+		return -1;
+	return it - addr_.begin();
+}
+
+///
+/// \brief Appends a link with unit weight. Vertex indexes are resolved later on.
+///
+void
+MPOLSR_dijkstra::add_link(nsaddr_t last, nsaddr_t dest) {
+	link_last_.push_back(last);
+	link_dest_.push_back(dest);
+	link_weight_.push_back(1);
+}
+
+///
+/// \brief Builds the graph from the topology, neighbor and 2-hop neighbor sets.
+///
+/// Links are added in the same order the original implementation used: first
+/// the topology set, then the neighbor set and finally the 2-hop neighbor set.
+/// Topology and 2-hop tuples which involve the source node are skipped, since
+/// the neighbor set already accounts for them.
+///
+/// \param source the address of the computing node.
+///
+void
+MPOLSR_dijkstra::build(nsaddr_t source, topologyset_t& topologyset,
+	nbset_t& nbset, nb2hopset_t& nb2hopset) {
+	addr_.clear();
+	link_last_.clear();
+	link_dest_.clear();
+	link_weight_.clear();
+
+	for (topologyset_t::iterator it = topologyset.begin(); it != topologyset.end(); it++) {
+		MPOLSR_topology_tuple* tuple = *it;
+		if (tuple->dest_addr() == source || tuple->last_addr() == source)
+			continue;
+		add_link(tuple->last_addr(), tuple->dest_addr());
+	}
+	for (nbset_t::iterator it = nbset.begin(); it != nbset.end(); it++)
+		add_link(source, (*it)->nb_main_addr());
+	for (nb2hopset_t::iterator it = nb2hopset.begin(); it != nb2hopset.end(); it++) {
+		MPOLSR_nb2hop_tuple* tuple = *it;
+		if (tuple->nb2hop_addr() == source || tuple->nb_main_addr() == source)
+			continue;
+		add_link(tuple->nb_main_addr(), tuple->nb2hop_addr());
+	}
+
+	// Vertices are numbered in ascending address order
+	addr_.push_back(source);
+	addr_.insert(addr_.end(), link_last_.begin(), link_last_.end());
+	addr_.insert(addr_.end(), link_dest_.begin(), link_dest_.end());
+	sort(addr_.begin(), addr_.end());
+	addr_.erase(unique(addr_.begin(), addr_.end()), addr_.end());
+
+	int n = addr_.size();
+	int m = link_weight_.size();
+	for (int e = 0; e < m; e++) {
+		link_last_[e] = index(link_last_[e]);
+		link_dest_[e] = index(link_dest_[e]);
+	}
+	source_ = index(source);
+
+	// Adjacency lists keep the links in insertion order
+	adj_begin_.assign(n + 1, 0);
+	last_begin_.assign(n + 1, 0);
+	for (int e = 0; e < m; e++) {
+		adj_begin_[link_last_[e] + 1]++;
+		if (link_dest_[e] != link_last_[e])
+			adj_begin_[link_dest_[e] + 1]++;
+		last_begin_[link_last_[e] + 1]++;
+	}
+	for (int i = 0; i < n; i++) {
+		adj_begin_[i + 1] += adj_begin_[i];
+		last_begin_[i + 1] += last_begin_[i];
+	}
+	adj_.resize(adj_begin_[n]);
+	last_.resize(last_begin_[n]);
+	pos_.assign(adj_begin_.begin(), adj_begin_.end() - 1);
+	for (int e = 0; e < m; e++) {
+		adj_[pos_[link_last_[e]]++] = e;
+		if (link_dest_[e] != link_last_[e])
+			adj_[pos_[link_dest_[e]]++] = e;
+	}
+	pos_.assign(last_begin_.begin(), last_begin_.end() - 1);
+	for (int e = 0; e < m; e++)
+		last_[pos_[link_last_[e]]++] = e;
+
+	dist_.resize(n);
+	pre_.resize(n);
+	settled_.resize(n);
+}
+
+///
+/// \brief Computes the lightest path from the source to a given destination
+/// using the current link weights.
+///
+/// \param dest the address of the destination node.
+/// \param path where the path is stored if it is found.
+/// \return MPOLSR_PATH_FOUND, MPOLSR_PATH_UNREACHABLE or MPOLSR_PATH_EXHAUSTED.
+///
+int
+MPOLSR_dijkstra::shortest_path(nsaddr_t dest, MPOLSR_path& path) {
+	MPOLSR_heap_greater greater;
+	int n = addr_.size();
+
+	path.clear();
+	heap_.clear();
+	for (int i = 0; i < n; i++) {
+		dist_[i]	= MAX_WEIGHT;
+		settled_[i]	= 0;
+	}
+	dist_[source_]		= 0;
+	settled_[source_]	= 1;
+	int unsettled		= n - 1;
+	int u			= source_;
+
+	while (unsettled > 0) {
+		// Relaxes every link of the last settled vertex
+		for (int j = adj_begin_[u]; j < adj_begin_[u + 1]; j++) {
+			int e = adj_[j];
+			int v = (link_last_[e] == u) ? link_dest_[e] : link_last_[e];
+			float w = dist_[u] + link_weight_[e];
+			if (w < dist_[v]) {
+				dist_[v]	= w;
+				pre_[v]		= u;
+				heap_.push_back(make_pair(w, v));
+				push_heap(heap_.begin(), heap_.end(), greater);
+			}
+		}
+
+		// Settles the lightest unvisited vertex
+		u = -1;
+		while (!heap_.empty()) {
+			int v = heap_.front().second;
+			pop_heap(heap_.begin(), heap_.end(), greater);
+			heap_.pop_back();
+			if (!settled_[v]) {
+				u = v;
+				break;
+			}
+		}
+		if (u == -1)
+			return MPOLSR_PATH_UNREACHABLE;
+		settled_[u] = 1;
+		unsettled--;
+
+		if (addr_[u] == dest) {
+			for (int v = u; v != source_; v = pre_[v])
+				path.push_back(addr_[v]);
+			path.push_back(addr_[source_]);
+			reverse(path.begin(), path.end());
+			return MPOLSR_PATH_FOUND;
+		}
+	}
+	return MPOLSR_PATH_EXHAUSTED;
+}
+
+///
+/// \brief Penalizes the weight of every link whose last address belongs to
+/// the given path (the source node excluded).
+///
+/// \param path a path previously returned by shortest_path().
+/// \param fn function which computes the new weight of a link.
+///
+void
+MPOLSR_dijkstra::penalize(MPOLSR_path& path, MPOLSR_weight_fn fn) {
+	for (MPOLSR_path::iterator it = path.begin() + 1; it != path.end(); it++) {
+		int v = index(*it);
+		for (int j = last_begin_[v]; j < last_begin_[v + 1]; j++)
+			link_weight_[last_[j]] = fn(link_weight_[last_[j]]);
+	}
+}
+
+///
+/// \brief Computes up to k paths to a given destination, penalizing the links
+/// of every path found before the next round.
+///
+/// \param dest the address of the destination node.
+/// \param k the maximum number of paths.
+/// \param fn function which computes the penalized weight of a link.
+/// \param paths where the found paths are appended.
+/// \return MPOLSR_PATH_FOUND if the k rounds succeeded, or the result of the
+/// round which failed.
+///
+int
+MPOLSR_dijkstra::k_paths(nsaddr_t dest, int k, MPOLSR_weight_fn fn, MPOLSR_path_list& paths) {
+	for (u_int32_t e = 0; e < link_weight_.size(); e++)
+		link_weight_[e] = 1;
+
+	for (int i = 0; i < k; i++) {
+		int result = shortest_path(dest, path_);
+		if (result != MPOLSR_PATH_FOUND)
+			return result;
+		paths.push_back(path_);
+		penalize(path_, fn);
+	}
+	return MPOLSR_PATH_FOUND;
+}
+
+///
+/// \brief Appends an arc and its (empty) reverse arc to the flow network.
+///
+void
+MPOLSR_dijkstra::add_arc(int from, int to, int cap, int cost) {
+	arc_head_.push_back(to);
+	arc_cap_.push_back(cap);
+	arc_cost_.push_back(cost);
+	arc_next_.push_back(flow_first_[from]);
+	flow_first_[from] = arc_head_.size() - 1;
+
+	arc_head_.push_back(from);
+	arc_cap_.push_back(0);
+	arc_cost_.push_back(-cost);
+	arc_next_.push_back(flow_first_[to]);
+	flow_first_[to] = arc_head_.size() - 1;
+}
+
+///
+/// \brief Computes up to k disjoint paths of minimum total hop count to a given
+/// destination (Suurballe/Bhandari).
+///
+/// Every undirected link becomes a pair of unit capacity arcs. In node-disjoint
+/// mode each vertex is also split into an input and an output vertex joined by
+/// a unit capacity arc. The paths are found by successive shortest augmenting
+/// paths over the residual network, so a new path may reroute the links of the
+/// previous ones, and the resulting flow is finally decomposed into paths.
+///
+/// \param dest the address of the destination node.
+/// \param k the maximum number of paths.
+/// \param node_disjoint true for node-disjoint paths, false for link-disjoint ones.
+/// \param paths where the found paths are appended, shortest first.
+/// \return MPOLSR_PATH_FOUND if at least one path exists, MPOLSR_PATH_EXHAUSTED otherwise.
+///
+int
+MPOLSR_dijkstra::disjoint_paths(nsaddr_t dest, int k, bool node_disjoint, MPOLSR_path_list& paths) {
+	int t = index(dest);
+	if (t == -1 || t == source_)
+		return MPOLSR_PATH_EXHAUSTED;
+
+	int n = addr_.size();
+	int split = node_disjoint ? 2 : 1;
+	int nv = n * split;
+	flow_first_.assign(nv, -1);
+	arc_next_.clear();
+	arc_head_.clear();
+	arc_cap_.clear();
+	arc_cost_.clear();
+
+	// Vertex v enters through v*split and leaves through v*split + split - 1
+	if (node_disjoint) {
+		for (int v = 0; v < n; v++)
+			add_arc(2*v, 2*v + 1, (v == source_ || v == t) ? k : 1, 0);
+	}
+	flow_links_.clear();
+	for (u_int32_t e = 0; e < link_last_.size(); e++) {
+		int a = link_last_[e], b = link_dest_[e];
+		if (a != b)
+			flow_links_.push_back(make_pair(min(a, b), max(a, b)));
+	}
+	sort(flow_links_.begin(), flow_links_.end());
+	flow_links_.erase(unique(flow_links_.begin(), flow_links_.end()), flow_links_.end());
+	for (u_int32_t i = 0; i < flow_links_.size(); i++) {
+		int a = flow_links_[i].first, b = flow_links_[i].second;
+		add_arc(a*split + split - 1, b*split, 1, 1);
+		add_arc(b*split + split - 1, a*split, 1, 1);
+	}
+
+	int s	= source_*split + split - 1;
+	int sink	= t*split;
+	int found	= 0;
+	for (; found < k; found++) {
+		// Bellman-Ford (FIFO queue), reverse arcs may have negative costs
+		flow_dist_.assign(nv, MAX_WEIGHT);
+		flow_pre_.assign(nv, -1);
+		flow_queued_.assign(nv, 0);
+		flow_queue_.clear();
+		flow_dist_[s] = 0;
+		flow_queue_.push_back(s);
+		flow_queued_[s] = 1;
+		for (u_int32_t head = 0; head < flow_queue_.size(); head++) {
+			int u = flow_queue_[head];
+			flow_queued_[u] = 0;
+			for (int e = flow_first_[u]; e != -1; e = arc_next_[e]) {
+				int v = arc_head_[e];
+				if (arc_cap_[e] > 0 && flow_dist_[u] + arc_cost_[e] < flow_dist_[v]) {
+					flow_dist_[v] = flow_dist_[u] + arc_cost_[e];
+					flow_pre_[v] = e;
+					if (!flow_queued_[v]) {
+						flow_queue_.push_back(v);
+						flow_queued_[v] = 1;
+					}
+				}
+			}
+		}
+		if (flow_dist_[sink] >= MAX_WEIGHT)
+			break;
+		for (int v = sink; v != s; v = arc_head_[flow_pre_[v] ^ 1]) {
+			arc_cap_[flow_pre_[v]]--;
+			arc_cap_[flow_pre_[v] ^ 1]++;
+		}
+	}
+	if (found == 0)
+		return MPOLSR_PATH_EXHAUSTED;
+
+	// Decomposes the flow: the reverse arc of a used link carries one unit
+	u_int32_t first = paths.size();
+	paths.resize(first + found);
+	for (int i = 0; i < found; i++) {
+		MPOLSR_path& path = paths[first + i];
+		path.push_back(addr_[source_]);
+		int u = s;
+		while (u != sink) {
+			int e = flow_first_[u];
+			while ((e & 1) || arc_cap_[e ^ 1] == 0)
+				e = arc_next_[e];
+			arc_cap_[e ^ 1]--;
+			u = arc_head_[e];
+			if (arc_cost_[e] > 0)
+				path.push_back(addr_[u / split]);
+		}
+	}
+	stable_sort(paths.begin() + first, paths.end(), shorter_path);
+	return MPOLSR_PATH_FOUND;
+}
+
+///
+/// \brief Tells if two nodes are joined by a link of the current graph.
+///
+bool
+MPOLSR_dijkstra::has_link(nsaddr_t a, nsaddr_t b) {
+	int u = index(a), v = index(b);
+	if (u == -1 || v == -1)
+		return false;
+	for (int j = adj_begin_[u]; j < adj_begin_[u + 1]; j++) {
+		int e = adj_[j];
+		if ((link_last_[e] == u && link_dest_[e] == v) ||
+			(link_last_[e] == v && link_dest_[e] == u))
+			return true;
+	}
+	return false;
+}
+
+///
+/// \brief Checks that a list of paths is made of loop free paths of the
+/// current graph from the source to a given destination, and that they are
+/// disjoint.
+///
+/// \param dest the address of the destination node.
+/// \param paths the paths to be checked.
+/// \param node_disjoint true for checking node-disjointness, false for link-disjointness.
+/// \return true if the paths are valid.
+///
+bool
+MPOLSR_dijkstra::disjoint(nsaddr_t dest, MPOLSR_path_list& paths, bool node_disjoint) {
+	std::vector<nsaddr_t> nodes;
+	std::vector<pair<nsaddr_t, nsaddr_t> > links;
+
+	for (MPOLSR_path_list::iterator it = paths.begin(); it != paths.end(); it++) {
+		MPOLSR_path& path = *it;
+		if (path.size() < 2 || path.front() != addr_[source_] || path.back() != dest)
+			return false;
+		MPOLSR_path sorted(path);
+		sort(sorted.begin(), sorted.end());
+		if (adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+			return false;
+		for (u_int32_t i = 0; i + 1 < path.size(); i++) {
+			if (!has_link(path[i], path[i + 1]))
+				return false;
+			links.push_back(make_pair(min(path[i], path[i + 1]), max(path[i], path[i + 1])));
+			if (i > 0)
+				nodes.push_back(path[i]);
+		}
+	}
+	if (node_disjoint) {
+		sort(nodes.begin(), nodes.end());
+		if (adjacent_find(nodes.begin(), nodes.end()) != nodes.end())
+			return false;
+	}
+	sort(links.begin(), links.end());
+	return adjacent_find(links.begin(), links.end()) == links.end();
+}
+
+///
+/// \brief Reference implementation of the k-path computation.
+///
+/// This is the original node map based algorithm, which rescans every link
+/// against every node at each step. It is only kept in order to check the
+/// results of the heap based engine (see the "check_m_rtable" command).
+///
+/// \return same as k_paths().
+///
+int
+MPOLSR_dijkstra::reference_k_paths(nsaddr_t source, nsaddr_t dest, int k,
+	topologyset_t& topologyset, nbset_t& nbset, nb2hopset_t& nb2hopset,
+	MPOLSR_weight_fn fn, MPOLSR_path_list& paths) {
+	int result = MPOLSR_PATH_FOUND;
+
+	topologyset_t n_topologyset_;
+	MPOLSR_topology_tuple* tt;
+	for (topologyset_t::iterator it = topologyset.begin(); it != topologyset.end(); it++) {
+		if ((*it)->dest_addr() == source || (*it)->last_addr() == source)
+			continue;
+		tt = new MPOLSR_topology_tuple;
+		tt->dest_addr() = (*it)->dest_addr();
+		tt->last_addr() = (*it)->last_addr();
+		tt->weight() = 1;
+		n_topologyset_.push_back(tt);
+	}
+	for (nbset_t::iterator it = nbset.begin(); it != nbset.end(); it++) {
+		tt = new MPOLSR_topology_tuple;
+		tt->dest_addr() = (*it)->nb_main_addr();
+		tt->last_addr() = source;
+		tt->weight() = 1;
+		n_topologyset_.push_back(tt);
+	}
+	for (nb2hopset_t::iterator it = nb2hopset.begin(); it != nb2hopset.end(); it++) {
+		if ((*it)->nb2hop_addr() == source || (*it)->nb_main_addr() == source)
+			continue;
+		tt = new MPOLSR_topology_tuple;
+		tt->dest_addr() = (*it)->nb2hop_addr();
+		tt->last_addr() = (*it)->nb_main_addr();
+		tt->weight() = 1;
+		n_topologyset_.push_back(tt);
+	}
+
+	map<nsaddr_t, Dijkstra_node> node_map_;
+	node_map_[source].addr_ = source;
+	for (topologyset_t::iterator it = n_topologyset_.begin(); it != n_topologyset_.end(); it++) {
+		node_map_[(*it)->last_addr()].addr_ = (*it)->last_addr();
+		node_map_[(*it)->dest_addr()].addr_ = (*it)->dest_addr();
+	}
+	map<nsaddr_t, Dijkstra_node>::iterator n_it;
+	for (n_it = node_map_.begin(); n_it != node_map_.end(); n_it++) {
+		(*n_it).second.weight_ = MAX_WEIGHT;
+		(*n_it).second.node_type = T_TYPE;
+	}
+
+	for (int i = 0; i < k && result == MPOLSR_PATH_FOUND; i++) {
+		Dijkstra_node* node_t = NULL;
+		node_map_[source].node_type = P_TYPE;
+		node_map_[source].weight_ = 0;
+		for (;;) {
+			// 1. renew the weight of all the T type nodes
+			for (topologyset_t::iterator it = n_topologyset_.begin(); it != n_topologyset_.end(); it++) {
+				for (n_it = node_map_.begin(); n_it != node_map_.end(); n_it++) {
+					Dijkstra_node* node_s = &(*n_it).second;
+					if (node_s->node_type != P_TYPE)
+						continue;
+					if (node_s->addr_ != (*it)->last_addr() && node_s->addr_ != (*it)->dest_addr())
+						continue;
+					Dijkstra_node* node_d = (node_s->addr_ == (*it)->last_addr()) ?
+						&node_map_[(*it)->dest_addr()] : &node_map_[(*it)->last_addr()];
+					if (node_s->weight_ + (*it)->weight() < node_d->weight_) {
+						node_d->weight_ = node_s->weight_ + (*it)->weight();
+						node_d->pre_addr_ = node_s->addr_;
+					}
+				}
+			}
+
+			// 2. find the T type node with the min weight, and set it to P type
+			node_t = &(*node_map_.begin()).second;
+			bool first = true;
+			for (n_it = node_map_.begin(); n_it != node_map_.end(); n_it++) {
+				Dijkstra_node* node_n = &(*n_it).second;
+				if (node_n->node_type == T_TYPE) {
+					if (first)
+						node_t = node_n;
+					if (node_t->weight_ > node_n->weight_)
+						node_t = node_n;
+					first = false;
+				}
+			}
+			if (node_t->weight_ >= MAX_WEIGHT) {
+				result = MPOLSR_PATH_UNREACHABLE;
+				break;
+			}
+			node_t->node_type = P_TYPE;
+
+			// 3. found the route to the destination
+			if (node_t->addr_ == dest)
+				break;
+
+			bool left = false;
+			for (n_it = node_map_.begin(); n_it != node_map_.end(); n_it++)
+				if ((*n_it).second.node_type == T_TYPE)
+					left = true;
+			if (!left) {
+				result = MPOLSR_PATH_EXHAUSTED;
+				break;
+			}
+		}
+		if (result != MPOLSR_PATH_FOUND)
+			break;
+
+		// Constructs the path and penalizes the links on it
+		MPOLSR_path path;
+		do {
+			path.push_back(node_t->addr_);
+			for (topologyset_t::iterator it = n_topologyset_.begin(); it != n_topologyset_.end(); it++)
+				if ((*it)->last_addr() == node_t->addr_)
+					(*it)->weight() = fn((*it)->weight());
+			node_t = &node_map_[node_t->pre_addr_];
+		} while (node_t->addr_ != source);
+		path.push_back(source);
+		reverse(path.begin(), path.end());
+		paths.push_back(path);
+
+		// Resets all the nodes for next rotation
+		for (n_it = node_map_.begin(); n_it != node_map_.end(); n_it++) {
+			(*n_it).second.node_type = T_TYPE;
+			(*n_it).second.weight_ = MAX_WEIGHT;
+		}
+	}
+
+	for (topologyset_t::iterator it = n_topologyset_.begin(); it != n_topologyset_.end(); it++)
+		delete *it;
+	return result;
+}
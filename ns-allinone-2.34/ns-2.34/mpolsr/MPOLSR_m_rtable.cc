@@ -22,79 +22,141 @@ using namespace std;
 ///\brief Creates a new empty routing table
 ///
 MPOLSR_m_rtable::MPOLSR_m_rtable(){
-	for (int i = 0;i<MAX_NODE; i ++)
-	{
-		out_of_date[i] = true;
-	}
+	old_.count_ = 0;
+	old_.epoch_ = 0;
 }
 
 ///
-///\brief Destroys the routing table and ll its entries
+///\brief Destroys the routing table and all its entries
 ///
 MPOLSR_m_rtable::~MPOLSR_m_rtable(){
-	for(m_rtable_t::iterator it = m_rt_.begin();it!=m_rt_.end();it++)
-		delete (*it).second;
-		
 }
 
-m_rtable_t* MPOLSR_m_rtable::m_rt(){
-	return &m_rt_;
+///
+///\brief Gets the slot of a destination, adding one if needed.
+///\param dest	address of the destination node.
+///\return the slot, or NULL if dest is not a node address (e.g. IP_BROADCAST).
+///
+MPOLSR_m_rt_dest* MPOLSR_m_rtable::dest(nsaddr_t dest){
+	if (dest < 0)
+		return NULL;
+	MPOLSR_m_rt_dest* d = find(dest);
+	if (d != NULL)
+		return d;
+	index_[dest] = m_rt_.size();
+	m_rt_.resize(m_rt_.size() + 1);
+	d = &m_rt_.back();
+	d->count_	= 0;
+	d->epoch_	= 0;
+	d->addr_	= dest;
+	return d;
 }
-void MPOLSR_m_rtable::set_flag(int id, bool flag){
-	out_of_date[id] = flag;
+
+///
+///\brief Stamps the entries of a destination with the topology epoch they were computed at.
+///\param dest	address of the destination node.
+///\param epoch	current topology epoch of the agent.
+///
+void MPOLSR_m_rtable::set_epoch(nsaddr_t dest, u_int32_t epoch){
+	MPOLSR_m_rt_dest* d = this->dest(dest);
+	if (d != NULL)
+		d->epoch_ = epoch;
 }
 
-void MPOLSR_m_rtable::set_flag(bool flag){
-	for (int i = 0; i < MAX_NODE; i ++){
-		out_of_date[i] = flag;
-	}
+///
+///\brief Tells if the entries of a destination were computed at the given topology epoch.
+///\param dest	address of the destination node.
+///\param epoch	current topology epoch of the agent.
+///\return true if the entries can be used without being recomputed.
+///
+bool MPOLSR_m_rtable::up_to_date(nsaddr_t dest, u_int32_t epoch){
+	MPOLSR_m_rt_dest* d = find(dest);
+	return d != NULL && d->epoch_ == epoch;
 }
 
-bool MPOLSR_m_rtable::get_flag(int id){
-	return out_of_date[id];
+///
+///\brief Marks the entries of every destination as out of date.
+///
+void MPOLSR_m_rtable::invalidate(){
+	for (u_int32_t i = 0; i < m_rt_.size(); i++)
+		m_rt_[i].epoch_ = 0;
 }
 ///
 ///\brief Destroys the routing table and all its entries
 ///
 void MPOLSR_m_rtable::clear(){
-	for (m_rtable_t::iterator it = m_rt_.begin();it != m_rt_.end(); it++)
-		delete (*it).second;
-
 	m_rt_.clear();
+	index_.clear();
 }
 
 
 ///
-///\brief Deletes the entry whose destination is given.
+///\brief Deletes the entries whose destination is given.
+///
+/// The deleted paths are kept aside until the next deletion, so that the new
+/// paths can inherit the scheduling state of the identical old ones.
+///
 ///\param dest	address of the destiantion node.
 ///
 void MPOLSR_m_rtable::rm_entry(nsaddr_t dest){
-/*	for (m_rtable_t::iterator it = m_rt_.begin(); it != m_rt_.end(); it++){
-		if ( (MPOLSR_m_rt_entry*)((*it).second).end() == dest)
-			delete (*it).second;
+	MPOLSR_m_rt_dest* d = find(dest);
+	if (d != NULL) {
+		old_ = *d;
+		d->count_ = 0;
+	}
+	else
+		old_.count_ = 0;
+}
+
+///
+///\brief Copies the scheduling state of the deleted path identical to a new one, if any.
+///\param entry	a new path of the last destination whose entries were deleted.
+///
+void MPOLSR_m_rtable::inherit(MPOLSR_m_rt_entry* entry){
+	for (int i = 0; i < old_.count_; i++) {
+		MPOLSR_m_rt_entry* old = &old_.paths_[i];
+		if (old->len_ != entry->len_ ||
+			memcmp(old->addr_, entry->addr_, entry->len_ * sizeof(nsaddr_t)) != 0)
+			continue;
+		entry->credit_		= old->credit_;
+		entry->outstanding_	= old->outstanding_;
+		entry->delay_		= old->delay_;
+		entry->last_feedback_	= old->last_feedback_;
+		entry->last_used_	= old->last_used_;
+		return;
 	}
-*/
-	m_rt_.erase(dest);
-	
 }
 
 ///
-///\brief finds the entries for the specified destination address
-///\param dest destination address
+///\brief Looks up the paths towards a destination.
+///\param dest	destination address
+///\return the paths towards the destination, or NULL if there is none.
 ///
-m_rtable_t::iterator MPOLSR_m_rtable::lookup(nsaddr_t dest){
-	return m_rt_.find(dest);
+MPOLSR_m_rt_dest* MPOLSR_m_rtable::lookup(nsaddr_t dest){
+	MPOLSR_m_rt_dest* d = find(dest);
+	if (d == NULL || d->count_ == 0)
+		return NULL;
+	return d;
 }
 
 ///
-///\brief add a new entry to the routing table
-///\
+///\brief Adds a new path towards a destination.
+///\param dest	destination address
+///\return the entry to be filled, or NULL if the destination already has MPOLSR_MAX_PATHS paths
+///	or is not a node address.
 ///
-void MPOLSR_m_rtable::add_entry(MPOLSR_m_rt_entry* entry,nsaddr_t addr){
-/*
-	MPOLSR_m_rt_entry::iterator it = (*entry).end();
-	nsaddr_t addr = (*it);
-	m_rt_.insert(pair<nsaddr_t,MPOLSR_m_rt_entry*>(addr,entry));*/
-//	nsaddr_t addr = (*entry).addr
-	m_rt_.insert(pair<nsaddr_t,MPOLSR_m_rt_entry*>(addr,entry));
+MPOLSR_m_rt_entry* MPOLSR_m_rtable::add_entry(nsaddr_t dest){
+	MPOLSR_m_rt_dest* d = this->dest(dest);
+	if (d == NULL || d->count_ == MPOLSR_MAX_PATHS)
+		return NULL;
+	MPOLSR_m_rt_entry* entry = &d->paths_[d->count_++];
+	entry->len_		= 0;
+	entry->cost_		= 0;
+	entry->last_used_	= 0;
+	entry->diversity_	= 0;
+	entry->credit_		= 0;
+	entry->outstanding_	= 0;
+	entry->delay_		= 0;
+	entry->last_feedback_	= 0;
+	return entry;
 }
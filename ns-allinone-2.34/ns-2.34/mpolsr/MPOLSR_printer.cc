@@ -34,6 +34,8 @@
 ///
 
 #include "mpolsr/MPOLSR_printer.h"
+#include <algorithm>
+
 /********** Messages and packets printing functions **********/
 
 ///
@@ -100,10 +102,12 @@ MPOLSR_printer::print_ip_hdr(FILE* out, struct hdr_ip* ih) {
 /// \brief Prints a given MPOLSR packet into a given file.
 /// \warning This function is actually not used.
 /// \param out	File where the %MPOLSR packet is going to be written.
-/// \param pkt	%MPOLSR packet to be written.
+/// \param p	packet whose %MPOLSR header and messages are going to be written.
 ///
 void
-MPOLSR_printer::print_mpolsr_pkt(FILE* out, MPOLSR_pkt* pkt) {
+MPOLSR_printer::print_mpolsr_pkt(FILE* out, Packet* p) {
+	MPOLSR_pkt* pkt = PKT_MPOLSR(p);
+	MPOLSR_msg msg;
 		
 	fprintf(out,
 		"  MPOLSR PACKET\n\tlength = %d\n\tseq_num = %d\n\t------------\n",
@@ -111,7 +115,8 @@ MPOLSR_printer::print_mpolsr_pkt(FILE* out, MPOLSR_pkt* pkt) {
 		pkt->pkt_seq_num());
 	
 	for (int i = 0; i < pkt->count; i++) {
-		print_mpolsr_msg(out, pkt->msg(i));
+		MPOLSR_pkt::get_msg(p, i, msg);
+		print_mpolsr_msg(out, msg);
 		fprintf(out, "\t------------\n");
 	}
 	fprintf(out, "\n");
@@ -357,3 +362,38 @@ MPOLSR_printer::print_topologyset(Trace* out, topologyset_t& topologyset) {
 		out->pt_->dump();
 	}
 }
+
+///
+/// \brief Prints the multipath routing table into a given trace file.
+/// \param out		Trace where the multipath routing table is going to be written.
+/// \param m_rt		Multipath routing table to be written.
+///
+void
+MPOLSR_printer::print_m_rtable(Trace* out, MPOLSR_m_rtable& m_rt) {
+	static const char* diversity[] = { "penalty", "node_disjoint", "link_disjoint" };
+
+	sprintf(out->pt_->buffer(), "P\tdest\tmode\thops\tcost\tused\tpath");
+	out->pt_->dump();
+	// destinations are printed in address order, not in the order they were added
+	std::vector<nsaddr_t> dests;
+	for (u_int32_t k = 0; k < m_rt.size(); k++)
+		dests.push_back(m_rt.slot(k)->addr_);
+	std::sort(dests.begin(), dests.end());
+	for (u_int32_t k = 0; k < dests.size(); k++) {
+		nsaddr_t dest = dests[k];
+		for (int i = 0; i < m_rt.count(dest); i++) {
+			MPOLSR_m_rt_entry* entry = m_rt.path(dest, i);
+			char* buf = out->pt_->buffer();
+			int n = sprintf(buf, "P\t%d\t%s\t%d\t%.2f\t%f\t",
+				MPOLSR::node_id(dest),
+				diversity[entry->diversity_],
+				entry->hops(),
+				entry->cost_,
+				entry->last_used_);
+			for (int j = 0; j < entry->len_; j++)
+				n += sprintf(buf + n, (j == 0) ? "%d" : "->%d",
+					MPOLSR::node_id(entry->addr_[j]));
+			out->pt_->dump();
+		}
+	}
+}
@@ -0,0 +1,200 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+///
+/// \file	MPOLSR_scheduler.cc
+/// \brief	Implementation of the MPOLSR path schedulers.
+///
+
+#include "mpolsr/MPOLSR.h"
+#include "mpolsr/MPOLSR_scheduler.h"
+
+///
+/// \brief Creates a path scheduler which does not remember any packet.
+///
+MPOLSR_path_scheduler::MPOLSR_path_scheduler() {
+	for (int i = 0; i < MPOLSR_SCHED_SENT_SLOTS; i++)
+		sent_uid_[i] = -1;
+}
+
+///
+/// \brief Creates a path scheduler given the name of its policy.
+/// \param name one of round_robin, wrr, least_outstanding or delay.
+/// \return the new scheduler, or NULL if the policy is unknown.
+///
+MPOLSR_path_scheduler*
+MPOLSR_path_scheduler::create(const char* name) {
+	if (strcasecmp(name, "round_robin") == 0)
+		return new MPOLSR_rr_scheduler();
+	if (strcasecmp(name, "wrr") == 0)
+		return new MPOLSR_wrr_scheduler();
+	if (strcasecmp(name, "least_outstanding") == 0)
+		return new MPOLSR_lop_scheduler();
+	if (strcasecmp(name, "delay") == 0)
+		return new MPOLSR_delay_scheduler();
+	return NULL;
+}
+
+///
+/// \brief Accounts for a packet sent through a path.
+///
+/// The sending time of the packet is remembered until a feedback is received,
+/// or until another packet falls into the same slot.
+///
+/// \param path the selected path.
+/// \param uid unique id of the packet.
+///
+void
+MPOLSR_path_scheduler::sent(MPOLSR_m_rt_entry& path, int uid) {
+	// A new busy period starts, the timeout of the outstanding
+	// packets is counted from now on
+	if (path.outstanding_ == 0)
+		path.last_feedback_ = CURRENT_TIME;
+	path.outstanding_++;
+
+	int slot = uid & (MPOLSR_SCHED_SENT_SLOTS - 1);
+	sent_uid_[slot]		= uid;
+	sent_time_[slot]	= CURRENT_TIME;
+}
+
+///
+/// \brief Accounts for a packet acknowledged by the next hop of a path.
+/// \param path the path the packet was sent through.
+/// \param uid unique id of the packet.
+///
+void
+MPOLSR_path_scheduler::acked(MPOLSR_m_rt_entry& path, int uid) {
+	if (path.outstanding_ > 0)
+		path.outstanding_--;
+	path.last_feedback_ = CURRENT_TIME;
+
+	int slot = uid & (MPOLSR_SCHED_SENT_SLOTS - 1);
+	if (sent_uid_[slot] != uid)
+		return;
+	sent_uid_[slot] = -1;
+
+	double delay = CURRENT_TIME - sent_time_[slot];
+	if (path.delay_ == 0)
+		path.delay_ = delay;
+	else
+		path.delay_ += MPOLSR_SCHED_DELAY_GAIN * (delay - path.delay_);
+}
+
+///
+/// \brief Accounts for a packet the MAC layer could not deliver to the next hop of a path.
+/// \param path the path the packet was sent through.
+/// \param uid unique id of the packet.
+///
+void
+MPOLSR_path_scheduler::failed(MPOLSR_m_rt_entry& path, int uid) {
+	if (path.outstanding_ > 0)
+		path.outstanding_--;
+	int slot = uid & (MPOLSR_SCHED_SENT_SLOTS - 1);
+	if (sent_uid_[slot] == uid)
+		sent_uid_[slot] = -1;
+	if (path.delay_ == 0)
+		path.delay_ = MPOLSR_SCHED_FAILURE_DELAY;
+	else
+		path.delay_ += MPOLSR_SCHED_DELAY_GAIN *
+			(MPOLSR_SCHED_FAILURE_DELAY - path.delay_);
+	path.last_feedback_ = CURRENT_TIME;
+}
+
+///
+/// \brief Smooth weighted round robin among the paths of a destination.
+///
+/// Every path earns its weight at each round and the richest one is selected
+/// and charged the sum of the weights, so that the paths are interleaved in
+/// proportion to their weights.
+///
+/// \param dest the paths towards the destination.
+/// \param weight the weight of every path.
+/// \return the index of the selected path.
+///
+int
+MPOLSR_path_scheduler::weighted_select(MPOLSR_m_rt_dest& dest, double* weight) {
+	double total	= 0;
+	int best	= 0;
+	for (int i = 0; i < dest.count_; i++) {
+		dest.paths_[i].credit_ += weight[i];
+		total += weight[i];
+		if (dest.paths_[i].credit_ > dest.paths_[best].credit_)
+			best = i;
+	}
+	dest.paths_[best].credit_ -= total;
+	return best;
+}
+
+///
+/// \brief Selects the next path, following a counter shared by every destination.
+///
+int
+MPOLSR_rr_scheduler::select(MPOLSR_m_rt_dest& dest) {
+	return count_++ % dest.count_;
+}
+
+///
+/// \brief Selects a path with a probability inversely proportional to its cost.
+///
+int
+MPOLSR_wrr_scheduler::select(MPOLSR_m_rt_dest& dest) {
+	double weight[MPOLSR_MAX_PATHS];
+	for (int i = 0; i < dest.count_; i++)
+		weight[i] = 1.0 / (dest.paths_[i].cost_ > 0 ? dest.paths_[i].cost_ : 1);
+	return weighted_select(dest, weight);
+}
+
+///
+/// \brief Selects the path with the fewest outstanding packets, the cheapest one on ties.
+///
+/// Packets dropped before reaching the MAC layer (e.g. by the interface queue)
+/// never get a feedback, so the outstanding packets of a path are forgotten
+/// when no feedback has been received for MPOLSR_SCHED_OUTSTANDING_TIMEOUT.
+///
+int
+MPOLSR_lop_scheduler::select(MPOLSR_m_rt_dest& dest) {
+	double now	= CURRENT_TIME;
+	int best	= 0;
+	for (int i = 0; i < dest.count_; i++) {
+		MPOLSR_m_rt_entry& path = dest.paths_[i];
+		if (path.outstanding_ > 0 &&
+			now - path.last_feedback_ > MPOLSR_SCHED_OUTSTANDING_TIMEOUT)
+			path.outstanding_ = 0;
+		if (path.outstanding_ < dest.paths_[best].outstanding_ ||
+			(path.outstanding_ == dest.paths_[best].outstanding_ &&
+			path.cost_ < dest.paths_[best].cost_))
+			best = i;
+	}
+	return best;
+}
+
+///
+/// \brief Selects a path with a probability inversely proportional to its delay.
+///
+/// Paths which have not been measured yet are given MPOLSR_SCHED_HOP_DELAY per hop.
+///
+int
+MPOLSR_delay_scheduler::select(MPOLSR_m_rt_dest& dest) {
+	double weight[MPOLSR_MAX_PATHS];
+	for (int i = 0; i < dest.count_; i++) {
+		MPOLSR_m_rt_entry& path = dest.paths_[i];
+		double delay = (path.delay_ > 0) ? path.delay_ :
+			path.hops() * MPOLSR_SCHED_HOP_DELAY;
+		weight[i] = 1.0 / (delay > 0 ? delay : MPOLSR_SCHED_HOP_DELAY);
+	}
+	return weighted_select(dest, weight);
+}
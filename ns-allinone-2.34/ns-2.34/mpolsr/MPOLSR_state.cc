@@ -37,58 +37,104 @@
 #include "mpolsr/MPOLSR_state.h"
 #include "mpolsr/MPOLSR.h"
 
+/********** Indexes **********/
+
+static nsaddr_t
+mprsel_key(MPOLSR_mprsel_tuple* tuple) { return tuple->main_addr(); }
+
+static nsaddr_t
+nb_key(MPOLSR_nb_tuple* tuple) { return tuple->nb_main_addr(); }
+
+static std::pair<nsaddr_t, nsaddr_t>
+nb2hop_key(MPOLSR_nb2hop_tuple* tuple) {
+	return std::make_pair(tuple->nb_main_addr(), tuple->nb2hop_addr());
+}
+
+static nsaddr_t
+link_key(MPOLSR_link_tuple* tuple) { return tuple->nb_iface_addr(); }
+
+static std::pair<nsaddr_t, nsaddr_t>
+topology_key(MPOLSR_topology_tuple* tuple) {
+	return std::make_pair(tuple->dest_addr(), tuple->last_addr());
+}
+
+static nsaddr_t
+ifaceassoc_key(MPOLSR_iface_assoc_tuple* tuple) { return tuple->iface_addr(); }
+
+///
+/// \brief Removes a tuple from a repository, keeping the order of the other ones.
+/// \return false if the tuple was not in the repository.
+///
+template <class T>
+static bool
+remove_tuple(std::vector<T*>& set, T* tuple) {
+	for (typename std::vector<T*>::iterator it = set.begin(); it != set.end(); it++) {
+		if (*it == tuple) {
+			set.erase(it);
+			return true;
+		}
+	}
+	return false;
+}
+
+MPOLSR_state::MPOLSR_state() :
+	mprsel_index_(mprsel_key),
+	nb_index_(nb_key),
+	nb2hop_index_(nb2hop_key),
+	link_index_(link_key),
+	topology_index_(topology_key),
+	ifaceassoc_index_(ifaceassoc_key) {
+	nbhood_version_ = 0;
+}
+
 /********** MPR Selector Set Manipulation **********/
 
 MPOLSR_mprsel_tuple*
 MPOLSR_state::find_mprsel_tuple(nsaddr_t main_addr) {
-	for (mprselset_t::iterator it = mprselset_.begin(); it != mprselset_.end(); it++) {
-		MPOLSR_mprsel_tuple* tuple = *it;
-		if (tuple->main_addr() == main_addr)
-			return tuple;
-	}
-	return NULL;
+	return mprsel_index_.find(main_addr);
 }
 
 void
 MPOLSR_state::erase_mprsel_tuple(MPOLSR_mprsel_tuple* tuple) {
-	for (mprselset_t::iterator it = mprselset_.begin(); it != mprselset_.end(); it++) {
-		if (*it == tuple) {
-			mprselset_.erase(it);
-			break;
-		}
-	}
+	if (remove_tuple(mprselset_, tuple))
+		mprsel_index_.erase(tuple, mprselset_);
 }
 
 void
 MPOLSR_state::erase_mprsel_tuples(nsaddr_t main_addr) {
-	for (mprselset_t::iterator it = mprselset_.begin(); it != mprselset_.end(); it++) {
+	if (mprsel_index_.count(main_addr) == 0)
+		return;
+	for (mprselset_t::iterator it = mprselset_.begin(); it != mprselset_.end();) {
 		MPOLSR_mprsel_tuple* tuple = *it;
 		if (tuple->main_addr() == main_addr) {
 			it = mprselset_.erase(it);
-			it--;
+			mprsel_index_.erase(tuple, mprselset_);
 		}
+		else
+			it++;
 	}
 }
 
 void
 MPOLSR_state::insert_mprsel_tuple(MPOLSR_mprsel_tuple* tuple) {
 	mprselset_.push_back(tuple);
+	mprsel_index_.insert(tuple);
 }
 
 /********** Neighbor Set Manipulation **********/
 
 MPOLSR_nb_tuple*
 MPOLSR_state::find_nb_tuple(nsaddr_t main_addr) {
-	for (nbset_t::iterator it = nbset_.begin(); it != nbset_.end(); it++) {
-		MPOLSR_nb_tuple* tuple = *it;
-		if (tuple->nb_main_addr() == main_addr)
-			return tuple;
-	}
-	return NULL;
+	return nb_index_.find(main_addr);
 }
 
 MPOLSR_nb_tuple*
 MPOLSR_state::find_sym_nb_tuple(nsaddr_t main_addr) {
+	// Several tuples with the same address are unusual, they are searched for in order
+	if (nb_index_.count(main_addr) <= 1) {
+		MPOLSR_nb_tuple* tuple = nb_index_.find(main_addr);
+		return (tuple != NULL && tuple->status() == MPOLSR_STATUS_SYM) ? tuple : NULL;
+	}
 	for (nbset_t::iterator it = nbset_.begin(); it != nbset_.end(); it++) {
 		MPOLSR_nb_tuple* tuple = *it;
 		if (tuple->nb_main_addr() == main_addr && tuple->status() == MPOLSR_STATUS_SYM)
@@ -99,6 +145,10 @@ MPOLSR_state::find_sym_nb_tuple(nsaddr_t main_addr) {
 
 MPOLSR_nb_tuple*
 MPOLSR_state::find_nb_tuple(nsaddr_t main_addr, u_int8_t willingness) {
+	if (nb_index_.count(main_addr) <= 1) {
+		MPOLSR_nb_tuple* tuple = nb_index_.find(main_addr);
+		return (tuple != NULL && tuple->willingness() == willingness) ? tuple : NULL;
+	}
 	for (nbset_t::iterator it = nbset_.begin(); it != nbset_.end(); it++) {
 		MPOLSR_nb_tuple* tuple = *it;
 		if (tuple->nb_main_addr() == main_addr && tuple->willingness() == willingness)
@@ -109,77 +159,76 @@ MPOLSR_state::find_nb_tuple(nsaddr_t main_addr, u_int8_t willingness) {
 
 void
 MPOLSR_state::erase_nb_tuple(MPOLSR_nb_tuple* tuple) {
-	for (nbset_t::iterator it = nbset_.begin(); it != nbset_.end(); it++) {
-		if (*it == tuple) {
-			nbset_.erase(it);
-			break;
-		}
+	if (remove_tuple(nbset_, tuple)) {
+		nb_index_.erase(tuple, nbset_);
+		nbhood_version_++;
 	}
 }
 
 void
 MPOLSR_state::erase_nb_tuple(nsaddr_t main_addr) {
-	for (nbset_t::iterator it = nbset_.begin(); it != nbset_.end(); it++) {
-		MPOLSR_nb_tuple* tuple = *it;
-		if (tuple->nb_main_addr() == main_addr) {
-			it = nbset_.erase(it);
-			break;
-		}
-	}
+	MPOLSR_nb_tuple* tuple = nb_index_.find(main_addr);
+	if (tuple != NULL)
+		erase_nb_tuple(tuple);
 }
 
 void
 MPOLSR_state::insert_nb_tuple(MPOLSR_nb_tuple* tuple) {
 	nbset_.push_back(tuple);
+	nb_index_.insert(tuple);
+	nbhood_version_++;
 }
 
 /********** Neighbor 2 Hop Set Manipulation **********/
 
 MPOLSR_nb2hop_tuple*
 MPOLSR_state::find_nb2hop_tuple(nsaddr_t nb_main_addr, nsaddr_t nb2hop_addr) {
-	for (nb2hopset_t::iterator it = nb2hopset_.begin(); it != nb2hopset_.end(); it++) {
-		MPOLSR_nb2hop_tuple* tuple = *it;
-		if (tuple->nb_main_addr() == nb_main_addr && tuple->nb2hop_addr() == nb2hop_addr)
-			return tuple;
-	}
-	return NULL;
+	return nb2hop_index_.find(std::make_pair(nb_main_addr, nb2hop_addr));
 }
 
 void
 MPOLSR_state::erase_nb2hop_tuple(MPOLSR_nb2hop_tuple* tuple) {
-	for (nb2hopset_t::iterator it = nb2hopset_.begin(); it != nb2hopset_.end(); it++) {
-		if (*it == tuple) {
-			nb2hopset_.erase(it);
-			break;
-		}
+	if (remove_tuple(nb2hopset_, tuple)) {
+		nb2hop_index_.erase(tuple, nb2hopset_);
+		nbhood_version_++;
 	}
 }
 
 void
 MPOLSR_state::erase_nb2hop_tuples(nsaddr_t nb_main_addr, nsaddr_t nb2hop_addr) {
-	for (nb2hopset_t::iterator it = nb2hopset_.begin(); it != nb2hopset_.end(); it++) {
+	if (nb2hop_index_.count(std::make_pair(nb_main_addr, nb2hop_addr)) == 0)
+		return;
+	for (nb2hopset_t::iterator it = nb2hopset_.begin(); it != nb2hopset_.end();) {
 		MPOLSR_nb2hop_tuple* tuple = *it;
 		if (tuple->nb_main_addr() == nb_main_addr && tuple->nb2hop_addr() == nb2hop_addr) {
 			it = nb2hopset_.erase(it);
-			it--;
+			nb2hop_index_.erase(tuple, nb2hopset_);
+			nbhood_version_++;
 		}
+		else
+			it++;
 	}
 }
 
 void
 MPOLSR_state::erase_nb2hop_tuples(nsaddr_t nb_main_addr) {
-	for (nb2hopset_t::iterator it = nb2hopset_.begin(); it != nb2hopset_.end(); it++) {
+	for (nb2hopset_t::iterator it = nb2hopset_.begin(); it != nb2hopset_.end();) {
 		MPOLSR_nb2hop_tuple* tuple = *it;
 		if (tuple->nb_main_addr() == nb_main_addr) {
 			it = nb2hopset_.erase(it);
-			it--;
+			nb2hop_index_.erase(tuple, nb2hopset_);
+			nbhood_version_++;
 		}
+		else
+			it++;
 	}
 }
 
 void
-MPOLSR_state::insert_nb2hop_tuple(MPOLSR_nb2hop_tuple* tuple){
+MPOLSR_state::insert_nb2hop_tuple(MPOLSR_nb2hop_tuple* tuple) {
 	nb2hopset_.push_back(tuple);
+	nb2hop_index_.insert(tuple);
+	nbhood_version_++;
 }
 
 /********** MPR Set Manipulation **********/
@@ -202,147 +251,178 @@ MPOLSR_state::clear_mprset() {
 
 /********** Duplicate Set Manipulation **********/
 
-MPOLSR_dup_tuple*
-MPOLSR_state::find_dup_tuple(nsaddr_t addr, u_int16_t seq_num) {
-	for (dupset_t::iterator it = dupset_.begin(); it != dupset_.end(); it++) {
-		MPOLSR_dup_tuple* tuple = *it;
-		if (tuple->addr() == addr && tuple->seq_num() == seq_num)
-			return tuple;
-	}
-	return NULL;
+///
+/// \brief Tells whether a message has been considered for forwarding.
+///
+/// Messages older than the window of their originator are taken as
+/// duplicates, since they would have been recorded less than the
+/// duplicate hold time ago.
+///
+/// \param addr originator address of the message.
+/// \param seq_num message sequence number.
+/// \param now current time.
+///
+bool
+MPOLSR_state::find_dup(nsaddr_t addr, u_int16_t seq_num, double now) {
+	MPOLSR_dup_window* window = dup_windows_.find(addr);
+	if (window == NULL || window->bits() == 0 || window->time() < now)
+		return false;
+	u_int16_t back = window->top() - seq_num;
+	if (back >= 0x8000)
+		return false;
+	if (back >= MPOLSR_DUP_WINDOW)
+		return true;
+	return (window->bits() >> back) & 1;
 }
 
+///
+/// \brief Records that a message has been considered for forwarding.
+///
+/// \param addr originator address of the message.
+/// \param seq_num message sequence number.
+/// \param now current time.
+/// \param time time at which the record expires.
+///
 void
-MPOLSR_state::erase_dup_tuple(MPOLSR_dup_tuple* tuple) {
-	for (dupset_t::iterator it = dupset_.begin(); it != dupset_.end(); it++) {
-		if (*it == tuple) {
-			dupset_.erase(it);
-			break;
-		}
+MPOLSR_state::insert_dup(nsaddr_t addr, u_int16_t seq_num, double now, double time) {
+	MPOLSR_dup_window& window = dup_windows_[addr];
+	u_int16_t back = window.top() - seq_num;
+	if (window.bits() == 0 || window.time() < now) {
+		window.top()	= seq_num;
+		window.bits()	= 1;
 	}
-}
-
-void
-MPOLSR_state::insert_dup_tuple(MPOLSR_dup_tuple* tuple) {
-	dupset_.push_back(tuple);
+	else if (back < 0x8000) {
+		if (back < MPOLSR_DUP_WINDOW)
+			window.bits() |= (u_int64_t)1 << back;
+	}
+	else {
+		u_int16_t ahead = seq_num - window.top();
+		window.top()	= seq_num;
+		window.bits()	= (ahead < MPOLSR_DUP_WINDOW) ? (window.bits() << ahead) | 1 : 1;
+	}
+	window.time() = time;
 }
 
 /********** Link Set Manipulation **********/
 
 MPOLSR_link_tuple*
 MPOLSR_state::find_link_tuple(nsaddr_t iface_addr) {
-	for (linkset_t::iterator it = linkset_.begin(); it != linkset_.end(); it++) {
-		MPOLSR_link_tuple* tuple = *it;
-		if (tuple->nb_iface_addr() == iface_addr)
-			return tuple;
-	}
-	return NULL;
+	return link_index_.find(iface_addr);
 }
 
 MPOLSR_link_tuple*
 MPOLSR_state::find_sym_link_tuple(nsaddr_t iface_addr, double now) {
-	for (linkset_t::iterator it = linkset_.begin(); it != linkset_.end(); it++) {
-		MPOLSR_link_tuple* tuple = *it;
-		if (tuple->nb_iface_addr() == iface_addr) {
-			if (tuple->sym_time() > now)
-				return tuple;
-			else
-				break;
-		}
-	}
-	return NULL;
+	MPOLSR_link_tuple* tuple = link_index_.find(iface_addr);
+	return (tuple != NULL && tuple->sym_time() > now) ? tuple : NULL;
 }
 
 void
 MPOLSR_state::erase_link_tuple(MPOLSR_link_tuple* tuple) {
-	for (linkset_t::iterator it = linkset_.begin(); it != linkset_.end(); it++) {
-		if (*it == tuple) {
-			linkset_.erase(it);
-			break;
-		}
-	}
+	if (remove_tuple(linkset_, tuple))
+		link_index_.erase(tuple, linkset_);
 }
 
 void
 MPOLSR_state::insert_link_tuple(MPOLSR_link_tuple* tuple) {
 	linkset_.push_back(tuple);
+	link_index_.insert(tuple);
 }
 
 /********** Topology Set Manipulation **********/
 
 MPOLSR_topology_tuple*
 MPOLSR_state::find_topology_tuple(nsaddr_t dest_addr, nsaddr_t last_addr) {
-	for (topologyset_t::iterator it = topologyset_.begin(); it != topologyset_.end(); it++) {
-		MPOLSR_topology_tuple* tuple = *it;
-		if (tuple->dest_addr() == dest_addr && tuple->last_addr() == last_addr)
-			return tuple;
-	}
-	return NULL;
+	return topology_index_.find(std::make_pair(dest_addr, last_addr));
 }
 
 MPOLSR_topology_tuple*
 MPOLSR_state::find_newer_topology_tuple(nsaddr_t last_addr, u_int16_t ansn) {
-	for (topologyset_t::iterator it = topologyset_.begin(); it != topologyset_.end(); it++) {
+	topologyset_t* tuples = topology_last_index_.find(last_addr);
+	if (tuples == NULL)
+		return NULL;
+	for (topologyset_t::iterator it = tuples->begin(); it != tuples->end(); it++) {
 		MPOLSR_topology_tuple* tuple = *it;
-		if (tuple->last_addr() == last_addr && tuple->seq() > ansn)
+		if (tuple->seq() > ansn)
 			return tuple;
 	}
 	return NULL;
 }
 
+///
+/// \brief Gives the topology tuples whose last hop is the given address.
+/// \return the tuples, in repository order, or NULL if there is none.
+///
+topologyset_t*
+MPOLSR_state::find_topology_tuples(nsaddr_t last_addr) {
+	return topology_last_index_.find(last_addr);
+}
+
 void
 MPOLSR_state::erase_topology_tuple(MPOLSR_topology_tuple* tuple) {
-	for (topologyset_t::iterator it = topologyset_.begin(); it != topologyset_.end(); it++) {
-		if (*it == tuple) {
-			topologyset_.erase(it);
-			break;
-		}
-	}
+	if (remove_tuple(topologyset_, tuple))
+		unindex_topology_tuple(tuple);
 }
 
 void
 MPOLSR_state::erase_older_topology_tuples(nsaddr_t last_addr, u_int16_t ansn) {
+	topologyset_t* tuples = topology_last_index_.find(last_addr);
+	if (tuples == NULL)
+		return;
+	topologyset_t older;
+	for (topologyset_t::iterator it = tuples->begin(); it != tuples->end(); it++)
+		if ((*it)->seq() < ansn)
+			older.push_back(*it);
+	if (older.empty())
+		return;
+
+	// Removes them in a single pass, keeping the order of the other tuples
+	topologyset_t::iterator out = topologyset_.begin();
 	for (topologyset_t::iterator it = topologyset_.begin(); it != topologyset_.end(); it++) {
 		MPOLSR_topology_tuple* tuple = *it;
-		if (tuple->last_addr() == last_addr && tuple->seq() < ansn) {
-			it = topologyset_.erase(it);
-			it--;
-		}
+		if (!(tuple->last_addr() == last_addr && tuple->seq() < ansn))
+			*out++ = tuple;
 	}
+	topologyset_.erase(out, topologyset_.end());
+	for (topologyset_t::iterator it = older.begin(); it != older.end(); it++)
+		unindex_topology_tuple(*it);
 }
 
 void
 MPOLSR_state::insert_topology_tuple(MPOLSR_topology_tuple* tuple) {
 	topologyset_.push_back(tuple);
+	topology_index_.insert(tuple);
+	topology_last_index_[tuple->last_addr()].push_back(tuple);
+}
+
+///
+/// \brief Unindexes a tuple which has just been removed from the Topology Set.
+///
+void
+MPOLSR_state::unindex_topology_tuple(MPOLSR_topology_tuple* tuple) {
+	topology_index_.erase(tuple, topologyset_);
+	topologyset_t* tuples = topology_last_index_.find(tuple->last_addr());
+	if (tuples == NULL)
+		return;
+	remove_tuple(*tuples, tuple);
+	if (tuples->empty())
+		topology_last_index_.erase(tuple->last_addr());
 }
 
 /********** Interface Association Set Manipulation **********/
 
 MPOLSR_iface_assoc_tuple*
 MPOLSR_state::find_ifaceassoc_tuple(nsaddr_t iface_addr) {
-	for (ifaceassocset_t::iterator it = ifaceassocset_.begin();
-		it != ifaceassocset_.end();
-		it++) {
-		MPOLSR_iface_assoc_tuple* tuple = *it;
-		if (tuple->iface_addr() == iface_addr)
-			return tuple;
-	}
-	return NULL;
+	return ifaceassoc_index_.find(iface_addr);
 }
 
 void
 MPOLSR_state::erase_ifaceassoc_tuple(MPOLSR_iface_assoc_tuple* tuple) {
-	for (ifaceassocset_t::iterator it = ifaceassocset_.begin();
-		it != ifaceassocset_.end();
-		it++) {
-		if (*it == tuple) {
-			ifaceassocset_.erase(it);
-			break;
-		}
-	}
+	if (remove_tuple(ifaceassocset_, tuple))
+		ifaceassoc_index_.erase(tuple, ifaceassocset_);
 }
 
 void
 MPOLSR_state::insert_ifaceassoc_tuple(MPOLSR_iface_assoc_tuple* tuple) {
 	ifaceassocset_.push_back(tuple);
+	ifaceassoc_index_.insert(tuple);
 }
@@ -1,14 +1,247 @@
+/*              Copyright (C) 2010
+	*             Multipath Extension by Jiazi Yi,                            *
+ 	*                   2007   Ecole Polytech of Nantes, France               *
+ 	*                   jiazi.yi@univ-nantes.fr				   *
+ 	****************************************************************************
+ 	*    	This program is distributed in the hope that it will be useful,				*
+	*    	but WITHOUT ANY WARRANTY; without even the implied warranty of				*
+	*    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 					*
+ 	**************************************************************************
+*/
+
+///
+/// \file	mojette.cc
+/// \brief	Implementation of the Mojette transform erasure coding layer.
+///
+
 #include "mpolsr/mojette.h"
+#include "ip.h"
+
+using namespace std;
+
+/********** Mojette packet header **********/
+
+int hdr_mojette::offset_;
+static class MojetteHeaderClass : public PacketHeaderClass {
+public:
+	MojetteHeaderClass() : PacketHeaderClass("PacketHeader/Mojette", sizeof(hdr_mojette)) {
+		bind_offset(&hdr_mojette::offset_);
+	}
+} class_rtProtoMojette_hdr;
+
+/********** Timer **********/
+
+///
+/// \brief Discards the buffers whose time is over.
+///
+void
+MojetteTimer::expire(Event* e) {
+	mojette_->expire();
+}
+
+/********** Coding layer **********/
+
+///
+/// \brief Creates an empty coding layer.
+///
+Mojette::Mojette() : timer_(this) {
+	encoded_	= 0;
+	decoded_	= 0;
+	expired_	= 0;
+	failed_		= 0;
+	redundant_	= 0;
+	latency_	= 0;
+	bytes_in_	= 0;
+	bytes_out_	= 0;
+}
+
+///
+/// \brief Releases the projections still waiting for reconstruction.
+///
+Mojette::~Mojette() {
+	for (map<mojette_key_t, MojetteBuffer>::iterator it = buffers_.begin();
+		it != buffers_.end(); it++)
+		for (int i = 0; i < MOJETTE_MAX_PROJECTIONS; i++)
+			if (it->second.proj_[i] != NULL)
+				Packet::free(it->second.proj_[i]);
+}
+
+///
+/// \brief Splits a packet into projections.
+///
+/// The payload is the data of the packet if it carries any, and the output of
+/// MojetteTransform::fill() otherwise. The packet itself becomes the last
+/// projection, the other ones are copies of it. Every projection keeps the common and IP headers of
+/// the packet, and its size is the one of the IP header, the Mojette header
+/// and its bins. Projections are sent to the routing agent port, so that
+/// the destination passes them to the agent instead of the upper layers.
+///
+/// \param p the packet, its size already accounts for the IP header.
+/// \param src address of the encoding node.
+/// \param n number of projections.
+/// \param m number of projections needed to reconstruct the packet.
+/// \param proj the projections.
+///
+void
+Mojette::encode(Packet* p, nsaddr_t src, int n, int m, vector<Packet*>& proj) {
+	struct hdr_cmn* ch	= HDR_CMN(p);
+	struct hdr_mojette* hm	= HDR_MOJETTE(p);
+	PacketData* pd		= (p->userdata() != NULL &&
+		p->userdata()->type() == PACKET_DATA) ? (PacketData*)p->userdata() : NULL;
+
+	int len = (pd != NULL) ? pd->size() : ch->size() - IP_HDR_LEN;
+	if (len < 1)
+		len = 1;
+	data_.resize(len);
+	if (pd != NULL)
+		memcpy(&data_[0], pd->data(), len);
+	else
+		MojetteTransform::fill(ch->uid(), &data_[0], len);
+
+	hm->src()	= src;
+	hm->uid()	= ch->uid();
+	hm->size()	= ch->size();
+	hm->len()	= len;
+	hm->dport()	= HDR_IP(p)->dport();
+	hm->n()		= n;
+	hm->m()		= m;
+	hm->synth()	= (pd == NULL);
+
+	encoded_++;
+	bytes_in_ += ch->size();
+
+	proj.clear();
+	for (int i = 0; i < n; i++) {
+		Packet* q = (i == n - 1) ? p : p->copy();
+		int dir = MojetteTransform::direction(i);
+		int b = MojetteTransform::bins(len, m, dir, MOJETTE_PIXEL_LEN) * MOJETTE_PIXEL_LEN;
+		PacketData* bins = new PacketData(b);
+		MojetteTransform::forward(&data_[0], len, m, dir, MOJETTE_PIXEL_LEN, bins->data());
+		q->setdata(bins);
 
+		HDR_MOJETTE(q)->index()	= i;
+		HDR_IP(q)->dport()	= RT_PORT;
+		HDR_CMN(q)->size()	= IP_HDR_LEN + MOJETTE_HDR_LEN + b;
+		bytes_out_ += HDR_CMN(q)->size();
+		proj.push_back(q);
+	}
+}
 
+///
+/// \brief Processes a projection destined to this node.
+///
+/// Once m different projections of a packet have been received, the payload
+/// is reconstructed and the packet is returned with its original unique id,
+/// size, addresses and data. Redundant projections are released.
+///
+/// \param p the projection.
+/// \return the reconstructed packet, or NULL if it is not complete yet.
+///
+Packet*
+Mojette::recv(Packet* p) {
+	struct hdr_mojette* hm	= HDR_MOJETTE(p);
+	double now		= Scheduler::instance().clock();
+	mojette_key_t key	= make_pair(hm->src(), hm->uid());
 
+	map<mojette_key_t, MojetteBuffer>::iterator it = buffers_.find(key);
+	if (it == buffers_.end()) {
+		MojetteBuffer buf;
+		buf.first_	= now;
+		buf.decoded_	= false;
+		buf.count_	= 0;
+		for (int i = 0; i < MOJETTE_MAX_PROJECTIONS; i++)
+			buf.proj_[i] = NULL;
+		it = buffers_.insert(make_pair(key, buf)).first;
 
+		expiry_.push_back(make_pair(now + MOJETTE_PACKET_TIMEOUT, key));
+		if (expiry_.size() == 1)
+			timer_.resched(MOJETTE_PACKET_TIMEOUT);
+	}
 
+	MojetteBuffer& buf = it->second;
+	if (buf.decoded_ || hm->index() >= MOJETTE_MAX_PROJECTIONS ||
+		buf.proj_[hm->index()] != NULL) {
+		redundant_++;
+		Packet::free(p);
+		return NULL;
+	}
+	buf.proj_[hm->index()] = p;
+	if (++buf.count_ < hm->m())
+		return NULL;
 
+	// Enough projections, reconstruct the payload
+	int m	= hm->m();
+	int len	= hm->len();
+	int dir[MOJETTE_MAX_PROJECTIONS];
+	const u_int8_t* bins[MOJETTE_MAX_PROJECTIONS];
+	int count = 0;
+	for (int i = 0; i < MOJETTE_MAX_PROJECTIONS; i++) {
+		Packet* q = buf.proj_[i];
+		if (q == NULL)
+			continue;
+		dir[count]	= MojetteTransform::direction(i);
+		bins[count]	= ((PacketData*)q->userdata())->data();
+		count++;
+	}
+	data_.resize(len);
+	bool ok = transform_.inverse(len, m, count, dir, bins, MOJETTE_PIXEL_LEN, &data_[0]);
+	if (ok && hm->synth()) {
+		vector<u_int8_t> expected(len);
+		MojetteTransform::fill(hm->uid(), &expected[0], len);
+		ok = (expected == data_);
+	}
 
-//std::map<int, Packet*> Mojette::sOriginals;
+	buf.decoded_ = true;
+	for (int i = 0; i < MOJETTE_MAX_PROJECTIONS; i++) {
+		if (buf.proj_[i] != NULL && buf.proj_[i] != p)
+			Packet::free(buf.proj_[i]);
+		buf.proj_[i] = NULL;
+	}
+	if (!ok) {
+		failed_++;
+		Packet::free(p);
+		return NULL;
+	}
 
-//std::map<int, MojetteTimer> Mojette::sTimers;
+	decoded_++;
+	latency_ += now - buf.first_;
 
+	// Restore the original packet
+	HDR_CMN(p)->uid()	= hm->uid();
+	HDR_CMN(p)->size()	= hm->size();
+	HDR_IP(p)->saddr()	= hm->src();
+	HDR_IP(p)->dport()	= hm->dport();
+	if (hm->synth())
+		p->setdata(NULL);
+	else {
+		PacketData* pd = new PacketData(len);
+		memcpy(pd->data(), &data_[0], len);
+		p->setdata(pd);
+	}
+	hm->n() = 0;
+	return p;
+}
 
+///
+/// \brief Discards the buffers older than MOJETTE_PACKET_TIMEOUT.
+///
+void
+Mojette::expire() {
+	double now = Scheduler::instance().clock();
 
+	while (!expiry_.empty() && expiry_.front().first <= now) {
+		map<mojette_key_t, MojetteBuffer>::iterator it =
+			buffers_.find(expiry_.front().second);
+		expiry_.pop_front();
+		if (it == buffers_.end())
+			continue;
+		if (!it->second.decoded_)
+			expired_++;
+		for (int i = 0; i < MOJETTE_MAX_PROJECTIONS; i++)
+			if (it->second.proj_[i] != NULL)
+				Packet::free(it->second.proj_[i]);
+		buffers_.erase(it);
+	}
+	if (!expiry_.empty())
+		timer_.resched(expiry_.front().first - now);
+}
@@ -0,0 +1,164 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+///
+/// \file	mojette_bench.cc
+/// \brief	Microbenchmark of the Mojette transform kernels.
+///
+/// A payload is split into n projections, n going from 2 to 8, and rebuilt
+/// from the last m = n - 1 of them, so that the projection of direction 0
+/// (which is a plain copy of the rows) is never used. The throughput of both
+/// operations is reported in MB of payload per second, and every
+/// reconstruction is checked.
+///
+/// Encoding is measured for every kernel the processor supports. Decoding
+/// only calls the kernel for pixels longer than MOJETTE_SHORT_XOR bytes, so
+/// it is measured once, as "inline", for shorter pixels.
+///
+/// Usage: mojette-bench [-k kernel] [-w pixel length] [-t seconds per case]
+///
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <vector>
+
+#include "mpolsr/mojette_kernels.h"
+
+/// Payload lengths measured, in bytes.
+static const int bench_sizes[] = { 64, 128, 256, 512, 1024, 1500 };
+/// Kernels measured, unless one is given on the command line.
+static const char* bench_kernels[] = { "scalar", "sse2", "avx2" };
+
+///
+/// \brief Gives the current time in seconds.
+///
+static double
+bench_now() {
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+///
+/// \brief Measures one payload length and number of projections.
+/// \param rate filled with the throughput of the encoding, or of the decoding.
+/// \return false if a reconstructed payload differs from the original one.
+///
+static bool
+bench_case(MojetteTransform& transform, int len, int n, int w, double span,
+	bool decode, double& rate) {
+	int m = n - 1;
+	std::vector<u_int8_t> data(len), out(len);
+	std::vector<std::vector<u_int8_t> > bins(n);
+	int dir[MOJETTE_MAX_PROJECTIONS];
+	const u_int8_t* in[MOJETTE_MAX_PROJECTIONS];
+
+	MojetteTransform::fill(len * n, &data[0], len);
+	for (int i = 0; i < n; i++)
+		bins[i].resize(MojetteTransform::bins(len, m, MojetteTransform::direction(i), w) * w);
+	for (int i = 1; i < n; i++) {
+		dir[i - 1]	= MojetteTransform::direction(i);
+		in[i - 1]	= &bins[i][0];
+	}
+
+	long rounds	= 0;
+	double start	= bench_now();
+	double elapsed;
+	do {
+		for (int r = 0; r < (decode ? 1 : 64); r++, rounds++)
+			for (int i = 0; i < n; i++)
+				MojetteTransform::forward(&data[0], len, m,
+					MojetteTransform::direction(i), w, &bins[i][0]);
+		elapsed = bench_now() - start;
+	} while (!decode && elapsed < span);
+	rate = len * (double)rounds / elapsed / 1e6;
+	if (!decode)
+		return true;
+
+	rounds	= 0;
+	start	= bench_now();
+	do {
+		for (int r = 0; r < 64; r++, rounds++)
+			transform.inverse(len, m, n - 1, dir, in, w, &out[0]);
+		elapsed = bench_now() - start;
+	} while (elapsed < span);
+	rate = len * (double)rounds / elapsed / 1e6;
+
+	return out == data;
+}
+
+static void
+usage(const char* prog) {
+	fprintf(stderr, "usage: %s [-k kernel] [-w pixel length] [-t seconds per case]\n", prog);
+	exit(2);
+}
+
+int
+main(int argc, char** argv) {
+	const char* only	= NULL;
+	int w			= 8;
+	double span		= 0.05;
+	int c;
+
+	while ((c = getopt(argc, argv, "k:w:t:")) != -1) {
+		switch (c) {
+		case 'k': only = optarg; break;
+		case 'w': w = atoi(optarg); break;
+		case 't': span = atof(optarg); break;
+		default: usage(argv[0]);
+		}
+	}
+	if (w < 1 || span <= 0)
+		usage(argv[0]);
+	if (only != NULL && !mojette_has_kernel(only)) {
+		fprintf(stderr, "%s: kernel %s is not supported\n", argv[0], only);
+		return 2;
+	}
+
+	MojetteTransform transform;
+	int errors = 0;
+	printf("# default kernel: %s, pixel length: %d bytes\n", mojette_kernel(), w);
+	for (int decode = 0; decode <= 1; decode++) {
+		printf("# %-8s %6s %2s %2s %12s\n", "kernel", "size", "n", "m",
+			decode ? "decode MB/s" : "encode MB/s");
+		bool inline_xor = decode && w <= MOJETTE_SHORT_XOR;
+		for (unsigned k = 0; k < sizeof(bench_kernels) / sizeof(bench_kernels[0]); k++) {
+			const char* name = bench_kernels[k];
+			if (only != NULL ? strcasecmp(only, name) != 0 : !mojette_has_kernel(name))
+				continue;
+			mojette_set_kernel(name);
+			for (unsigned s = 0; s < sizeof(bench_sizes) / sizeof(bench_sizes[0]); s++) {
+				for (int n = 2; n <= MOJETTE_MAX_PROJECTIONS; n++) {
+					double rate;
+					bool ok = bench_case(transform, bench_sizes[s], n, w, span, decode, rate);
+					printf("  %-8s %6d %2d %2d %12.1f%s\n", inline_xor ? "inline" : name,
+						bench_sizes[s], n, n - 1, rate, ok ? "" : "  MISMATCH");
+					if (!ok)
+						errors++;
+				}
+			}
+			// the kernel is never called, one pass is enough
+			if (inline_xor)
+				break;
+		}
+	}
+	return errors > 0;
+}
@@ -0,0 +1,332 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+///
+/// \file	mojette_kernels.cc
+/// \brief	Implementation of the Mojette transform kernels.
+///
+
+#include <string.h>
+#include <strings.h>
+#include <algorithm>
+
+#include "mpolsr/mojette_kernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MOJETTE_X86
+#endif
+
+/********** XOR kernels **********/
+
+///
+/// \brief XORs a buffer into another one, a 64-bit word at a time.
+///
+/// Loop vectorization is disabled, so that this is the reference the other
+/// kernels are compared to.
+///
+#ifdef __GNUC__
+__attribute__((optimize("no-tree-vectorize")))
+#endif
+static void
+mojette_xor_scalar(u_int8_t* dst, const u_int8_t* src, int len) {
+	int i = 0;
+	for (; i + 8 <= len; i += 8) {
+		u_int64_t a, b;
+		memcpy(&a, dst + i, 8);
+		memcpy(&b, src + i, 8);
+		a ^= b;
+		memcpy(dst + i, &a, 8);
+	}
+	for (; i < len; i++)
+		dst[i] ^= src[i];
+}
+
+#ifdef MOJETTE_X86
+///
+/// \brief XORs a buffer into another one, vectorized by the compiler for SSE2.
+///
+__attribute__((target("sse2"), optimize("tree-vectorize", "vect-cost-model=dynamic")))
+static void
+mojette_xor_sse2(u_int8_t* __restrict__ dst, const u_int8_t* __restrict__ src, int len) {
+	for (int i = 0; i < len; i++)
+		dst[i] ^= src[i];
+}
+
+///
+/// \brief XORs a buffer into another one, vectorized by the compiler for AVX2.
+///
+__attribute__((target("avx2"), optimize("tree-vectorize", "vect-cost-model=dynamic")))
+static void
+mojette_xor_avx2(u_int8_t* __restrict__ dst, const u_int8_t* __restrict__ src, int len) {
+	for (int i = 0; i < len; i++)
+		dst[i] ^= src[i];
+}
+#endif
+
+/// A kernel and its name.
+struct mojette_kernel_t {
+	const char*	name_;
+	mojette_xor_t	xor_;
+};
+
+/// Kernels, from the slowest to the fastest.
+static const mojette_kernel_t mojette_kernels[] = {
+	{ "scalar",	mojette_xor_scalar },
+#ifdef MOJETTE_X86
+	{ "sse2",	mojette_xor_sse2 },
+	{ "avx2",	mojette_xor_avx2 },
+#endif
+};
+
+#define MOJETTE_NKERNELS	(int)(sizeof(mojette_kernels) / sizeof(mojette_kernels[0]))
+
+/// Index of the kernel in use.
+static int mojette_current = 0;
+
+///
+/// \brief Tells if the processor can run a kernel.
+/// \param name the name of the kernel.
+///
+bool
+mojette_has_kernel(const char* name) {
+#ifdef MOJETTE_X86
+	__builtin_cpu_init();
+	if (strcasecmp(name, "sse2") == 0)
+		return __builtin_cpu_supports("sse2");
+	if (strcasecmp(name, "avx2") == 0)
+		return __builtin_cpu_supports("avx2");
+#endif
+	return strcasecmp(name, "scalar") == 0;
+}
+
+///
+/// \brief Chooses the fastest kernel the processor can run.
+///
+static mojette_xor_t
+mojette_best_kernel() {
+	for (int i = MOJETTE_NKERNELS - 1; i > 0; i--) {
+		if (mojette_has_kernel(mojette_kernels[i].name_)) {
+			mojette_current = i;
+			break;
+		}
+	}
+	return mojette_kernels[mojette_current].xor_;
+}
+
+mojette_xor_t mojette_xor = mojette_best_kernel();
+
+///
+/// \brief Gives the name of the kernel in use.
+///
+const char*
+mojette_kernel() {
+	return mojette_kernels[mojette_current].name_;
+}
+
+///
+/// \brief Selects the kernel to be used.
+/// \param name the name of the kernel.
+/// \return false if the kernel is unknown or not supported by the processor.
+///
+bool
+mojette_set_kernel(const char* name) {
+	for (int i = 0; i < MOJETTE_NKERNELS; i++) {
+		if (strcasecmp(name, mojette_kernels[i].name_) == 0) {
+			if (!mojette_has_kernel(name))
+				return false;
+			mojette_current	= i;
+			mojette_xor	= mojette_kernels[i].xor_;
+			return true;
+		}
+	}
+	return false;
+}
+
+///
+/// \brief XORs a pixel into a bin.
+///
+/// Pixels are usually a few words long, so they are XORed inline and only
+/// the long ones go through the kernel.
+///
+static inline void
+mojette_xor_pixel(u_int8_t* dst, const u_int8_t* src, int len) {
+	if (len > MOJETTE_SHORT_XOR) {
+		mojette_xor(dst, src, len);
+		return;
+	}
+	int i = 0;
+	for (; i + 8 <= len; i += 8) {
+		u_int64_t a, b;
+		memcpy(&a, dst + i, 8);
+		memcpy(&b, src + i, 8);
+		a ^= b;
+		memcpy(dst + i, &a, 8);
+	}
+	for (; i < len; i++)
+		dst[i] ^= src[i];
+}
+
+/********** Mojette transform **********/
+
+///
+/// \brief Gives the direction of a projection.
+/// \param index the index of the projection.
+/// \return p_i, following the sequence 0, 1, -1, 2, -2, ...
+///
+int
+MojetteTransform::direction(int index) {
+	return (index % 2 == 1) ? (index + 1) / 2 : -(index / 2);
+}
+
+///
+/// \brief Gives the number of columns of the grid.
+/// \param len length of the payload.
+/// \param m number of rows of the grid.
+/// \param w length of a pixel.
+///
+int
+MojetteTransform::cols(int len, int m, int w) {
+	int pixels = (len + w - 1) / w;
+	return (pixels + m - 1) / m;
+}
+
+///
+/// \brief Gives the number of bins of a projection.
+/// \param len length of the payload.
+/// \param m number of rows of the grid.
+/// \param p direction of the projection.
+/// \param w length of a pixel, i.e. of a bin.
+///
+int
+MojetteTransform::bins(int len, int m, int p, int w) {
+	return cols(len, m, w) + (m - 1) * (p < 0 ? -p : p);
+}
+
+///
+/// \brief Computes the projection (p, 1) of a payload.
+///
+/// Pixel k of row l lies on bin k + p l, shifted by (m - 1) |p| when p is
+/// negative, so every row is XORed at once into a contiguous run of bins.
+/// The bytes padding the last rows are zero, so they are skipped.
+///
+/// \param data the payload.
+/// \param len length of the payload.
+/// \param m number of rows of the grid.
+/// \param p direction of the projection.
+/// \param w length of a pixel.
+/// \param bins the bins of the projection, bins() * w bytes long.
+///
+void
+MojetteTransform::forward(const u_int8_t* data, int len, int m, int p, int w,
+	u_int8_t* bins) {
+	int row	= cols(len, m, w) * w;
+	int off	= (p < 0) ? -p * (m - 1) : 0;
+
+	memset(bins, 0, MojetteTransform::bins(len, m, p, w) * w);
+	for (int l = 0; l < m && l * row < len; l++) {
+		int end = std::min(row, len - l * row);
+		mojette_xor(bins + (off + p * l) * w, data + l * row, end);
+	}
+}
+
+///
+/// \brief Reconstructs a payload from a set of its projections.
+///
+/// Only the first m projections are used. They are sorted by decreasing
+/// direction and row l is read from projection l: pixel k of row l is
+/// recovered at step k + d_l, with d_0 = 0 and d_l = d_(l-1) + p_l. At that
+/// step the other pixels of its bin have already been recovered and removed
+/// from the bin, so it holds the value of the pixel, which is then removed
+/// from the bins of the other projections.
+///
+/// \param len length of the payload.
+/// \param m number of rows of the grid.
+/// \param count number of projections.
+/// \param p direction of every projection, all different.
+/// \param bins the bins of every projection.
+/// \param w length of a pixel.
+/// \param data the reconstructed payload, len bytes long.
+/// \return false if there are less than m projections.
+///
+bool
+MojetteTransform::inverse(int len, int m, int count, const int* p,
+	const u_int8_t* const* bins, int w, u_int8_t* data) {
+	if (count < m || m > MOJETTE_MAX_PROJECTIONS)
+		return false;
+
+	int P = cols(len, m, w);
+	int order[MOJETTE_MAX_PROJECTIONS];
+	int dir[MOJETTE_MAX_PROJECTIONS];
+	int off[MOJETTE_MAX_PROJECTIONS];
+	int base[MOJETTE_MAX_PROJECTIONS + 1];
+	int delay[MOJETTE_MAX_PROJECTIONS];
+
+	for (int j = 0; j < m; j++)
+		order[j] = j;
+	for (int j = 1; j < m; j++)
+		for (int i = j; i > 0 && p[order[i]] > p[order[i - 1]]; i--)
+			std::swap(order[i], order[i - 1]);
+
+	base[0] = 0;
+	for (int j = 0; j < m; j++) {
+		dir[j]		= p[order[j]];
+		off[j]		= (dir[j] < 0) ? -dir[j] * (m - 1) : 0;
+		base[j + 1]	= base[j] + MojetteTransform::bins(len, m, dir[j], w);
+		delay[j]	= (j == 0) ? 0 : delay[j - 1] + dir[j];
+	}
+	resid_.resize(base[m] * w);
+	for (int j = 0; j < m; j++)
+		memcpy(&resid_[base[j] * w], bins[order[j]], (base[j + 1] - base[j]) * w);
+	grid_.resize(m * P * w);
+
+	int first	= *std::min_element(delay, delay + m);
+	int last	= *std::max_element(delay, delay + m) + P;
+	for (int t = first; t < last; t++) {
+		for (int l = 0; l < m; l++) {
+			int k = t - delay[l];
+			if (k < 0 || k >= P)
+				continue;
+			u_int8_t* pixel = &grid_[(l * P + k) * w];
+			memcpy(pixel, &resid_[(base[l] + off[l] + dir[l] * l + k) * w], w);
+			for (int j = 0; j < m; j++)
+				if (j != l)
+					mojette_xor_pixel(&resid_[(base[j] + off[j] + dir[j] * l + k) * w],
+						pixel, w);
+		}
+	}
+	memcpy(data, &grid_[0], len);
+	return true;
+}
+
+///
+/// \brief Generates the payload of a packet which does not carry any data.
+///
+/// The bytes only depend on the unique id of the packet, so the receiver
+/// can check the reconstruction.
+///
+/// \param uid unique id of the packet.
+/// \param data the payload.
+/// \param len length of the payload.
+///
+void
+MojetteTransform::fill(int uid, u_int8_t* data, int len) {
+	u_int32_t x = (u_int32_t)uid * 2654435761u + 1;
+	for (int i = 0; i < len; i++) {
+		x = x * 1103515245u + 12345u;
+		data[i] = (u_int8_t)(x >> 16);
+	}
+}
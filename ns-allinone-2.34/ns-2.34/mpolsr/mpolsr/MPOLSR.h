@@ -49,6 +49,9 @@
 #include "MPOLSR_state.h"
 #include "MPOLSR_rtable.h"
 #include "MPOLSR_m_rtable.h"
+#include "MPOLSR_dijkstra.h"
+#include "MPOLSR_scheduler.h"
+#include "mojette.h"
 #include "MPOLSR_repositories.h"
 #include "trace.h"
 #include "classifier-port.h"
@@ -57,6 +60,7 @@
 #include "timer-handler.h"
 #include "random.h"
 #include "vector"
+#include "map"
 #include <dsr-priqueue.h>
 
 /********** Useful macros **********/
@@ -175,17 +179,21 @@
 #define P_TYPE 1
 #define T_TYPE 0
 
-#define MAX_ROUTE 3
-
 #define USE_MAC TRUE
 
+/// Number of slots of the tuple expiry wheel (must be a power of 2).
+#define MPOLSR_WHEEL_SLOTS	64
+/// Time spanned by every slot of the tuple expiry wheel, in seconds.
+#define MPOLSR_WHEEL_TICK		0.5
+
+
 class MPOLSR;			// forward declaration
 
 
 /********** Timers **********/
 
 
-/// Timer for sending an enqued message.
+/// Timer for sending the enqued messages.
 class MPOLSR_MsgTimer : public TimerHandler {
 public:
 	MPOLSR_MsgTimer(MPOLSR* agent) : TimerHandler() {
@@ -226,23 +234,66 @@ protected:
 };
 
 
-/// Timer for removing duplicate tuples: MPOLSR_dup_tuple.
-class MPOLSR_DupTupleTimer : public TimerHandler {
+///
+/// \brief Base class of the timers removing the tuples of the repositories.
+///
+/// They are not scheduled on their own: resched() hands them to the expiry
+/// wheel of their agent, which calls expire() once they are due.
+///
+class MPOLSR_TupleTimer {
+	friend class MPOLSR_ExpiryWheel;
 public:
-	MPOLSR_DupTupleTimer(MPOLSR* agent, MPOLSR_dup_tuple* tuple) : TimerHandler() {
-		agent_ = agent;
-		tuple_ = tuple;
-	}
+	MPOLSR_TupleTimer(MPOLSR* agent) { agent_ = agent; }
+	virtual ~MPOLSR_TupleTimer() {}
+	void		resched(double);
+protected:
+	MPOLSR*	agent_;			///< MPOLSR agent which created the timer.
+	virtual void expire(Event* e) = 0;
+};
+
+
+///
+/// \brief Timer which expires all the tuple timers of an agent.
+///
+/// Tuple timers are kept in a hashed wheel of MPOLSR_WHEEL_SLOTS slots, each
+/// one spanning MPOLSR_WHEEL_TICK seconds, so only this handler is known by
+/// the scheduler. It is scheduled at the time of the earliest tuple timer,
+/// and then expires every due one, in the order the scheduler would have
+/// dispatched them.
+///
+class MPOLSR_ExpiryWheel : public TimerHandler {
+	/// A tuple timer and the time at which it is due.
+	struct entry {
+		double			time_;
+		long			tick_;	///< Number of the slot, counting from time 0.
+		u_int32_t		seq_;	///< Order of scheduling.
+		MPOLSR_TupleTimer*	timer_;
+
+		inline bool operator<(const entry& e) const {
+			return time_ < e.time_ || (time_ == e.time_ && seq_ < e.seq_);
+		}
+	};
+
+	std::vector<entry>	slots_[MPOLSR_WHEEL_SLOTS];
+	std::vector<entry>	due_;		///< Timers being expired.
+	long			cursor_;	///< No timer lies in a slot before this one.
+	u_int32_t		size_;		///< Number of timers in the wheel.
+	u_int32_t		seq_;		///< Order of the next timer to be scheduled.
+	double			next_;		///< Time of the earliest timer, or -1.
+	bool			sweeping_;	///< Whether due timers are being expired.
+
+	void		reschedule();
+public:
+	MPOLSR_ExpiryWheel();
+	void		schedule(MPOLSR_TupleTimer*, double);
+	inline u_int32_t	size() { return size_; }
 protected:
-	MPOLSR*		agent_;	///< MPOLSR agent which created the timer.
-	MPOLSR_dup_tuple*	tuple_;	///< MPOLSR_dup_tuple which must be removed.
-	
 	virtual void expire(Event* e);
 };
 
 
 /// Timer for removing link tuples: MPOLSR_link_tuple.
-class MPOLSR_LinkTupleTimer : public TimerHandler {
+class MPOLSR_LinkTupleTimer : public MPOLSR_TupleTimer, public MPOLSR_pooled<MPOLSR_LinkTupleTimer> {
 	///
 	/// \brief A flag which tells if the timer has expired (at least) once or not.
 	///
@@ -252,13 +303,11 @@ class MPOLSR_LinkTupleTimer : public TimerHandler {
 	///
 	bool			first_time_;
 public:
-	MPOLSR_LinkTupleTimer(MPOLSR* agent, MPOLSR_link_tuple* tuple) : TimerHandler() {
-		agent_		= agent;
+	MPOLSR_LinkTupleTimer(MPOLSR* agent, MPOLSR_link_tuple* tuple) : MPOLSR_TupleTimer(agent) {
 		tuple_		= tuple;
 		first_time_	= true;
 	}
 protected:
-	MPOLSR*			agent_;	///< MPOLSR agent which created the timer.
 	MPOLSR_link_tuple*	tuple_;	///< MPOLSR_link_tuple which must be removed.
 	
 	virtual void expire(Event* e);
@@ -266,14 +315,12 @@ protected:
 
 
 /// Timer for removing nb2hop tuples: MPOLSR_nb2hop_tuple.
-class MPOLSR_Nb2hopTupleTimer : public TimerHandler {
+class MPOLSR_Nb2hopTupleTimer : public MPOLSR_TupleTimer, public MPOLSR_pooled<MPOLSR_Nb2hopTupleTimer> {
 public:
-	MPOLSR_Nb2hopTupleTimer(MPOLSR* agent, MPOLSR_nb2hop_tuple* tuple) : TimerHandler() {
-		agent_ = agent;
+	MPOLSR_Nb2hopTupleTimer(MPOLSR* agent, MPOLSR_nb2hop_tuple* tuple) : MPOLSR_TupleTimer(agent) {
 		tuple_ = tuple;
 	}
 protected:
-	MPOLSR*			agent_;	///< MPOLSR agent which created the timer.
 	MPOLSR_nb2hop_tuple*	tuple_;	///< MPOLSR_nb2hop_tuple which must be removed.
 	
 	virtual void expire(Event* e);
@@ -281,14 +328,12 @@ protected:
 
 
 /// Timer for removing MPR selector tuples: MPOLSR_mprsel_tuple.
-class MPOLSR_MprSelTupleTimer : public TimerHandler {
+class MPOLSR_MprSelTupleTimer : public MPOLSR_TupleTimer, public MPOLSR_pooled<MPOLSR_MprSelTupleTimer> {
 public:
-	MPOLSR_MprSelTupleTimer(MPOLSR* agent, MPOLSR_mprsel_tuple* tuple) : TimerHandler() {
-		agent_ = agent;
+	MPOLSR_MprSelTupleTimer(MPOLSR* agent, MPOLSR_mprsel_tuple* tuple) : MPOLSR_TupleTimer(agent) {
 		tuple_ = tuple;
 	}
 protected:
-	MPOLSR*			agent_;	///< MPOLSR agent which created the timer.
 	MPOLSR_mprsel_tuple*	tuple_;	///< MPOLSR_mprsel_tuple which must be removed.
 	
 	virtual void expire(Event* e);
@@ -296,14 +341,12 @@ protected:
 
 
 /// Timer for removing topology tuples: MPOLSR_topology_tuple.
-class MPOLSR_TopologyTupleTimer : public TimerHandler {
+class MPOLSR_TopologyTupleTimer : public MPOLSR_TupleTimer, public MPOLSR_pooled<MPOLSR_TopologyTupleTimer> {
 public:
-	MPOLSR_TopologyTupleTimer(MPOLSR* agent, MPOLSR_topology_tuple* tuple) : TimerHandler() {
-		agent_ = agent;
+	MPOLSR_TopologyTupleTimer(MPOLSR* agent, MPOLSR_topology_tuple* tuple) : MPOLSR_TupleTimer(agent) {
 		tuple_ = tuple;
 	}
 protected:
-	MPOLSR*			agent_;	///< MPOLSR agent which created the timer.
 	MPOLSR_topology_tuple*	tuple_;	///< MPOLSR_topology_tuple which must be removed.
 	
 	virtual void expire(Event* e);
@@ -311,14 +354,12 @@ protected:
 
 
 /// Timer for removing interface association tuples: MPOLSR_iface_assoc_tuple.
-class MPOLSR_IfaceAssocTupleTimer : public TimerHandler {
+class MPOLSR_IfaceAssocTupleTimer : public MPOLSR_TupleTimer, public MPOLSR_pooled<MPOLSR_IfaceAssocTupleTimer> {
 public:
-	MPOLSR_IfaceAssocTupleTimer(MPOLSR* agent, MPOLSR_iface_assoc_tuple* tuple) : TimerHandler() {
-		agent_ = agent;
+	MPOLSR_IfaceAssocTupleTimer(MPOLSR* agent, MPOLSR_iface_assoc_tuple* tuple) : MPOLSR_TupleTimer(agent) {
 		tuple_ = tuple;
 	}
 protected:
-	MPOLSR*			agent_;	///< MPOLSR agent which created the timer.
 	MPOLSR_iface_assoc_tuple*	tuple_;	///< MPOLSR_iface_assoc_tuple which must be removed.
 	
 	virtual void expire(Event* e);
@@ -340,12 +381,12 @@ class MPOLSR : public Agent {
 	friend class MPOLSR_HelloTimer;
 	friend class MPOLSR_TcTimer;
 	friend class MPOLSR_MidTimer;
-	friend class MPOLSR_DupTupleTimer;
 	friend class MPOLSR_LinkTupleTimer;
 	friend class MPOLSR_Nb2hopTupleTimer;
 	friend class MPOLSR_MprSelTupleTimer;
 	friend class MPOLSR_TopologyTupleTimer;
 	friend class MPOLSR_IfaceAssocTupleTimer;
+	friend class MPOLSR_TupleTimer;
 	friend class MPOLSR_MsgTimer;
 	
 	/// Address of the routing agent.
@@ -368,21 +409,101 @@ class MPOLSR : public Agent {
 	int		willingness_;
 	/// Determines if layer 2 notifications are enabled or not.
 	int		use_mac_;
+	/// Determines if TC messages only advertise the changes of the MPR
+	/// Selector Set (see send_tc()).
+	int		tc_delta_;
+	/// Maximum interval between two full TC messages when tc_delta_ is set.
+	int		tc_full_ival_;
+	/// Determines if the wall clock time spent processing TC messages is
+	/// measured (see tc_stats).
+	int		timing_;
+	/// Number of paths computed towards every destination.
+	int		max_route_;
+	/// Number of Mojette projections every originated packet is split into, 0 disables coding.
+	int		mojette_n_;
+	/// Number of Mojette projections needed to reconstruct a packet.
+	int		mojette_m_;
 	
 	/// Routing table.
 	MPOLSR_rtable		rtable_;
 
 	/// Multipath routing table
 	MPOLSR_m_rtable		m_rtable_;
+	/// Engine used for computing the multipath routing table.
+	MPOLSR_dijkstra		dijkstra_;
 
 	
 	/// Internal state with all needed data structs.
 	MPOLSR_state		state_;
 	/// A list of pending messages which are buffered awaiting for being sent.
 	std::vector<MPOLSR_msg>	msgs_;
+	/// Time at which the buffered messages are sent.
+	double			msgs_deadline_;
+	/// Maximum length (in bytes) of the %MPOLSR packets bundling buffered messages.
+	int			max_pkt_size_;
+	/// Number of %MPOLSR packets sent.
+	u_int32_t		bundle_pkts_;
+	/// Number of %MPOLSR messages sent.
+	u_int32_t		bundle_msgs_;
+	/// Bytes of headers saved by bundling messages rather than sending
+	/// every one in its own packet.
+	u_int32_t		bundle_saved_;
+	/// Most %MPOLSR messages sent in one packet.
+	u_int32_t		bundle_max_;
+	/// Number of MAC layer acknowledgements of packets originated by this node.
+	u_int32_t		mac_acks_;
+	/// Number of MAC layer acknowledgements of packets originated by other nodes.
+	u_int32_t		mac_foreign_acks_;
+	/// Version of the neighborhood the MPR Set was computed for.
+	u_int32_t		mpr_version_;
+	/// Sorted main addresses of the MPR selectors advertised by the last
+	/// TC message, when tc_delta_ is set.
+	std::vector<nsaddr_t>	tc_adv_;
+	/// ANSN of the last TC message, when tc_delta_ is set. It is only
+	/// increased when the advertised set changes.
+	u_int16_t		tc_ansn_;
+	/// Time at which the last full TC message was sent.
+	double			tc_full_time_;
+	/// Whether the next TC message must be a full one.
+	bool			tc_full_req_;
+	/// Time at which a full TC message was last requested to every originator.
+	std::map<nsaddr_t, double>	tc_req_time_;
+	/// Number of full and delta TC messages generated.
+	u_int32_t		tc_full_;
+	u_int32_t		tc_deltas_;
+	/// Number of TC requests generated.
+	u_int32_t		tc_reqs_;
+	/// Number of delta TC messages which could not be applied.
+	u_int32_t		tc_gaps_;
+	/// Bytes of TC messages and TC requests sent, forwarded ones included.
+	u_int32_t		tc_bytes_;
+	/// Number of TC messages processed.
+	u_int32_t		tc_rcvd_;
+	/// Wall clock time spent processing them, in seconds.
+	double			tc_time_;
 
 	///packet count
 	int 		packet_count_;
+
+	/// Topology epoch, incremented whenever the link, neighbor, 2-hop neighbor
+	/// or topology sets change.
+	u_int32_t	topology_epoch_;
+	/// Number of multipath routing table computations which were run.
+	u_int32_t	m_rt_computed_;
+	/// Number of multipath routing table computations which were avoided.
+	u_int32_t	m_rt_avoided_;
+	/// Computes the multipath routing table for every destination at once.
+	bool		m_rt_all_dest_;
+	/// Path diversity mode (see MPOLSR_dijkstra.h).
+	int		path_diversity_;
+	/// Number of paths per destination the multipath routing table was computed with.
+	int		m_rt_max_route_;
+	/// Chooses the path of every originated packet.
+	MPOLSR_path_scheduler*	path_scheduler_;
+	/// Mojette erasure coding layer.
+	Mojette		mojette_;
+	/// Projections of the packet being sent.
+	std::vector<Packet*>	mojette_proj_;
 	
 protected:
 	PortClassifier*	dmux_;		///< For passing packets up to agents.
@@ -391,6 +512,8 @@ protected:
 	MPOLSR_HelloTimer	hello_timer_;	///< Timer for sending HELLO messages.
 	MPOLSR_TcTimer	tc_timer_;	///< Timer for sending TC messages.
 	MPOLSR_MidTimer	mid_timer_;	///< Timer for sending MID messages.
+	MPOLSR_MsgTimer	msg_timer_;	///< Timer for sending the buffered messages.
+	MPOLSR_ExpiryWheel	expiry_wheel_;	///< Timer removing the expired tuples.
 	
 	/// Increments packet sequence number and returns the new value.
 	inline u_int16_t	pkt_seq() {
@@ -410,6 +533,15 @@ protected:
 	inline int&		mid_ival()	{ return mid_ival_; }
 	inline int&		willingness()	{ return willingness_; }
 	inline int&		use_mac()	{ return use_mac_; }
+	/// Returns max_route_, bounded to [1, MPOLSR_MAX_PATHS].
+	inline int		max_route()	{
+		if (max_route_ < 1)
+			return 1;
+		return (max_route_ > MPOLSR_MAX_PATHS) ? MPOLSR_MAX_PATHS : max_route_;
+	}
+
+	/// Signals a change in the sets used for computing the multipath routing table.
+	inline void		topology_changed()	{ topology_epoch_++; }
 	
 	inline linkset_t&	linkset()	{ return state_.linkset(); }
 	inline mprset_t&	mprset()	{ return state_.mprset(); }
@@ -417,7 +549,6 @@ protected:
 	inline nbset_t&		nbset()		{ return state_.nbset(); }
 	inline nb2hopset_t&	nb2hopset()	{ return state_.nb2hopset(); }
 	inline topologyset_t&	topologyset()	{ return state_.topologyset(); }
-	inline dupset_t&	dupset()	{ return state_.dupset(); }
 	inline ifaceassocset_t&	ifaceassocset()	{ return state_.ifaceassocset(); }
 	
 	void		recv_mpolsr(Packet*);
@@ -425,19 +556,31 @@ protected:
 	void		mpr_computation();
 	void		rtable_computation();
 	void 		m_rtable_computation(Packet*);
+	void		m_rtable_update(Packet*);
+	void		m_rtable_fill(nsaddr_t);
+	void		set_source_route(struct hdr_sr*, MPOLSR_m_rt_entry*);
+	int		find_in_source_route(struct hdr_sr*);
+	MPOLSR_m_rt_entry*	select_path(Packet*);
+	MPOLSR_m_rt_entry*	sent_path(Packet*);
+	int		check_m_rtable();
 
 	void		process_hello(MPOLSR_msg&, nsaddr_t, nsaddr_t);
 	void		process_tc(MPOLSR_msg&, nsaddr_t);
+	bool		process_delta_tc(MPOLSR_msg&);
+	void		process_tc_req(MPOLSR_msg&);
 	void		process_mid(MPOLSR_msg&, nsaddr_t);
 	
-	void		forward_default(Packet*, MPOLSR_msg&, MPOLSR_dup_tuple*, nsaddr_t);
+	void		forward_default(Packet*, MPOLSR_msg&, nsaddr_t);
 	void		forward_data(Packet*);
 	void 		m_forward_data(Packet*);
 	void		resend_data(Packet*);
+	void		send_projections(Packet*);
 	
 	void		enque_msg(MPOLSR_msg&, double);
 	void		send_hello();
 	void		send_tc();
+	void		fill_delta_tc(MPOLSR_tc&);
+	void		send_tc_req(nsaddr_t, u_int8_t);
 	void		send_mid();
 	void		send_pkt();
 	
@@ -451,8 +594,6 @@ protected:
 	void		set_mid_timer();
 
 	void		nb_loss(MPOLSR_link_tuple*);
-	void		add_dup_tuple(MPOLSR_dup_tuple*);
-	void		rm_dup_tuple(MPOLSR_dup_tuple*);
 	void		add_link_tuple(MPOLSR_link_tuple*, u_int8_t);
 	void		rm_link_tuple(MPOLSR_link_tuple*);
 	void		updated_link_tuple(MPOLSR_link_tuple*);
@@ -468,10 +609,9 @@ protected:
 	void		rm_ifaceassoc_tuple(MPOLSR_iface_assoc_tuple*);
 	
 	nsaddr_t	get_main_addr(nsaddr_t);
-	int		degree(MPOLSR_nb_tuple*);
 
 	static bool	seq_num_bigger_than(u_int16_t, u_int16_t);
-	float 		tuple_weight(float a);
+	static float	tuple_weight(float a);
 
 	NsObject *ll;		        // our link layer output 
 	CMUPriQueue *ifq;		// output interface queue
@@ -479,9 +619,11 @@ protected:
 
 public:
 	MPOLSR(nsaddr_t);
+	~MPOLSR();
 	int	command(int, const char*const*);
 	void	recv(Packet*, Handler*);
 	void	mac_failed(Packet*);
+	void	mac_succeeded(Packet*);
 	
 	static double		emf_to_seconds(u_int8_t);
 	static u_int8_t		seconds_to_emf(double);
@@ -0,0 +1,156 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+///
+/// \file	MPOLSR_dijkstra.h
+/// \brief	Header file for the multipath Dijkstra engine used by MPOLSR.
+///
+/// The engine builds an adjacency (CSR) view of the topology, neighbor and
+/// 2-hop neighbor sets once, and then runs a binary heap Dijkstra for every
+/// one of the k rounds of the multipath algorithm.
+///
+/// The engine is owned by the agent and all the transient state of a
+/// computation lives in its vectors. They are only cleared between two
+/// computations, so their storage is reused and no memory is allocated once
+/// they have grown to the size of the network.
+///
+
+#ifndef __MPOLSR_dijkstra_h__
+#define __MPOLSR_dijkstra_h__
+
+#include "MPOLSR_repositories.h"
+#include "vector"
+
+/// A path as a list of main addresses, from the source to the destination.
+typedef std::vector<nsaddr_t>		MPOLSR_path;
+/// A list of paths towards the same destination.
+typedef std::vector<MPOLSR_path>	MPOLSR_path_list;
+
+/// Function used to penalize the weight of a link after each round.
+typedef float (*MPOLSR_weight_fn)(float);
+
+/********** Results of a Dijkstra round **********/
+
+/// A path to the destination has been found.
+#define MPOLSR_PATH_FOUND	0
+/// The destination can not be reached, but some nodes are left unvisited.
+#define MPOLSR_PATH_UNREACHABLE	1
+/// Every node has been visited without reaching the destination.
+#define MPOLSR_PATH_EXHAUSTED	2
+
+/********** Path diversity modes **********/
+
+/// Links of every found path are penalized before the next round.
+#define MPOLSR_DIVERSITY_PENALTY	0
+/// Paths do not share any intermediate node.
+#define MPOLSR_DIVERSITY_NODE_DISJOINT	1
+/// Paths do not share any link.
+#define MPOLSR_DIVERSITY_LINK_DISJOINT	2
+
+///
+/// \brief Multipath Dijkstra engine.
+///
+/// Vertices are numbered following the ascending order of their addresses, so
+/// ties between nodes with the same weight are broken exactly as the original
+/// node map based implementation did. Links are treated as bidirectional, but
+/// only the ones whose last address lies on a computed path are penalized.
+///
+/// Strictly node-disjoint or link-disjoint paths can also be computed over the
+/// same graph, as a unit capacity min-cost flow (Suurballe/Bhandari).
+///
+class MPOLSR_dijkstra {
+	/// Address of every vertex, in ascending order.
+	std::vector<nsaddr_t>	addr_;
+	/// Index of the first adjacent link of every vertex (CSR row pointers).
+	std::vector<int>	adj_begin_;
+	/// Adjacent links of every vertex (CSR column indexes).
+	std::vector<int>	adj_;
+	/// Index of the first link whose last address is a given vertex.
+	std::vector<int>	last_begin_;
+	/// Links grouped by their last address.
+	std::vector<int>	last_;
+	/// Last address (as a vertex index) of every link.
+	std::vector<int>	link_last_;
+	/// Destination address (as a vertex index) of every link.
+	std::vector<int>	link_dest_;
+	/// Current weight of every link.
+	std::vector<float>	link_weight_;
+
+	/// Vertex index of the source node.
+	int			source_;
+
+	/// Tentative distance of every vertex.
+	std::vector<float>	dist_;
+	/// Predecessor of every vertex in the shortest path tree.
+	std::vector<int>	pre_;
+	/// Tells which vertices are already settled (P type).
+	std::vector<char>	settled_;
+	/// Binary heap of (distance, vertex) pairs.
+	std::vector<std::pair<float, int> >	heap_;
+	/// Path found by the last round.
+	MPOLSR_path		path_;
+	/// Insertion positions used while building the adjacency lists.
+	std::vector<int>	pos_;
+
+	/// First arc leaving every vertex of the flow network.
+	std::vector<int>	flow_first_;
+	/// Next arc leaving the same vertex.
+	std::vector<int>	arc_next_;
+	/// Head vertex of every arc. Arc e^1 is the reverse of arc e.
+	std::vector<int>	arc_head_;
+	/// Residual capacity of every arc.
+	std::vector<int>	arc_cap_;
+	/// Cost of every arc.
+	std::vector<int>	arc_cost_;
+	/// Distance of every vertex of the flow network.
+	std::vector<int>	flow_dist_;
+	/// Arc through which every vertex of the flow network was reached.
+	std::vector<int>	flow_pre_;
+	/// Undirected links of the graph, without duplicates.
+	std::vector<std::pair<int, int> >	flow_links_;
+	/// FIFO queue of the Bellman-Ford search.
+	std::vector<int>	flow_queue_;
+	/// Tells which vertices are in the queue.
+	std::vector<char>	flow_queued_;
+
+	int		index(nsaddr_t);
+	void		add_link(nsaddr_t, nsaddr_t);
+	void		add_arc(int, int, int, int);
+
+public:
+	MPOLSR_dijkstra();
+
+	void		build(nsaddr_t, topologyset_t&, nbset_t&, nb2hopset_t&);
+	int		shortest_path(nsaddr_t, MPOLSR_path&);
+	void		penalize(MPOLSR_path&, MPOLSR_weight_fn);
+	int		k_paths(nsaddr_t, int, MPOLSR_weight_fn, MPOLSR_path_list&);
+	int		disjoint_paths(nsaddr_t, int, bool, MPOLSR_path_list&);
+	bool		has_link(nsaddr_t, nsaddr_t);
+	bool		disjoint(nsaddr_t, MPOLSR_path_list&, bool);
+
+	/// Returns the number of vertices of the current graph.
+	inline int	num_nodes()	{ return addr_.size(); }
+	/// Returns the number of links of the current graph.
+	inline int	num_links()	{ return link_weight_.size(); }
+	/// Returns the address of a given vertex.
+	inline nsaddr_t	node_addr(int i)	{ return addr_[i]; }
+
+	static int	reference_k_paths(nsaddr_t, nsaddr_t, int, topologyset_t&,
+				nbset_t&, nb2hopset_t&, MPOLSR_weight_fn, MPOLSR_path_list&);
+};
+
+#endif
@@ -0,0 +1,234 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+///
+/// \file	MPOLSR_hash.h
+/// \brief	Open addressing hash tables used to index the MPOLSR repositories.
+///
+/// Keys are hashed with MPOLSR_hash_key(), which is defined for addresses and
+/// pairs of them. Collisions are resolved by linear probing, and entries are
+/// removed by shifting back the following ones, so that no tombstone is left.
+///
+/// The repositories stay vectors, whose order is the one the RFC 3626
+/// algorithms iterate in, and MPOLSR_index finds their tuples by key.
+///
+
+#ifndef __MPOLSR_hash_h__
+#define __MPOLSR_hash_h__
+
+#include <vector>
+#include <utility>
+#include "config.h"
+
+/// Initial number of slots of a table (must be a power of 2).
+#define MPOLSR_HASH_MIN_SLOTS	16
+
+///
+/// \brief Hashes an address (Fibonacci hashing, the table keeps the high bits).
+///
+inline u_int32_t
+MPOLSR_hash_key(nsaddr_t addr) {
+	return (u_int32_t)addr * 2654435761u;
+}
+
+///
+/// \brief Hashes a pair of keys, e.g. an address and a sequence number.
+///
+template <class A, class B>
+inline u_int32_t
+MPOLSR_hash_key(const std::pair<A, B>& key) {
+	return ((u_int32_t)key.first * 0x85ebca6bu + (u_int32_t)key.second) * 2654435761u;
+}
+
+///
+/// \brief Hash table from K to V.
+///
+template <class K, class V>
+class MPOLSR_hash {
+	struct slot {
+		K	key_;
+		V	value_;
+		bool	used_;
+	};
+	std::vector<slot>	slots_;
+	/// Number of entries.
+	u_int32_t		size_;
+	/// log2 of the number of slots.
+	int			bits_;
+
+	inline u_int32_t home(const K& key) const {
+		return MPOLSR_hash_key(key) >> (32 - bits_);
+	}
+	inline u_int32_t mask() const { return slots_.size() - 1; }
+
+	void grow() {
+		std::vector<slot> old;
+		old.swap(slots_);
+		bits_++;
+		slots_.assign(1u << bits_, slot());
+		for (u_int32_t i = 0; i < slots_.size(); i++)
+			slots_[i].used_ = false;
+		size_ = 0;
+		for (u_int32_t i = 0; i < old.size(); i++)
+			if (old[i].used_)
+				(*this)[old[i].key_] = old[i].value_;
+	}
+
+public:
+	MPOLSR_hash() : size_(0), bits_(0) {
+		while ((1u << bits_) < MPOLSR_HASH_MIN_SLOTS)
+			bits_++;
+		slots_.assign(1u << bits_, slot());
+		for (u_int32_t i = 0; i < slots_.size(); i++)
+			slots_[i].used_ = false;
+	}
+
+	inline u_int32_t size() const { return size_; }
+
+	///
+	/// \brief Looks a key up.
+	/// \return the value of the key, or NULL if it is not in the table.
+	///
+	V* find(const K& key) {
+		for (u_int32_t i = home(key); slots_[i].used_; i = (i + 1) & mask())
+			if (slots_[i].key_ == key)
+				return &slots_[i].value_;
+		return NULL;
+	}
+
+	///
+	/// \brief Gives the value of a key, which is inserted with a
+	///	default value if it is not in the table.
+	///
+	V& operator[](const K& key) {
+		V* v = find(key);
+		if (v != NULL)
+			return *v;
+		// Keeps the load factor under 1/2
+		if (2 * (size_ + 1) > slots_.size())
+			grow();
+		u_int32_t i = home(key);
+		while (slots_[i].used_)
+			i = (i + 1) & mask();
+		slots_[i].key_		= key;
+		slots_[i].value_	= V();
+		slots_[i].used_		= true;
+		size_++;
+		return slots_[i].value_;
+	}
+
+	///
+	/// \brief Removes a key from the table, if it is there.
+	///
+	void erase(const K& key) {
+		u_int32_t i = home(key);
+		while (slots_[i].used_ && !(slots_[i].key_ == key))
+			i = (i + 1) & mask();
+		if (!slots_[i].used_)
+			return;
+		slots_[i].used_ = false;
+		size_--;
+
+		// Moves back the entries which were displaced by the removed one
+		for (u_int32_t j = (i + 1) & mask(); slots_[j].used_; j = (j + 1) & mask()) {
+			u_int32_t h = home(slots_[j].key_);
+			// The entry stays if its home lies cyclically in (i, j]
+			if ((i < j) ? (i < h && h <= j) : (i < h || h <= j))
+				continue;
+			slots_[i]		= slots_[j];
+			slots_[j].used_	= false;
+			i = j;
+		}
+	}
+
+	void clear() {
+		for (u_int32_t i = 0; i < slots_.size(); i++)
+			slots_[i].used_ = false;
+		size_ = 0;
+	}
+};
+
+///
+/// \brief Index of a repository by a key of its tuples.
+///
+/// For every key, it keeps the first tuple of the repository with that key
+/// and how many tuples share it, so that lookups return the same tuple as a
+/// linear search of the repository would.
+///
+template <class K, class T>
+class MPOLSR_index {
+public:
+	/// Gives the key of a tuple.
+	typedef K	(*key_fn_t)(T*);
+
+private:
+	struct bucket {
+		T*	first_;
+		int	count_;
+	};
+	MPOLSR_hash<K, bucket>	hash_;
+	key_fn_t		key_;
+
+public:
+	MPOLSR_index(key_fn_t key) : key_(key) {}
+
+	/// Returns the first tuple with a key, or NULL if there is none.
+	inline T* find(const K& key) {
+		bucket* b = hash_.find(key);
+		return (b != NULL) ? b->first_ : NULL;
+	}
+
+	/// Returns the number of tuples with a key.
+	inline int count(const K& key) {
+		bucket* b = hash_.find(key);
+		return (b != NULL) ? b->count_ : 0;
+	}
+
+	/// Indexes a tuple which has just been appended to the repository.
+	void insert(T* tuple) {
+		bucket& b = hash_[key_(tuple)];
+		if (b.count_++ == 0)
+			b.first_ = tuple;
+	}
+
+	///
+	/// \brief Unindexes a tuple which has just been removed from the repository.
+	/// \param tuple the removed tuple.
+	/// \param set the repository, where the next tuple with the same key is
+	///	looked for if the removed one was the first.
+	///
+	void erase(T* tuple, std::vector<T*>& set) {
+		K key		= key_(tuple);
+		bucket* b	= hash_.find(key);
+		if (b == NULL)
+			return;
+		if (--b->count_ == 0) {
+			hash_.erase(key);
+			return;
+		}
+		if (b->first_ != tuple)
+			return;
+		for (typename std::vector<T*>::iterator it = set.begin(); it != set.end(); it++) {
+			if (key_(*it) == key) {
+				b->first_ = *it;
+				break;
+			}
+		}
+	}
+};
+
+#endif
@@ -17,18 +17,30 @@
 #define __MPOLSR_m_rtable_h__
 //#include <mpolsr/MPOLSR.h>
 #include "MPOLSR_repositories.h"
+#include "MPOLSR_hash.h"
 #include <trace.h>
-#include <map>
+#include <vector>
 #include "cmu-trace.h"
 
 ///
-///\brief defines m_rtable_t as a map of MPOLSR_m_rt_entry, whose key is the destination address.
-///The routing table is thus defined as pairs: [dest address, entry]. 
-//typedef std::map<nsaddr_t, MPOLSR_m_rt_entry*> m_rtable_t;
-
+///\brief The paths towards a destination, stored inline.
+///
+typedef struct MPOLSR_m_rt_dest{
+	/// The paths, only the first count_ ones are valid.
+	MPOLSR_m_rt_entry	paths_[MPOLSR_MAX_PATHS];
+	/// Number of paths towards the destination.
+	int			count_;
+	/// Topology epoch at which the paths were computed, 0 if never computed.
+	u_int32_t		epoch_;
+	/// Address of the destination.
+	nsaddr_t		addr_;
+}MPOLSR_m_rt_dest;
 
-//typedef std::vector<MPOLSR_m_rt_entry*> 	m_rtable_t;
-typedef std::multimap<nsaddr_t,MPOLSR_m_rt_entry*> m_rtable_t;
+///
+///\brief defines m_rtable_t as a table of MPOLSR_m_rt_dest, one per destination
+///a path was ever computed to.
+///
+typedef std::vector<MPOLSR_m_rt_dest>	m_rtable_t;
 
 
 ///
@@ -36,26 +48,46 @@ typedef std::multimap<nsaddr_t,MPOLSR_m_rt_entry*> m_rtable_t;
 ///
 class MPOLSR_m_rtable{
 	m_rtable_t m_rt_;
-	
-	//the flag, to see if the table need to be recomputed.
-	bool out_of_date[MAX_NODE];
+	/// Position in m_rt_ of every destination, addresses being too sparse
+	/// (e.g. hierarchical ones) to index m_rt_ directly.
+	MPOLSR_hash<nsaddr_t, u_int32_t>	index_;
+	/// Paths of the last destination whose entries were deleted.
+	MPOLSR_m_rt_dest	old_;
+
+	MPOLSR_m_rt_dest*	dest(nsaddr_t dest);
+
+	/// Returns the slot of a destination, or NULL if it has none.
+	inline MPOLSR_m_rt_dest*	find(nsaddr_t dest) {
+		u_int32_t* i = index_.find(dest);
+		return (i != NULL) ? &m_rt_[*i] : NULL;
+	}
 
 public:
 	MPOLSR_m_rtable();
 	~MPOLSR_m_rtable();
 
-	m_rtable_t* m_rt();
-	void 	set_flag(int id,bool flag);
-	void 	set_flag(bool flag);
-	bool	get_flag(int id);
+	void 	set_epoch(nsaddr_t dest, u_int32_t epoch);
+	bool	up_to_date(nsaddr_t dest, u_int32_t epoch);
+	void	invalidate();
 	void 	clear();
-	void 	rm_entry(nsaddr_t des);
-	void	add_entry(MPOLSR_m_rt_entry* entry,nsaddr_t addr);
-	m_rtable_t::iterator 	lookup(nsaddr_t dest);
-	
-	u_int32_t	size();
-	void 	print(Trace*);
+	void 	rm_entry(nsaddr_t dest);
+	MPOLSR_m_rt_entry*	add_entry(nsaddr_t dest);
+	MPOLSR_m_rt_dest*	lookup(nsaddr_t dest);
+	void	inherit(MPOLSR_m_rt_entry* entry);
 
+	/// Returns the number of destination slots of the table.
+	inline u_int32_t	size()	{ return m_rt_.size(); }
+	/// Returns the i-th destination slot of the table.
+	inline MPOLSR_m_rt_dest*	slot(u_int32_t i)	{ return &m_rt_[i]; }
+	/// Returns the number of paths towards a destination.
+	inline int		count(nsaddr_t dest) {
+		MPOLSR_m_rt_dest* d = find(dest);
+		return (d != NULL) ? d->count_ : 0;
+	}
+	/// Returns the i-th path towards a destination.
+	inline MPOLSR_m_rt_entry*	path(nsaddr_t dest, int i) {
+		return &find(dest)->paths_[i];
+	}
 };
 
 #endif
@@ -55,8 +55,9 @@ protected:
 	static void	print_mprset(Trace*, mprset_t&);
 	static void	print_mprselset(Trace*, mprselset_t&);
 	static void	print_topologyset(Trace*, topologyset_t&);
+	static void	print_m_rtable(Trace*, MPOLSR_m_rtable&);
 	
-	static void	print_mpolsr_pkt(FILE*, MPOLSR_pkt*);
+	static void	print_mpolsr_pkt(FILE*, Packet*);
 	static void	print_mpolsr_msg(FILE*, MPOLSR_msg&);
 	static void	print_mpolsr_hello(FILE*, MPOLSR_hello&);
 	static void	print_mpolsr_tc(FILE*, MPOLSR_tc&);
@@ -40,13 +40,14 @@
 #include "set"
 #include "vector"
 #include "config.h"
+#include "MPOLSR_pool.h"
 #include "hdr_sr.h"
 
 #define MAX_WEIGHT	65535	//max weight for the node
 
 
 /// An %MPOLSR's routing table entry.
-typedef struct MPOLSR_rt_entry {
+typedef struct MPOLSR_rt_entry : public MPOLSR_pooled<MPOLSR_rt_entry> {
 	nsaddr_t	dest_addr_;	///< Address of the destination node.
 	nsaddr_t	next_addr_;	///< Address of the next hop.
 	nsaddr_t	iface_addr_;	///< Address of the local interface.
@@ -58,10 +59,31 @@ typedef struct MPOLSR_rt_entry {
 	inline u_int32_t&	dist()		{ return dist_; }
 } MPOLSR_rt_entry;
 
-/// An routing table entry for multipath routing
-//typedef std::vector<nsaddr_t>	MPOLSR_m_rt_entry;
+/// Maximum number of paths the multipath routing table keeps per destination.
+#define MPOLSR_MAX_PATHS	8
+
+/// An routing table entry for multipath routing, i.e. one path towards a destination.
 typedef struct MPOLSR_m_rt_entry{
-	sr_addr	addr_[MAX_SR_LEN];
+	/// Addresses of the path, from the source to the destination.
+	nsaddr_t	addr_[MAX_SR_LEN];
+	/// Number of addresses of the path (source and destination included).
+	int		len_;
+	/// Cost of the path.
+	float		cost_;
+	/// Last time the path was used for sending a packet.
+	double		last_used_;
+	/// Path diversity mode used for computing the path.
+	int		diversity_;
+	/// Weighted round robin credit of the path.
+	double		credit_;
+	/// Packets sent through the path and waiting for a MAC layer feedback.
+	int		outstanding_;
+	/// Smoothed first hop delay of the path, 0 if not measured yet.
+	double		delay_;
+	/// Last time a MAC layer feedback was received for the path.
+	double		last_feedback_;
+
+	inline int	hops()	{ return len_ - 1; }
 }MPOLSR_m_rt_entry;
 
 /// a node struct for Dijkstra
@@ -73,7 +95,7 @@ typedef struct Dijkstra_node{
 } Dijkstra_node;
 
 /// An Interface Association Tuple.
-typedef struct MPOLSR_iface_assoc_tuple {
+typedef struct MPOLSR_iface_assoc_tuple : public MPOLSR_pooled<MPOLSR_iface_assoc_tuple> {
 	/// Interface address of a node.
 	nsaddr_t	iface_addr_;
 	/// Main address of the node.
@@ -87,7 +109,7 @@ typedef struct MPOLSR_iface_assoc_tuple {
 } MPOLSR_iface_assoc_tuple;
 
 /// A Link Tuple.
-typedef struct MPOLSR_link_tuple {
+typedef struct MPOLSR_link_tuple : public MPOLSR_pooled<MPOLSR_link_tuple> {
 	/// Interface address of the local node.
 	nsaddr_t	local_iface_addr_;
 	/// Interface address of the neighbor node.
@@ -110,7 +132,7 @@ typedef struct MPOLSR_link_tuple {
 } MPOLSR_link_tuple;
 
 /// A Neighbor Tuple.
-typedef struct MPOLSR_nb_tuple {
+typedef struct MPOLSR_nb_tuple : public MPOLSR_pooled<MPOLSR_nb_tuple> {
 	/// Main address of a neighbor node.
 	nsaddr_t nb_main_addr_;
 	/// Neighbor Type and Link Type at the four less significative digits.
@@ -124,7 +146,7 @@ typedef struct MPOLSR_nb_tuple {
 } MPOLSR_nb_tuple;
 
 /// A 2-hop Tuple.
-typedef struct MPOLSR_nb2hop_tuple {
+typedef struct MPOLSR_nb2hop_tuple : public MPOLSR_pooled<MPOLSR_nb2hop_tuple> {
 	/// Main address of a neighbor.
 	nsaddr_t	nb_main_addr_;
 	/// Main address of a 2-hop neighbor with a symmetric link to nb_main_addr.
@@ -138,7 +160,7 @@ typedef struct MPOLSR_nb2hop_tuple {
 } MPOLSR_nb2hop_tuple;
 
 /// An MPR-Selector Tuple.
-typedef struct MPOLSR_mprsel_tuple {
+typedef struct MPOLSR_mprsel_tuple : public MPOLSR_pooled<MPOLSR_mprsel_tuple> {
 	/// Main address of a node which have selected this node as a MPR.
 	nsaddr_t	main_addr_;
 	/// Time at which this tuple expires and must be removed.
@@ -148,31 +170,35 @@ typedef struct MPOLSR_mprsel_tuple {
 	inline double&		time()		{ return time_; }
 } MPOLSR_mprsel_tuple;
 
-/// The type "list of interface addresses"
-typedef std::vector<nsaddr_t> addr_list_t;
+/// Number of sequence numbers of an originator the Duplicate Set keeps track of.
+#define MPOLSR_DUP_WINDOW	64
 
-/// A Duplicate Tuple
-typedef struct MPOLSR_dup_tuple {
-	/// Originator address of the message.
-	nsaddr_t	addr_;
-	/// Message sequence number.
-	u_int16_t	seq_num_;
-	/// Indicates whether the message has been retransmitted or not.
-	bool		retransmitted_;
-	/// List of interfaces which the message has been received on.
-	addr_list_t	iface_list_;
-	/// Time at which this tuple expires and must be removed.
+///
+/// \brief Duplicate Set entries of an originator.
+///
+/// Rather than a tuple per message, the messages of an originator which have
+/// been considered for forwarding are recorded in a bitmap of the
+/// MPOLSR_DUP_WINDOW sequence numbers up to the highest one, so that duplicates
+/// are found without allocating memory nor scheduling timers. Since a node
+/// has a single interface, the only information a duplicate tuple held was
+/// whether it existed.
+///
+typedef struct MPOLSR_dup_window {
+	/// Highest sequence number recorded.
+	u_int16_t	top_;
+	/// Bit i is set if sequence number top_ - i has been recorded.
+	u_int64_t	bits_;
+	/// Time at which the entries expire and must be forgotten, which is
+	/// given by the last one recorded.
 	double		time_;
 	
-	inline nsaddr_t&	addr()		{ return addr_; }
-	inline u_int16_t&	seq_num()	{ return seq_num_; }
-	inline bool&		retransmitted()	{ return retransmitted_; }
-	inline addr_list_t&	iface_list()	{ return iface_list_; }
+	inline u_int16_t&	top()		{ return top_; }
+	inline u_int64_t&	bits()		{ return bits_; }
 	inline double&		time()		{ return time_; }
-} MPOLSR_dup_tuple;
+} MPOLSR_dup_window;
 
 /// A Topology Tuple
-typedef struct MPOLSR_topology_tuple {
+typedef struct MPOLSR_topology_tuple : public MPOLSR_pooled<MPOLSR_topology_tuple> {
 	/// Main address of the destination.
 	nsaddr_t	dest_addr_;
 	/// Main address of a node which is a neighbor of the destination.
@@ -202,7 +228,6 @@ typedef std::vector<MPOLSR_link_tuple*>		linkset_t;	///< Link Set type.
 typedef std::vector<MPOLSR_nb_tuple*>		nbset_t;	///< Neighbor Set type.
 typedef std::vector<MPOLSR_nb2hop_tuple*>		nb2hopset_t;	///< 2-hop Neighbor Set type.
 typedef std::vector<MPOLSR_topology_tuple*>	topologyset_t;	///< Topology Set type.
-typedef std::vector<MPOLSR_dup_tuple*>		dupset_t;	///< Duplicate Set type.
 typedef std::vector<MPOLSR_iface_assoc_tuple*>	ifaceassocset_t;///< Interface Association Set type.
 
 #endif
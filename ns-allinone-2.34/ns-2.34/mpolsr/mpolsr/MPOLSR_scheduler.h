@@ -0,0 +1,119 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+///
+/// \file	MPOLSR_scheduler.h
+/// \brief	Header file for the path schedulers used by MPOLSR.
+///
+/// A path scheduler chooses, for every packet originated by the agent, which
+/// one of the paths of the multipath routing table is copied into its source
+/// route. Schedulers which need it are told about the outcome of the first
+/// hop transmission of every packet by the MAC layer callbacks.
+///
+
+#ifndef __MPOLSR_scheduler_h__
+#define __MPOLSR_scheduler_h__
+
+#include "MPOLSR_m_rtable.h"
+
+/// Delay sample (in seconds) accounted for a transmission failure.
+#define MPOLSR_SCHED_FAILURE_DELAY	1.0
+/// Initial delay estimate (in seconds) per hop of a path.
+#define MPOLSR_SCHED_HOP_DELAY		0.01
+/// Weight of a new sample in the smoothed delay of a path.
+#define MPOLSR_SCHED_DELAY_GAIN		0.125
+/// Time (in seconds) after which packets with no MAC feedback are no longer outstanding.
+#define MPOLSR_SCHED_OUTSTANDING_TIMEOUT	1.0
+/// Number of packets whose sending time is remembered (must be a power of 2).
+#define MPOLSR_SCHED_SENT_SLOTS		256
+
+///
+/// \brief Base class of the path schedulers.
+///
+class MPOLSR_path_scheduler {
+	/// Unique id of the last packet sent at every slot, -1 if none.
+	int		sent_uid_[MPOLSR_SCHED_SENT_SLOTS];
+	/// Time at which the packet of every slot was sent.
+	double		sent_time_[MPOLSR_SCHED_SENT_SLOTS];
+
+public:
+	MPOLSR_path_scheduler();
+	virtual ~MPOLSR_path_scheduler() {}
+
+	/// Returns the index of the path to be used among the ones of a destination.
+	virtual int	select(MPOLSR_m_rt_dest&) = 0;
+	/// Name of the policy, as given to the path_scheduler command.
+	virtual const char*	name() = 0;
+	/// Tells if the scheduler needs the MAC layer feedback.
+	virtual bool	feedback() { return false; }
+
+	virtual void	sent(MPOLSR_m_rt_entry&, int);
+	virtual void	acked(MPOLSR_m_rt_entry&, int);
+	virtual void	failed(MPOLSR_m_rt_entry&, int);
+
+	static MPOLSR_path_scheduler*	create(const char*);
+
+protected:
+	int		weighted_select(MPOLSR_m_rt_dest&, double*);
+};
+
+///
+/// \brief Uses the paths in turn, with a counter shared by all the destinations.
+///
+/// This is the original behaviour of MPOLSR.
+///
+class MPOLSR_rr_scheduler : public MPOLSR_path_scheduler {
+	/// Number of packets scheduled so far.
+	u_int32_t	count_;
+public:
+	MPOLSR_rr_scheduler() : count_(0) {}
+	int		select(MPOLSR_m_rt_dest&);
+	const char*	name() { return "round_robin"; }
+};
+
+///
+/// \brief Weighted round robin per destination, the weight of a path being the
+/// inverse of its cost.
+///
+class MPOLSR_wrr_scheduler : public MPOLSR_path_scheduler {
+public:
+	int		select(MPOLSR_m_rt_dest&);
+	const char*	name() { return "wrr"; }
+};
+
+///
+/// \brief Uses the path with the fewest packets waiting for a MAC layer feedback.
+///
+class MPOLSR_lop_scheduler : public MPOLSR_path_scheduler {
+public:
+	int		select(MPOLSR_m_rt_dest&);
+	const char*	name() { return "least_outstanding"; }
+	bool		feedback() { return true; }
+};
+
+///
+/// \brief Weighted round robin per destination, the weight of a path being the
+/// inverse of its smoothed first hop delay, as measured by the MAC layer feedback.
+///
+class MPOLSR_delay_scheduler : public MPOLSR_path_scheduler {
+public:
+	int		select(MPOLSR_m_rt_dest&);
+	const char*	name() { return "delay"; }
+	bool		feedback() { return true; }
+};
+
+#endif
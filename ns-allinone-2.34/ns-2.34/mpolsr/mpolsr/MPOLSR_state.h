@@ -38,6 +38,7 @@
 #define __MPOLSR_state_h__
 
 #include "MPOLSR_repositories.h"
+#include "MPOLSR_hash.h"
 
 /// This class encapsulates all data structures needed for maintaining internal state of an MPOLSR node.
 class MPOLSR_state {
@@ -49,17 +50,43 @@ class MPOLSR_state {
 	topologyset_t	topologyset_;	///< Topology Set (RFC 3626, section 4.4).
 	mprset_t	mprset_;	///< MPR Set (RFC 3626, section 4.3.3).
 	mprselset_t	mprselset_;	///< MPR Selector Set (RFC 3626, section 4.3.4).
-	dupset_t	dupset_;	///< Duplicate Set (RFC 3626, section 3.4).
 	ifaceassocset_t	ifaceassocset_;	///< Interface Association Set (RFC 3626, section 4.1).
+
+	/// Tuples of the repositories by key, see MPOLSR_hash.h.
+	MPOLSR_index<nsaddr_t, MPOLSR_mprsel_tuple>	mprsel_index_;	///< By main address.
+	MPOLSR_index<nsaddr_t, MPOLSR_nb_tuple>		nb_index_;	///< By main address.
+	/// By neighbor and 2-hop neighbor main addresses.
+	MPOLSR_index<std::pair<nsaddr_t, nsaddr_t>, MPOLSR_nb2hop_tuple>	nb2hop_index_;
+	MPOLSR_index<nsaddr_t, MPOLSR_link_tuple>		link_index_;	///< By neighbor interface address.
+	/// By destination and last hop addresses.
+	MPOLSR_index<std::pair<nsaddr_t, nsaddr_t>, MPOLSR_topology_tuple>	topology_index_;
+	/// Topology tuples of every last hop address, in repository order.
+	MPOLSR_hash<nsaddr_t, topologyset_t>	topology_last_index_;
+	MPOLSR_index<nsaddr_t, MPOLSR_iface_assoc_tuple>	ifaceassoc_index_;	///< By interface address.
+	/// Duplicate Set (RFC 3626, section 3.4), by originator address.
+	MPOLSR_hash<nsaddr_t, MPOLSR_dup_window>	dup_windows_;
+
+	/// Number of changes of the Neighbor Set and the 2-hop Neighbor Set.
+	u_int32_t	nbhood_version_;
+
+	void			unindex_topology_tuple(MPOLSR_topology_tuple*);
+
+public:
+	MPOLSR_state();
 	
 protected:
+	/// Gives the number of changes of the neighborhood, which tells whether
+	/// it has changed since a given time.
+	inline	u_int32_t		nbhood_version()	{ return nbhood_version_; }
+	/// Must be called when a neighbor tuple is modified.
+	inline	void			nbhood_changed()	{ nbhood_version_++; }
+
 	inline	linkset_t&		linkset()	{ return linkset_; }
 	inline	mprset_t&		mprset()	{ return mprset_; }
 	inline	mprselset_t&		mprselset()	{ return mprselset_; }
 	inline	nbset_t&		nbset()		{ return nbset_; }
 	inline	nb2hopset_t&		nb2hopset()	{ return nb2hopset_; }
 	inline	topologyset_t&		topologyset()	{ return topologyset_; }
-	inline	dupset_t&		dupset()	{ return dupset_; }
 	inline	ifaceassocset_t&	ifaceassocset()	{ return ifaceassocset_; }
 	
 	MPOLSR_mprsel_tuple*	find_mprsel_tuple(nsaddr_t);
@@ -73,6 +100,8 @@ protected:
 	void			erase_nb_tuple(MPOLSR_nb_tuple*);
 	void			erase_nb_tuple(nsaddr_t);
 	void			insert_nb_tuple(MPOLSR_nb_tuple*);
+	/// Tells in constant time if there is a neighbor tuple for a main address.
+	inline bool		is_nb(nsaddr_t main_addr) { return nb_index_.count(main_addr) > 0; }
 	
 	MPOLSR_nb2hop_tuple*	find_nb2hop_tuple(nsaddr_t, nsaddr_t);
 	void			erase_nb2hop_tuple(MPOLSR_nb2hop_tuple*);
@@ -84,9 +113,8 @@ protected:
 	void			insert_mpr_addr(nsaddr_t);
 	void			clear_mprset();
 	
-	MPOLSR_dup_tuple*		find_dup_tuple(nsaddr_t, u_int16_t);
-	void			erase_dup_tuple(MPOLSR_dup_tuple*);
-	void			insert_dup_tuple(MPOLSR_dup_tuple*);
+	bool			find_dup(nsaddr_t, u_int16_t, double);
+	void			insert_dup(nsaddr_t, u_int16_t, double, double);
 	
 	MPOLSR_link_tuple*	find_link_tuple(nsaddr_t);
 	MPOLSR_link_tuple*	find_sym_link_tuple(nsaddr_t, double);
@@ -95,6 +123,7 @@ protected:
 
 	MPOLSR_topology_tuple*	find_topology_tuple(nsaddr_t, nsaddr_t);
 	MPOLSR_topology_tuple*	find_newer_topology_tuple(nsaddr_t, u_int16_t);
+	topologyset_t*		find_topology_tuples(nsaddr_t);
 	void			erase_topology_tuple(MPOLSR_topology_tuple*);
 	void			erase_older_topology_tuples(nsaddr_t, u_int16_t);
 	void			insert_topology_tuple(MPOLSR_topology_tuple*);
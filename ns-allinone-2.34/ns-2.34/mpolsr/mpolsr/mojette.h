@@ -1,6 +1,6 @@
 /*              Copyright (C) 2010
 	*             Multipath Extension by Jiazi Yi,                            *
- 	*                   2007   Ecole Polytech of Nantes, France               * 
+ 	*                   2007   Ecole Polytech of Nantes, France               *
  	*                   jiazi.yi@univ-nantes.fr				   *
  	****************************************************************************
  	*    	This program is distributed in the hope that it will be useful,				*
@@ -8,24 +8,158 @@
 	*    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 					*
  	**************************************************************************
 */
+
+///
+/// \file	mojette.h
+/// \brief	Header file for the Mojette transform erasure coding layer of MPOLSR.
+///
+/// The payload of a packet is laid out as a grid of m rows of P pixels of
+/// MOJETTE_PIXEL_LEN bytes. Each projection (p_i, 1) sums (XOR) the pixels
+/// lying on the lines of direction (p_i, 1) into P + (m - 1) |p_i| bins. By the Katz criterion, any m of the
+/// n projections are enough to reconstruct the grid, so the packet survives
+/// the loss of n - m projections, i.e. of the paths they were sent through.
+///
+
 #ifndef __mojette_h__
 #define __mojette_h__
 
 #include <vector>
 #include <map>
+#include <deque>
 
 #include <packet.h>
 #include <timer-handler.h>
 //#include "dsr/hdr_sr.h"
+#include "mojette_kernels.h"
 
+/// Time (in seconds) a partially received packet is kept waiting for projections.
 #define MOJETTE_PACKET_TIMEOUT 5
+/// Length (in bytes) of a pixel of the grid, and thus of a bin.
+#define MOJETTE_PIXEL_LEN	8
+/// Length (in bytes) of the Mojette header carried by every projection.
+#define MOJETTE_HDR_LEN		12
 
+#define HDR_MOJETTE(p)		hdr_mojette::access(p)
 
+///
+/// \brief Header of a projection packet.
+///
+struct hdr_mojette {
+	/// Address of the node which encoded the packet.
+	nsaddr_t	src_;
+	/// Unique id of the original packet.
+	int		uid_;
+	/// Size of the original packet.
+	int		size_;
+	/// Length of the encoded payload.
+	int		len_;
+	/// Destination port of the original packet.
+	int		dport_;
+	/// Index of the projection, it gives its direction (see MojetteTransform::direction()).
+	u_int8_t	index_;
+	/// Number of projections the packet was split into, 0 if it is not a projection.
+	u_int8_t	n_;
+	/// Number of projections needed to reconstruct the packet.
+	u_int8_t	m_;
+	/// Tells that the payload was generated by MojetteTransform::fill() instead of
+	/// being the data of the original packet.
+	u_int8_t	synth_;
 
+	static int	offset_;
+	inline static int& offset() { return offset_; }
+	inline static hdr_mojette* access(const Packet* p) {
+		return (hdr_mojette*)p->access(offset_);
+	}
 
+	inline nsaddr_t&	src()	{ return src_; }
+	inline int&		uid()	{ return uid_; }
+	inline int&		size()	{ return size_; }
+	inline int&		len()	{ return len_; }
+	inline int&		dport()	{ return dport_; }
+	inline u_int8_t&	index()	{ return index_; }
+	inline u_int8_t&	n()	{ return n_; }
+	inline u_int8_t&	m()	{ return m_; }
+	inline u_int8_t&	synth()	{ return synth_; }
+};
 
+class Mojette;
 
+///
+/// \brief Timer which discards the packets which could not be reconstructed in time.
+///
+class MojetteTimer : public TimerHandler {
+public:
+	MojetteTimer(Mojette* mojette) : TimerHandler() {
+		mojette_	= mojette;
+	}
+protected:
+	Mojette*	mojette_;
+	virtual void	expire(Event* e);
+};
 
-#endif
+///
+/// \brief Projections received so far for a given packet.
+///
+typedef struct MojetteBuffer {
+	/// Time the first projection was received at.
+	double		first_;
+	/// Tells if the packet has already been reconstructed.
+	bool		decoded_;
+	/// Number of different projections received.
+	int		count_;
+	/// Received projections, by index.
+	Packet*		proj_[MOJETTE_MAX_PROJECTIONS];
+} MojetteBuffer;
+
+/// Identifies a packet by the address of its encoder and its original unique id.
+typedef std::pair<nsaddr_t, int>		mojette_key_t;
+
+///
+/// \brief Mojette erasure coding layer of an agent.
+///
+/// It splits originated packets into projections and reassembles the
+/// packets destined to the agent, keeping the related statistics.
+///
+class Mojette {
+	friend class MojetteTimer;
+
+	/// Packets being reassembled, or recently reassembled.
+	std::map<mojette_key_t, MojetteBuffer>	buffers_;
+	/// Expiration time of the buffers, in creation order.
+	std::deque<std::pair<double, mojette_key_t> >	expiry_;
+	/// Timer for discarding the expired buffers.
+	MojetteTimer	timer_;
 
+	/// Transform, with its scratch buffers.
+	MojetteTransform	transform_;
+	/// Payload bytes used while encoding or decoding.
+	std::vector<u_int8_t>	data_;
 
+	void		expire();
+
+public:
+	/// Packets encoded.
+	u_int32_t	encoded_;
+	/// Packets reconstructed.
+	u_int32_t	decoded_;
+	/// Packets for which not enough projections arrived in time.
+	u_int32_t	expired_;
+	/// Packets whose reconstruction failed or was wrong.
+	u_int32_t	failed_;
+	/// Projections received after their packet had been reconstructed.
+	u_int32_t	redundant_;
+	/// Sum of the times elapsed between the first projection and the reconstruction.
+	double		latency_;
+	/// Bytes of the original packets encoded.
+	double		bytes_in_;
+	/// Bytes of the projections sent.
+	double		bytes_out_;
+
+	Mojette();
+	~Mojette();
+
+	void		encode(Packet*, nsaddr_t, int, int, std::vector<Packet*>&);
+	Packet*		recv(Packet*);
+};
+
+#endif
@@ -0,0 +1,73 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+///
+/// \file	mojette_kernels.h
+/// \brief	Header file for the Mojette transform kernels.
+///
+/// The payload is laid out as a grid of m rows of P pixels, a pixel being a
+/// block of w contiguous bytes. The forward transform XORs whole rows into a
+/// projection through a single buffer XOR kernel, compiled for SSE2, AVX2 and
+/// plain 64-bit words, the best one the processor supports being chosen at
+/// startup. The inverse transform recovers one pixel at a time, each from the
+/// previous ones, so it only calls the kernel for pixels longer than
+/// MOJETTE_SHORT_XOR bytes and XORs the shorter ones inline.
+///
+/// This file does not depend on the simulator, so that the kernels can be
+/// benchmarked on their own (see mojette_bench.cc).
+///
+
+#ifndef __mojette_kernels_h__
+#define __mojette_kernels_h__
+
+#include <sys/types.h>
+#include <vector>
+
+/// Maximum number of projections a packet can be split into.
+#define MOJETTE_MAX_PROJECTIONS	8
+/// Length (in bytes) under which the XOR of a pixel is not worth a kernel call.
+#define MOJETTE_SHORT_XOR	32
+
+/// A kernel XORing len bytes of src into dst.
+typedef void (*mojette_xor_t)(u_int8_t*, const u_int8_t*, int);
+
+/// Kernel in use, chosen at startup.
+extern mojette_xor_t	mojette_xor;
+
+const char*	mojette_kernel();
+bool		mojette_set_kernel(const char*);
+bool		mojette_has_kernel(const char*);
+
+///
+/// \brief Forward and inverse Mojette transforms, with directions (p_i, 1).
+///
+class MojetteTransform {
+	/// Remaining XOR of the unknown pixels of every bin.
+	std::vector<u_int8_t>	resid_;
+	/// Reconstructed grid, padding included.
+	std::vector<u_int8_t>	grid_;
+
+public:
+	static int	direction(int);
+	static int	cols(int, int, int);
+	static int	bins(int, int, int, int);
+	static void	forward(const u_int8_t*, int, int, int, int, u_int8_t*);
+	bool		inverse(int, int, int, const int*, const u_int8_t* const*, int, u_int8_t*);
+	static void	fill(int, u_int8_t*, int);
+};
+
+#endif
@@ -584,6 +584,7 @@ AllocAddrBits set MAXADDRSIZE_ 32                ;# leaving the signed bit
 Simulator set node_factory_ Node
 Simulator set nsv1flag 0
 Simulator set mobile_ip_ 0			 ;# flag for mobileIP
+Simulator set prunePacketHeaders_ 0	 ;# see prune-packet-headers
 
 #this was commented out - ratul
 #Simulator set EnableHierRt_ 0   ;# is hierarchical routing on?  (to turn it on, call set-hieraddress)
@@ -1370,6 +1371,11 @@ Agent/OLSR set willingness_ 3
 Agent/OLSR set hello_ival_  2
 Agent/OLSR set tc_ival_     5
 Agent/OLSR set mid_ival_    5
+Agent/OLSR set max_pkt_size_ 1472
+Agent/OLSR set tc_delta_    false
+Agent/OLSR set tc_full_ival_ 30
+Agent/OLSR set fisheye_     false
+Agent/OLSR set timing_      false
 
 # Defaults defined for AOLSR
 Agent/AOLSR set debug_       false
@@ -1378,6 +1384,7 @@ Agent/AOLSR set willingness_ 3
 Agent/AOLSR set hello_ival_  2
 Agent/AOLSR set tc_ival_     5
 Agent/AOLSR set mid_ival_    5
+Agent/AOLSR set max_pkt_size_ 1472
 
 
 # Defaults defined for BOLSR
@@ -1387,6 +1394,7 @@ Agent/BOLSR set willingness_ 3
 Agent/BOLSR set hello_ival_  2
 Agent/BOLSR set tc_ival_     5
 Agent/BOLSR set mid_ival_    5
+Agent/BOLSR set max_pkt_size_ 1472
 
 # Defaults defined for MP-OLSR
 Agent/MPOLSR set debug_       false
@@ -1395,6 +1403,13 @@ Agent/MPOLSR set willingness_ 3
 Agent/MPOLSR set hello_ival_  2
 Agent/MPOLSR set tc_ival_     5
 Agent/MPOLSR set mid_ival_    5
+Agent/MPOLSR set max_pkt_size_ 1472
+Agent/MPOLSR set tc_delta_    false
+Agent/MPOLSR set tc_full_ival_ 30
+Agent/MPOLSR set timing_      false
+Agent/MPOLSR set max_route_   3
+Agent/MPOLSR set mojette_n_   0
+Agent/MPOLSR set mojette_m_   2
 
 # Intitialization for directed diffusion : Chalermek
 Agent/Diff_Sink set packetSize_ 512
@@ -996,6 +996,9 @@ Simulator instproc run {} {
 	$self check-node-num
 	$self rtmodel-configure			;# in case there are any
 	[$self get-routelogic] configure
+	if [Simulator set prunePacketHeaders_] {
+		$self prune-packet-headers	;# before any packet is allocated
+	}
 	$self instvar scheduler_ Node_ link_ started_ 
 	
 	set started_ 1
@@ -70,6 +70,8 @@
 #
 
 PacketHeaderManager set hdrlen_ 0
+# check that the headers of new packets are zero, see Packet::audit()
+PacketHeaderManager set audit_ false
 
 # XXX Common header should ALWAYS be present
 PacketHeaderManager set tab_(Common) 1
@@ -171,6 +173,7 @@ foreach prot {
 	AOMDV
 	OLSR  # routing protocol for ad-hoc networks
 	MPOLSR  # routing protocol for ad-hoc networks
+	Mojette # MPOLSR erasure coding, mpolsr/mojette.cc
 	AOLSR  # routing protocol for ad-hoc networks
 	BOLSR  # routing protocol for ad-hoc networks
 # Other:
@@ -219,6 +222,123 @@ PacketHeaderManager instproc allochdr cl {
 	return $base
 }
 
+#
+# Headers the C++ objects of each class access in the packets they handle,
+# used by Simulator prune-packet-headers to leave the other headers out of
+# the layout. Only classes listed here can be pruned around: the common
+# header is always kept, and a class which is not listed, even a subclass
+# of a listed one, keeps the full layout. Trace::format() and get_seqno()
+# access their headers whatever the packet, and CMUTrace only the header of
+# the protocol of the packet, kept by the agent which sent it.
+#
+foreach pair {
+	{ Simulator {} }
+	{ Scheduler/Calendar {} }
+	{ Scheduler/List {} }
+	{ Scheduler/Heap {} }
+	{ Scheduler/Splay {} }
+	{ Scheduler/Map {} }
+	{ Scheduler/Ladder {} }
+	{ PacketHeaderManager {} }
+	{ RNG {} }
+	{ Address {} }
+	{ AllocAddr {} }
+	{ RouteLogic {} }
+	{ RtModule/Base {} }
+	{ God { IP } }
+	{ Topography {} }
+	{ Node/MobileNode {} }
+	{ EnergyModel {} }
+	{ Classifier/Hash/Dest { IP } }
+	{ Classifier/Port { IP } }
+	{ Channel/WirelessChannel {} }
+	{ Propagation/TwoRayGround {} }
+	{ Propagation/FreeSpace {} }
+	{ Antenna/OmniAntenna {} }
+	{ Phy/WirelessPhy {} }
+	{ Mac/802_11 { Mac } }
+	{ Queue/DropTail {} }
+	{ Queue/DropTail/PriQueue {} }
+	{ LL { IP LL Mac } }
+	{ ARPTable { IP LL Mac ARP } }
+	{ Agent/Null { IP Flags NV } }
+	{ Agent/UDP { IP Flags NV RTP } }
+	{ Agent/AODV { IP Flags NV AODV } }
+	{ Agent/OLSR { IP Flags NV OLSR } }
+	{ Agent/MPOLSR { IP Flags NV MPOLSR SR Mojette } }
+	{ Agent/AOLSR { IP Flags NV AOLSR } }
+	{ Agent/BOLSR { IP Flags NV BOLSR } }
+	{ Application/Traffic/CBR {} }
+	{ Application/Traffic/Exponential {} }
+	{ CMUTrace/Send { IP Mac ARP } }
+	{ CMUTrace/Recv { IP Mac ARP } }
+	{ CMUTrace/Drop { IP Mac ARP } }
+	{ CMUTrace/EOT { IP Mac ARP } }
+	{ Trace/Generic { IP Flags TCP RTP RAP TFRC TFRC_ACK SCTP SRM } }
+	{ Trace/Enque { IP Flags TCP RTP RAP TFRC TFRC_ACK SCTP SRM } }
+	{ Trace/Deque { IP Flags TCP RTP RAP TFRC TFRC_ACK SCTP SRM } }
+	{ Trace/Drop { IP Flags TCP RTP RAP TFRC TFRC_ACK SCTP SRM } }
+	{ Trace/Recv { IP Flags TCP RTP RAP TFRC TFRC_ACK SCTP SRM } }
+} {
+	PacketHeaderManager set uses_([lindex $pair 0]) [lindex $pair 1]
+}
+
+proc all-instances cl {
+	set l [$cl info instances]
+	foreach sub [$cl info subclass] {
+		eval lappend l [all-instances $sub]
+	}
+	return $l
+}
+
+#
+# Lay the packet headers out again, leaving out the headers which none of
+# the objects of the simulation access, see PacketHeaderManager uses_.
+# This must happen before the first packet is allocated; Simulator run
+# calls it when Simulator prunePacketHeaders_ is set. Pruned headers get
+# offsets far below zero, so that Packet::access() catches a stray access
+# to them, or to one of their fields, and names the header.
+#
+Simulator instproc prune-packet-headers {} {
+	PacketHeaderManager instvar tab_ uses_
+	$self instvar packetManager_
+
+	if {[lindex [$packetManager_ zero-stats] 0] > 0} {
+		puts "packet headers: not pruned, packets were allocated\
+		      before the simulation started"
+		return
+	}
+	set keep(PacketHeader/Common) 1
+	foreach o [all-instances TclObject] {
+		set cl [$o info class]
+		if ![info exists uses_($cl)] {
+			puts "packet headers: not pruned, the headers $cl\
+			      accesses are unknown"
+			return
+		}
+		foreach hdr $uses_($cl) {
+			set keep(PacketHeader/$hdr) 1
+		}
+	}
+	set old [$packetManager_ set hdrlen_]
+	$packetManager_ set hdrlen_ 0
+	set kept 0
+	set pruned 0
+	foreach cl [PacketHeader info subclass] {
+		if ![info exists tab_($cl)] {
+			continue
+		}
+		if [info exists keep($cl)] {
+			$cl offset [$packetManager_ allochdr $cl]
+			incr kept
+		} else {
+			$cl offset [expr -65536 * [incr pruned]]
+		}
+	}
+	puts "packet headers: $kept of [expr $kept + $pruned] kept,\
+	      $old -> [$packetManager_ set hdrlen_] bytes per packet"
+}
+
 # XXX Old code. Do NOT delete for now. - Aug 30, 2000
 
 # Initialization
@@ -1069,6 +1069,7 @@ void
 CMUTrace::format_olsr(Packet *p, int offset)
 {
 	OLSR_pkt* op = PKT_OLSR(p);
+	OLSR_msg msg;
 
 	if (pt_->tagged()) {
 		sprintf(pt_->buffer() + offset,
@@ -1079,16 +1080,17 @@ CMUTrace::format_olsr(Packet *p, int offset)
 		int len = strlen(pt_->buffer());
 		for (int i = 0; i < op->count; i++) {
 			const char *s;
-			if (op->msg(i).msg_type() == OLSR_HELLO_MSG)
+			OLSR_pkt::get_msg(p, i, msg, true);
+			if (msg.msg_type() == OLSR_HELLO_MSG)
 				s = "-olsr:t HELLO -olsr:o %d -olsr:h %d -olsr:ms %d ";
-			else if (op->msg(i).msg_type() == OLSR_TC_MSG)
+			else if (msg.msg_type() == OLSR_TC_MSG)
 				s = "-olsr:t TC -olsr:o %d -olsr:h %d -olsr:ms %d ";
 			else
 				s = "-olsr:t UNKNOWN -olsr:o %d -olsr:h %d -olsr:ms %d ";
 			sprintf(pt_->buffer() + len, s,
-				op->msg(i).orig_addr(),
-				op->msg(i).hop_count(),
-				op->msg(i).msg_seq_num());
+				msg.orig_addr(),
+				msg.hop_count(),
+				msg.msg_seq_num());
 			len = strlen(pt_->buffer());
 		}
 	}
@@ -1101,16 +1103,17 @@ CMUTrace::format_olsr(Packet *p, int offset)
 		int len = strlen(pt_->buffer());
 		for (int i = 0; i < op->count; i++) {
 			const char *s;
-			if (op->msg(i).msg_type() == OLSR_HELLO_MSG)
+			OLSR_pkt::get_msg(p, i, msg, true);
+			if (msg.msg_type() == OLSR_HELLO_MSG)
 				s = "[-Pt HELLO -Po %d -Ph %d -Pms %d] ";
-			else if (op->msg(i).msg_type() == OLSR_TC_MSG)
+			else if (msg.msg_type() == OLSR_TC_MSG)
 				s = "[-Pt TC -Po %d -Ph %d -Pms %d] ";
 			else
 				s = "[-Pt UNKNOWN -Po %d -Ph %d -Pms %d] ";
 			sprintf(pt_->buffer() + len, s,
-				op->msg(i).orig_addr(),
-				op->msg(i).hop_count(),
-				op->msg(i).msg_seq_num());
+				msg.orig_addr(),
+				msg.hop_count(),
+				msg.msg_seq_num());
 			len = strlen(pt_->buffer());
 		}
 	}
@@ -1123,16 +1126,17 @@ CMUTrace::format_olsr(Packet *p, int offset)
 		int len = strlen(pt_->buffer());
 		for (int i = 0; i < op->count; i++) {
 			const char *s;
-			if (op->msg(i).msg_type() == OLSR_HELLO_MSG)
+			OLSR_pkt::get_msg(p, i, msg, true);
+			if (msg.msg_type() == OLSR_HELLO_MSG)
 				s = "[HELLO %d %d %d]";
-			else if (op->msg(i).msg_type() == OLSR_TC_MSG)
+			else if (msg.msg_type() == OLSR_TC_MSG)
 				s = "[TC %d %d %d]";
 			else
 				s = "[UNKNOWN %d %d %d]";
 			sprintf(pt_->buffer() + len, s,
-				op->msg(i).orig_addr(),
-				op->msg(i).hop_count(),
-				op->msg(i).msg_seq_num());
+				msg.orig_addr(),
+				msg.hop_count(),
+				msg.msg_seq_num());
 			len = strlen(pt_->buffer());
 		}
 
@@ -1144,6 +1148,7 @@ void
 CMUTrace::format_mpolsr(Packet *p, int offset)
 {
 	MPOLSR_pkt* op = PKT_MPOLSR(p);
+	MPOLSR_msg msg;
 
 	if (pt_->tagged()) {
 		sprintf(pt_->buffer() + offset,
@@ -1154,16 +1159,17 @@ CMUTrace::format_mpolsr(Packet *p, int offset)
 		int len = strlen(pt_->buffer());
 		for (int i = 0; i < op->count; i++) {
 			const char *s;
-			if (op->msg(i).msg_type() == MPOLSR_HELLO_MSG)
+			MPOLSR_pkt::get_msg(p, i, msg, true);
+			if (msg.msg_type() == MPOLSR_HELLO_MSG)
 				s = "-mpolsr:t HELLO -mpolsr:o %d -mpolsr:h %d -mpolsr:ms %d ";
-			else if (op->msg(i).msg_type() == MPOLSR_TC_MSG)
+			else if (msg.msg_type() == MPOLSR_TC_MSG)
 				s = "-mpolsr:t TC -mpolsr:o %d -mpolsr:h %d -mpolsr:ms %d ";
 			else
 				s = "-mpolsr:t UNKNOWN -mpolsr:o %d -mpolsr:h %d -mpolsr:ms %d ";
 			sprintf(pt_->buffer() + len, s,
-				op->msg(i).orig_addr(),
-				op->msg(i).hop_count(),
-				op->msg(i).msg_seq_num());
+				msg.orig_addr(),
+				msg.hop_count(),
+				msg.msg_seq_num());
 			len = strlen(pt_->buffer());
 		}
 	}
@@ -1176,16 +1182,17 @@ CMUTrace::format_mpolsr(Packet *p, int offset)
 		int len = strlen(pt_->buffer());
 		for (int i = 0; i < op->count; i++) {
 			const char *s;
-			if (op->msg(i).msg_type() == MPOLSR_HELLO_MSG)
+			MPOLSR_pkt::get_msg(p, i, msg, true);
+			if (msg.msg_type() == MPOLSR_HELLO_MSG)
 				s = "[-Pt HELLO -Po %d -Ph %d -Pms %d] ";
-			else if (op->msg(i).msg_type() == MPOLSR_TC_MSG)
+			else if (msg.msg_type() == MPOLSR_TC_MSG)
 				s = "[-Pt TC -Po %d -Ph %d -Pms %d] ";
 			else
 				s = "[-Pt UNKNOWN -Po %d -Ph %d -Pms %d] ";
 			sprintf(pt_->buffer() + len, s,
-				op->msg(i).orig_addr(),
-				op->msg(i).hop_count(),
-				op->msg(i).msg_seq_num());
+				msg.orig_addr(),
+				msg.hop_count(),
+				msg.msg_seq_num());
 			len = strlen(pt_->buffer());
 		}
 	}
@@ -1198,16 +1205,17 @@ CMUTrace::format_mpolsr(Packet *p, int offset)
 		int len = strlen(pt_->buffer());
 		for (int i = 0; i < op->count; i++) {
 			const char *s;
-			if (op->msg(i).msg_type() == MPOLSR_HELLO_MSG)
+			MPOLSR_pkt::get_msg(p, i, msg, true);
+			if (msg.msg_type() == MPOLSR_HELLO_MSG)
 				s = "[HELLO %d %d %d]";
-			else if (op->msg(i).msg_type() == MPOLSR_TC_MSG)
+			else if (msg.msg_type() == MPOLSR_TC_MSG)
 				s = "[TC %d %d %d]";
 			else
 				s = "[UNKNOWN %d %d %d]";
 			sprintf(pt_->buffer() + len, s,
-				op->msg(i).orig_addr(),
-				op->msg(i).hop_count(),
-				op->msg(i).msg_seq_num());
+				msg.orig_addr(),
+				msg.hop_count(),
+				msg.msg_seq_num());
 			len = strlen(pt_->buffer());
 		}
 
@@ -1219,6 +1227,7 @@ void
 CMUTrace::format_aolsr(Packet *p, int offset)
 {
 	AOLSR_pkt* op = PKT_AOLSR(p);
+	AOLSR_msg msg;
 
 	if (pt_->tagged()) {
 		sprintf(pt_->buffer() + offset,
@@ -1229,16 +1238,17 @@ CMUTrace::format_aolsr(Packet *p, int offset)
 		int len = strlen(pt_->buffer());
 		for (int i = 0; i < op->count; i++) {
 			const char *s;
-			if (op->msg(i).msg_type() == AOLSR_HELLO_MSG)
+			AOLSR_pkt::get_msg(p, i, msg, true);
+			if (msg.msg_type() == AOLSR_HELLO_MSG)
 				s = "-aolsr:t HELLO -aolsr:o %d -aolsr:h %d -aolsr:ms %d ";
-			else if (op->msg(i).msg_type() == AOLSR_TC_MSG)
+			else if (msg.msg_type() == AOLSR_TC_MSG)
 				s = "-aolsr:t TC -aolsr:o %d -aolsr:h %d -aolsr:ms %d ";
 			else
 				s = "-aolsr:t UNKNOWN -aolsr:o %d -aolsr:h %d -aolsr:ms %d ";
 			sprintf(pt_->buffer() + len, s,
-				op->msg(i).orig_addr(),
-				op->msg(i).hop_count(),
-				op->msg(i).msg_seq_num());
+				msg.orig_addr(),
+				msg.hop_count(),
+				msg.msg_seq_num());
 			len = strlen(pt_->buffer());
 		}
 	}
@@ -1251,16 +1261,17 @@ CMUTrace::format_aolsr(Packet *p, int offset)
 		int len = strlen(pt_->buffer());
 		for (int i = 0; i < op->count; i++) {
 			const char *s;
-			if (op->msg(i).msg_type() == AOLSR_HELLO_MSG)
+			AOLSR_pkt::get_msg(p, i, msg, true);
+			if (msg.msg_type() == AOLSR_HELLO_MSG)
 				s = "[-Pt HELLO -Po %d -Ph %d -Pms %d] ";
-			else if (op->msg(i).msg_type() == AOLSR_TC_MSG)
+			else if (msg.msg_type() == AOLSR_TC_MSG)
 				s = "[-Pt TC -Po %d -Ph %d -Pms %d] ";
 			else
 				s = "[-Pt UNKNOWN -Po %d -Ph %d -Pms %d] ";
 			sprintf(pt_->buffer() + len, s,
-				op->msg(i).orig_addr(),
-				op->msg(i).hop_count(),
-				op->msg(i).msg_seq_num());
+				msg.orig_addr(),
+				msg.hop_count(),
+				msg.msg_seq_num());
 			len = strlen(pt_->buffer());
 		}
 	}
@@ -1273,16 +1284,17 @@ CMUTrace::format_aolsr(Packet *p, int offset)
 		int len = strlen(pt_->buffer());
 		for (int i = 0; i < op->count; i++) {
 			const char *s;
-			if (op->msg(i).msg_type() == AOLSR_HELLO_MSG)
+			AOLSR_pkt::get_msg(p, i, msg, true);
+			if (msg.msg_type() == AOLSR_HELLO_MSG)
 				s = "[HELLO %d %d %d]";
-			else if (op->msg(i).msg_type() == AOLSR_TC_MSG)
+			else if (msg.msg_type() == AOLSR_TC_MSG)
 				s = "[TC %d %d %d]";
 			else
 				s = "[UNKNOWN %d %d %d]";
 			sprintf(pt_->buffer() + len, s,
-				op->msg(i).orig_addr(),
-				op->msg(i).hop_count(),
-				op->msg(i).msg_seq_num());
+				msg.orig_addr(),
+				msg.hop_count(),
+				msg.msg_seq_num());
 			len = strlen(pt_->buffer());
 		}
 
@@ -1294,6 +1306,7 @@ void
 CMUTrace::format_bolsr(Packet *p, int offset)
 {
 	BOLSR_pkt* op = PKT_BOLSR(p);
+	BOLSR_msg msg;
 
 	if (pt_->tagged()) {
 		sprintf(pt_->buffer() + offset,
@@ -1304,16 +1317,17 @@ CMUTrace::format_bolsr(Packet *p, int offset)
 		int len = strlen(pt_->buffer());
 		for (int i = 0; i < op->count; i++) {
 			const char *s;
-			if (op->msg(i).msg_type() == BOLSR_HELLO_MSG)
+			BOLSR_pkt::get_msg(p, i, msg, true);
+			if (msg.msg_type() == BOLSR_HELLO_MSG)
 				s = "-bolsr:t HELLO -bolsr:o %d -bolsr:h %d -bolsr:ms %d ";
-			else if (op->msg(i).msg_type() == BOLSR_TC_MSG)
+			else if (msg.msg_type() == BOLSR_TC_MSG)
 				s = "-bolsr:t TC -bolsr:o %d -bolsr:h %d -bolsr:ms %d ";
 			else
 				s = "-bolsr:t UNKNOWN -bolsr:o %d -bolsr:h %d -bolsr:ms %d ";
 			sprintf(pt_->buffer() + len, s,
-				op->msg(i).orig_addr(),
-				op->msg(i).hop_count(),
-				op->msg(i).msg_seq_num());
+				msg.orig_addr(),
+				msg.hop_count(),
+				msg.msg_seq_num());
 			len = strlen(pt_->buffer());
 		}
 	}
@@ -1326,16 +1340,17 @@ CMUTrace::format_bolsr(Packet *p, int offset)
 		int len = strlen(pt_->buffer());
 		for (int i = 0; i < op->count; i++) {
 			const char *s;
-			if (op->msg(i).msg_type() == BOLSR_HELLO_MSG)
+			BOLSR_pkt::get_msg(p, i, msg, true);
+			if (msg.msg_type() == BOLSR_HELLO_MSG)
 				s = "[-Pt HELLO -Po %d -Ph %d -Pms %d] ";
-			else if (op->msg(i).msg_type() == BOLSR_TC_MSG)
+			else if (msg.msg_type() == BOLSR_TC_MSG)
 				s = "[-Pt TC -Po %d -Ph %d -Pms %d] ";
 			else
 				s = "[-Pt UNKNOWN -Po %d -Ph %d -Pms %d] ";
 			sprintf(pt_->buffer() + len, s,
-				op->msg(i).orig_addr(),
-				op->msg(i).hop_count(),
-				op->msg(i).msg_seq_num());
+				msg.orig_addr(),
+				msg.hop_count(),
+				msg.msg_seq_num());
 			len = strlen(pt_->buffer());
 		}
 	}
@@ -1348,16 +1363,17 @@ CMUTrace::format_bolsr(Packet *p, int offset)
 		int len = strlen(pt_->buffer());
 		for (int i = 0; i < op->count; i++) {
 			const char *s;
-			if (op->msg(i).msg_type() == BOLSR_HELLO_MSG)
+			BOLSR_pkt::get_msg(p, i, msg, true);
+			if (msg.msg_type() == BOLSR_HELLO_MSG)
 				s = "[HELLO %d %d %d]";
-			else if (op->msg(i).msg_type() == BOLSR_TC_MSG)
+			else if (msg.msg_type() == BOLSR_TC_MSG)
 				s = "[TC %d %d %d]";
 			else
 				s = "[UNKNOWN %d %d %d]";
 			sprintf(pt_->buffer() + len, s,
-				op->msg(i).orig_addr(),
-				op->msg(i).hop_count(),
-				op->msg(i).msg_seq_num());
+				msg.orig_addr(),
+				msg.hop_count(),
+				msg.msg_seq_num());
 			len = strlen(pt_->buffer());
 		}
 
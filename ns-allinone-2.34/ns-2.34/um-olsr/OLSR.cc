@@ -35,6 +35,9 @@
 #include <ip.h>
 #include <cmu-trace.h>
 #include <map>
+#include <sys/time.h>
+#include <algorithm>
+#include <iterator>
 
 /// Length (in bytes) of UDP header.
 #define UDP_HDR_LEN	8
@@ -75,6 +78,24 @@ public:
 	}
 } class_rtProtoOLSR;
 
+
+///
+/// \brief Appends the usage of the pool of type T to the result of a Tcl command.
+///
+/// The element is the list {name objects_in_use high_water_mark objects_allocated}.
+///
+/// \param tcl the Tcl interpreter.
+/// \param name the name of the pooled type.
+///
+template <class T>
+static void
+append_pool_stats(Tcl& tcl, const char* name) {
+	char buf[128];
+	sprintf(buf, "%s %u %u %u", name,
+		OLSR_pool<T>::in_use(), OLSR_pool<T>::high_water(), OLSR_pool<T>::capacity());
+	Tcl_AppendElement(tcl.interp(), buf);
+}
+
 ///
 /// \brief Interface with TCL interpreter.
 ///
@@ -217,6 +238,60 @@ OLSR::command(int argc, const char*const* argv) {
 			}
 			return TCL_OK;
 		}
+		// Gives the number of OLSR packets received and the wall clock
+		// time spent processing them (zero unless timing_ is set)
+		else if (strcasecmp(argv[1], "ctrl_stats") == 0) {
+			Tcl& tcl = Tcl::instance();
+			tcl.resultf("%u %f", ctrl_pkts_, ctrl_time_);
+			return TCL_OK;
+		}
+		// Gives the number of times the routing table was computed and
+		// of topology changes which only updated the route to one
+		// destination
+		else if (strcasecmp(argv[1], "rtable_stats") == 0) {
+			Tcl& tcl = Tcl::instance();
+			tcl.resultf("%u %u", rtable_builds_, rtable_updates_);
+			return TCL_OK;
+		}
+		// Gives the number of full and delta TC messages and of TC
+		// requests generated, of delta TC messages which could not be
+		// applied, the bytes of TC messages and requests sent, and the
+		// number of TC messages processed and the wall clock time spent
+		// processing them (zero unless timing_ is set)
+		else if (strcasecmp(argv[1], "tc_stats") == 0) {
+			Tcl& tcl = Tcl::instance();
+			tcl.resultf("%u %u %u %u %u %u %f", tc_full_, tc_deltas_, tc_reqs_,
+				tc_gaps_, tc_bytes_, tc_rcvd_, tc_time_);
+			return TCL_OK;
+		}
+		// Gives the number of OLSR packets and messages sent, the
+		// bytes of headers saved by bundling the messages and the
+		// most messages sent in one packet
+		else if (strcasecmp(argv[1], "bundle_stats") == 0) {
+			Tcl& tcl = Tcl::instance();
+			tcl.resultf("%u %u %u %u", bundle_pkts_, bundle_msgs_,
+				bundle_saved_, bundle_max_);
+			return TCL_OK;
+		}
+		// Gives the usage of the pools of tuples and timers, which are
+		// shared by all the agents
+		else if (strcasecmp(argv[1], "pool_stats") == 0) {
+			Tcl& tcl = Tcl::instance();
+			Tcl_ResetResult(tcl.interp());
+			append_pool_stats<OLSR_rt_entry>(tcl, "rt_entry");
+			append_pool_stats<OLSR_link_tuple>(tcl, "link_tuple");
+			append_pool_stats<OLSR_nb_tuple>(tcl, "nb_tuple");
+			append_pool_stats<OLSR_nb2hop_tuple>(tcl, "nb2hop_tuple");
+			append_pool_stats<OLSR_mprsel_tuple>(tcl, "mprsel_tuple");
+			append_pool_stats<OLSR_topology_tuple>(tcl, "topology_tuple");
+			append_pool_stats<OLSR_iface_assoc_tuple>(tcl, "iface_assoc_tuple");
+			append_pool_stats<OLSR_LinkTupleTimer>(tcl, "link_timer");
+			append_pool_stats<OLSR_Nb2hopTupleTimer>(tcl, "nb2hop_timer");
+			append_pool_stats<OLSR_MprSelTupleTimer>(tcl, "mprsel_timer");
+			append_pool_stats<OLSR_TopologyTupleTimer>(tcl, "topology_timer");
+			append_pool_stats<OLSR_IfaceAssocTupleTimer>(tcl, "iface_assoc_timer");
+			return TCL_OK;
+		}
 	}
 	else if (argc == 3) {
 		// Obtains the corresponding dmux to carry packets to upper layers
@@ -235,6 +310,47 @@ OLSR::command(int argc, const char*const* argv) {
 				return TCL_ERROR;
 			return TCL_OK;
 		}
+		// Sets the TTLs of successive TC messages in fisheye mode, given
+		// as a list such as "2 4 255"
+		else if (strcasecmp(argv[1], "fisheye_ttls") == 0) {
+			Tcl& tcl = Tcl::instance();
+			int n;
+			const char** ttls;
+			if (Tcl_SplitList(tcl.interp(), argv[2], &n, &ttls) != TCL_OK)
+				return TCL_ERROR;
+			std::vector<u_int8_t> fisheye_ttl;
+			for (int i = 0; i < n; i++) {
+				int ttl = atoi(ttls[i]);
+				if (ttl < 1 || ttl > 255)
+					break;
+				fisheye_ttl.push_back(ttl);
+			}
+			Tcl_Free((char*)ttls);
+			if (n == 0 || (int)fisheye_ttl.size() != n) {
+				tcl.resultf("%s: invalid TTL list \"%s\"", argv[1], argv[2]);
+				return TCL_ERROR;
+			}
+			fisheye_ttl_.swap(fisheye_ttl);
+			fisheye_pos_ = 0;
+			return TCL_OK;
+		}
+		// Gives the number of topology tuples whose last hop is the given
+		// address
+		else if (strcasecmp(argv[1], "topology_tuples") == 0) {
+			Tcl& tcl = Tcl::instance();
+			topologyset_t* tuples = state_.find_topology_tuples(atoi(argv[2]));
+			tcl.resultf("%u", tuples == NULL ? 0 : (u_int32_t)tuples->size());
+			return TCL_OK;
+		}
+		// Gives the next hop towards the given address, or -1 if there is
+		// no route to it
+		else if (strcasecmp(argv[1], "next_hop") == 0) {
+			Tcl& tcl = Tcl::instance();
+			rtable_computation();
+			OLSR_rt_entry* entry = rtable_.lookup(atoi(argv[2]));
+			tcl.resultf("%d", entry == NULL ? -1 : (int)entry->next_addr());
+			return TCL_OK;
+		}
 	}
 	// Pass the command up to the base class
 	return Agent::command(argc, argv);
@@ -278,24 +394,6 @@ OLSR_MidTimer::expire(Event* e) {
 #endif
 }
 
-///
-/// \brief Removes tuple_ if expired. Else timer is rescheduled to expire at tuple_->time().
-///
-/// The task of actually removing the tuple is left to the OLSR agent.
-///
-/// \param e The event which has expired.
-///
-void
-OLSR_DupTupleTimer::expire(Event* e) {
-	if (tuple_->time() < CURRENT_TIME) {
-		agent_->rm_dup_tuple(tuple_);
-		delete tuple_;
-		delete this;
-	}
-	else
-		resched(DELAY(tuple_->time()));
-}
-
 ///
 /// \brief Removes tuple_ if expired. Else if symmetric time
 /// has expired then it is assumed a neighbor loss and agent_->nb_loss()
@@ -397,17 +495,132 @@ OLSR_IfaceAssocTupleTimer::expire(Event* e) {
 		resched(DELAY(tuple_->time()));
 }
 
+/********** Tuple expiry wheel **********/
+
+///
+/// \brief Hands the timer to the expiry wheel of its agent.
+/// \param delay time from now at which the timer expires.
 ///
-/// \brief Sends a control packet which must bear every message in the OLSR agent's buffer.
+void
+OLSR_TupleTimer::resched(double delay) {
+	agent_->expiry_wheel_.schedule(this, delay);
+}
+
+OLSR_ExpiryWheel::OLSR_ExpiryWheel() : TimerHandler() {
+	cursor_		= 0;
+	size_		= 0;
+	seq_		= 0;
+	next_		= -1.0;
+	sweeping_	= false;
+}
+
 ///
-/// The task of actually sending the packet is left to the OLSR agent.
+/// \brief Adds a tuple timer to the wheel.
+///
+/// The handler is only rescheduled if the timer is due before all the
+/// other ones.
+///
+/// \param timer the tuple timer.
+/// \param delay time from now at which the timer expires.
+///
+void
+OLSR_ExpiryWheel::schedule(OLSR_TupleTimer* timer, double delay) {
+	entry e;
+	e.time_		= CURRENT_TIME + delay;
+	e.tick_		= (long)floor(e.time_ / OLSR_WHEEL_TICK);
+	e.seq_		= seq_++;
+	e.timer_	= timer;
+	slots_[e.tick_ & (OLSR_WHEEL_SLOTS - 1)].push_back(e);
+	size_++;
+	if (e.tick_ < cursor_)
+		cursor_ = e.tick_;
+
+	// While sweeping, the handler is rescheduled once all due timers are expired
+	if (!sweeping_ && (next_ < 0 || e.time_ < next_)) {
+		next_ = e.time_;
+		resched(delay);
+	}
+}
+
+///
+/// \brief Expires all the due tuple timers, sorted by time and then by order
+/// of scheduling, and reschedules the handler at the next one.
+/// \param e The event which has expired.
+///
+void
+OLSR_ExpiryWheel::expire(Event* e) {
+	// The handler may run slightly before next_ due to rounding errors
+	double now	= MAX(CURRENT_TIME, next_);
+	long last	= (long)floor(now / OLSR_WHEEL_TICK);
+
+	// Every slot is visited once at most
+	if (last - cursor_ >= OLSR_WHEEL_SLOTS)
+		cursor_ = last - OLSR_WHEEL_SLOTS + 1;
+	for (long k = cursor_; k <= last; k++) {
+		std::vector<entry>& slot = slots_[k & (OLSR_WHEEL_SLOTS - 1)];
+		for (u_int32_t i = 0; i < slot.size();) {
+			if (slot[i].time_ <= now) {
+				due_.push_back(slot[i]);
+				slot[i] = slot.back();
+				slot.pop_back();
+			}
+			else
+				i++;
+		}
+	}
+	cursor_	= last;
+	size_	-= due_.size();
+	std::sort(due_.begin(), due_.end());
+
+	sweeping_ = true;
+	for (u_int32_t i = 0; i < due_.size(); i++)
+		due_[i].timer_->expire(e);
+	due_.clear();
+	sweeping_ = false;
+
+	reschedule();
+}
+
+///
+/// \brief Schedules the handler at the time of the earliest tuple timer.
+///
+void
+OLSR_ExpiryWheel::reschedule() {
+	next_ = -1.0;
+	if (size_ == 0)
+		return;
+
+	// The earliest timer lies in the first slot with a timer of the current round...
+	const entry* first = NULL;
+	for (long k = cursor_; first == NULL && k < cursor_ + OLSR_WHEEL_SLOTS; k++) {
+		std::vector<entry>& slot = slots_[k & (OLSR_WHEEL_SLOTS - 1)];
+		for (u_int32_t i = 0; i < slot.size(); i++)
+			if (slot[i].tick_ == k && (first == NULL || slot[i] < *first))
+				first = &slot[i];
+	}
+	// ...unless all of them lie beyond the wheel
+	if (first == NULL) {
+		for (int s = 0; s < OLSR_WHEEL_SLOTS; s++)
+			for (u_int32_t i = 0; i < slots_[s].size(); i++)
+				if (first == NULL || slots_[s][i] < *first)
+					first = &slots_[s][i];
+	}
+
+	cursor_	= first->tick_;
+	next_	= first->time_;
+	resched(next_ - CURRENT_TIME);
+}
+
+///
+/// \brief Sends the control packets which must bear every message in the OLSR agent's buffer.
+///
+/// The task of actually sending the packets is left to the OLSR agent.
 ///
 /// \param e The event which has expired.
 ///
 void
 OLSR_MsgTimer::expire(Event* e) {
 	agent_->send_pkt();
-	delete this;
 }
 
 
@@ -423,7 +636,8 @@ OLSR_MsgTimer::expire(Event* e) {
 OLSR::OLSR(nsaddr_t id) :	Agent(PT_OLSR),
 				hello_timer_(this),
 				tc_timer_(this),
-				mid_timer_(this) {
+				mid_timer_(this),
+				msg_timer_(this) {
 
 	// Enable usage of some of the configuration variables from Tcl.
 	//
@@ -435,12 +649,44 @@ OLSR::OLSR(nsaddr_t id) :	Agent(PT_OLSR),
 	bind("tc_ival_", &tc_ival_);
 	bind("mid_ival_", &mid_ival_);
 	bind_bool("use_mac_", &use_mac_);
+	bind("max_pkt_size_", &max_pkt_size_);
+	bind_bool("tc_delta_", &tc_delta_);
+	bind("tc_full_ival_", &tc_full_ival_);
+	bind_bool("fisheye_", &fisheye_);
+	bind_bool("timing_", &timing_);
 	
 	// Do some initializations
 	ra_addr_	= id;
 	pkt_seq_	= OLSR_MAX_SEQ_NUM;
 	msg_seq_	= OLSR_MAX_SEQ_NUM;
 	ansn_		= OLSR_MAX_SEQ_NUM;
+	ctrl_pkts_	= 0;
+	ctrl_time_	= 0.0;
+	mpr_version_	= 0;
+	msgs_deadline_	= 0.0;
+	bundle_pkts_	= 0;
+	bundle_msgs_	= 0;
+	bundle_saved_	= 0;
+	bundle_max_	= 0;
+	rtable_dirty_	= true;
+	rtable_version_	= 0;
+	rtable_expiry_	= 0.0;
+	rtable_builds_	= 0;
+	rtable_updates_	= 0;
+	tc_ansn_	= OLSR_MAX_SEQ_NUM;
+	tc_full_time_	= 0.0;
+	tc_full_req_	= true;
+	tc_full_	= 0;
+	tc_deltas_	= 0;
+	tc_reqs_	= 0;
+	tc_gaps_	= 0;
+	tc_bytes_	= 0;
+	tc_rcvd_	= 0;
+	tc_time_	= 0.0;
+	fisheye_pos_	= 0;
+	fisheye_ttl_.push_back(2);
+	fisheye_ttl_.push_back(4);
+	fisheye_ttl_.push_back(255);
 }
 
 ///
@@ -470,8 +716,18 @@ OLSR::recv(Packet* p, Handler* h) {
 	}
 	
 	// If it is an OLSR packet, must process it
-	if (ch->ptype() == PT_OLSR)
-		recv_olsr(p);
+	if (ch->ptype() == PT_OLSR) {
+		ctrl_pkts_++;
+		if (timing_) {
+			struct timeval start, end;
+			gettimeofday(&start, NULL);
+			recv_olsr(p);
+			gettimeofday(&end, NULL);
+			ctrl_time_ += (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+		}
+		else
+			recv_olsr(p);
+	}
 	// Otherwise, must forward the packet (unless TTL has reached zero)
 	else {
 		ih->ttl_--;
@@ -505,9 +761,10 @@ OLSR::recv_olsr(Packet* p) {
 		return;
 	}
 	
-	assert(op->count >= 0 && op->count <= OLSR_MAX_MSGS);
+	assert(op->count >= 0);
 	for (int i = 0; i < op->count; i++) {
-		OLSR_msg& msg = op->msg(i);
+		OLSR_msg msg;
+		OLSR_pkt::get_msg(p, i, msg);
 		
 		// If ttl is less than or equal to zero, or
 		// the receiver is the same as the originator,
@@ -518,15 +775,26 @@ OLSR::recv_olsr(Packet* p) {
 		// If the message has been processed it must not be
 		// processed again
 		bool do_forwarding = true;
-		OLSR_dup_tuple* duplicated = state_.find_dup_tuple(msg.orig_addr(), msg.msg_seq_num());
-		if (duplicated == NULL) {
+		if (!state_.find_dup(msg.orig_addr(), msg.msg_seq_num(), CURRENT_TIME)) {
 			// Process the message according to its type
 			if (msg.msg_type() == OLSR_HELLO_MSG)
 				process_hello(msg, ra_addr(), ih->saddr());
-			else if (msg.msg_type() == OLSR_TC_MSG)
-				process_tc(msg, ih->saddr());
+			else if (msg.msg_type() == OLSR_TC_MSG) {
+				tc_rcvd_++;
+				if (timing_) {
+					struct timeval start, end;
+					gettimeofday(&start, NULL);
+					process_tc(msg, ih->saddr());
+					gettimeofday(&end, NULL);
+					tc_time_ += (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+				}
+				else
+					process_tc(msg, ih->saddr());
+			}
 			else if (msg.msg_type() == OLSR_MID_MSG)
 				process_mid(msg, ih->saddr());
+			else if (msg.msg_type() == OLSR_TC_REQ_MSG)
+				process_tc_req(msg);
 			else {
 				debug("%f: Node %d can not process OLSR packet because does not "
 					"implement OLSR type (%x)\n",
@@ -538,14 +806,7 @@ OLSR::recv_olsr(Packet* p) {
 		else {
 			// If the message has been considered for forwarding, it should
 			// not be retransmitted again
-			for (addr_list_t::iterator it = duplicated->iface_list().begin();
-				it != duplicated->iface_list().end();
-				it++) {
-				if (*it == ra_addr()) {
-					do_forwarding = false;
-					break;
-				}
-			}
+			do_forwarding = false;
 		}
 			
 		if (do_forwarding) {
@@ -553,7 +814,7 @@ OLSR::recv_olsr(Packet* p) {
 			// TC and MID messages are forwarded using the default algorithm.
 			// Remaining messages are also forwarded using the default algorithm.
 			if (msg.msg_type() != OLSR_HELLO_MSG)
-				forward_default(p, msg, duplicated, ra_addr());
+				forward_default(p, msg, ra_addr());
 		}
 
 	}
@@ -565,22 +826,71 @@ OLSR::recv_olsr(Packet* p) {
 	Packet::free(p);
 }
 
+///
+/// \brief Moves a member of N to a bucket of the MPR computation.
+///
+/// \param buckets the buckets, by willingness and reachability.
+/// \param pos position of every member of N in its bucket.
+/// \param b the bucket.
+/// \param y the member of N.
+///
+static void
+bucket_insert(std::vector<std::vector<int> >& buckets, std::vector<int>& pos, int b, int y) {
+	pos[y] = buckets[b].size();
+	buckets[b].push_back(y);
+}
+
+///
+/// \brief Removes a member of N from a bucket of the MPR computation.
+///
+/// \param buckets the buckets, by willingness and reachability.
+/// \param pos position of every member of N in its bucket.
+/// \param b the bucket.
+/// \param y the member of N.
+///
+static void
+bucket_erase(std::vector<std::vector<int> >& buckets, std::vector<int>& pos, int b, int y) {
+	std::vector<int>& bucket = buckets[b];
+	bucket[pos[y]]		= bucket.back();
+	pos[bucket[pos[y]]]	= pos[y];
+	bucket.pop_back();
+}
+
 ///
 /// \brief Computates MPR set of a node following RFC 3626 hints.
 ///
+/// The set only depends on the Neighbor Set and the 2-hop Neighbor Set, so it
+/// is only computed again once they have changed. The members of N are kept
+/// in buckets by willingness and reachability, which are updated as the
+/// members of N2 get covered, so that every step of the heuristic only looks
+/// at the members with the highest willingness and reachability.
+///
 void
 OLSR::mpr_computation() {
+	if (mpr_version_ == state_.nbhood_version())
+		return;
+	mpr_version_ = state_.nbhood_version();
+
 	// MPR computation should be done for each interface. See section 8.3.1
 	// (RFC 3626) for details.
 	
 	state_.clear_mprset();
 	
-	nbset_t N; nb2hopset_t N2;
 	// N is the subset of neighbors of the node, which are
-	// neighbor "of the interface I"
-	for (nbset_t::iterator it = nbset().begin(); it != nbset().end(); it++)
-		if ((*it)->status() == OLSR_STATUS_SYM) // I think that we need this check
-			N.push_back(*it);
+	// neighbor "of the interface I". Its members are numbered in the
+	// order of the Neighbor Set.
+	std::vector<OLSR_nb_tuple*> N;
+	OLSR_hash<nsaddr_t, int> N_index;
+	int max_willingness = 0;
+	for (nbset_t::iterator it = nbset().begin(); it != nbset().end(); it++) {
+		OLSR_nb_tuple* nb_tuple = *it;
+		if (nb_tuple->status() == OLSR_STATUS_SYM // I think that we need this check
+			&& N_index.find(nb_tuple->nb_main_addr()) == NULL) {
+			N_index[nb_tuple->nb_main_addr()] = N.size();
+			N.push_back(nb_tuple);
+			max_willingness = MAX(max_willingness, nb_tuple->willingness());
+		}
+	}
 	
 	// N2 is the set of 2-hop neighbors reachable from "the interface
 	// I", excluding:
@@ -588,179 +898,123 @@ OLSR::mpr_computation() {
 	// (ii)  the node performing the computation
 	// (iii) all the symmetric neighbors: the nodes for which there exists a symmetric
 	//       link to this node on some interface.
+	// Its members are numbered too, providers holds the members of N which
+	// every one is reachable through, and covers the members of N2 which are
+	// reachable through every member of N.
+	//
+	// 2. Calculate D(y), where y is a member of N, for all nodes in N:
+	// the number of symmetric neighbors of y, excluding all the members
+	// of N and the node performing the computation.
+	OLSR_hash<nsaddr_t, int> N2_index;
+	std::vector<std::vector<int> > providers;
+	std::vector<std::vector<int> > covers(N.size());
+	std::vector<int> degree(N.size(), 0);
 	for (nb2hopset_t::iterator it = nb2hopset().begin(); it != nb2hopset().end(); it++) {
 		OLSR_nb2hop_tuple* nb2hop_tuple = *it;
-		bool ok = true;
-		OLSR_nb_tuple* nb_tuple = state_.find_sym_nb_tuple(nb2hop_tuple->nb_main_addr());
-		if (nb_tuple == NULL)
-			ok = false;
-		else {
-			nb_tuple = state_.find_nb_tuple(nb2hop_tuple->nb_main_addr(), OLSR_WILL_NEVER);
-			if (nb_tuple != NULL)
-				ok = false;
-			else {
-				nb_tuple = state_.find_sym_nb_tuple(nb2hop_tuple->nb2hop_addr());
-				if (nb_tuple != NULL)
-					ok = false;
-			}
+		nsaddr_t addr	= nb2hop_tuple->nb2hop_addr();
+		int* y		= N_index.find(nb2hop_tuple->nb_main_addr());
+		if (y == NULL || addr == ra_addr() || N_index.find(addr) != NULL)
+			continue;
+		degree[*y]++;
+		if (N[*y]->willingness() == OLSR_WILL_NEVER)
+			continue;
+		int* x = N2_index.find(addr);
+		if (x == NULL) {
+			N2_index[addr] = providers.size();
+			providers.push_back(std::vector<int>());
+			x = N2_index.find(addr);
 		}
-
-		if (ok)
-			N2.push_back(nb2hop_tuple);
+		providers[*x].push_back(*y);
+		covers[*y].push_back(*x);
 	}
 	
-	// 1. Start with an MPR set made of all members of N with
-	// N_willingness equal to WILL_ALWAYS
-	for (nbset_t::iterator it = N.begin(); it != N.end(); it++) {
-		OLSR_nb_tuple* nb_tuple = *it;
-		if (nb_tuple->willingness() == OLSR_WILL_ALWAYS)
-			state_.insert_mpr_addr(nb_tuple->nb_main_addr());
+	// The reachability of a member of N is the number of members of N2
+	// which are not yet covered by a node in the MPR set, and which are
+	// reachable through it. Members of N which are not in the MPR set
+	// and have a non-zero reachability are kept in buckets, which sort
+	// them by willingness and then by reachability.
+	int stride	= providers.size() + 1;
+	int n_buckets	= (max_willingness + 1) * stride;
+	std::vector<std::vector<int> > buckets(n_buckets);
+	std::vector<int> reachability(N.size());
+	std::vector<int> pos(N.size());
+	for (u_int32_t y = 0; y < N.size(); y++) {
+		reachability[y] = covers[y].size();
+		if (reachability[y] > 0)
+			bucket_insert(buckets, pos,
+				N[y]->willingness() * stride + reachability[y], y);
 	}
 	
-	// 2. Calculate D(y), where y is a member of N, for all nodes in N.
-	// We will do this later.
+	// 1. Start with an MPR set made of all members of N with
+	// N_willingness equal to WILL_ALWAYS
+	std::vector<int> selected;
+	for (u_int32_t y = 0; y < N.size(); y++)
+		if (N[y]->willingness() == OLSR_WILL_ALWAYS)
+			selected.push_back(y);
 	
 	// 3. Add to the MPR set those nodes in N, which are the *only*
 	// nodes to provide reachability to a node in N2. Remove the
 	// nodes from N2 which are now covered by a node in the MPR set.
-	mprset_t foundset;
-	std::set<nsaddr_t> deleted_addrs;
-	for (nb2hopset_t::iterator it = N2.begin(); it != N2.end(); it++) {
-		OLSR_nb2hop_tuple* nb2hop_tuple1 = *it;
-		
-		mprset_t::iterator pos = foundset.find(nb2hop_tuple1->nb2hop_addr());
-		if (pos != foundset.end())
-			continue;
-		
-		bool found = false;
-		for (nbset_t::iterator it2 = N.begin(); it2 != N.end(); it2++) {
-			if ((*it2)->nb_main_addr() == nb2hop_tuple1->nb_main_addr()) {
-				found = true;
-				break;
-			}
-		}
-		if (!found)
-			continue;
-		
-		found = false;
-		for (nb2hopset_t::iterator it2 = it + 1; it2 != N2.end(); it2++) {
-			OLSR_nb2hop_tuple* nb2hop_tuple2 = *it2;
-			if (nb2hop_tuple1->nb2hop_addr() == nb2hop_tuple2->nb2hop_addr()) {
-				foundset.insert(nb2hop_tuple1->nb2hop_addr());
-				found = true;
-				break;
-			}
-		}
-		if (!found) {
-			state_.insert_mpr_addr(nb2hop_tuple1->nb_main_addr());
-			
-			for (nb2hopset_t::iterator it2 = it + 1; it2 != N2.end(); it2++) {
-				OLSR_nb2hop_tuple* nb2hop_tuple2 = *it2;
-				if (nb2hop_tuple1->nb_main_addr() == nb2hop_tuple2->nb_main_addr()) {
-					deleted_addrs.insert(nb2hop_tuple2->nb2hop_addr());
-					it2 = N2.erase(it2);
-					it2--;
-				}
-			}
-			it = N2.erase(it);
-			it--;
-		}
-		
-		for (std::set<nsaddr_t>::iterator it2 = deleted_addrs.begin();
-			it2 != deleted_addrs.end();
-			it2++) {
-			for (nb2hopset_t::iterator it3 = N2.begin();
-				it3 != N2.end();
-				it3++) {
-				if ((*it3)->nb2hop_addr() == *it2) {
-					it3 = N2.erase(it3);
-					it3--;
-					// I have to reset the external iterator because it
-					// may have been invalidated by the latter deletion
-					it = N2.begin();
-					it--;
-				}
-			}
-		}
-		deleted_addrs.clear();
-	}
+	for (u_int32_t x = 0; x < providers.size(); x++)
+		if (providers[x].size() == 1)
+			selected.push_back(providers[x][0]);
 	
 	// 4. While there exist nodes in N2 which are not covered by at
 	// least one node in the MPR set:
-	while (N2.begin() != N2.end()) {
-		// 4.1. For each node in N, calculate the reachability, i.e., the
-		// number of nodes in N2 which are not yet covered by at
-		// least one node in the MPR set, and which are reachable
-		// through this 1-hop neighbor
-		map<int, std::vector<OLSR_nb_tuple*> > reachability;
-		set<int> rs;
-		for (nbset_t::iterator it = N.begin(); it != N.end(); it++) {
-			OLSR_nb_tuple* nb_tuple = *it;
-			int r = 0;
-			for (nb2hopset_t::iterator it2 = N2.begin(); it2 != N2.end(); it2++) {
-				OLSR_nb2hop_tuple* nb2hop_tuple = *it2;
-				if (nb_tuple->nb_main_addr() == nb2hop_tuple->nb_main_addr())
-					r++;
-			}
-			rs.insert(r);
-			reachability[r].push_back(nb_tuple);
+	std::vector<bool> mpr(N.size(), false);
+	std::vector<bool> covered(providers.size(), false);
+	u_int32_t uncovered = providers.size();
+	u_int32_t next = 0;
+	int top = n_buckets - 1;
+	while (next < selected.size() || uncovered > 0) {
+		int max;
+		if (next < selected.size()) {
+			max = selected[next++];
+			if (mpr[max])
+				continue;
 		}
-		
-		// 4.2. Select as a MPR the node with highest N_willingness among
-		// the nodes in N with non-zero reachability. In case of
-		// multiple choice select the node which provides
-		// reachability to the maximum number of nodes in N2. In
-		// case of multiple nodes providing the same amount of
-		// reachability, select the node as MPR whose D(y) is
-		// greater. Remove the nodes from N2 which are now covered
-		// by a node in the MPR set.
-		OLSR_nb_tuple* max = NULL;
-		int max_r = 0;
-		for (set<int>::iterator it = rs.begin(); it != rs.end(); it++) {
-			int r = *it;
-			if (r > 0) {
-				for (std::vector<OLSR_nb_tuple*>::iterator it2 = reachability[r].begin();
-					it2 != reachability[r].end();
-					it2++) {
-					OLSR_nb_tuple* nb_tuple = *it2;
-					if (max == NULL || nb_tuple->willingness() > max->willingness()) {
-						max = nb_tuple;
-						max_r = r;
-					}
-					else if (nb_tuple->willingness() == max->willingness()) {
-						if (r > max_r) {
-							max = nb_tuple;
-							max_r = r;
-						}
-						else if (r == max_r) {
-							if (degree(nb_tuple) > degree(max)) {
-								max = nb_tuple;
-								max_r = r;
-							}
-						}
-					}
-				}
+		else {
+			// 4.2. Select as a MPR the node with highest N_willingness among
+			// the nodes in N with non-zero reachability. In case of
+			// multiple choice select the node which provides
+			// reachability to the maximum number of nodes in N2. In
+			// case of multiple nodes providing the same amount of
+			// reachability, select the node as MPR whose D(y) is
+			// greater.
+			while (buckets[top].empty())
+				top--;
+			max = buckets[top][0];
+			for (u_int32_t i = 1; i < buckets[top].size(); i++) {
+				int y = buckets[top][i];
+				if (degree[y] > degree[max] || (degree[y] == degree[max] && y < max))
+					max = y;
 			}
 		}
-		if (max != NULL) {
-			state_.insert_mpr_addr(max->nb_main_addr());
-			std::set<nsaddr_t> nb2hop_addrs;
-			for (nb2hopset_t::iterator it = N2.begin(); it != N2.end(); it++) {
-				OLSR_nb2hop_tuple* nb2hop_tuple = *it;
-				if (nb2hop_tuple->nb_main_addr() == max->nb_main_addr()) {
-					nb2hop_addrs.insert(nb2hop_tuple->nb2hop_addr());
-					it = N2.erase(it);
-					it--;
-				}
-			}
-			for (nb2hopset_t::iterator it = N2.begin(); it != N2.end(); it++) {
-				OLSR_nb2hop_tuple* nb2hop_tuple = *it;
-				std::set<nsaddr_t>::iterator it2 =
-					nb2hop_addrs.find(nb2hop_tuple->nb2hop_addr());
-				if (it2 != nb2hop_addrs.end()) {
-					it = N2.erase(it);
-					it--;
-				}
+		
+		mpr[max] = true;
+		state_.insert_mpr_addr(N[max]->nb_main_addr());
+		if (reachability[max] > 0)
+			bucket_erase(buckets, pos,
+				N[max]->willingness() * stride + reachability[max], max);
+		
+		// Remove the nodes from N2 which are now covered by a node in the
+		// MPR set, and update the reachability of the nodes they are
+		// reachable through.
+		for (u_int32_t i = 0; i < covers[max].size(); i++) {
+			int x = covers[max][i];
+			if (covered[x])
+				continue;
+			covered[x] = true;
+			uncovered--;
+			for (u_int32_t j = 0; j < providers[x].size(); j++) {
+				int y = providers[x][j];
+				int b = N[y]->willingness() * stride + reachability[y];
+				reachability[y]--;
+				if (mpr[y])
+					continue;
+				bucket_erase(buckets, pos, b, y);
+				if (reachability[y] > 0)
+					bucket_insert(buckets, pos, b - 1, y);
 			}
 		}
 	}
@@ -769,11 +1023,42 @@ OLSR::mpr_computation() {
 ///
 /// \brief Creates the routing table of the node following RFC 3626 hints.
 ///
+/// The table is only computed again if it may have changed since the last
+/// time: the neighborhood has changed, a link it follows has expired, or
+/// rtable_dirty_ is set. Otherwise the previous one is kept. Step 4 is a
+/// breadth first search which, at every distance h, only visits the topology
+/// tuples whose last hop is h hops away.
+///
 void
 OLSR::rtable_computation() {
+	double now = CURRENT_TIME;
+	
+	if (!rtable_dirty_ && rtable_version_ == state_.nbhood_version() && now <= rtable_expiry_)
+		return;
+	rtable_dirty_	= false;
+	rtable_version_	= state_.nbhood_version();
+	rtable_expiry_	= HUGE_VAL;
+	rtable_builds_++;
+	
 	// 1. All the entries from the routing table are removed.
 	rtable_.clear();
 	
+	// Valid links, as pairs [neighbor main address, position in the Link Set],
+	// so that sorting them gives the links to every neighbor in Link Set order
+	std::vector<std::pair<nsaddr_t, u_int32_t> > links;
+	for (u_int32_t i = 0; i < linkset().size(); i++) {
+		OLSR_link_tuple* link_tuple = linkset()[i];
+		if (link_tuple->time() >= now) {
+			links.push_back(std::make_pair(get_main_addr(link_tuple->nb_iface_addr()), i));
+			if (link_tuple->time() < rtable_expiry_)
+				rtable_expiry_ = link_tuple->time();
+		}
+		else
+			// It becomes valid again if it is refreshed before being removed
+			rtable_dirty_ = true;
+	}
+	std::sort(links.begin(), links.end());
+	
 	// 2. The new routing entries are added starting with the
 	// symmetric neighbors (h=1) as the destination nodes.
 	for (nbset_t::iterator it = nbset().begin(); it != nbset().end(); it++) {
@@ -781,17 +1066,19 @@ OLSR::rtable_computation() {
 		if (nb_tuple->status() == OLSR_STATUS_SYM) {
 			bool nb_main_addr = false;
 			OLSR_link_tuple* lt = NULL;
-			for (linkset_t::iterator it2 = linkset().begin(); it2 != linkset().end(); it2++) {
-				OLSR_link_tuple* link_tuple = *it2;
-				if (get_main_addr(link_tuple->nb_iface_addr()) == nb_tuple->nb_main_addr() && link_tuple->time() >= CURRENT_TIME) {
-					lt = link_tuple;
-					rtable_.add_entry(link_tuple->nb_iface_addr(),
-							link_tuple->nb_iface_addr(),
-							link_tuple->local_iface_addr(),
-							1);
-					if (link_tuple->nb_iface_addr() == nb_tuple->nb_main_addr())
-						nb_main_addr = true;
-				}
+			for (std::vector<std::pair<nsaddr_t, u_int32_t> >::iterator it2 =
+				std::lower_bound(links.begin(), links.end(),
+					std::make_pair(nb_tuple->nb_main_addr(), (u_int32_t)0));
+				it2 != links.end() && it2->first == nb_tuple->nb_main_addr();
+				it2++) {
+				OLSR_link_tuple* link_tuple = linkset()[it2->second];
+				lt = link_tuple;
+				rtable_.add_entry(link_tuple->nb_iface_addr(),
+						link_tuple->nb_iface_addr(),
+						link_tuple->local_iface_addr(),
+						1);
+				if (link_tuple->nb_iface_addr() == nb_tuple->nb_main_addr())
+					nb_main_addr = true;
 			}
 			if (!nb_main_addr && lt != NULL) {
 				rtable_.add_entry(nb_tuple->nb_main_addr(),
@@ -802,6 +1089,9 @@ OLSR::rtable_computation() {
 		}
 	}
 	
+	// Destinations which are h hops away, for h >= 2
+	std::vector<std::vector<nsaddr_t> > hops(3);
+	
 	// N2 is the set of 2-hop neighbors reachable from this node, excluding:
 	// (i)   the nodes only reachable by members of N with willingness WILL_NEVER
 	// (ii)  the node performing the computation
@@ -828,6 +1118,9 @@ OLSR::rtable_computation() {
 		if (ok) {
 			OLSR_rt_entry* entry = rtable_.lookup(nb2hop_tuple->nb_main_addr());
 			assert(entry != NULL);
+			OLSR_rt_entry* old = rtable_.lookup(nb2hop_tuple->nb2hop_addr());
+			if (old == NULL || old->dist() != 2)
+				hops[2].push_back(nb2hop_tuple->nb2hop_addr());
 			rtable_.add_entry(nb2hop_tuple->nb2hop_addr(),
 					entry->next_addr(),
 					entry->iface_addr(),
@@ -835,8 +1128,11 @@ OLSR::rtable_computation() {
 		}
 	}
 	
+	// First topology tuple leading to every new destination
+	OLSR_hash<nsaddr_t, OLSR_topology_tuple*> first;
 	for (u_int32_t h = 2; ; h++) {
 		bool added = false;
+		hops.resize(h + 2);
 		
 		// 4.1. For each topology entry in the topology table, if its
 		// T_dest_addr does not correspond to R_dest_addr of any
@@ -844,20 +1140,33 @@ OLSR::rtable_computation() {
 		// corresponds to R_dest_addr of a route entry whose R_dist
 		// is equal to h, then a new route entry MUST be recorded in
 		// the routing table (if it does not already exist)
-		for (topologyset_t::iterator it = topologyset().begin();
-			it != topologyset().end();
-			it++) {
-			OLSR_topology_tuple* topology_tuple = *it;
-			OLSR_rt_entry* entry1 = rtable_.lookup(topology_tuple->dest_addr());
-			OLSR_rt_entry* entry2 = rtable_.lookup(topology_tuple->last_addr());
-			if (entry1 == NULL && entry2 != NULL && entry2->dist() == h) {
-				rtable_.add_entry(topology_tuple->dest_addr(),
-						entry2->next_addr(),
-						entry2->iface_addr(),
-						h+1);
-				added = true;
+		first.clear();
+		for (u_int32_t i = 0; i < hops[h].size(); i++) {
+			topologyset_t* tuples = state_.find_topology_tuples(hops[h][i]);
+			if (tuples == NULL)
+				continue;
+			for (topologyset_t::iterator it = tuples->begin(); it != tuples->end(); it++) {
+				OLSR_topology_tuple* topology_tuple = *it;
+				if (rtable_.lookup(topology_tuple->dest_addr()) != NULL)
+					continue;
+				OLSR_topology_tuple*& tuple = first[topology_tuple->dest_addr()];
+				if (tuple == NULL) {
+					tuple = topology_tuple;
+					hops[h+1].push_back(topology_tuple->dest_addr());
+				}
+				else if (topology_tuple->order() < tuple->order())
+					tuple = topology_tuple;
 			}
 		}
+		for (u_int32_t i = 0; i < hops[h+1].size(); i++) {
+			OLSR_topology_tuple* topology_tuple = *first.find(hops[h+1][i]);
+			OLSR_rt_entry* entry2 = rtable_.lookup(topology_tuple->last_addr());
+			rtable_.add_entry(topology_tuple->dest_addr(),
+					entry2->next_addr(),
+					entry2->iface_addr(),
+					h+1);
+			added = true;
+		}
 		
 		// 5. For each entry in the multiple interface association base
 		// where there exists a routing entry such that:
@@ -876,6 +1185,8 @@ OLSR::rtable_computation() {
 						entry1->next_addr(),
 						entry1->iface_addr(),
 						entry1->dist());
+				if (entry1->dist() == h+1)
+					hops[h+1].push_back(tuple->iface_addr());
 				added = true;
 			}
 		}
@@ -885,6 +1196,69 @@ OLSR::rtable_computation() {
 	}
 }
 
+///
+/// \brief Must be called before a topology tuple is added to or removed from
+///	the Topology Set. The routing table is updated if the tuple only changes
+///	the route to its destination, and marked to be computed again if it may
+///	change other routes.
+///
+/// A tuple whose last hop is h >= 2 hops away may only give a route of h+1
+/// hops to its destination. A new tuple is the last one of the Topology Set,
+/// so any other tuple giving such a route is preferred to it. When no topology
+/// tuple leaves the destination and there are no interface associations, no
+/// other route goes through the destination, so that its own route is the only
+/// one to update. The new route then comes from the first tuple, in Topology
+/// Set order, among the ones towards the destination whose last hop is the
+/// nearest, as it would in rtable_computation().
+///
+/// \param tuple the topology tuple.
+/// \param added true if the tuple is being added, false if it is being removed.
+///
+void
+OLSR::topology_tuple_changed(OLSR_topology_tuple* tuple, bool added) {
+	if (rtable_dirty_)
+		return;
+	OLSR_rt_entry* last = rtable_.lookup(tuple->last_addr());
+	if (last == NULL || last->dist() < 2)
+		return;
+	OLSR_rt_entry* dest = rtable_.lookup(tuple->dest_addr());
+	if (added) {
+		// Routes to interfaces given by step 5 are not preferred to the tuple
+		if (dest != NULL && dest->dist() <= last->dist() + 1 &&
+			state_.find_ifaceassoc_tuple(tuple->dest_addr()) == NULL)
+			return;
+	}
+	else if (dest == NULL || dest->dist() != last->dist() + 1)
+		return;
+	
+	if (!ifaceassocset().empty() || state_.find_topology_tuples(tuple->dest_addr()) != NULL) {
+		rtable_dirty_ = true;
+		return;
+	}
+	rtable_updates_++;
+	if (added) {
+		rtable_.add_entry(tuple->dest_addr(), last->next_addr(), last->iface_addr(),
+			last->dist() + 1);
+		return;
+	}
+	
+	OLSR_rt_entry* best = NULL;
+	for (topologyset_t::iterator it = topologyset().begin(); it != topologyset().end(); it++) {
+		OLSR_topology_tuple* topology_tuple = *it;
+		if (topology_tuple == tuple || topology_tuple->dest_addr() != tuple->dest_addr())
+			continue;
+		OLSR_rt_entry* entry = rtable_.lookup(topology_tuple->last_addr());
+		if (entry != NULL && entry->dist() >= 2 &&
+			(best == NULL || entry->dist() < best->dist()))
+			best = entry;
+	}
+	if (best == NULL)
+		rtable_.rm_entry(tuple->dest_addr());
+	else
+		rtable_.add_entry(tuple->dest_addr(), best->next_addr(), best->iface_addr(),
+			best->dist() + 1);
+}
+
 ///
 /// \brief Processes a HELLO message following RFC 3626 specification.
 ///
@@ -936,16 +1310,32 @@ OLSR::process_tc(OLSR_msg& msg, nsaddr_t sender_iface) {
 		state_.find_newer_topology_tuple(msg.orig_addr(), tc.ansn());
 	if (topology_tuple != NULL)
 		return;
-	
-	// 3. All tuples in the topology set where:
-	//	T_last_addr == originator address AND
-	//	T_seq       <  ANSN
-	// MUST be removed from the topology set.
-	state_.erase_older_topology_tuples(msg.orig_addr(), tc.ansn());
+
+	// A delta TC message only updates the tuples of the originator, and
+	// the addresses to be recorded are the added ones
+	int added = tc.count;
+	if (tc.reserved() & OLSR_TC_DELTA) {
+		if (!process_delta_tc(msg))
+			return;
+		added = tc.reserved() & ~OLSR_TC_DELTA;
+	}
+	else {
+		// 3. All tuples in the topology set where:
+		//	T_last_addr == originator address AND
+		//	T_seq       <  ANSN
+		// MUST be removed from the topology set.
+		topologyset_t* tuples = state_.find_topology_tuples(msg.orig_addr());
+		if (tuples != NULL) {
+			for (topologyset_t::iterator it = tuples->begin(); it != tuples->end(); it++)
+				if ((*it)->seq() < tc.ansn())
+					topology_tuple_changed(*it, false);
+		}
+		state_.erase_older_topology_tuples(msg.orig_addr(), tc.ansn());
+	}
 
 	// 4. For each of the advertised neighbor main address received in
 	// the TC message:
-	for (int i = 0; i < tc.count; i++) {
+	for (int i = 0; i < added; i++) {
 		assert(i >= 0 && i < OLSR_MAX_ADDRS);
 		nsaddr_t addr = tc.nb_main_addr(i);
 		// 4.1. If there exist some tuple in the topology set where:
@@ -978,6 +1368,72 @@ OLSR::process_tc(OLSR_msg& msg, nsaddr_t sender_iface) {
 	}
 }
 
+///
+/// \brief Applies a delta TC message to the tuples of its originator.
+///
+/// The message lists the addresses added to the set advertised with the
+/// previous ANSN, followed by the removed ones (see send_tc()). It can only
+/// be applied if the tuples of the originator were recorded with the
+/// previous ANSN, or with its own ANSN if the set did not change. Otherwise
+/// some message was lost, and a full TC message is requested to the
+/// originator.
+///
+/// The removed tuples are erased and the remaining ones take the ANSN of
+/// the message and are refreshed. The added ones are left to process_tc().
+///
+/// \param msg the %OLSR message which contains the delta TC message.
+/// \return true if the message could be applied.
+///
+bool
+OLSR::process_delta_tc(OLSR_msg& msg) {
+	double now	= CURRENT_TIME;
+	OLSR_tc& tc	= msg.tc();
+	int added	= tc.reserved() & ~OLSR_TC_DELTA;
+	u_int16_t prev	= (tc.ansn() + OLSR_MAX_SEQ_NUM)%(OLSR_MAX_SEQ_NUM + 1);
+
+	// A delta TC message with no address does not change the set, and its
+	// ANSN is the one of the set
+	topologyset_t* tuples = state_.find_topology_tuples(msg.orig_addr());
+	if (tuples == NULL || tuples->empty() || (tuples->front()->seq() != tc.ansn() &&
+		(tc.count == 0 || tuples->front()->seq() != prev))) {
+		tc_gaps_++;
+		send_tc_req(msg.orig_addr(), msg.hop_count() + 1);
+		return false;
+	}
+
+	for (int i = added; i < tc.count; i++) {
+		OLSR_topology_tuple* topology_tuple =
+			state_.find_topology_tuple(tc.nb_main_addr(i), msg.orig_addr());
+		if (topology_tuple != NULL)
+			rm_topology_tuple(topology_tuple);
+	}
+	tuples = state_.find_topology_tuples(msg.orig_addr());
+	if (tuples != NULL) {
+		for (topologyset_t::iterator it = tuples->begin(); it != tuples->end(); it++) {
+			(*it)->seq()	= tc.ansn();
+			(*it)->time()	= now + OLSR::emf_to_seconds(msg.vtime());
+		}
+	}
+	return true;
+}
+
+///
+/// \brief Processes a TC request.
+///
+/// If this node is one of the originators listed in the request, its next
+/// TC message is a full one.
+///
+/// \param msg the %OLSR message which contains the TC request.
+///
+void
+OLSR::process_tc_req(OLSR_msg& msg) {
+	assert(msg.msg_type() == OLSR_TC_REQ_MSG);
+	OLSR_mid& tc_req = msg.tc_req();
+	for (int i = 0; i < tc_req.count; i++)
+		if (tc_req.iface_addr(i) == ra_addr())
+			tc_full_req_ = true;
+}
+
 ///
 /// \brief Processes a MID message following RFC 3626 specification.
 ///
@@ -1033,12 +1489,10 @@ OLSR::process_mid(OLSR_msg& msg, nsaddr_t sender_iface) {
 ///
 /// \param p the %OLSR packet which has been received.
 /// \param msg the %OLSR message which must be forwarded.
-/// \param dup_tuple NULL if the message has never been considered for forwarding,
-/// or a duplicate tuple in other case.
 /// \param local_iface the address of the interface where the message was received from.
 ///
 void
-OLSR::forward_default(Packet* p, OLSR_msg& msg, OLSR_dup_tuple* dup_tuple, nsaddr_t local_iface) {
+OLSR::forward_default(Packet* p, OLSR_msg& msg, nsaddr_t local_iface) {
 	double now		= CURRENT_TIME;
 	struct hdr_ip* ih	= HDR_IP(p);
 	
@@ -1048,21 +1502,9 @@ OLSR::forward_default(Packet* p, OLSR_msg& msg, OLSR_dup_tuple* dup_tuple, nsadd
 	if (link_tuple == NULL)
 		return;
 
-	// If the message has already been considered for forwarding,
-	// it must not be retransmitted again
-	if (dup_tuple != NULL && dup_tuple->retransmitted()) {
-		debug("%f: Node %d does not forward a message received"
-			" from %d because it is duplicated\n",
-			CURRENT_TIME,
-			OLSR::node_id(ra_addr()),
-			OLSR::node_id(dup_tuple->addr()));
-		return;
-	}
-	
 	// If the sender interface address is an interface address
 	// of a MPR selector of this node and ttl is greater than 1,
 	// the message must be retransmitted
-	bool retransmitted = false;
 	if (msg.ttl() > 1) {
 		OLSR_mprsel_tuple* mprsel_tuple =
 			state_.find_mprsel_tuple(get_main_addr(ih->saddr()));
@@ -1073,30 +1515,14 @@ OLSR::forward_default(Packet* p, OLSR_msg& msg, OLSR_dup_tuple* dup_tuple, nsadd
 			// We have to introduce a random delay to avoid
 			// synchronization with neighbors.
 			enque_msg(new_msg, JITTER);
-			retransmitted = true;
+			if (new_msg.msg_type() == OLSR_TC_MSG || new_msg.msg_type() == OLSR_TC_REQ_MSG)
+				tc_bytes_ += new_msg.size();
 		}
 	}
 	
-	// Update duplicate tuple...
-	if (dup_tuple != NULL) {
-		dup_tuple->time()		= now + OLSR_DUP_HOLD_TIME;
-		dup_tuple->retransmitted()	= retransmitted;
-		dup_tuple->iface_list().push_back(local_iface);
-	}
-	// ...or create a new one
-	else {
-		OLSR_dup_tuple* new_dup = new OLSR_dup_tuple;
-		new_dup->addr()			= msg.orig_addr();
-		new_dup->seq_num()		= msg.msg_seq_num();
-		new_dup->time()			= now + OLSR_DUP_HOLD_TIME;
-		new_dup->retransmitted()	= retransmitted;
-		new_dup->iface_list().push_back(local_iface);
-		add_dup_tuple(new_dup);
-		// Schedules dup tuple deletion
-		OLSR_DupTupleTimer* dup_timer =
-			new OLSR_DupTupleTimer(this, new_dup);
-		dup_timer->resched(DELAY(new_dup->time()));
-	}
+	// Records the message in the Duplicate Set, which is only looked up
+	// for messages already considered for forwarding
+	state_.insert_dup(msg.orig_addr(), msg.msg_seq_num(), now, now + OLSR_DUP_HOLD_TIME);
 }
 
 ///
@@ -1148,7 +1574,7 @@ OLSR::forward_data(Packet* p) {
 /// \brief Enques an %OLSR message which will be sent with a delay of (0, delay].
 ///
 /// This buffering system is used in order to piggyback several %OLSR messages in
-/// a same %OLSR packet.
+/// a same %OLSR packet. All of them are sent once the first one is due.
 ///
 /// \param msg the %OLSR message which must be sent.
 /// \param delay maximum delay the %OLSR message is going to be buffered.
@@ -1157,49 +1583,52 @@ void
 OLSR::enque_msg(OLSR_msg& msg, double delay) {
 	assert(delay >= 0);
 	
+	// The timer is armed to the earliest deadline of the buffered messages
+	double deadline = CURRENT_TIME + delay;
+	if (msgs_.empty() || deadline < msgs_deadline_) {
+		msgs_deadline_ = deadline;
+		msg_timer_.resched(delay);
+	}
 	msgs_.push_back(msg);
-	OLSR_MsgTimer* timer = new OLSR_MsgTimer(this);
-	timer->resched(delay);
 }
 
 ///
 /// \brief Creates as many %OLSR packets as needed in order to send all buffered
 /// %OLSR messages.
 ///
-/// Maximum number of messages which can be contained in an %OLSR packet is
-/// dictated by OLSR_MAX_MSGS constant.
+/// Messages are bundled in order, as long as the length of the packet does
+/// not exceed max_pkt_size_ bytes. A longer message is sent on its own.
 ///
 void
 OLSR::send_pkt() {
-	int num_msgs = msgs_.size();
-	if (num_msgs == 0)
-		return;
-	
-	// Calculates the number of needed packets
-	int num_pkts = (num_msgs%OLSR_MAX_MSGS == 0) ? num_msgs/OLSR_MAX_MSGS :
-		(num_msgs/OLSR_MAX_MSGS + 1);
-	
-	for (int i = 0; i < num_pkts; i++) {
-		Packet* p		= allocpkt();
+	u_int32_t i = 0;
+	while (i < msgs_.size()) {
+		// msgs_[first..i) are bundled in the packet
+		u_int32_t first		= i;
+		u_int16_t pkt_len	= OLSR_PKT_HDR_SIZE;
+		do {
+			pkt_len += msgs_[i].size();
+			i++;
+		} while (i < msgs_.size() &&
+			pkt_len + msgs_[i].size() <= (u_int32_t)max_pkt_size_);
+		
+		Packet* p		= allocpkt(pkt_len - OLSR_PKT_HDR_SIZE);
 		struct hdr_cmn* ch	= HDR_CMN(p);
 		struct hdr_ip* ih	= HDR_IP(p);
 		OLSR_pkt* op		= PKT_OLSR(p);
 		
-		op->pkt_len()		= OLSR_PKT_HDR_SIZE;
+		op->pkt_len()		= pkt_len;
 		op->pkt_seq_num()	= pkt_seq();
-	
-		int j = 0;
-		for (std::vector<OLSR_msg>::iterator it = msgs_.begin(); it != msgs_.end(); it++) {
-			if (j == OLSR_MAX_MSGS)
-				break;
-			
-			op->pkt_body_[j++]	= *it;
-			op->count		= j;
-			op->pkt_len()		+= (*it).size();
-			
-			it = msgs_.erase(it);
-			it--;
-		}
+		op->count		= i - first;
+		unsigned char* buf	= p->accessdata();
+		for (u_int32_t j = first; j < i; j++)
+			buf += OLSR_pkt::put_msg(buf, msgs_[j]);
+		
+		bundle_pkts_++;
+		bundle_msgs_	+= op->count;
+		bundle_saved_	+= (op->count - 1) * (IP_HDR_LEN + UDP_HDR_LEN + OLSR_PKT_HDR_SIZE);
+		if ((u_int32_t)op->count > bundle_max_)
+			bundle_max_ = op->count;
 	
 		ch->ptype()		= PT_OLSR;
 		ch->direction()		= hdr_cmn::DOWN;
@@ -1220,6 +1649,7 @@ OLSR::send_pkt() {
 		
 		Scheduler::instance().schedule(target_, p, 0.0);
 	}
+	msgs_.clear();
 }
 
 ///
@@ -1320,6 +1750,16 @@ OLSR::send_hello() {
 ///
 /// \brief Creates a new %OLSR TC message which is buffered to be sent later on.
 ///
+/// If tc_delta_ is set, the message may only advertise the changes of the
+/// MPR Selector Set (see fill_delta_tc()).
+///
+/// If fisheye_ is set, the message is flooded with the next TTL of
+/// fisheye_ttl_, so that far nodes receive fewer TC messages than near ones.
+/// Its validity time is stretched by the TC intervals until the next TC
+/// message which reaches as far, so that the tuples it gives outlive that
+/// message by OLSR_TOP_HOLD_TIME, as for unscoped TC messages. Delta TC
+/// messages are not used then, since most nodes would miss some of them.
+///
 void
 OLSR::send_tc() {
 	OLSR_msg msg;
@@ -1327,6 +1767,12 @@ OLSR::send_tc() {
 	msg.vtime()		= OLSR::seconds_to_emf(OLSR_TOP_HOLD_TIME);
 	msg.orig_addr()		= ra_addr();
 	msg.ttl()		= 255;
+	if (fisheye_) {
+		u_int32_t gap	= fisheye_gap(fisheye_pos_);
+		msg.vtime()	= OLSR::seconds_to_emf(OLSR_TOP_HOLD_TIME + (gap - 1) * tc_ival());
+		msg.ttl()	= fisheye_ttl_[fisheye_pos_];
+		fisheye_pos_	= (fisheye_pos_ + 1) % fisheye_ttl_.size();
+	}
 	msg.hop_count()		= 0;
 	msg.msg_seq_num()	= msg_seq();
 	
@@ -1334,20 +1780,129 @@ OLSR::send_tc() {
 	msg.tc().reserved()	= 0;
 	msg.tc().count		= 0;
 	
-	for (mprselset_t::iterator it = mprselset().begin(); it != mprselset().end(); it++) {
-		OLSR_mprsel_tuple* mprsel_tuple = *it;
-		int count = msg.tc().count;
+	if (tc_delta_ && !fisheye_)
+		fill_delta_tc(msg.tc());
+	else {
+		for (mprselset_t::iterator it = mprselset().begin(); it != mprselset().end(); it++) {
+			OLSR_mprsel_tuple* mprsel_tuple = *it;
+			int count = msg.tc().count;
 
-		assert(count >= 0 && count < OLSR_MAX_ADDRS);
-		msg.tc().nb_main_addr(count) = mprsel_tuple->main_addr();
-		msg.tc().count++;
+			assert(count >= 0 && count < OLSR_MAX_ADDRS);
+			msg.tc().nb_main_addr(count) = mprsel_tuple->main_addr();
+			msg.tc().count++;
+		}
+		tc_full_++;
 	}
 
 	msg.msg_size()		= msg.size();
+	tc_bytes_		+= msg.size();
 	
 	enque_msg(msg, JITTER);
 }
 
+///
+/// \brief Fills a TC message advertising the MPR Selector Set in delta mode.
+///
+/// The ANSN is only increased when the advertised set changes, so that
+/// receivers can tell whether they missed a change. A full TC message is
+/// sent every tc_full_ival_ seconds, or earlier if some node requested it
+/// (see process_tc_req()). Otherwise the message only lists the MPR
+/// selectors added since the last TC message, followed by the removed ones,
+/// and its reserved field is OLSR_TC_DELTA plus the number of added ones.
+///
+/// \param tc the TC message, with no address.
+///
+void
+OLSR::fill_delta_tc(OLSR_tc& tc) {
+	double now = CURRENT_TIME;
+
+	std::vector<nsaddr_t> adv;
+	for (mprselset_t::iterator it = mprselset().begin(); it != mprselset().end(); it++)
+		adv.push_back((*it)->main_addr());
+	std::sort(adv.begin(), adv.end());
+
+	std::vector<nsaddr_t> added, removed;
+	std::set_difference(adv.begin(), adv.end(), tc_adv_.begin(), tc_adv_.end(),
+		std::back_inserter(added));
+	std::set_difference(tc_adv_.begin(), tc_adv_.end(), adv.begin(), adv.end(),
+		std::back_inserter(removed));
+	if (!added.empty() || !removed.empty())
+		tc_ansn_ = (tc_ansn_ + 1)%(OLSR_MAX_SEQ_NUM + 1);
+	tc.ansn() = tc_ansn_;
+
+	if (tc_full_req_ || now - tc_full_time_ >= tc_full_ival_ ||
+		added.size() + removed.size() > OLSR_MAX_ADDRS) {
+		for (u_int32_t i = 0; i < adv.size(); i++) {
+			assert(tc.count < OLSR_MAX_ADDRS);
+			tc.nb_main_addr(tc.count++) = adv[i];
+		}
+		tc_full_time_	= now;
+		tc_full_req_	= false;
+		tc_full_++;
+	}
+	else {
+		for (u_int32_t i = 0; i < added.size(); i++)
+			tc.nb_main_addr(tc.count++) = added[i];
+		for (u_int32_t i = 0; i < removed.size(); i++)
+			tc.nb_main_addr(tc.count++) = removed[i];
+		tc.reserved() = OLSR_TC_DELTA | added.size();
+		tc_deltas_++;
+	}
+	tc_adv_.swap(adv);
+}
+
+///
+/// \brief Gives the number of TC messages from the one at the given position
+/// of fisheye_ttl_ to the next one which is flooded as far.
+///
+/// \param pos the position in fisheye_ttl_.
+/// \return the number of TC intervals the message must be valid for.
+///
+u_int32_t
+OLSR::fisheye_gap(u_int32_t pos) {
+	u_int32_t n = fisheye_ttl_.size();
+	for (u_int32_t gap = 1; gap < n; gap++)
+		if (fisheye_ttl_[(pos + gap) % n] >= fisheye_ttl_[pos])
+			return gap;
+	return n;
+}
+
+///
+/// \brief Creates a new %OLSR TC request which is buffered to be sent later on.
+///
+/// It asks the originator of a delta TC message which could not be applied
+/// for a full TC message. Requests are sent to the same originator once per
+/// TC interval at most.
+///
+/// \param orig_addr main address of the originator.
+/// \param ttl number of hops from the originator.
+///
+void
+OLSR::send_tc_req(nsaddr_t orig_addr, u_int8_t ttl) {
+	double now = CURRENT_TIME;
+	std::map<nsaddr_t, double>::iterator it = tc_req_time_.find(orig_addr);
+	if (it != tc_req_time_.end() && now - it->second < tc_ival())
+		return;
+	tc_req_time_[orig_addr] = now;
+
+	OLSR_msg msg;
+	msg.msg_type()		= OLSR_TC_REQ_MSG;
+	msg.vtime()		= OLSR::seconds_to_emf(OLSR_TOP_HOLD_TIME);
+	msg.orig_addr()		= ra_addr();
+	msg.ttl()		= ttl;
+	msg.hop_count()		= 0;
+	msg.msg_seq_num()	= msg_seq();
+
+	msg.tc_req().count		= 1;
+	msg.tc_req().iface_addr(0)	= orig_addr;
+
+	msg.msg_size()		= msg.size();
+	tc_reqs_++;
+	tc_bytes_		+= msg.size();
+
+	enque_msg(msg, JITTER);
+}
+
 ///
 /// \brief Creates a new %OLSR MID message which is buffered to be sent later on.
 /// \warning This message is never invoked because there is no support for multiple interfaces.
@@ -1460,8 +2015,10 @@ OLSR::populate_nbset(OLSR_msg& msg) {
 	OLSR_hello& hello = msg.hello();
 	
 	OLSR_nb_tuple* nb_tuple = state_.find_nb_tuple(msg.orig_addr());
-	if (nb_tuple != NULL)
+	if (nb_tuple != NULL && nb_tuple->willingness() != hello.willingness()) {
 		nb_tuple->willingness() = hello.willingness();
+		state_.nbhood_changed();
+	}
 }
 
 ///
@@ -1606,6 +2163,7 @@ OLSR::mac_failed(Packet* p) {
 	if (link_tuple != NULL) {
 		link_tuple->lost_time()	= now + OLSR_NEIGHB_HOLD_TIME;
 		link_tuple->time()	= now + OLSR_NEIGHB_HOLD_TIME;
+		rtable_dirty_		= true;
 		nb_loss(link_tuple);
 	}
 	drop(p, DROP_RTR_MAC_CALLBACK);
@@ -1657,38 +2215,6 @@ OLSR::nb_loss(OLSR_link_tuple* tuple) {
  	rtable_computation();
 }
 
-///
-/// \brief Adds a duplicate tuple to the Duplicate Set.
-///
-/// \param tuple the duplicate tuple to be added.
-///
-void
-OLSR::add_dup_tuple(OLSR_dup_tuple* tuple) {
-	/*debug("%f: Node %d adds dup tuple: addr = %d seq_num = %d\n",
-		CURRENT_TIME,
-		OLSR::node_id(ra_addr()),
-		OLSR::node_id(tuple->addr()),
-		tuple->seq_num());*/
-	
-	state_.insert_dup_tuple(tuple);
-}
-
-///
-/// \brief Removes a duplicate tuple from the Duplicate Set.
-///
-/// \param tuple the duplicate tuple to be removed.
-///
-void
-OLSR::rm_dup_tuple(OLSR_dup_tuple* tuple) {
-	/*debug("%f: Node %d removes dup tuple: addr = %d seq_num = %d\n",
-		CURRENT_TIME,
-		OLSR::node_id(ra_addr()),
-		OLSR::node_id(tuple->addr()),
-		tuple->seq_num());*/
-	
-	state_.erase_dup_tuple(tuple);
-}
-
 ///
 /// \brief Adds a link tuple to the Link Set (and an associated neighbor tuple to the Neighbor Set).
 ///
@@ -1705,6 +2231,7 @@ OLSR::add_link_tuple(OLSR_link_tuple* tuple, u_int8_t  willingness) {
 		OLSR::node_id(tuple->nb_iface_addr()));
 
 	state_.insert_link_tuple(tuple);
+	rtable_dirty_ = true;
 	// Creates associated neighbor tuple
 	OLSR_nb_tuple* nb_tuple		= new OLSR_nb_tuple;
 	nb_tuple->nb_main_addr()	= get_main_addr(tuple->nb_iface_addr());
@@ -1737,6 +2264,7 @@ OLSR::rm_link_tuple(OLSR_link_tuple* tuple) {
 		OLSR::node_id(nb_addr));
 
 	state_.erase_link_tuple(tuple);
+	rtable_dirty_ = true;
 	
 	OLSR_nb_tuple* nb_tuple = state_.find_nb_tuple(nb_addr);
 	state_.erase_nb_tuple(nb_tuple);
@@ -1757,12 +2285,15 @@ OLSR::updated_link_tuple(OLSR_link_tuple* tuple) {
 	OLSR_nb_tuple* nb_tuple =
 		state_.find_nb_tuple(get_main_addr(tuple->nb_iface_addr()));
 	if (nb_tuple != NULL) {
+		u_int8_t status = nb_tuple->status();
 		if (use_mac() && tuple->lost_time() >= now)
 			nb_tuple->status() = OLSR_STATUS_NOT_SYM;
 		else if (tuple->sym_time() >= now)
 			nb_tuple->status() = OLSR_STATUS_SYM;
 		else
 			nb_tuple->status() = OLSR_STATUS_NOT_SYM;
+		if (nb_tuple->status() != status)
+			state_.nbhood_changed();
 	
 	debug("%f: Node %d has updated link tuple: nb_addr = %d status = %s\n",
 		now,
@@ -1886,6 +2417,7 @@ OLSR::add_topology_tuple(OLSR_topology_tuple* tuple) {
 		OLSR::node_id(tuple->last_addr()),
 		tuple->seq());
 
+	topology_tuple_changed(tuple, true);
 	state_.insert_topology_tuple(tuple);
 }
 
@@ -1903,6 +2435,7 @@ OLSR::rm_topology_tuple(OLSR_topology_tuple* tuple) {
 		OLSR::node_id(tuple->last_addr()),
 		tuple->seq());
 
+	topology_tuple_changed(tuple, false);
 	state_.erase_topology_tuple(tuple);
 }
 
@@ -1920,6 +2453,7 @@ OLSR::add_ifaceassoc_tuple(OLSR_iface_assoc_tuple* tuple) {
 		OLSR::node_id(tuple->iface_addr()));
 
 	state_.insert_ifaceassoc_tuple(tuple);
+	rtable_dirty_ = true;
 }
 
 ///
@@ -1936,6 +2470,7 @@ OLSR::rm_ifaceassoc_tuple(OLSR_iface_assoc_tuple* tuple) {
 		OLSR::node_id(tuple->iface_addr()));
 
 	state_.erase_ifaceassoc_tuple(tuple);
+	rtable_dirty_ = true;
 }
 
 ///
@@ -1967,27 +2502,6 @@ OLSR::seq_num_bigger_than(u_int16_t s1, u_int16_t s2) {
 		|| (s2 > s1 && s2-s1 > OLSR_MAX_SEQ_NUM/2);
 }
 
-///
-/// \brief This auxiliary function (defined in RFC 3626) is used for calculating the MPR Set.
-///
-/// \param tuple the neighbor tuple which has the main address of the node we are going to calculate its degree to.
-/// \return the degree of the node.
-///
-int
-OLSR::degree(OLSR_nb_tuple* tuple) {
-	int degree = 0;
-	for (nb2hopset_t::iterator it = nb2hopset().begin(); it != nb2hopset().end(); it++) {
-		OLSR_nb2hop_tuple* nb2hop_tuple = *it;
-		if (nb2hop_tuple->nb_main_addr() == tuple->nb_main_addr()) {
-			OLSR_nb_tuple* nb_tuple =
-				state_.find_nb_tuple(nb2hop_tuple->nb_main_addr());
-			if (nb_tuple == NULL)
-				degree++;
-		}
-	}
-	return degree;
-}
-
 ///
 /// \brief Converts a decimal number of seconds to the mantissa/exponent format.
 ///
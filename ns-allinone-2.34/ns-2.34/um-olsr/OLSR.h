@@ -42,6 +42,7 @@
 #include <timer-handler.h>
 #include <random.h>
 #include <vector>
+#include <map>
 
 /********** Useful macros **********/
 
@@ -156,13 +157,19 @@
 #define JITTER			(Random::uniform()*OLSR_MAXJITTER)
 
 
+/// Number of slots of the tuple expiry wheel (must be a power of 2).
+#define OLSR_WHEEL_SLOTS	64
+/// Time spanned by every slot of the tuple expiry wheel, in seconds.
+#define OLSR_WHEEL_TICK		0.5
+
+
 class OLSR;			// forward declaration
 
 
 /********** Timers **********/
 
 
-/// Timer for sending an enqued message.
+/// Timer for sending the enqued messages.
 class OLSR_MsgTimer : public TimerHandler {
 public:
 	OLSR_MsgTimer(OLSR* agent) : TimerHandler() {
@@ -203,23 +210,66 @@ protected:
 };
 
 
-/// Timer for removing duplicate tuples: OLSR_dup_tuple.
-class OLSR_DupTupleTimer : public TimerHandler {
+///
+/// \brief Base class of the timers removing the tuples of the repositories.
+///
+/// They are not scheduled on their own: resched() hands them to the expiry
+/// wheel of their agent, which calls expire() once they are due.
+///
+class OLSR_TupleTimer {
+	friend class OLSR_ExpiryWheel;
 public:
-	OLSR_DupTupleTimer(OLSR* agent, OLSR_dup_tuple* tuple) : TimerHandler() {
-		agent_ = agent;
-		tuple_ = tuple;
-	}
+	OLSR_TupleTimer(OLSR* agent) { agent_ = agent; }
+	virtual ~OLSR_TupleTimer() {}
+	void		resched(double);
+protected:
+	OLSR*	agent_;			///< OLSR agent which created the timer.
+	virtual void expire(Event* e) = 0;
+};
+
+
+///
+/// \brief Timer which expires all the tuple timers of an agent.
+///
+/// Tuple timers are kept in a hashed wheel of OLSR_WHEEL_SLOTS slots, each
+/// one spanning OLSR_WHEEL_TICK seconds, so only this handler is known by
+/// the scheduler. It is scheduled at the time of the earliest tuple timer,
+/// and then expires every due one, in the order the scheduler would have
+/// dispatched them.
+///
+class OLSR_ExpiryWheel : public TimerHandler {
+	/// A tuple timer and the time at which it is due.
+	struct entry {
+		double			time_;
+		long			tick_;	///< Number of the slot, counting from time 0.
+		u_int32_t		seq_;	///< Order of scheduling.
+		OLSR_TupleTimer*	timer_;
+
+		inline bool operator<(const entry& e) const {
+			return time_ < e.time_ || (time_ == e.time_ && seq_ < e.seq_);
+		}
+	};
+
+	std::vector<entry>	slots_[OLSR_WHEEL_SLOTS];
+	std::vector<entry>	due_;		///< Timers being expired.
+	long			cursor_;	///< No timer lies in a slot before this one.
+	u_int32_t		size_;		///< Number of timers in the wheel.
+	u_int32_t		seq_;		///< Order of the next timer to be scheduled.
+	double			next_;		///< Time of the earliest timer, or -1.
+	bool			sweeping_;	///< Whether due timers are being expired.
+
+	void		reschedule();
+public:
+	OLSR_ExpiryWheel();
+	void		schedule(OLSR_TupleTimer*, double);
+	inline u_int32_t	size() { return size_; }
 protected:
-	OLSR*		agent_;	///< OLSR agent which created the timer.
-	OLSR_dup_tuple*	tuple_;	///< OLSR_dup_tuple which must be removed.
-	
 	virtual void expire(Event* e);
 };
 
 
 /// Timer for removing link tuples: OLSR_link_tuple.
-class OLSR_LinkTupleTimer : public TimerHandler {
+class OLSR_LinkTupleTimer : public OLSR_TupleTimer, public OLSR_pooled<OLSR_LinkTupleTimer> {
 	///
 	/// \brief A flag which tells if the timer has expired (at least) once or not.
 	///
@@ -229,13 +279,11 @@ class OLSR_LinkTupleTimer : public TimerHandler {
 	///
 	bool			first_time_;
 public:
-	OLSR_LinkTupleTimer(OLSR* agent, OLSR_link_tuple* tuple) : TimerHandler() {
-		agent_		= agent;
+	OLSR_LinkTupleTimer(OLSR* agent, OLSR_link_tuple* tuple) : OLSR_TupleTimer(agent) {
 		tuple_		= tuple;
 		first_time_	= true;
 	}
 protected:
-	OLSR*			agent_;	///< OLSR agent which created the timer.
 	OLSR_link_tuple*	tuple_;	///< OLSR_link_tuple which must be removed.
 	
 	virtual void expire(Event* e);
@@ -243,14 +291,12 @@ protected:
 
 
 /// Timer for removing nb2hop tuples: OLSR_nb2hop_tuple.
-class OLSR_Nb2hopTupleTimer : public TimerHandler {
+class OLSR_Nb2hopTupleTimer : public OLSR_TupleTimer, public OLSR_pooled<OLSR_Nb2hopTupleTimer> {
 public:
-	OLSR_Nb2hopTupleTimer(OLSR* agent, OLSR_nb2hop_tuple* tuple) : TimerHandler() {
-		agent_ = agent;
+	OLSR_Nb2hopTupleTimer(OLSR* agent, OLSR_nb2hop_tuple* tuple) : OLSR_TupleTimer(agent) {
 		tuple_ = tuple;
 	}
 protected:
-	OLSR*			agent_;	///< OLSR agent which created the timer.
 	OLSR_nb2hop_tuple*	tuple_;	///< OLSR_nb2hop_tuple which must be removed.
 	
 	virtual void expire(Event* e);
@@ -258,14 +304,12 @@ protected:
 
 
 /// Timer for removing MPR selector tuples: OLSR_mprsel_tuple.
-class OLSR_MprSelTupleTimer : public TimerHandler {
+class OLSR_MprSelTupleTimer : public OLSR_TupleTimer, public OLSR_pooled<OLSR_MprSelTupleTimer> {
 public:
-	OLSR_MprSelTupleTimer(OLSR* agent, OLSR_mprsel_tuple* tuple) : TimerHandler() {
-		agent_ = agent;
+	OLSR_MprSelTupleTimer(OLSR* agent, OLSR_mprsel_tuple* tuple) : OLSR_TupleTimer(agent) {
 		tuple_ = tuple;
 	}
 protected:
-	OLSR*			agent_;	///< OLSR agent which created the timer.
 	OLSR_mprsel_tuple*	tuple_;	///< OLSR_mprsel_tuple which must be removed.
 	
 	virtual void expire(Event* e);
@@ -273,14 +317,12 @@ protected:
 
 
 /// Timer for removing topology tuples: OLSR_topology_tuple.
-class OLSR_TopologyTupleTimer : public TimerHandler {
+class OLSR_TopologyTupleTimer : public OLSR_TupleTimer, public OLSR_pooled<OLSR_TopologyTupleTimer> {
 public:
-	OLSR_TopologyTupleTimer(OLSR* agent, OLSR_topology_tuple* tuple) : TimerHandler() {
-		agent_ = agent;
+	OLSR_TopologyTupleTimer(OLSR* agent, OLSR_topology_tuple* tuple) : OLSR_TupleTimer(agent) {
 		tuple_ = tuple;
 	}
 protected:
-	OLSR*			agent_;	///< OLSR agent which created the timer.
 	OLSR_topology_tuple*	tuple_;	///< OLSR_topology_tuple which must be removed.
 	
 	virtual void expire(Event* e);
@@ -288,14 +330,12 @@ protected:
 
 
 /// Timer for removing interface association tuples: OLSR_iface_assoc_tuple.
-class OLSR_IfaceAssocTupleTimer : public TimerHandler {
+class OLSR_IfaceAssocTupleTimer : public OLSR_TupleTimer, public OLSR_pooled<OLSR_IfaceAssocTupleTimer> {
 public:
-	OLSR_IfaceAssocTupleTimer(OLSR* agent, OLSR_iface_assoc_tuple* tuple) : TimerHandler() {
-		agent_ = agent;
+	OLSR_IfaceAssocTupleTimer(OLSR* agent, OLSR_iface_assoc_tuple* tuple) : OLSR_TupleTimer(agent) {
 		tuple_ = tuple;
 	}
 protected:
-	OLSR*			agent_;	///< OLSR agent which created the timer.
 	OLSR_iface_assoc_tuple*	tuple_;	///< OLSR_iface_assoc_tuple which must be removed.
 	
 	virtual void expire(Event* e);
@@ -317,12 +357,12 @@ class OLSR : public Agent {
 	friend class OLSR_HelloTimer;
 	friend class OLSR_TcTimer;
 	friend class OLSR_MidTimer;
-	friend class OLSR_DupTupleTimer;
 	friend class OLSR_LinkTupleTimer;
 	friend class OLSR_Nb2hopTupleTimer;
 	friend class OLSR_MprSelTupleTimer;
 	friend class OLSR_TopologyTupleTimer;
 	friend class OLSR_IfaceAssocTupleTimer;
+	friend class OLSR_TupleTimer;
 	friend class OLSR_MsgTimer;
 	
 	/// Address of the routing agent.
@@ -345,6 +385,17 @@ class OLSR : public Agent {
 	int		willingness_;
 	/// Determines if layer 2 notifications are enabled or not.
 	int		use_mac_;
+	/// Determines if TC messages only advertise the changes of the MPR
+	/// Selector Set (see send_tc()).
+	int		tc_delta_;
+	/// Maximum interval between two full TC messages when tc_delta_ is set.
+	int		tc_full_ival_;
+	/// Determines if TC messages are flooded with the TTLs of fisheye_ttl_
+	/// in turn rather than network-wide (see send_tc()).
+	int		fisheye_;
+	/// Determines if the wall clock time spent processing control packets
+	/// and TC messages is measured (see ctrl_stats and tc_stats).
+	int		timing_;
 	
 	/// Routing table.
 	OLSR_rtable		rtable_;
@@ -352,6 +403,68 @@ class OLSR : public Agent {
 	OLSR_state		state_;
 	/// A list of pending messages which are buffered awaiting for being sent.
 	std::vector<OLSR_msg>	msgs_;
+	/// Time at which the buffered messages are sent.
+	double			msgs_deadline_;
+	/// Maximum length (in bytes) of the %OLSR packets bundling buffered messages.
+	int			max_pkt_size_;
+	/// Number of %OLSR packets sent.
+	u_int32_t		bundle_pkts_;
+	/// Number of %OLSR messages sent.
+	u_int32_t		bundle_msgs_;
+	/// Bytes of headers saved by bundling messages rather than sending
+	/// every one in its own packet.
+	u_int32_t		bundle_saved_;
+	/// Most %OLSR messages sent in one packet.
+	u_int32_t		bundle_max_;
+	/// Version of the neighborhood the MPR Set was computed for.
+	u_int32_t		mpr_version_;
+	/// Whether the routing table must be computed again. It is set whenever
+	/// the Link Set, the Interface Association Set or a topology tuple which
+	/// may change several routes is modified, and when the time of a link is
+	/// brought forward.
+	bool			rtable_dirty_;
+	/// Version of the neighborhood the routing table was computed for.
+	u_int32_t		rtable_version_;
+	/// Time at which the first link followed by the routing table expires.
+	double			rtable_expiry_;
+	/// Number of times the routing table was computed.
+	u_int32_t		rtable_builds_;
+	/// Number of topology changes which only updated the route to one destination.
+	u_int32_t		rtable_updates_;
+	/// Sorted main addresses of the MPR selectors advertised by the last
+	/// TC message, when tc_delta_ is set.
+	std::vector<nsaddr_t>	tc_adv_;
+	/// ANSN of the last TC message, when tc_delta_ is set. It is only
+	/// increased when the advertised set changes.
+	u_int16_t		tc_ansn_;
+	/// Time at which the last full TC message was sent.
+	double			tc_full_time_;
+	/// Whether the next TC message must be a full one.
+	bool			tc_full_req_;
+	/// Time at which a full TC message was last requested to every originator.
+	std::map<nsaddr_t, double>	tc_req_time_;
+	/// Number of full and delta TC messages generated.
+	u_int32_t		tc_full_;
+	u_int32_t		tc_deltas_;
+	/// Number of TC requests generated.
+	u_int32_t		tc_reqs_;
+	/// Number of delta TC messages which could not be applied.
+	u_int32_t		tc_gaps_;
+	/// Bytes of TC messages and TC requests sent, forwarded ones included.
+	u_int32_t		tc_bytes_;
+	/// Number of TC messages processed.
+	u_int32_t		tc_rcvd_;
+	/// Wall clock time spent processing them, in seconds.
+	double			tc_time_;
+	/// TTLs of successive TC messages when fisheye_ is set.
+	std::vector<u_int8_t>	fisheye_ttl_;
+	/// Position in fisheye_ttl_ of the TTL of the next TC message.
+	u_int32_t		fisheye_pos_;
+	
+	/// Number of %OLSR packets received.
+	u_int32_t	ctrl_pkts_;
+	/// Wall clock time spent processing them, in seconds.
+	double		ctrl_time_;
 	
 protected:
 	PortClassifier*	dmux_;		///< For passing packets up to agents.
@@ -360,6 +473,8 @@ protected:
 	OLSR_HelloTimer	hello_timer_;	///< Timer for sending HELLO messages.
 	OLSR_TcTimer	tc_timer_;	///< Timer for sending TC messages.
 	OLSR_MidTimer	mid_timer_;	///< Timer for sending MID messages.
+	OLSR_MsgTimer	msg_timer_;	///< Timer for sending the buffered messages.
+	OLSR_ExpiryWheel	expiry_wheel_;	///< Timer removing the expired tuples.
 	
 	/// Increments packet sequence number and returns the new value.
 	inline u_int16_t	pkt_seq() {
@@ -386,24 +501,29 @@ protected:
 	inline nbset_t&		nbset()		{ return state_.nbset(); }
 	inline nb2hopset_t&	nb2hopset()	{ return state_.nb2hopset(); }
 	inline topologyset_t&	topologyset()	{ return state_.topologyset(); }
-	inline dupset_t&	dupset()	{ return state_.dupset(); }
 	inline ifaceassocset_t&	ifaceassocset()	{ return state_.ifaceassocset(); }
 	
 	void		recv_olsr(Packet*);
 	
 	void		mpr_computation();
 	void		rtable_computation();
+	void		topology_tuple_changed(OLSR_topology_tuple*, bool);
 	
 	void		process_hello(OLSR_msg&, nsaddr_t, nsaddr_t);
 	void		process_tc(OLSR_msg&, nsaddr_t);
+	bool		process_delta_tc(OLSR_msg&);
+	void		process_tc_req(OLSR_msg&);
 	void		process_mid(OLSR_msg&, nsaddr_t);
 	
-	void		forward_default(Packet*, OLSR_msg&, OLSR_dup_tuple*, nsaddr_t);
+	void		forward_default(Packet*, OLSR_msg&, nsaddr_t);
 	void		forward_data(Packet*);
 	
 	void		enque_msg(OLSR_msg&, double);
 	void		send_hello();
 	void		send_tc();
+	void		fill_delta_tc(OLSR_tc&);
+	u_int32_t	fisheye_gap(u_int32_t);
+	void		send_tc_req(nsaddr_t, u_int8_t);
 	void		send_mid();
 	void		send_pkt();
 	
@@ -417,8 +537,6 @@ protected:
 	void		set_mid_timer();
 
 	void		nb_loss(OLSR_link_tuple*);
-	void		add_dup_tuple(OLSR_dup_tuple*);
-	void		rm_dup_tuple(OLSR_dup_tuple*);
 	void		add_link_tuple(OLSR_link_tuple*, u_int8_t);
 	void		rm_link_tuple(OLSR_link_tuple*);
 	void		updated_link_tuple(OLSR_link_tuple*);
@@ -434,7 +552,6 @@ protected:
 	void		rm_ifaceassoc_tuple(OLSR_iface_assoc_tuple*);
 	
 	nsaddr_t	get_main_addr(nsaddr_t);
-	int		degree(OLSR_nb_tuple*);
 
 	static bool	seq_num_bigger_than(u_int16_t, u_int16_t);
 
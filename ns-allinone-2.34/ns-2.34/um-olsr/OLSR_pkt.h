@@ -37,6 +37,8 @@
 #define OLSR_TC_MSG		2
 /// %OLSR MID message type.
 #define OLSR_MID_MSG		3
+/// %OLSR TC request message type (private use, see OLSR::send_tc_req()).
+#define OLSR_TC_REQ_MSG	128
 
 /********** Packets stuff **********/
 
@@ -56,9 +58,6 @@
 #define ADDR_SIZE	4
 #endif
 
-/// Maximum number of messages per packet.
-#define OLSR_MAX_MSGS		4
-
 /// Maximum number of hellos per message (4 possible link types * 3 possible nb types).
 #define OLSR_MAX_HELLOS		12
 
@@ -80,6 +79,10 @@
 /// Size (in bytes) of tc header.
 #define OLSR_TC_HDR_SIZE	4
 
+/// Flag of the reserved field of a delta TC message (see OLSR::send_tc()).
+/// The other bits give the number of added addresses.
+#define OLSR_TC_DELTA		0x8000
+
 /// Auxiliary struct which is part of the %OLSR HELLO message (struct OLSR_hello).
 typedef struct OLSR_hello_msg {
 
@@ -191,6 +194,8 @@ typedef struct OLSR_msg {
 	inline	OLSR_hello&	hello()		{ return msg_body_.hello_; }
 	inline	OLSR_tc&	tc()		{ return msg_body_.tc_; }
 	inline	OLSR_mid&	mid()		{ return msg_body_.mid_; }
+	/// TC requests list the originators asked for a full TC message.
+	inline	OLSR_mid&	tc_req()	{ return msg_body_.mid_; }
 	
 	inline u_int32_t size() {
 		u_int32_t sz = OLSR_MSG_HDR_SIZE;
@@ -198,24 +203,149 @@ typedef struct OLSR_msg {
 			sz += hello().size();
 		else if (msg_type() == OLSR_TC_MSG)
 			sz += tc().size();
-		else if (msg_type() == OLSR_MID_MSG)
+		else if (msg_type() == OLSR_MID_MSG || msg_type() == OLSR_TC_REQ_MSG)
 			sz += mid().size();
 		return sz;
 	}
 
 } OLSR_msg;
 
-/// %OLSR packet.
+///
+/// \brief %OLSR packet.
+///
+/// Only the packet header is stored in the ns header of the packet. The
+/// messages it carries are serialized, in the format of RFC 3626, into the
+/// data buffer of the packet, which is pkt_len() - OLSR_PKT_HDR_SIZE bytes
+/// long, so the size of the header does not depend on the size of the
+/// largest message. They are written by put_msg() and read back by
+/// get_msg().
+///
 typedef struct OLSR_pkt {
 
 	u_int16_t	pkt_len_;			///< Packet length (in bytes).
 	u_int16_t	pkt_seq_num_;			///< Packet sequence number.
-	OLSR_msg	pkt_body_[OLSR_MAX_MSGS];	///< Packet body.
-	int		count;				///< Number of OLSR_msg contained in pkt_body_.
+	int		count;				///< Number of messages contained in the packet body.
 	
 	inline	u_int16_t&	pkt_len()	{ return pkt_len_; }
 	inline	u_int16_t&	pkt_seq_num()	{ return pkt_seq_num_; }
-	inline	OLSR_msg&	msg(int i)	{ return pkt_body_[i]; }
+	
+	///
+	/// \brief Serializes a message.
+	/// \param buf	buffer of at least msg.size() bytes.
+	/// \param msg	message to be serialized. Its sizes must be up to date.
+	/// \return the number of bytes written.
+	///
+	inline static u_int32_t put_msg(unsigned char* buf, OLSR_msg& msg) {
+		unsigned char* start = buf;
+		assert(msg.msg_size() == msg.size());
+		
+		buf[0]	= msg.msg_type();
+		buf[1]	= msg.vtime();
+		put16(buf + 2, msg.msg_size());
+		put32(buf + 4, msg.orig_addr());
+		buf[8]	= msg.ttl();
+		buf[9]	= msg.hop_count();
+		put16(buf + 10, msg.msg_seq_num());
+		buf += OLSR_MSG_HDR_SIZE;
+		
+		if (msg.msg_type() == OLSR_HELLO_MSG) {
+			OLSR_hello& hello = msg.hello();
+			put16(buf, hello.reserved());
+			buf[2]	= hello.htime();
+			buf[3]	= hello.willingness();
+			buf += OLSR_HELLO_HDR_SIZE;
+			for (int i = 0; i < hello.count; i++) {
+				OLSR_hello_msg& hello_msg = hello.hello_msg(i);
+				assert(hello_msg.link_msg_size() == hello_msg.size());
+				buf[0]	= hello_msg.link_code();
+				buf[1]	= hello_msg.reserved();
+				put16(buf + 2, hello_msg.link_msg_size());
+				buf += OLSR_HELLO_MSG_HDR_SIZE;
+				for (int j = 0; j < hello_msg.count; j++, buf += ADDR_SIZE)
+					put_addr(buf, hello_msg.nb_iface_addr(j));
+			}
+		}
+		else if (msg.msg_type() == OLSR_TC_MSG) {
+			OLSR_tc& tc = msg.tc();
+			put16(buf, tc.ansn());
+			put16(buf + 2, tc.reserved());
+			buf += OLSR_TC_HDR_SIZE;
+			for (int i = 0; i < tc.count; i++, buf += ADDR_SIZE)
+				put_addr(buf, tc.nb_main_addr(i));
+		}
+		else if (msg.msg_type() == OLSR_MID_MSG ||
+			msg.msg_type() == OLSR_TC_REQ_MSG) {
+			OLSR_mid& mid = msg.mid();
+			for (int i = 0; i < mid.count; i++, buf += ADDR_SIZE)
+				put_addr(buf, mid.iface_addr(i));
+		}
+		return buf - start;
+	}
+	
+	///
+	/// \brief Deserializes a message of a packet.
+	/// \param p	the packet.
+	/// \param i	index of the message in the packet.
+	/// \param msg	message where the i-th one of the packet is read into.
+	/// \param hdr_only	whether only the message header must be read.
+	///
+	inline static void get_msg(const Packet* p, int i, OLSR_msg& msg, bool hdr_only = false) {
+		assert(i >= 0 && i < access(p)->count);
+		const unsigned char* buf = p->accessdata();
+		for (; i > 0; i--)
+			buf += get16(buf + 2);
+		
+		msg.msg_type()		= buf[0];
+		msg.vtime()		= buf[1];
+		msg.msg_size()		= get16(buf + 2);
+		msg.orig_addr()		= get32(buf + 4);
+		msg.ttl()		= buf[8];
+		msg.hop_count()		= buf[9];
+		msg.msg_seq_num()	= get16(buf + 10);
+		if (hdr_only)
+			return;
+		
+		const unsigned char* end = buf + msg.msg_size();
+		buf += OLSR_MSG_HDR_SIZE;
+		if (msg.msg_type() == OLSR_HELLO_MSG) {
+			OLSR_hello& hello	= msg.hello();
+			hello.reserved()	= get16(buf);
+			hello.htime()		= buf[2];
+			hello.willingness()	= buf[3];
+			hello.count		= 0;
+			for (buf += OLSR_HELLO_HDR_SIZE; buf < end; hello.count++) {
+				assert(hello.count < OLSR_MAX_HELLOS);
+				OLSR_hello_msg& hello_msg	= hello.hello_msg(hello.count);
+				hello_msg.link_code()		= buf[0];
+				hello_msg.reserved()		= buf[1];
+				hello_msg.link_msg_size()	= get16(buf + 2);
+				hello_msg.count			=
+					(hello_msg.link_msg_size() - OLSR_HELLO_MSG_HDR_SIZE) / ADDR_SIZE;
+				assert(hello_msg.count <= OLSR_MAX_ADDRS);
+				buf += OLSR_HELLO_MSG_HDR_SIZE;
+				for (int j = 0; j < hello_msg.count; j++, buf += ADDR_SIZE)
+					hello_msg.nb_iface_addr(j) = get_addr(buf);
+			}
+		}
+		else if (msg.msg_type() == OLSR_TC_MSG) {
+			OLSR_tc& tc	= msg.tc();
+			tc.ansn()	= get16(buf);
+			tc.reserved()	= get16(buf + 2);
+			buf += OLSR_TC_HDR_SIZE;
+			tc.count	= (end - buf) / ADDR_SIZE;
+			assert(tc.count <= OLSR_MAX_ADDRS);
+			for (int j = 0; j < tc.count; j++, buf += ADDR_SIZE)
+				tc.nb_main_addr(j) = get_addr(buf);
+		}
+		else if (msg.msg_type() == OLSR_MID_MSG ||
+			msg.msg_type() == OLSR_TC_REQ_MSG) {
+			OLSR_mid& mid	= msg.mid();
+			mid.count	= (end - buf) / ADDR_SIZE;
+			assert(mid.count <= OLSR_MAX_ADDRS);
+			for (int j = 0; j < mid.count; j++, buf += ADDR_SIZE)
+				mid.iface_addr(j) = get_addr(buf);
+		}
+	}
 	
 	static int offset_;
 	inline static int& offset() { return offset_; }
@@ -223,6 +353,31 @@ typedef struct OLSR_pkt {
 		return (struct OLSR_pkt*)p->access(offset_);
 	}
 
+private:
+	// Fields are serialized in network byte order. Addresses are IPv4 ones,
+	// padded with zeros up to ADDR_SIZE bytes.
+	inline static void put16(unsigned char* buf, u_int16_t v) {
+		buf[0] = v >> 8;
+		buf[1] = v;
+	}
+	inline static void put32(unsigned char* buf, u_int32_t v) {
+		put16(buf, v >> 16);
+		put16(buf + 2, v);
+	}
+	inline static void put_addr(unsigned char* buf, nsaddr_t addr) {
+		memset(buf, 0, ADDR_SIZE - 4);
+		put32(buf + ADDR_SIZE - 4, addr);
+	}
+	inline static u_int16_t get16(const unsigned char* buf) {
+		return (buf[0] << 8) | buf[1];
+	}
+	inline static u_int32_t get32(const unsigned char* buf) {
+		return ((u_int32_t)get16(buf) << 16) | get16(buf + 2);
+	}
+	inline static nsaddr_t get_addr(const unsigned char* buf) {
+		return get32(buf + ADDR_SIZE - 4);
+	}
+
 } OLSR_pkt;
 
 #endif
@@ -91,10 +91,12 @@ OLSR_printer::print_ip_hdr(FILE* out, struct hdr_ip* ih) {
 /// \brief Prints a given OLSR packet into a given file.
 /// \warning This function is actually not used.
 /// \param out	File where the %OLSR packet is going to be written.
-/// \param pkt	%OLSR packet to be written.
+/// \param p	packet whose %OLSR header and messages are going to be written.
 ///
 void
-OLSR_printer::print_olsr_pkt(FILE* out, OLSR_pkt* pkt) {
+OLSR_printer::print_olsr_pkt(FILE* out, Packet* p) {
+	OLSR_pkt* pkt = PKT_OLSR(p);
+	OLSR_msg msg;
 		
 	fprintf(out,
 		"  OLSR PACKET\n\tlength = %d\n\tseq_num = %d\n\t------------\n",
@@ -102,7 +104,8 @@ OLSR_printer::print_olsr_pkt(FILE* out, OLSR_pkt* pkt) {
 		pkt->pkt_seq_num());
 	
 	for (int i = 0; i < pkt->count; i++) {
-		print_olsr_msg(out, pkt->msg(i));
+		OLSR_pkt::get_msg(p, i, msg);
+		print_olsr_msg(out, msg);
 		fprintf(out, "\t------------\n");
 	}
 	fprintf(out, "\n");
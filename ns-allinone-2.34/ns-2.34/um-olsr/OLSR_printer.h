@@ -45,7 +45,7 @@ protected:
 	static void	print_mprselset(Trace*, mprselset_t&);
 	static void	print_topologyset(Trace*, topologyset_t&);
 	
-	static void	print_olsr_pkt(FILE*, OLSR_pkt*);
+	static void	print_olsr_pkt(FILE*, Packet*);
 	static void	print_olsr_msg(FILE*, OLSR_msg&);
 	static void	print_olsr_hello(FILE*, OLSR_hello&);
 	static void	print_olsr_tc(FILE*, OLSR_tc&);
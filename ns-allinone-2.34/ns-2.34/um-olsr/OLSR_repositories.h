@@ -29,9 +29,10 @@
 #include <set>
 #include <vector>
 #include <config.h>
+#include <olsr/OLSR_pool.h>
 
 /// An %OLSR's routing table entry.
-typedef struct OLSR_rt_entry {
+typedef struct OLSR_rt_entry : public OLSR_pooled<OLSR_rt_entry> {
 	nsaddr_t	dest_addr_;	///< Address of the destination node.
 	nsaddr_t	next_addr_;	///< Address of the next hop.
 	nsaddr_t	iface_addr_;	///< Address of the local interface.
@@ -44,7 +45,7 @@ typedef struct OLSR_rt_entry {
 } OLSR_rt_entry;
 
 /// An Interface Association Tuple.
-typedef struct OLSR_iface_assoc_tuple {
+typedef struct OLSR_iface_assoc_tuple : public OLSR_pooled<OLSR_iface_assoc_tuple> {
 	/// Interface address of a node.
 	nsaddr_t	iface_addr_;
 	/// Main address of the node.
@@ -58,7 +59,7 @@ typedef struct OLSR_iface_assoc_tuple {
 } OLSR_iface_assoc_tuple;
 
 /// A Link Tuple.
-typedef struct OLSR_link_tuple {
+typedef struct OLSR_link_tuple : public OLSR_pooled<OLSR_link_tuple> {
 	/// Interface address of the local node.
 	nsaddr_t	local_iface_addr_;
 	/// Interface address of the neighbor node.
@@ -81,7 +82,7 @@ typedef struct OLSR_link_tuple {
 } OLSR_link_tuple;
 
 /// A Neighbor Tuple.
-typedef struct OLSR_nb_tuple {
+typedef struct OLSR_nb_tuple : public OLSR_pooled<OLSR_nb_tuple> {
 	/// Main address of a neighbor node.
 	nsaddr_t nb_main_addr_;
 	/// Neighbor Type and Link Type at the four less significative digits.
@@ -95,7 +96,7 @@ typedef struct OLSR_nb_tuple {
 } OLSR_nb_tuple;
 
 /// A 2-hop Tuple.
-typedef struct OLSR_nb2hop_tuple {
+typedef struct OLSR_nb2hop_tuple : public OLSR_pooled<OLSR_nb2hop_tuple> {
 	/// Main address of a neighbor.
 	nsaddr_t	nb_main_addr_;
 	/// Main address of a 2-hop neighbor with a symmetric link to nb_main_addr.
@@ -109,7 +110,7 @@ typedef struct OLSR_nb2hop_tuple {
 } OLSR_nb2hop_tuple;
 
 /// An MPR-Selector Tuple.
-typedef struct OLSR_mprsel_tuple {
+typedef struct OLSR_mprsel_tuple : public OLSR_pooled<OLSR_mprsel_tuple> {
 	/// Main address of a node which have selected this node as a MPR.
 	nsaddr_t	main_addr_;
 	/// Time at which this tuple expires and must be removed.
@@ -119,31 +120,35 @@ typedef struct OLSR_mprsel_tuple {
 	inline double&		time()		{ return time_; }
 } OLSR_mprsel_tuple;
 
-/// The type "list of interface addresses"
-typedef std::vector<nsaddr_t> addr_list_t;
+/// Number of sequence numbers of an originator the Duplicate Set keeps track of.
+#define OLSR_DUP_WINDOW	64
 
-/// A Duplicate Tuple
-typedef struct OLSR_dup_tuple {
-	/// Originator address of the message.
-	nsaddr_t	addr_;
-	/// Message sequence number.
-	u_int16_t	seq_num_;
-	/// Indicates whether the message has been retransmitted or not.
-	bool		retransmitted_;
-	/// List of interfaces which the message has been received on.
-	addr_list_t	iface_list_;
-	/// Time at which this tuple expires and must be removed.
+///
+/// \brief Duplicate Set entries of an originator.
+///
+/// Rather than a tuple per message, the messages of an originator which have
+/// been considered for forwarding are recorded in a bitmap of the
+/// OLSR_DUP_WINDOW sequence numbers up to the highest one, so that duplicates
+/// are found without allocating memory nor scheduling timers. Since a node
+/// has a single interface, the only information a duplicate tuple held was
+/// whether it existed.
+///
+typedef struct OLSR_dup_window {
+	/// Highest sequence number recorded.
+	u_int16_t	top_;
+	/// Bit i is set if sequence number top_ - i has been recorded.
+	u_int64_t	bits_;
+	/// Time at which the entries expire and must be forgotten, which is
+	/// given by the last one recorded.
 	double		time_;
 	
-	inline nsaddr_t&	addr()		{ return addr_; }
-	inline u_int16_t&	seq_num()	{ return seq_num_; }
-	inline bool&		retransmitted()	{ return retransmitted_; }
-	inline addr_list_t&	iface_list()	{ return iface_list_; }
+	inline u_int16_t&	top()		{ return top_; }
+	inline u_int64_t&	bits()		{ return bits_; }
 	inline double&		time()		{ return time_; }
-} OLSR_dup_tuple;
+} OLSR_dup_window;
 
 /// A Topology Tuple
-typedef struct OLSR_topology_tuple {
+typedef struct OLSR_topology_tuple : public OLSR_pooled<OLSR_topology_tuple> {
 	/// Main address of the destination.
 	nsaddr_t	dest_addr_;
 	/// Main address of a node which is a neighbor of the destination.
@@ -152,11 +157,14 @@ typedef struct OLSR_topology_tuple {
 	u_int16_t	seq_;
 	/// Time at which this tuple expires and must be removed.
 	double		time_;
+	/// Order of insertion into the Topology Set, which is the order of the set.
+	u_int32_t	order_;
 	
 	inline nsaddr_t&	dest_addr()	{ return dest_addr_; }
 	inline nsaddr_t&	last_addr()	{ return last_addr_; }
 	inline u_int16_t&	seq()		{ return seq_; }
 	inline double&		time()		{ return time_; }
+	inline u_int32_t&	order()		{ return order_; }
 } OLSR_topology_tuple;
 
 
@@ -166,7 +174,6 @@ typedef std::vector<OLSR_link_tuple*>		linkset_t;	///< Link Set type.
 typedef std::vector<OLSR_nb_tuple*>		nbset_t;	///< Neighbor Set type.
 typedef std::vector<OLSR_nb2hop_tuple*>		nb2hopset_t;	///< 2-hop Neighbor Set type.
 typedef std::vector<OLSR_topology_tuple*>	topologyset_t;	///< Topology Set type.
-typedef std::vector<OLSR_dup_tuple*>		dupset_t;	///< Duplicate Set type.
 typedef std::vector<OLSR_iface_assoc_tuple*>	ifaceassocset_t;///< Interface Association Set type.
 
 #endif
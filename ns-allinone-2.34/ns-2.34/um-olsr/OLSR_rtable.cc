@@ -26,6 +26,7 @@
 #include <olsr/OLSR.h>
 #include <olsr/OLSR_rtable.h>
 #include <olsr/OLSR_repositories.h>
+#include <algorithm>
 
 ///
 /// \brief Creates a new empty routing table.
@@ -38,8 +39,8 @@ OLSR_rtable::OLSR_rtable() {
 ///
 OLSR_rtable::~OLSR_rtable() {
 	// Iterates over the routing table deleting each OLSR_rt_entry*.
-	for (rtable_t::iterator it = rt_.begin(); it != rt_.end(); it++)
-		delete (*it).second;
+	for (u_int32_t i = 0; i < rt_.size(); i++)
+		delete rt_[i];
 }
 
 ///
@@ -48,11 +49,12 @@ OLSR_rtable::~OLSR_rtable() {
 void
 OLSR_rtable::clear() {
 	// Iterates over the routing table deleting each OLSR_rt_entry*.
-	for (rtable_t::iterator it = rt_.begin(); it != rt_.end(); it++)
-		delete (*it).second;
+	for (u_int32_t i = 0; i < rt_.size(); i++)
+		delete rt_[i];
 
 	// Cleans routing table.
 	rt_.clear();
+	index_.clear();
 }
 
 ///
@@ -61,8 +63,12 @@ OLSR_rtable::clear() {
 ///
 void
 OLSR_rtable::rm_entry(nsaddr_t dest) {
-	// Remove the pair whose key is dest
-	rt_.erase(dest);
+	// Remove the entry whose key is dest
+	OLSR_rt_entry** entry = index_.find(dest);
+	if (entry == NULL)
+		return;
+	rt_.erase(std::find(rt_.begin(), rt_.end(), *entry));
+	index_.erase(dest);
 }
 
 ///
@@ -73,14 +79,12 @@ OLSR_rtable::rm_entry(nsaddr_t dest) {
 ///
 OLSR_rt_entry*
 OLSR_rtable::lookup(nsaddr_t dest) {
-	// Get the iterator at "dest" position
-	rtable_t::iterator it = rt_.find(dest);
 	// If there is no route to "dest", return NULL
-	if (it == rt_.end())
+	OLSR_rt_entry** entry = index_.find(dest);
+	if (entry == NULL)
 		return NULL;
 	
-	// Returns the rt entry (second element of the pair)
-	return (*it).second;
+	return *entry;
 }
 
 ///
@@ -110,7 +114,7 @@ OLSR_rtable::find_send_entry(OLSR_rt_entry* entry) {
 ///
 /// \brief Adds a new entry into the routing table.
 ///
-/// If an entry for the given destination existed, it is deleted and freed.
+/// If an entry for the given destination existed, it is overwritten.
 ///
 /// \param dest		address of the destination node.
 /// \param next		address of the next hop node.
@@ -120,19 +124,17 @@ OLSR_rtable::find_send_entry(OLSR_rt_entry* entry) {
 ///
 OLSR_rt_entry*
 OLSR_rtable::add_entry(nsaddr_t dest, nsaddr_t next, nsaddr_t iface, u_int32_t dist) {
-	// Creates a new rt entry with specified values
-	OLSR_rt_entry* entry = new OLSR_rt_entry();
+	// Creates a new rt entry, unless there is one for that destination
+	OLSR_rt_entry*& entry = index_[dest];
+	if (entry == NULL) {
+		entry = new OLSR_rt_entry();
+		rt_.push_back(entry);
+	}
 	entry->dest_addr()	= dest;
 	entry->next_addr()	= next;
 	entry->iface_addr()	= iface;
 	entry->dist()		= dist;
 	
-	// Inserts the new entry
-	rtable_t::iterator it = rt_.find(dest);
-	if (it != rt_.end())
-		delete (*it).second;
-	rt_[dest] = entry;
-	
 	// Returns the new rt entry
 	return entry;
 }
@@ -159,7 +161,10 @@ void
 OLSR_rtable::print(Trace* out) {	
 	sprintf(out->pt_->buffer(), "P\tdest\tnext\tiface\tdist");
 	out->pt_->dump();
-	for (rtable_t::iterator it = rt_.begin(); it != rt_.end(); it++) {
+	rtable_t rt;
+	for (u_int32_t i = 0; i < rt_.size(); i++)
+		rt[rt_[i]->dest_addr()] = rt_[i];
+	for (rtable_t::iterator it = rt.begin(); it != rt.end(); it++) {
 		OLSR_rt_entry* entry = (*it).second;
 		sprintf(out->pt_->buffer(), "P\t%d\t%d\t%d\t%d",
 			OLSR::node_id(entry->dest_addr()),
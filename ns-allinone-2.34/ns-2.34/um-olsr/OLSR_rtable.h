@@ -27,6 +27,7 @@
 #define __OLSR_rtable_h__
 
 #include <olsr/OLSR_repositories.h>
+#include <olsr/OLSR_hash.h>
 #include <trace.h>
 #include <map>
 
@@ -34,15 +35,20 @@
 /// \brief Defines rtable_t as a map of OLSR_rt_entry, whose key is the destination address.
 ///
 /// The routing table is thus defined as pairs: [dest address, entry]. Each element
-/// of the pair can be accesed via "first" and "second" members.
+/// of the pair can be accesed via "first" and "second" members. It is only
+/// built for printing the routing table sorted by destination.
 ///
 typedef std::map<nsaddr_t, OLSR_rt_entry*> rtable_t;
 
 ///
 /// \brief This class is a representation of the OLSR's Routing Table.
 ///
+/// Entries are indexed by destination address, since the table is looked up
+/// and rebuilt far more often than it is printed.
+///
 class OLSR_rtable {
-	rtable_t	rt_;	///< Data structure for the routing table.
+	std::vector<OLSR_rt_entry*>		rt_;	///< Entries of the routing table.
+	OLSR_hash<nsaddr_t, OLSR_rt_entry*>	index_;	///< Entries by destination address.
 
 public:
 	
@@ -27,6 +27,7 @@
 #define __OLSR_state_h__
 
 #include <olsr/OLSR_repositories.h>
+#include <olsr/OLSR_hash.h>
 
 /// This class encapsulates all data structures needed for maintaining internal state of an OLSR node.
 class OLSR_state {
@@ -38,17 +39,45 @@ class OLSR_state {
 	topologyset_t	topologyset_;	///< Topology Set (RFC 3626, section 4.4).
 	mprset_t	mprset_;	///< MPR Set (RFC 3626, section 4.3.3).
 	mprselset_t	mprselset_;	///< MPR Selector Set (RFC 3626, section 4.3.4).
-	dupset_t	dupset_;	///< Duplicate Set (RFC 3626, section 3.4).
 	ifaceassocset_t	ifaceassocset_;	///< Interface Association Set (RFC 3626, section 4.1).
+
+	/// Tuples of the repositories by key, see OLSR_hash.h.
+	OLSR_index<nsaddr_t, OLSR_mprsel_tuple>	mprsel_index_;	///< By main address.
+	OLSR_index<nsaddr_t, OLSR_nb_tuple>		nb_index_;	///< By main address.
+	/// By neighbor and 2-hop neighbor main addresses.
+	OLSR_index<std::pair<nsaddr_t, nsaddr_t>, OLSR_nb2hop_tuple>	nb2hop_index_;
+	OLSR_index<nsaddr_t, OLSR_link_tuple>		link_index_;	///< By neighbor interface address.
+	/// By destination and last hop addresses.
+	OLSR_index<std::pair<nsaddr_t, nsaddr_t>, OLSR_topology_tuple>	topology_index_;
+	/// Topology tuples of every last hop address, in repository order.
+	OLSR_hash<nsaddr_t, topologyset_t>	topology_last_index_;
+	OLSR_index<nsaddr_t, OLSR_iface_assoc_tuple>	ifaceassoc_index_;	///< By interface address.
+	/// Duplicate Set (RFC 3626, section 3.4), by originator address.
+	OLSR_hash<nsaddr_t, OLSR_dup_window>	dup_windows_;
+
+	/// Number of changes of the Neighbor Set and the 2-hop Neighbor Set.
+	u_int32_t	nbhood_version_;
+	/// Order of the next tuple inserted into the Topology Set.
+	u_int32_t	topology_order_;
+
+	void			unindex_topology_tuple(OLSR_topology_tuple*);
+
+public:
+	OLSR_state();
 	
 protected:
+	/// Gives the number of changes of the neighborhood, which tells whether
+	/// it has changed since a given time.
+	inline	u_int32_t		nbhood_version()	{ return nbhood_version_; }
+	/// Must be called when a neighbor tuple is modified.
+	inline	void			nbhood_changed()	{ nbhood_version_++; }
+
 	inline	linkset_t&		linkset()	{ return linkset_; }
 	inline	mprset_t&		mprset()	{ return mprset_; }
 	inline	mprselset_t&		mprselset()	{ return mprselset_; }
 	inline	nbset_t&		nbset()		{ return nbset_; }
 	inline	nb2hopset_t&		nb2hopset()	{ return nb2hopset_; }
 	inline	topologyset_t&		topologyset()	{ return topologyset_; }
-	inline	dupset_t&		dupset()	{ return dupset_; }
 	inline	ifaceassocset_t&	ifaceassocset()	{ return ifaceassocset_; }
 	
 	OLSR_mprsel_tuple*	find_mprsel_tuple(nsaddr_t);
@@ -73,9 +102,8 @@ protected:
 	void			insert_mpr_addr(nsaddr_t);
 	void			clear_mprset();
 	
-	OLSR_dup_tuple*		find_dup_tuple(nsaddr_t, u_int16_t);
-	void			erase_dup_tuple(OLSR_dup_tuple*);
-	void			insert_dup_tuple(OLSR_dup_tuple*);
+	bool			find_dup(nsaddr_t, u_int16_t, double);
+	void			insert_dup(nsaddr_t, u_int16_t, double, double);
 	
 	OLSR_link_tuple*	find_link_tuple(nsaddr_t);
 	OLSR_link_tuple*	find_sym_link_tuple(nsaddr_t, double);
@@ -84,6 +112,7 @@ protected:
 
 	OLSR_topology_tuple*	find_topology_tuple(nsaddr_t, nsaddr_t);
 	OLSR_topology_tuple*	find_newer_topology_tuple(nsaddr_t, u_int16_t);
+	topologyset_t*		find_topology_tuples(nsaddr_t);
 	void			erase_topology_tuple(OLSR_topology_tuple*);
 	void			erase_older_topology_tuples(nsaddr_t, u_int16_t);
 	void			insert_topology_tuple(OLSR_topology_tuple*);
@@ -0,0 +1,113 @@
+# ======================================================================
+# Forwarding benchmark for MPOLSR source routing.
+#
+# Places 11 static nodes on a line, 200 m apart, so that every node only
+# hears its two neighbours, and sends a CBR flow from one end of the chain
+# to the other (10 hops). At the end, the script prints the number of
+# packets delivered, the number of hops they were forwarded through and
+# the rate of forwarded packets per second of wall clock time.
+#
+# usage: ns mpolsr_chain.tcl [packets per second]
+# ======================================================================
+set opt(chan)           Channel/WirelessChannel  ;# channel type
+set opt(prop)           Propagation/TwoRayGround ;# radio-propagation model
+set opt(netif)          Phy/WirelessPhy          ;# network interface type
+set opt(mac)            Mac/802_11               ;# MAC type
+set opt(ifq)            Queue/DropTail/PriQueue  ;# interface queue type
+set opt(ll)             LL                       ;# link layer type
+set opt(ant)            Antenna/OmniAntenna      ;# antenna model
+set opt(ifqlen)         50                       ;# max packet in ifq
+set opt(nn)             11                       ;# number of mobilenodes
+set opt(adhocRouting)   MPOLSR                   ;# routing protocol
+set opt(x)              2200                     ;# x coordinate of topology
+set opt(y)              100                      ;# y coordinate of topology
+set opt(seed)           1.0                      ;# seed for random number gen.
+set opt(stop)           100.0                    ;# time to stop simulation
+
+$opt(mac) set basicRate_ 1Mb
+$opt(mac) set dataRate_ 2Mb
+
+Antenna/OmniAntenna set X_ 0
+Antenna/OmniAntenna set Y_ 0
+Antenna/OmniAntenna set Z_ 1.5
+Antenna/OmniAntenna set Gt_ 1.0
+Antenna/OmniAntenna set Gr_ 1.0
+
+Phy/WirelessPhy set CPThresh_ 10.0
+Phy/WirelessPhy set CSThresh_ 1.559e-11
+Phy/WirelessPhy set RXThresh_ 3.65262e-10
+Phy/WirelessPhy set Rb_ 2*1e6
+Phy/WirelessPhy set Pt_ 0.2818
+Phy/WirelessPhy set freq_ 914e+6
+Phy/WirelessPhy set L_ 1.0
+
+set opt(rate)           50                       ;# packets per second
+if {$argc > 0} {
+    set opt(rate) [lindex $argv 0]
+}
+
+ns-random $opt(seed)
+
+set ns_ [new Simulator]
+# the trace is not needed, and writing it would dominate the run time
+$ns_ trace-all [open /dev/null w]
+
+set topo [new Topography]
+$topo load_flatgrid $opt(x) $opt(y)
+set god_ [create-god $opt(nn)]
+set chan_1_ [new $opt(chan)]
+
+$ns_ node-config -adhocRouting $opt(adhocRouting) \
+                 -llType $opt(ll) \
+                 -macType $opt(mac) \
+                 -ifqType $opt(ifq) \
+                 -ifqLen $opt(ifqlen) \
+                 -antType $opt(ant) \
+                 -propType $opt(prop) \
+                 -phyType $opt(netif) \
+                 -channel $chan_1_ \
+                 -topoInstance $topo \
+                 -wiredRouting OFF \
+                 -agentTrace OFF \
+                 -routerTrace OFF \
+                 -macTrace OFF \
+                 -movementTrace OFF
+
+for {set i 0} {$i < $opt(nn)} {incr i} {
+    set node_($i) [$ns_ node]
+    $node_($i) random-motion 0
+    $node_($i) set X_ [expr 50 + 200 * $i]
+    $node_($i) set Y_ 50
+    $node_($i) set Z_ 0
+}
+
+set last [expr $opt(nn) - 1]
+set udp_ [new Agent/UDP]
+$ns_ attach-agent $node_(0) $udp_
+set sink_ [new Agent/LossMonitor]
+$ns_ attach-agent $node_($last) $sink_
+set cbr_ [new Application/Traffic/CBR]
+$cbr_ set packetSize_ 64
+$cbr_ set interval_ [expr 1.0 / $opt(rate)]
+$cbr_ attach-agent $udp_
+$ns_ connect $udp_ $sink_
+$ns_ at 20.0 "$cbr_ start"
+$ns_ at [expr $opt(stop) - 1] "$cbr_ stop"
+
+proc finish {} {
+    global ns_ sink_ opt last start
+    set wall [expr ([clock clicks -milliseconds] - $start) / 1000.0]
+    set delivered [$sink_ set npkts_]
+    set forwarded [expr $delivered * $last]
+    puts "delivered:  $delivered packets"
+    puts "forwarded:  $forwarded hops"
+    puts "wall time:  [format %.2f $wall] s"
+    if {$wall > 0} {
+        puts "rate:       [format %.1f [expr $forwarded / $wall]] forwarded packets/s"
+    }
+    exit 0
+}
+$ns_ at $opt(stop) "finish"
+
+set start [clock clicks -milliseconds]
+$ns_ run
@@ -0,0 +1,111 @@
+# ======================================================================
+# Regression test for the MPOLSR multipath Dijkstra engine.
+#
+# Runs the "scen" topology with MPOLSR and, at several instants, asks
+# every node to compare the paths computed by the heap based engine
+# against the original node map implementation (check_m_rtable).
+# Odd nodes compute the paths towards every destination at once ("all"
+# mode), which must not print anything unless the agents' debug_ is set.
+# The script exits with status 1 if any node reports a mismatch.
+#
+# usage: ns mpolsr_dijkstra.tcl
+# ======================================================================
+set opt(chan)           Channel/WirelessChannel  ;# channel type
+set opt(prop)           Propagation/TwoRayGround ;# radio-propagation model
+set opt(netif)          Phy/WirelessPhy          ;# network interface type
+set opt(mac)            Mac/802_11               ;# MAC type
+set opt(ifq)            Queue/DropTail/PriQueue  ;# interface queue type
+set opt(ll)             LL                       ;# link layer type
+set opt(ant)            Antenna/OmniAntenna      ;# antenna model
+set opt(ifqlen)         50                       ;# max packet in ifq
+set opt(nn)             28                       ;# number of mobilenodes
+set opt(adhocRouting)   MPOLSR                   ;# routing protocol
+set opt(sc)             "scen"                   ;# node movement file
+set opt(tr)             mpolsr_dijkstra.tr       ;# trace file
+set opt(x)              800                      ;# x coordinate of topology
+set opt(y)              800                      ;# y coordinate of topology
+set opt(seed)           1.0                      ;# seed for random number gen.
+set opt(stop)           40.0                     ;# time to stop simulation
+
+$opt(mac) set basicRate_ 1Mb
+$opt(mac) set dataRate_ 2Mb
+
+Antenna/OmniAntenna set X_ 0
+Antenna/OmniAntenna set Y_ 0
+Antenna/OmniAntenna set Z_ 1.5
+Antenna/OmniAntenna set Gt_ 1.0
+Antenna/OmniAntenna set Gr_ 1.0
+
+Phy/WirelessPhy set CPThresh_ 10.0
+Phy/WirelessPhy set CSThresh_ 1.559e-11
+Phy/WirelessPhy set RXThresh_ 3.65262e-10
+Phy/WirelessPhy set Rb_ 2*1e6
+Phy/WirelessPhy set Pt_ 0.2818
+Phy/WirelessPhy set freq_ 914e+6
+Phy/WirelessPhy set L_ 1.0
+
+ns-random $opt(seed)
+
+set ns_ [new Simulator]
+set tracefd [open $opt(tr) w]
+$ns_ trace-all $tracefd
+
+set topo [new Topography]
+$topo load_flatgrid $opt(x) $opt(y)
+set god_ [create-god $opt(nn)]
+set chan_1_ [new $opt(chan)]
+
+$ns_ node-config -adhocRouting $opt(adhocRouting) \
+                 -llType $opt(ll) \
+                 -macType $opt(mac) \
+                 -ifqType $opt(ifq) \
+                 -ifqLen $opt(ifqlen) \
+                 -antType $opt(ant) \
+                 -propType $opt(prop) \
+                 -phyType $opt(netif) \
+                 -channel $chan_1_ \
+                 -topoInstance $topo \
+                 -wiredRouting OFF \
+                 -agentTrace OFF \
+                 -routerTrace OFF \
+                 -macTrace OFF \
+                 -movementTrace OFF
+
+for {set i 0} {$i < $opt(nn)} {incr i} {
+    set node_($i) [$ns_ node]
+    $node_($i) random-motion 0
+    if {$i % 2 == 1} {
+        [$node_($i) agent 255] m_rtable_mode all
+    }
+}
+source $opt(sc)
+
+# node 4 walks away, so the topology changes during the run
+$ns_ at 16 "$node_(4) setdest 799 1 4"
+
+set errors 0
+proc check {} {
+    global node_ opt errors
+    for {set i 0} {$i < $opt(nn)} {incr i} {
+        incr errors [[$node_($i) agent 255] check_m_rtable]
+    }
+}
+
+foreach t {10.0 15.0 20.0 25.0 30.0 35.0} {
+    $ns_ at $t "check"
+}
+
+proc finish {} {
+    global ns_ tracefd errors
+    $ns_ flush-trace
+    close $tracefd
+    if {$errors > 0} {
+        puts "FAILED: $errors mismatching routes"
+        exit 1
+    }
+    puts "PASSED"
+    exit 0
+}
+$ns_ at $opt(stop) "finish"
+
+$ns_ run
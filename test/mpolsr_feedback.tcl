@@ -0,0 +1,138 @@
+# ======================================================================
+# Regression test for the MAC layer feedback of MPOLSR.
+#
+# Places 4 static nodes on a line, 200 m apart, and sends a CBR flow from
+# each end of the line to the other, so that both flows are forwarded by
+# the 2 nodes in the middle. Every node uses the least_outstanding path
+# scheduler, which asks the MAC layer to acknowledge the packets its node
+# originates. The script checks that both ends received acknowledgements,
+# at most one per packet they sent, and that no node received the
+# acknowledgement of a packet it did not originate. It exits with status
+# 1 if any check fails.
+#
+# usage: ns mpolsr_feedback.tcl
+# ======================================================================
+set opt(chan)           Channel/WirelessChannel  ;# channel type
+set opt(prop)           Propagation/TwoRayGround ;# radio-propagation model
+set opt(netif)          Phy/WirelessPhy          ;# network interface type
+set opt(mac)            Mac/802_11               ;# MAC type
+set opt(ifq)            Queue/DropTail/PriQueue  ;# interface queue type
+set opt(ll)             LL                       ;# link layer type
+set opt(ant)            Antenna/OmniAntenna      ;# antenna model
+set opt(ifqlen)         50                       ;# max packet in ifq
+set opt(nn)             4                        ;# number of mobilenodes
+set opt(adhocRouting)   MPOLSR                   ;# routing protocol
+set opt(x)              800                      ;# x coordinate of topology
+set opt(y)              100                      ;# y coordinate of topology
+set opt(seed)           1.0                      ;# seed for random number gen.
+set opt(stop)           40.0                     ;# time to stop simulation
+
+$opt(mac) set basicRate_ 1Mb
+$opt(mac) set dataRate_ 2Mb
+
+Antenna/OmniAntenna set X_ 0
+Antenna/OmniAntenna set Y_ 0
+Antenna/OmniAntenna set Z_ 1.5
+Antenna/OmniAntenna set Gt_ 1.0
+Antenna/OmniAntenna set Gr_ 1.0
+
+Phy/WirelessPhy set CPThresh_ 10.0
+Phy/WirelessPhy set CSThresh_ 1.559e-11
+Phy/WirelessPhy set RXThresh_ 3.65262e-10
+Phy/WirelessPhy set Rb_ 2*1e6
+Phy/WirelessPhy set Pt_ 0.2818
+Phy/WirelessPhy set freq_ 914e+6
+Phy/WirelessPhy set L_ 1.0
+
+set opt(rate)           10                       ;# packets per second
+
+ns-random $opt(seed)
+
+set ns_ [new Simulator]
+$ns_ trace-all [open /dev/null w]
+
+set topo [new Topography]
+$topo load_flatgrid $opt(x) $opt(y)
+set god_ [create-god $opt(nn)]
+set chan_1_ [new $opt(chan)]
+
+$ns_ node-config -adhocRouting $opt(adhocRouting) \
+                 -llType $opt(ll) \
+                 -macType $opt(mac) \
+                 -ifqType $opt(ifq) \
+                 -ifqLen $opt(ifqlen) \
+                 -antType $opt(ant) \
+                 -propType $opt(prop) \
+                 -phyType $opt(netif) \
+                 -channel $chan_1_ \
+                 -topoInstance $topo \
+                 -wiredRouting OFF \
+                 -agentTrace OFF \
+                 -routerTrace OFF \
+                 -macTrace OFF \
+                 -movementTrace OFF
+
+for {set i 0} {$i < $opt(nn)} {incr i} {
+    set node_($i) [$ns_ node]
+    $node_($i) random-motion 0
+    $node_($i) set X_ [expr 50 + 200 * $i]
+    $node_($i) set Y_ 50
+    $node_($i) set Z_ 0
+}
+for {set i 0} {$i < $opt(nn)} {incr i} {
+    [$node_($i) agent 255] path_scheduler least_outstanding
+}
+
+set last [expr $opt(nn) - 1]
+set opt(start) 20.0
+set opt(end)   [expr $opt(stop) - 1]
+foreach {src dst} [list 0 $last $last 0] {
+    set udp_($src) [new Agent/UDP]
+    $ns_ attach-agent $node_($src) $udp_($src)
+    set sink_($dst) [new Agent/LossMonitor]
+    $ns_ attach-agent $node_($dst) $sink_($dst)
+    set cbr_($src) [new Application/Traffic/CBR]
+    $cbr_($src) set packetSize_ 64
+    $cbr_($src) set interval_ [expr 1.0 / $opt(rate)]
+    $cbr_($src) attach-agent $udp_($src)
+    $ns_ connect $udp_($src) $sink_($dst)
+    $ns_ at $opt(start) "$cbr_($src) start"
+    $ns_ at $opt(end) "$cbr_($src) stop"
+}
+
+proc finish {} {
+    global node_ sink_ opt last
+    set errors 0
+    set sent [expr int(($opt(end) - $opt(start)) * $opt(rate)) + 1]
+    for {set i 0} {$i < $opt(nn)} {incr i} {
+        set stats [[$node_($i) agent 255] feedback_stats]
+        set acks [lindex $stats 0]
+        set foreign [lindex $stats 1]
+        puts "node $i: $acks acknowledgements, $foreign of foreign packets"
+        if {$foreign != 0} {
+            incr errors
+        }
+        if {$i == 0 || $i == $last} {
+            if {$acks == 0 || $acks > $sent} {
+                puts "node $i sent $sent packets"
+                incr errors
+            }
+        } elseif {$acks != 0} {
+            incr errors
+        }
+    }
+    if {[$sink_(0) set npkts_] == 0 || [$sink_($last) set npkts_] == 0} {
+        puts "delivered [$sink_($last) set npkts_] and [$sink_(0) set npkts_]\
+              packets"
+        incr errors
+    }
+    if {$errors > 0} {
+        puts "FAILED: $errors errors"
+        exit 1
+    }
+    puts "PASSED"
+    exit 0
+}
+$ns_ at $opt(stop) "finish"
+
+$ns_ run
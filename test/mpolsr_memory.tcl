@@ -0,0 +1,155 @@
+# ======================================================================
+# Memory benchmark for MPOLSR.
+#
+# Runs a random waypoint scenario with MPOLSR and several CBR flows and
+# samples the resident set size of the simulator at regular intervals.
+# Once the routing state has been built, RSS is expected to stay flat,
+# or at least to grow no faster than with the same run under OLSR (the
+# packet free list and the scheduler also grow during the first minutes).
+# At the end, the script prints the growth of RSS after 100 s and over
+# the second half of the run, by which time the routing state of every
+# node has seen most of the network.
+#
+# usage: ns mpolsr_memory.tcl [stop] [nn] [flows] [protocol] > /dev/null
+# (the RSS samples are written to stderr)
+# ======================================================================
+set opt(chan)           Channel/WirelessChannel  ;# channel type
+set opt(prop)           Propagation/TwoRayGround ;# radio-propagation model
+set opt(netif)          Phy/WirelessPhy          ;# network interface type
+set opt(mac)            Mac/802_11               ;# MAC type
+set opt(ifq)            Queue/DropTail/PriQueue  ;# interface queue type
+set opt(ll)             LL                       ;# link layer type
+set opt(ant)            Antenna/OmniAntenna      ;# antenna model
+set opt(ifqlen)         50                       ;# max packet in ifq
+set opt(nn)             100                      ;# number of mobilenodes
+set opt(flows)          10                       ;# number of CBR flows
+set opt(adhocRouting)   MPOLSR                   ;# routing protocol
+set opt(x)              1500                     ;# x coordinate of topology
+set opt(y)              1500                     ;# y coordinate of topology
+set opt(seed)           1.0                      ;# seed for random number gen.
+set opt(stop)           1000.0                   ;# time to stop simulation
+set opt(sample)         50.0                     ;# RSS sampling interval
+set opt(speed)          5.0                      ;# max node speed (m/s)
+
+if {$argc > 0} { set opt(stop)  [lindex $argv 0] }
+if {$argc > 1} { set opt(nn)    [lindex $argv 1] }
+if {$argc > 2} { set opt(flows) [lindex $argv 2] }
+if {$argc > 3} { set opt(adhocRouting) [lindex $argv 3] }
+
+$opt(mac) set basicRate_ 1Mb
+$opt(mac) set dataRate_ 2Mb
+
+Antenna/OmniAntenna set X_ 0
+Antenna/OmniAntenna set Y_ 0
+Antenna/OmniAntenna set Z_ 1.5
+Antenna/OmniAntenna set Gt_ 1.0
+Antenna/OmniAntenna set Gr_ 1.0
+
+Phy/WirelessPhy set CPThresh_ 10.0
+Phy/WirelessPhy set CSThresh_ 1.559e-11
+Phy/WirelessPhy set RXThresh_ 3.65262e-10
+Phy/WirelessPhy set Rb_ 2*1e6
+Phy/WirelessPhy set Pt_ 0.2818
+Phy/WirelessPhy set freq_ 914e+6
+Phy/WirelessPhy set L_ 1.0
+
+ns-random $opt(seed)
+set rng [new RNG]
+$rng seed $opt(seed)
+
+set ns_ [new Simulator]
+set tracefd [open /dev/null w]
+$ns_ trace-all $tracefd
+
+set topo [new Topography]
+$topo load_flatgrid $opt(x) $opt(y)
+set god_ [create-god $opt(nn)]
+set chan_1_ [new $opt(chan)]
+
+$ns_ node-config -adhocRouting $opt(adhocRouting) \
+                 -llType $opt(ll) \
+                 -macType $opt(mac) \
+                 -ifqType $opt(ifq) \
+                 -ifqLen $opt(ifqlen) \
+                 -antType $opt(ant) \
+                 -propType $opt(prop) \
+                 -phyType $opt(netif) \
+                 -channel $chan_1_ \
+                 -topoInstance $topo \
+                 -wiredRouting OFF \
+                 -agentTrace OFF \
+                 -routerTrace OFF \
+                 -macTrace OFF \
+                 -movementTrace OFF
+
+for {set i 0} {$i < $opt(nn)} {incr i} {
+    set node_($i) [$ns_ node]
+    $node_($i) random-motion 0
+    $node_($i) set X_ [$rng uniform 1 $opt(x)]
+    $node_($i) set Y_ [$rng uniform 1 $opt(y)]
+    $node_($i) set Z_ 0
+}
+
+# random waypoint movement
+for {set i 0} {$i < $opt(nn)} {incr i} {
+    for {set t 1.0} {$t < $opt(stop)} {set t [expr $t + 100.0]} {
+        $ns_ at $t "$node_($i) setdest [$rng uniform 1 $opt(x)] \
+            [$rng uniform 1 $opt(y)] [$rng uniform 0.5 $opt(speed)]"
+    }
+}
+
+for {set i 0} {$i < $opt(flows)} {incr i} {
+    set src [expr $i % $opt(nn)]
+    set dst [expr ($opt(nn) - 1 - $i) % $opt(nn)]
+    set udp_($i) [new Agent/UDP]
+    $ns_ attach-agent $node_($src) $udp_($i)
+    set null_($i) [new Agent/Null]
+    $ns_ attach-agent $node_($dst) $null_($i)
+    set cbr_($i) [new Application/Traffic/CBR]
+    $cbr_($i) set packetSize_ 512
+    $cbr_($i) set rate_ 16kb
+    $cbr_($i) attach-agent $udp_($i)
+    $ns_ connect $udp_($i) $null_($i)
+    $ns_ at [expr 10.0 + $i] "$cbr_($i) start"
+}
+
+proc rss {} {
+    set f [open /proc/[pid]/status r]
+    set status [read $f]
+    close $f
+    regexp {VmRSS:\s+([0-9]+)} $status all kb
+    return $kb
+}
+
+proc sample {} {
+    global ns_ opt first half
+    set kb [rss]
+    set now [$ns_ now]
+    if {![info exists first] && $now >= 100.0} {
+        set first $kb
+    }
+    if {![info exists half] && $now >= $opt(stop) / 2} {
+        set half $kb
+    }
+    puts stderr [format "%8.1f s  RSS %8d kB" $now $kb]
+    if {$now + $opt(sample) <= $opt(stop)} {
+        $ns_ at [expr $now + $opt(sample)] "sample"
+    }
+}
+$ns_ at $opt(sample) "sample"
+
+proc finish {} {
+    global ns_ tracefd first half
+    $ns_ flush-trace
+    close $tracefd
+    if {[info exists first]} {
+        puts stderr "RSS growth after 100 s: [expr [rss] - $first] kB"
+    }
+    if {[info exists half]} {
+        puts stderr "RSS growth over the second half: [expr [rss] - $half] kB"
+    }
+    exit 0
+}
+$ns_ at [expr $opt(stop) + 0.001] "finish"
+
+$ns_ run
@@ -0,0 +1,113 @@
+# ======================================================================
+# Regression test for the MPOLSR Mojette erasure coding layer.
+#
+# Runs the "scen" topology with MPOLSR and a CBR flow whose packets are
+# split into 3 projections, any 2 of which rebuild the packet. The
+# script exits with status 1 if the sink could not rebuild any packet,
+# or if a rebuilt payload differs from the original one.
+#
+# usage: ns mpolsr_mojette.tcl
+# ======================================================================
+set opt(chan)           Channel/WirelessChannel  ;# channel type
+set opt(prop)           Propagation/TwoRayGround ;# radio-propagation model
+set opt(netif)          Phy/WirelessPhy          ;# network interface type
+set opt(mac)            Mac/802_11               ;# MAC type
+set opt(ifq)            Queue/DropTail/PriQueue  ;# interface queue type
+set opt(ll)             LL                       ;# link layer type
+set opt(ant)            Antenna/OmniAntenna      ;# antenna model
+set opt(ifqlen)         50                       ;# max packet in ifq
+set opt(nn)             28                       ;# number of mobilenodes
+set opt(adhocRouting)   MPOLSR                   ;# routing protocol
+set opt(sc)             "scen"                   ;# node movement file
+set opt(tr)             mpolsr_mojette.tr        ;# trace file
+set opt(x)              800                      ;# x coordinate of topology
+set opt(y)              800                      ;# y coordinate of topology
+set opt(seed)           1.0                      ;# seed for random number gen.
+set opt(stop)           40.0                     ;# time to stop simulation
+
+$opt(mac) set basicRate_ 1Mb
+$opt(mac) set dataRate_ 2Mb
+
+Antenna/OmniAntenna set X_ 0
+Antenna/OmniAntenna set Y_ 0
+Antenna/OmniAntenna set Z_ 1.5
+Antenna/OmniAntenna set Gt_ 1.0
+Antenna/OmniAntenna set Gr_ 1.0
+
+Phy/WirelessPhy set CPThresh_ 10.0
+Phy/WirelessPhy set CSThresh_ 1.559e-11
+Phy/WirelessPhy set RXThresh_ 3.65262e-10
+Phy/WirelessPhy set Rb_ 2*1e6
+Phy/WirelessPhy set Pt_ 0.2818
+Phy/WirelessPhy set freq_ 914e+6
+Phy/WirelessPhy set L_ 1.0
+
+ns-random $opt(seed)
+
+Agent/MPOLSR set mojette_n_ 3
+Agent/MPOLSR set mojette_m_ 2
+
+set ns_ [new Simulator]
+set tracefd [open $opt(tr) w]
+$ns_ trace-all $tracefd
+
+set topo [new Topography]
+$topo load_flatgrid $opt(x) $opt(y)
+set god_ [create-god $opt(nn)]
+set chan_1_ [new $opt(chan)]
+
+$ns_ node-config -adhocRouting $opt(adhocRouting) \
+                 -llType $opt(ll) \
+                 -macType $opt(mac) \
+                 -ifqType $opt(ifq) \
+                 -ifqLen $opt(ifqlen) \
+                 -antType $opt(ant) \
+                 -propType $opt(prop) \
+                 -phyType $opt(netif) \
+                 -channel $chan_1_ \
+                 -topoInstance $topo \
+                 -wiredRouting OFF \
+                 -agentTrace OFF \
+                 -routerTrace OFF \
+                 -macTrace OFF \
+                 -movementTrace OFF
+
+for {set i 0} {$i < $opt(nn)} {incr i} {
+    set node_($i) [$ns_ node]
+    $node_($i) random-motion 0
+}
+source $opt(sc)
+
+# node 4 walks away, so the topology changes during the run
+$ns_ at 16 "$node_(4) setdest 799 1 4"
+
+set udp_ [new Agent/UDP]
+$ns_ attach-agent $node_(0) $udp_
+set null_ [new Agent/Null]
+$ns_ attach-agent $node_(20) $null_
+set cbr_ [new Application/Traffic/CBR]
+$cbr_ set packetSize_ 512
+$cbr_ set interval_ 0.1
+$cbr_ attach-agent $udp_
+$ns_ connect $udp_ $null_
+$ns_ at 10.0 "$cbr_ start"
+$ns_ at 35.0 "$cbr_ stop"
+
+proc finish {} {
+    global ns_ tracefd node_
+    $ns_ flush-trace
+    close $tracefd
+    set src [[$node_(0) agent 255] mojette_stats]
+    set dst [[$node_(20) agent 255] mojette_stats]
+    puts "source: $src"
+    puts "sink:   $dst"
+    if {[lindex $src 0] == 0 || [lindex $dst 1] == 0 || [lindex $dst 3] > 0} {
+        puts "FAILED"
+        exit 1
+    }
+    puts "PASSED"
+    exit 0
+}
+$ns_ at $opt(stop) "finish"
+
+$ns_ run
@@ -0,0 +1,114 @@
+# ======================================================================
+# Regression test for the bundling of OLSR messages into packets.
+#
+# Places 30 static nodes at random in a 600 m x 600 m area and runs OLSR
+# without any data traffic, so that the nodes forward bursts of TC
+# messages. The script checks that some packet carried more than 4
+# messages, the limit packets used to have, and that node 0, whose
+# max_pkt_size_ only leaves room for the header of one message, sent
+# every message in its own packet. The script exits with status 1 if
+# any check fails.
+#
+# usage: ns olsr_bundle.tcl
+# ======================================================================
+set opt(chan)           Channel/WirelessChannel  ;# channel type
+set opt(prop)           Propagation/TwoRayGround ;# radio-propagation model
+set opt(netif)          Phy/WirelessPhy          ;# network interface type
+set opt(mac)            Mac/802_11               ;# MAC type
+set opt(ifq)            Queue/DropTail/PriQueue  ;# interface queue type
+set opt(ll)             LL                       ;# link layer type
+set opt(ant)            Antenna/OmniAntenna      ;# antenna model
+set opt(ifqlen)         50                       ;# max packet in ifq
+set opt(nn)             30                       ;# number of mobilenodes
+set opt(adhocRouting)   OLSR                     ;# routing protocol
+set opt(x)              600                      ;# x coordinate of topology
+set opt(y)              600                      ;# y coordinate of topology
+set opt(seed)           1.0                      ;# seed for random number gen.
+set opt(stop)           30.0                     ;# time to stop simulation
+
+$opt(mac) set basicRate_ 1Mb
+$opt(mac) set dataRate_ 2Mb
+
+Antenna/OmniAntenna set X_ 0
+Antenna/OmniAntenna set Y_ 0
+Antenna/OmniAntenna set Z_ 1.5
+Antenna/OmniAntenna set Gt_ 1.0
+Antenna/OmniAntenna set Gr_ 1.0
+
+Phy/WirelessPhy set CPThresh_ 10.0
+Phy/WirelessPhy set CSThresh_ 1.559e-11
+Phy/WirelessPhy set RXThresh_ 3.65262e-10
+Phy/WirelessPhy set Rb_ 2*1e6
+Phy/WirelessPhy set Pt_ 0.2818
+Phy/WirelessPhy set freq_ 914e+6
+Phy/WirelessPhy set L_ 1.0
+
+ns-random $opt(seed)
+
+set ns_ [new Simulator]
+$ns_ trace-all [open /dev/null w]
+
+set topo [new Topography]
+$topo load_flatgrid $opt(x) $opt(y)
+set god_ [create-god $opt(nn)]
+set chan_1_ [new $opt(chan)]
+
+$ns_ node-config -adhocRouting $opt(adhocRouting) \
+                 -llType $opt(ll) \
+                 -macType $opt(mac) \
+                 -ifqType $opt(ifq) \
+                 -ifqLen $opt(ifqlen) \
+                 -antType $opt(ant) \
+                 -propType $opt(prop) \
+                 -phyType $opt(netif) \
+                 -channel $chan_1_ \
+                 -topoInstance $topo \
+                 -wiredRouting OFF \
+                 -agentTrace OFF \
+                 -routerTrace OFF \
+                 -macTrace OFF \
+                 -movementTrace OFF
+
+set rng [new RNG]
+$rng seed 1
+for {set i 0} {$i < $opt(nn)} {incr i} {
+    set node_($i) [$ns_ node]
+    $node_($i) random-motion 0
+    $node_($i) set X_ [$rng uniform 0 $opt(x)]
+    $node_($i) set Y_ [$rng uniform 0 $opt(y)]
+    $node_($i) set Z_ 0
+}
+# packet header (4 bytes) and message header (12 bytes)
+[$node_(0) agent 255] set max_pkt_size_ 16
+
+proc finish {} {
+    global node_ opt
+    set errors 0
+    set largest 0
+    for {set i 1} {$i < $opt(nn)} {incr i} {
+        set stats [[$node_($i) agent 255] bundle_stats]
+        if {[lindex $stats 3] > $largest} {
+            set largest [lindex $stats 3]
+        }
+    }
+    puts "largest bundle: $largest messages"
+    if {$largest <= 4} {
+        puts "no packet carried more than 4 messages"
+        incr errors
+    }
+    set stats [[$node_(0) agent 255] bundle_stats]
+    if {[lindex $stats 0] == 0 || [lindex $stats 3] != 1} {
+        puts "node 0 sent [lindex $stats 1] messages in [lindex $stats 0]\
+              packets, at most [lindex $stats 3] in one"
+        incr errors
+    }
+    if {$errors > 0} {
+        puts "FAILED: $errors errors"
+        exit 1
+    }
+    puts "PASSED"
+    exit 0
+}
+$ns_ at $opt(stop) "finish"
+
+$ns_ run
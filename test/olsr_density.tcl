@@ -0,0 +1,180 @@
+# ======================================================================
+# Scaling benchmark of OLSR control packet processing.
+#
+# Places the given number of static nodes at random in a 600 m x 600 m
+# area, so that the number of neighbours of every node grows with the
+# number of nodes, and runs OLSR without any data traffic. At the end,
+# the script prints the number of OLSR packets received by all the nodes,
+# the mean wall clock time spent processing one of them, the number of
+# events scheduled during the simulation, the number of routing table
+# computations and of topology changes which only updated the route to
+# one destination, and how the messages were bundled in the packets
+# sent, followed by the usage of the pools of tuples and timers shared
+# by the agents. The TC line gives the bandwidth of the TC
+# messages and requests sent by all the nodes, the mean wall clock time a
+# node spent processing TC messages, and how many full and delta TC
+# messages and requests were generated. The copies line gives the number
+# of packets copied, the number of packets the channels shared with the
+# receivers and how many of them had to be copied after all, and the bytes
+# of headers and data copied, and the zeroed line the number of packets
+# allocated and the bytes of headers zeroed to allocate them. With
+# "delta", the TC messages only advertise the changes of the MPR
+# selectors, and with "prune", the packet headers which none of the
+# objects of the simulation access are left out of the packets. Calendar,
+# Heap, Ladder, List, Map or Splay selects the event scheduler.
+#
+# usage: ns olsr_density.tcl [number of nodes] [delta] [prune] [scheduler]
+# ======================================================================
+set opt(chan)           Channel/WirelessChannel  ;# channel type
+set opt(prop)           Propagation/TwoRayGround ;# radio-propagation model
+set opt(netif)          Phy/WirelessPhy          ;# network interface type
+set opt(mac)            Mac/802_11               ;# MAC type
+set opt(ifq)            Queue/DropTail/PriQueue  ;# interface queue type
+set opt(ll)             LL                       ;# link layer type
+set opt(ant)            Antenna/OmniAntenna      ;# antenna model
+set opt(ifqlen)         50                       ;# max packet in ifq
+set opt(nn)             50                       ;# number of mobilenodes
+set opt(adhocRouting)   OLSR                     ;# routing protocol
+set opt(x)              600                      ;# x coordinate of topology
+set opt(y)              600                      ;# y coordinate of topology
+set opt(seed)           1.0                      ;# seed for random number gen.
+set opt(stop)           60.0                     ;# time to stop simulation
+set opt(sched)          Calendar                 ;# event scheduler
+
+$opt(mac) set basicRate_ 1Mb
+$opt(mac) set dataRate_ 2Mb
+
+Antenna/OmniAntenna set X_ 0
+Antenna/OmniAntenna set Y_ 0
+Antenna/OmniAntenna set Z_ 1.5
+Antenna/OmniAntenna set Gt_ 1.0
+Antenna/OmniAntenna set Gr_ 1.0
+
+Phy/WirelessPhy set CPThresh_ 10.0
+Phy/WirelessPhy set CSThresh_ 1.559e-11
+Phy/WirelessPhy set RXThresh_ 3.65262e-10
+Phy/WirelessPhy set Rb_ 2*1e6
+Phy/WirelessPhy set Pt_ 0.2818
+Phy/WirelessPhy set freq_ 914e+6
+Phy/WirelessPhy set L_ 1.0
+
+# measure the time spent processing control packets
+Agent/OLSR set timing_ true
+
+if {$argc > 0} {
+    set opt(nn) [lindex $argv 0]
+}
+foreach arg [lrange $argv 1 end] {
+    switch $arg {
+        delta { Agent/OLSR set tc_delta_ true }
+        prune { Simulator set prunePacketHeaders_ 1 }
+        default { set opt(sched) $arg }
+    }
+}
+
+ns-random $opt(seed)
+
+set ns_ [new Simulator]
+$ns_ use-scheduler $opt(sched)
+# the trace is not needed, and writing it would dominate the run time
+$ns_ trace-all [open /dev/null w]
+
+set topo [new Topography]
+$topo load_flatgrid $opt(x) $opt(y)
+set god_ [create-god $opt(nn)]
+set chan_1_ [new $opt(chan)]
+
+$ns_ node-config -adhocRouting $opt(adhocRouting) \
+                 -llType $opt(ll) \
+                 -macType $opt(mac) \
+                 -ifqType $opt(ifq) \
+                 -ifqLen $opt(ifqlen) \
+                 -antType $opt(ant) \
+                 -propType $opt(prop) \
+                 -phyType $opt(netif) \
+                 -channel $chan_1_ \
+                 -topoInstance $topo \
+                 -wiredRouting OFF \
+                 -agentTrace OFF \
+                 -routerTrace OFF \
+                 -macTrace OFF \
+                 -movementTrace OFF
+
+set rng [new RNG]
+$rng seed 1
+for {set i 0} {$i < $opt(nn)} {incr i} {
+    set node_($i) [$ns_ node]
+    $node_($i) random-motion 0
+    $node_($i) set X_ [$rng uniform 0 $opt(x)]
+    $node_($i) set Y_ [$rng uniform 0 $opt(y)]
+    $node_($i) set Z_ 0
+}
+
+proc finish {} {
+    global ns_ node_ opt start chan_1_
+    set wall [expr ([clock clicks -milliseconds] - $start) / 1000.0]
+    set pkts 0
+    set time 0.0
+    set sent 0
+    set msgs 0
+    set saved 0
+    set largest 0
+    set tc {0 0 0 0 0 0 0.0}
+    set builds 0
+    set updates 0
+    for {set i 0} {$i < $opt(nn)} {incr i} {
+        set stats [[$node_($i) agent 255] ctrl_stats]
+        incr pkts [lindex $stats 0]
+        set time [expr $time + [lindex $stats 1]]
+        set stats [[$node_($i) agent 255] bundle_stats]
+        incr sent [lindex $stats 0]
+        incr msgs [lindex $stats 1]
+        incr saved [lindex $stats 2]
+        if {[lindex $stats 3] > $largest} {
+            set largest [lindex $stats 3]
+        }
+        set stats [[$node_($i) agent 255] tc_stats]
+        set sum {}
+        foreach a $tc b $stats {
+            lappend sum [expr $a + $b]
+        }
+        set tc $sum
+        set stats [[$node_($i) agent 255] rtable_stats]
+        incr builds [lindex $stats 0]
+        incr updates [lindex $stats 1]
+    }
+    puts "nodes:      $opt(nn), $opt(sched) scheduler"
+    puts "received:   $pkts OLSR packets"
+    puts "processing: [format %.3f $time] s"
+    if {$pkts > 0} {
+        puts "per packet: [format %.2f [expr $time * 1e6 / $pkts]] us"
+    }
+    puts "events:     [[$ns_ set scheduler_] event-count] scheduled"
+    puts "rtable:     $builds computations, $updates single route updates"
+    if {$sent > 0} {
+        puts "bundling:   $msgs messages in $sent packets\
+              ([format %.2f [expr double($msgs) / $sent]] per packet,\
+              at most $largest), $saved bytes of headers saved"
+    }
+    puts "tc:         [format %.0f [expr [lindex $tc 4] / $opt(stop)]] B/s,\
+          [format %.2f [expr [lindex $tc 6] * 1e3 / $opt(nn)]] ms per node,\
+          [lindex $tc 0] full, [lindex $tc 1] delta, [lindex $tc 2] requests,\
+          [lindex $tc 3] gaps"
+    set copies [$chan_1_ copy-stats]
+    puts "copies:     [lindex $copies 0] packets, [lindex $copies 1] shared,\
+          [lindex $copies 2] unshared,\
+          [format %.1f [expr [lindex $copies 3] / 1e6]] MB"
+    set zeroed [[$ns_ set packetManager_] zero-stats]
+    puts "zeroed:     [lindex $zeroed 0] packets allocated,\
+          [format %.1f [expr [lindex $zeroed 1] / 1e6]] MB of headers zeroed"
+    puts "wall time:  [format %.2f $wall] s"
+    puts "pools:      (name, in use, high water, allocated)"
+    foreach pool [[$node_(0) agent 255] pool_stats] {
+        puts "            $pool"
+    }
+    exit 0
+}
+$ns_ at $opt(stop) "finish"
+
+set start [clock clicks -milliseconds]
+$ns_ run
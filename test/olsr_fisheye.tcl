@@ -0,0 +1,261 @@
+# ======================================================================
+# Benchmark of OLSR fisheye-scoped TC flooding against network size.
+#
+# Places the given number of nodes at random in a square whose side
+# grows with the number of nodes, so that the mean number of neighbours
+# stays the same and the diameter of the network grows. Nodes move slowly
+# towards random destinations, and OLSR runs without any data traffic. At
+# the end, the script prints the bandwidth of the TC messages sent by a
+# node, forwarded ones included, and the route stretch: the number of hops
+# of the routes packets would follow hop by hop between random pairs of
+# connected nodes, divided by the number of hops of the shortest path at
+# that time. Routes which loop, end before the destination or follow a
+# link which is out of range are counted as broken.
+#
+# Halfway through, the node which most nodes hold topology tuples from
+# flies out of range of all the others, to a parking area beyond the
+# side of the square. The links it advertised are then only removed when
+# their tuples expire, which must happen at most OLSR_TOP_HOLD_TIME plus
+# the TC intervals between two TC messages flooded network wide after
+# its last TC message, give or take the time the message took to be
+# forwarded. The script exits with status 1 if any node still holds one
+# of these tuples after that time.
+#
+# usage: ns olsr_fisheye.tcl [number of nodes] [fisheye]
+# ======================================================================
+set opt(chan)           Channel/WirelessChannel  ;# channel type
+set opt(prop)           Propagation/TwoRayGround ;# radio-propagation model
+set opt(netif)          Phy/WirelessPhy          ;# network interface type
+set opt(mac)            Mac/802_11               ;# MAC type
+set opt(ifq)            Queue/DropTail/PriQueue  ;# interface queue type
+set opt(ll)             LL                       ;# link layer type
+set opt(ant)            Antenna/OmniAntenna      ;# antenna model
+set opt(ifqlen)         50                       ;# max packet in ifq
+set opt(nn)             50                       ;# number of mobilenodes
+set opt(adhocRouting)   OLSR                     ;# routing protocol
+set opt(density)        50                       ;# nodes per square km
+set opt(range)          250                      ;# radio range
+set opt(pairs)          500                      ;# pairs of nodes sampled
+set opt(speed)          5                        ;# max speed of nodes (m/s)
+set opt(seed)           1.0                      ;# seed for random number gen.
+set opt(stop)           60.0                     ;# time to stop simulation
+set opt(leave)          25.0                     ;# time a node flies away
+set opt(hold)           15.0                     ;# OLSR_TOP_HOLD_TIME
+set opt(delay)          3.0                      ;# max delay of a TC message
+
+$opt(mac) set basicRate_ 1Mb
+$opt(mac) set dataRate_ 2Mb
+
+Antenna/OmniAntenna set X_ 0
+Antenna/OmniAntenna set Y_ 0
+Antenna/OmniAntenna set Z_ 1.5
+Antenna/OmniAntenna set Gt_ 1.0
+Antenna/OmniAntenna set Gr_ 1.0
+
+Phy/WirelessPhy set CPThresh_ 10.0
+Phy/WirelessPhy set CSThresh_ 1.559e-11
+Phy/WirelessPhy set RXThresh_ 3.65262e-10
+Phy/WirelessPhy set Rb_ 2*1e6
+Phy/WirelessPhy set Pt_ 0.2818
+Phy/WirelessPhy set freq_ 914e+6
+Phy/WirelessPhy set L_ 1.0
+
+if {$argc > 0} {
+    set opt(nn) [lindex $argv 0]
+}
+if {$argc > 1 && [lindex $argv 1] == "fisheye"} {
+    Agent/OLSR set fisheye_ true
+}
+set opt(x) [expr 1000.0 * sqrt(double($opt(nn)) / $opt(density))]
+set opt(y) $opt(x)
+# TC intervals between two TC messages flooded network wide
+set opt(gap) 1
+if {[Agent/OLSR set fisheye_]} {
+    set opt(gap) 3
+}
+
+ns-random $opt(seed)
+
+set ns_ [new Simulator]
+# the trace is not needed, and writing it would dominate the run time
+$ns_ trace-all [open /dev/null w]
+
+set topo [new Topography]
+$topo load_flatgrid [expr $opt(x) + 2 * $opt(range)] $opt(y)
+set god_ [create-god $opt(nn)]
+set chan_1_ [new $opt(chan)]
+
+$ns_ node-config -adhocRouting $opt(adhocRouting) \
+                 -llType $opt(ll) \
+                 -macType $opt(mac) \
+                 -ifqType $opt(ifq) \
+                 -ifqLen $opt(ifqlen) \
+                 -antType $opt(ant) \
+                 -propType $opt(prop) \
+                 -phyType $opt(netif) \
+                 -channel $chan_1_ \
+                 -topoInstance $topo \
+                 -wiredRouting OFF \
+                 -agentTrace OFF \
+                 -routerTrace OFF \
+                 -macTrace OFF \
+                 -movementTrace OFF
+
+set rng [new RNG]
+$rng seed 1
+for {set i 0} {$i < $opt(nn)} {incr i} {
+    set node_($i) [$ns_ node]
+    $node_($i) random-motion 0
+    $node_($i) set X_ [$rng uniform 0 $opt(x)]
+    $node_($i) set Y_ [$rng uniform 0 $opt(y)]
+    $node_($i) set Z_ 0
+    $ns_ at [$rng uniform 1 10] "$node_($i) setdest [$rng uniform 1 $opt(x)] \
+        [$rng uniform 1 $opt(y)] [$rng uniform 1 $opt(speed)]"
+}
+
+# Whether nodes u and v are within radio range.
+proc in_range {u v} {
+    global node_ opt
+    set dx [expr [$node_($u) set X_] - [$node_($v) set X_]]
+    set dy [expr [$node_($u) set Y_] - [$node_($v) set Y_]]
+    return [expr $dx * $dx + $dy * $dy <= $opt(range) * $opt(range)]
+}
+
+# Number of hops of the shortest paths from src, by breadth-first search
+# over the pairs of nodes within radio range.
+proc shortest_hops {src} {
+    global node_ opt
+    set hops($src) 0
+    set queue [list $src]
+    while {[llength $queue] > 0} {
+        set u [lindex $queue 0]
+        set queue [lrange $queue 1 end]
+        for {set v 0} {$v < $opt(nn)} {incr v} {
+            if {[info exists hops($v)]} {
+                continue
+            }
+            if {[in_range $u $v]} {
+                set hops($v) [expr $hops($u) + 1]
+                lappend queue $v
+            }
+        }
+    }
+    return [array get hops]
+}
+
+# Number of hops of the route followed hop by hop from src to dst, or -1
+# if it is broken.
+proc route_hops {src dst} {
+    global node_ opt
+    set n 0
+    set u $src
+    while {$u != $dst} {
+        set v [[$node_($u) agent 255] next_hop $dst]
+        incr n
+        if {$v < 0 || $n > $opt(nn) || ![in_range $u $v]} {
+            return -1
+        }
+        set u $v
+    }
+    return $n
+}
+
+# Sends the node which most nodes hold topology tuples from out of range
+# of all the others, and checks that they forgot these tuples once they
+# have expired.
+proc leave {} {
+    global ns_ node_ opt gone
+    set most 0
+    set gone -1
+    for {set i 0} {$i < $opt(nn)} {incr i} {
+        set holders 0
+        for {set j 0} {$j < $opt(nn)} {incr j} {
+            if {[[$node_($j) agent 255] topology_tuples $i] > 0} {
+                incr holders
+            }
+        }
+        if {$holders > $most} {
+            set most $holders
+            set gone $i
+        }
+    }
+    if {$gone < 0} {
+        puts "FAILED: no topology tuples"
+        exit 1
+    }
+    # brings X_ and Y_ up to date
+    $node_($gone) log-movement
+    set dx [expr $opt(x) + 2 * $opt(range) - 1 - [$node_($gone) set X_]]
+    set speed 500.0
+    $node_($gone) setdest [expr $opt(x) + 2 * $opt(range) - 1] \
+        [$node_($gone) set Y_] $speed
+    set out [expr [$ns_ now] + $dx / $speed]
+    set bound [expr $opt(hold) + ($opt(gap) - 1) * [Agent/OLSR set tc_ival_]]
+    $ns_ at [expr $out + $bound + $opt(delay)] "check_gone $most"
+}
+
+proc check_gone {most} {
+    global ns_ node_ opt gone
+    set holders 0
+    for {set j 0} {$j < $opt(nn)} {incr j} {
+        if {[[$node_($j) agent 255] topology_tuples $gone] > 0} {
+            incr holders
+        }
+    }
+    puts "left:       node $gone at $opt(leave) s, held by $most nodes,\
+          by $holders at [format %.1f [$ns_ now]] s"
+    if {$holders > 0} {
+        puts "FAILED: $holders nodes hold tuples of node $gone"
+        exit 1
+    }
+}
+$ns_ at $opt(leave) "leave"
+
+proc finish {} {
+    global ns_ node_ opt start rng
+    set bytes 0
+    for {set i 0} {$i < $opt(nn)} {incr i} {
+        incr bytes [lindex [[$node_($i) agent 255] tc_stats] 4]
+        # brings X_ and Y_ up to date
+        $node_($i) log-movement
+    }
+    set pairs 0
+    set broken 0
+    set stretch 0.0
+    for {set k 0} {$k < $opt(pairs)} {incr k} {
+        set src [$rng integer $opt(nn)]
+        set dst [$rng integer $opt(nn)]
+        if {$src == $dst} {
+            continue
+        }
+        if {![info exists shortest($src)]} {
+            set shortest($src) [shortest_hops $src]
+        }
+        array set hops $shortest($src)
+        if {![info exists hops($dst)]} {
+            array unset hops
+            continue
+        }
+        incr pairs
+        set n [route_hops $src $dst]
+        if {$n < 0} {
+            incr broken
+        } else {
+            set stretch [expr $stretch + double($n) / $hops($dst)]
+        }
+        array unset hops
+    }
+    set wall [expr ([clock clicks -milliseconds] - $start) / 1000.0]
+    puts "nodes:      $opt(nn) in [format %.0f $opt(x)] m x [format %.0f $opt(y)] m"
+    puts "tc:         [format %.1f [expr $bytes / $opt(stop) / $opt(nn)]] B/s per node"
+    puts "routes:     $pairs pairs of connected nodes, $broken broken"
+    if {$pairs > $broken} {
+        puts "stretch:    [format %.3f [expr $stretch / ($pairs - $broken)]]"
+    }
+    puts "wall time:  [format %.2f $wall] s"
+    exit 0
+}
+$ns_ at $opt(stop) "finish"
+
+set start [clock clicks -milliseconds]
+$ns_ run
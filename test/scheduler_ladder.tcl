@@ -0,0 +1,116 @@
+# ======================================================================
+# Regression test for the ladder queue event scheduler.
+#
+# Schedules events at times drawn from a skewed distribution, most of
+# them packed in a few microseconds with many equal times, and the rest
+# spread up to a thousand seconds. The events schedule further events
+# while they are dispatched, some at the current time, and cancel some
+# of the pending ones. Times are multiples of 2^-20 s, so that they are
+# exact. The script checks that the events are dispatched in time order,
+# that events with the same time are dispatched in the order they were
+# scheduled, and that all the events but the cancelled ones are
+# dispatched. It exits with status 1 if any check fails.
+#
+# usage: ns scheduler_ladder.tcl [scheduler]
+# ======================================================================
+set opt(sched)          Ladder                   ;# event scheduler
+set opt(events)         20000                    ;# events scheduled at first
+set opt(children)       10000                    ;# events scheduled by events
+
+if {$argc > 0} {
+    set opt(sched) [lindex $argv 0]
+}
+
+# exact times
+set tcl_precision 17
+set tick [expr 1.0 / 1048576]
+
+set ns_ [new Simulator]
+$ns_ use-scheduler $opt(sched)
+
+set rng [new RNG]
+$rng seed 1
+
+# Time in ticks of a new event at or after now.
+proc draw {now} {
+    global rng
+    set p [$rng uniform 0 1]
+    if {$p < 0.6} {
+        return [expr $now + [$rng integer 16]]
+    } elseif {$p < 0.9} {
+        return [expr $now + [$rng integer 65536]]
+    }
+    return [expr $now + [$rng integer 1073741824]]
+}
+
+set seq 0
+set scheduled 0
+set cancelled 0
+set order {}
+
+proc sched {t} {
+    global ns_ tick seq scheduled pending
+    set uid [$ns_ at [expr $t * $tick] "fire $seq $t"]
+    set pending($seq) $uid
+    incr seq
+    incr scheduled
+}
+
+proc fire {s t} {
+    global ns_ rng opt order pending seq cancelled
+    lappend order [list $t $s]
+    unset pending($s)
+    if {$opt(children) > 0 && [$rng integer 2] == 0} {
+        incr opt(children) -1
+        if {[$rng integer 4] == 0} {
+            sched $t
+        } else {
+            sched [draw $t]
+        }
+    }
+    if {[$rng integer 10] == 0} {
+        set victim [$rng integer $seq]
+        if {[info exists pending($victim)]} {
+            $ns_ cancel $pending($victim)
+            unset pending($victim)
+            incr cancelled
+        }
+    }
+}
+
+proc finish {} {
+    global order scheduled cancelled opt
+    set errors 0
+    set last {-1 -1}
+    foreach ev $order {
+        set t [lindex $ev 0]
+        set s [lindex $ev 1]
+        if {$t < [lindex $last 0] ||
+            ($t == [lindex $last 0] && $s < [lindex $last 1])} {
+            if {$errors < 10} {
+                puts "event $s at $t dispatched after event\
+                      [lindex $last 1] at [lindex $last 0]"
+            }
+            incr errors
+        }
+        set last $ev
+    }
+    set n [llength $order]
+    if {$n != $scheduled - $cancelled} {
+        puts "$n events dispatched, expected [expr $scheduled - $cancelled]"
+        incr errors
+    }
+    puts "$opt(sched) scheduler: $scheduled events, $cancelled cancelled"
+    if {$errors > 0} {
+        puts "FAILED: $errors errors"
+        exit 1
+    }
+    puts "PASSED"
+    exit 0
+}
+
+for {set i 0} {$i < $opt(events)} {incr i} {
+    sched [draw 0]
+}
+$ns_ at 100000.0 "finish"
+$ns_ run